@@ -0,0 +1,125 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "atomic-queue.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ATOMIC_QUEUE_MIN_CAPACITY (2)
+#define ATOMIC_QUEUE_CACHE_LINE_SIZE (64)
+
+typedef struct atomic_queue_cell {
+    atomic_size_t sequence;
+    void* data;
+} atomic_queue_cell_t;
+
+typedef struct atomic_queue {
+    atomic_queue_cell_t* cells;
+    size_t mask;
+    _Alignas(ATOMIC_QUEUE_CACHE_LINE_SIZE) atomic_size_t enqueue_position;
+    _Alignas(ATOMIC_QUEUE_CACHE_LINE_SIZE) atomic_size_t dequeue_position;
+} atomic_queue_t;
+
+atomic_queue_t* atomic_queue_create(size_t capacity) {
+    size_t cell_count = ATOMIC_QUEUE_MIN_CAPACITY;
+    while (cell_count < capacity) {
+        cell_count *= 2;
+    }
+    atomic_queue_t* queue = calloc(1, sizeof(atomic_queue_t));
+    if (!queue) {
+        return NULL;
+    }
+    queue->cells = calloc(cell_count, sizeof(atomic_queue_cell_t));
+    if (!queue->cells) {
+        free(queue);
+        return NULL;
+    }
+    for (size_t i = 0; i < cell_count; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+    }
+    queue->mask = cell_count - 1;
+    atomic_init(&queue->enqueue_position, 0);
+    atomic_init(&queue->dequeue_position, 0);
+    return queue;
+}
+
+void atomic_queue_destroy(atomic_queue_t* queue) {
+    if (!queue) {
+        return;
+    }
+    free(queue->cells);
+    free(queue);
+}
+
+bool atomic_queue_enqueue(atomic_queue_t* queue, void* data) {
+    if (!queue || !data) {
+        return false;
+    }
+    size_t position = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    atomic_queue_cell_t* cell;
+    while (true) {
+        cell = &queue->cells[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+        }
+    }
+    cell->data = data;
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    return true;
+}
+
+void* atomic_queue_dequeue(atomic_queue_t* queue) {
+    if (!queue) {
+        return NULL;
+    }
+    size_t position = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    atomic_queue_cell_t* cell;
+    while (true) {
+        cell = &queue->cells[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return NULL;
+        } else {
+            position = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+        }
+    }
+    void* data = cell->data;
+    atomic_store_explicit(&cell->sequence, position + queue->mask + 1, memory_order_release);
+    return data;
+}
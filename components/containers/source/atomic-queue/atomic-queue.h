@@ -0,0 +1,79 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CONTAINERS_ATOMIC_QUEUE_H
+#define CONTAINERS_ATOMIC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @defgroup atomic-queue Atomic Queue
+ *
+ * @brief Bounded lock-free queue for many producers and many consumers
+ * @{
+ */
+
+typedef struct atomic_queue atomic_queue_t; /**< @brief Atomic queue abstract type. Use only as pointer */
+
+/**
+ * @brief Create a new atomic queue
+ * @param[in] capacity Maximum number of elements stored, rounded up to a power of two
+ * @note Uses memory allocation, the queue does not allocate afterwards
+ * @return pointer to a new atomic queue
+ */
+atomic_queue_t* atomic_queue_create(size_t capacity);
+
+/**
+ * @brief Destroy the atomic queue
+ * @param[in] queue pointer to the atomic queue to destroy
+ * @note Uses memory de-allocation
+ * @note Make sure to destroy the referenced data!
+ */
+void atomic_queue_destroy(atomic_queue_t* queue);
+
+/**
+ * @brief Appends the element to the back of the atomic queue
+ * @param[in] queue pointer to the atomic queue
+ * @param[in] data pointer to the new data to be placed
+ * @return true if data is stored successfully
+ * @return false if pointers are invalid or queue is full
+ * @note Safe to call from any number of threads at once
+ */
+bool atomic_queue_enqueue(atomic_queue_t* queue, void* data);
+
+/**
+ * @brief Retrieve the element from the front of the atomic queue
+ * @param[in] queue pointer to the atomic queue
+ * @return NULL if the pointer to the queue is invalid
+ * @return NULL if the queue is empty
+ * @return pointer to data content
+ * @note Safe to call from any number of threads at once
+ */
+void* atomic_queue_dequeue(atomic_queue_t* queue);
+
+/**
+ * @}
+ */
+
+#endif  // CONTAINERS_ATOMIC_QUEUE_H
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "cmocka.h"
+
+#include "atomic-queue.h"
+
+#define TEST_THREAD_COUNT (4)
+#define TEST_ELEMENTS_PER_PRODUCER (20000)
+#define TEST_CAPACITY (64)
+
+typedef struct test_context {
+    atomic_queue_t* queue;
+    uintptr_t first_value;
+    atomic_size_t consumed_count;
+    atomic_uint_fast64_t consumed_sum;
+} test_context_t;
+
+static void test_try_to_use_invalid_queue_pointer(void** state) {
+    int input = 1;
+    assert_false(atomic_queue_enqueue(NULL, &input));
+    assert_null(atomic_queue_dequeue(NULL));
+    atomic_queue_destroy(NULL);
+}
+
+static void test_pass_elements_in_order(void** state) {
+    atomic_queue_t* queue = atomic_queue_create(4);
+    int input[3] = {1, 2, 3};
+    assert_null(atomic_queue_dequeue(queue));
+    assert_false(atomic_queue_enqueue(queue, NULL));
+    for (size_t i = 0; i < 3; i++) {
+        assert_true(atomic_queue_enqueue(queue, input + i));
+    }
+    for (size_t i = 0; i < 3; i++) {
+        assert_ptr_equal(atomic_queue_dequeue(queue), input + i);
+    }
+    assert_null(atomic_queue_dequeue(queue));
+    atomic_queue_destroy(queue);
+}
+
+static void test_full_queue_rejects_elements(void** state) {
+    atomic_queue_t* queue = atomic_queue_create(3);
+    int input[5] = {0};
+    for (size_t i = 0; i < 4; i++) {
+        assert_true(atomic_queue_enqueue(queue, input + i));
+    }
+    assert_false(atomic_queue_enqueue(queue, input + 4));
+    assert_ptr_equal(atomic_queue_dequeue(queue), input);
+    assert_true(atomic_queue_enqueue(queue, input + 4));
+    atomic_queue_destroy(queue);
+}
+
+static void test_wrap_around_many_times(void** state) {
+    atomic_queue_t* queue = atomic_queue_create(2);
+    int input[3] = {0};
+    for (size_t i = 0; i < 1000; i++) {
+        assert_true(atomic_queue_enqueue(queue, input + (i % 3)));
+        assert_true(atomic_queue_enqueue(queue, input + ((i + 1) % 3)));
+        assert_ptr_equal(atomic_queue_dequeue(queue), input + (i % 3));
+        assert_ptr_equal(atomic_queue_dequeue(queue), input + ((i + 1) % 3));
+    }
+    assert_null(atomic_queue_dequeue(queue));
+    atomic_queue_destroy(queue);
+}
+
+static void* produce(void* context) {
+    test_context_t* test_context = context;
+    uintptr_t first_value = test_context->first_value;
+    for (uintptr_t value = first_value; value < (first_value + TEST_ELEMENTS_PER_PRODUCER); value++) {
+        while (!atomic_queue_enqueue(test_context->queue, (void*)value)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void* consume(void* context) {
+    test_context_t* test_context = context;
+    size_t total_count = (size_t)TEST_THREAD_COUNT * TEST_ELEMENTS_PER_PRODUCER;
+    while (atomic_load(&test_context->consumed_count) < total_count) {
+        uintptr_t value = (uintptr_t)atomic_queue_dequeue(test_context->queue);
+        if (!value) {
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add(&test_context->consumed_sum, value);
+        atomic_fetch_add(&test_context->consumed_count, 1);
+    }
+    return NULL;
+}
+
+static void test_many_producers_and_consumers(void** state) {
+    atomic_queue_t* queue = atomic_queue_create(TEST_CAPACITY);
+    test_context_t producers[TEST_THREAD_COUNT];
+    test_context_t consumer = {.queue = queue};
+    pthread_t threads[2 * TEST_THREAD_COUNT];
+    uint64_t expected_sum = 0;
+    for (size_t i = 0; i < TEST_THREAD_COUNT; i++) {
+        producers[i] = (test_context_t){.queue = queue, .first_value = 1 + (i * TEST_ELEMENTS_PER_PRODUCER)};
+        for (uintptr_t value = 0; value < TEST_ELEMENTS_PER_PRODUCER; value++) {
+            expected_sum += producers[i].first_value + value;
+        }
+        pthread_create(threads + i, NULL, produce, producers + i);
+        pthread_create(threads + TEST_THREAD_COUNT + i, NULL, consume, &consumer);
+    }
+    for (size_t i = 0; i < (2 * TEST_THREAD_COUNT); i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert_int_equal(atomic_load(&consumer.consumed_count), TEST_THREAD_COUNT * TEST_ELEMENTS_PER_PRODUCER);
+    assert_true(atomic_load(&consumer.consumed_sum) == expected_sum);
+    assert_null(atomic_queue_dequeue(queue));
+    atomic_queue_destroy(queue);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_try_to_use_invalid_queue_pointer),
+        cmocka_unit_test(test_pass_elements_in_order),
+        cmocka_unit_test(test_full_queue_rejects_elements),
+        cmocka_unit_test(test_wrap_around_many_times),
+        cmocka_unit_test(test_many_producers_and_consumers),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
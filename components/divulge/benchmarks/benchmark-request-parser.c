@@ -0,0 +1,113 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "divulge-request-parser.h"
+
+#define BENCHMARK_ITERATIONS (200000)
+#define BENCHMARK_SEGMENT_SIZE (64)
+
+static const char* corpus[] = {
+    "GET / HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "\r\n",
+
+    "GET /api/devices/42/sensors/temperature?unit=C&samples=10 HTTP/1.1\r\n"
+    "Host: 192.168.4.1:5000\r\n"
+    "User-Agent: curl/7.88.1\r\n"
+    "Accept: application/json\r\n"
+    "\r\n",
+
+    "GET /static/js/dashboard.bundle.js HTTP/1.1\r\n"
+    "Host: 192.168.4.1:5000\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+    "Accept: */*\r\n"
+    "Referer: http://192.168.4.1:5000/\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9,pl;q=0.8\r\n"
+    "If-None-Match: \"5d8c72a5edda8d6a\"\r\n"
+    "\r\n",
+
+    "POST /api/config HTTP/1.1\r\n"
+    "Host: 192.168.4.1:5000\r\n"
+    "Authorization: Basic ZzI6ZzM=\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 40\r\n"
+    "\r\n"
+    "{\"ssid\":\"g2labs\",\"password\":\"secret123\"}",
+};
+
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+static double get_time_s(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+static size_t parse(const char* request, size_t request_size, size_t segment_size) {
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    divulge_request_parser_status_t status = DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE;
+    for (size_t size = segment_size; status == DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE; size += segment_size) {
+        status = divulge_request_parser_execute(&parser, request, (size < request_size) ? size : request_size);
+    }
+    if (status != DIVULGE_REQUEST_PARSER_STATUS_COMPLETE) {
+        fprintf(stderr, "Corpus request could not be parsed\n");
+        exit(EXIT_FAILURE);
+    }
+    return parser.header_count;
+}
+
+static void run_benchmark(const char* name, size_t segment_size) {
+    size_t sizes[CORPUS_SIZE];
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        sizes[i] = strlen(corpus[i]);
+        total_bytes += sizes[i];
+    }
+    volatile size_t header_count = 0;
+    double start = get_time_s();
+    for (size_t iteration = 0; iteration < BENCHMARK_ITERATIONS; iteration++) {
+        for (size_t i = 0; i < CORPUS_SIZE; i++) {
+            header_count += parse(corpus[i], sizes[i], segment_size ? segment_size : sizes[i]);
+        }
+    }
+    double elapsed = get_time_s() - start;
+    double requests = (double)BENCHMARK_ITERATIONS * CORPUS_SIZE;
+    printf("%-24s %12.0f requests/s %10.1f MB/s\n", name, requests / elapsed,
+           ((double)total_bytes * BENCHMARK_ITERATIONS) / elapsed / 1e6);
+}
+
+int main(void) {
+    printf("Parsing %zu canned requests %d times\n", CORPUS_SIZE, BENCHMARK_ITERATIONS);
+    run_benchmark("single read", 0);
+    run_benchmark("64-byte segments", BENCHMARK_SEGMENT_SIZE);
+    run_benchmark("1-byte segments", 1);
+    return 0;
+}
@@ -29,74 +29,82 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
-#include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
-#define G2LABS_LOG_MODULE_LEVEL G2LABS_LOG_MODULE_LEVEL_INFO
-#define G2LABS_LOG_MODULE_NAME "divulge-x64"
 #include "divulge-basic-authentication.h"
+#include "divulge-compression.h"
+#include "divulge-multipart.h"
+#include "divulge-sse.h"
+#include "divulge-static-files.h"
+#include "divulge-websocket.h"
 #include "divulge.h"
 #include "file-names.h"
-#include "g2labs-log.h"
+#include "g2l-fs.h"
+#include "g2l-log.h"
 #include "static-string.h"
 #include "stream-server.h"
 
+#define TAG "divulge-x64"
+
 #define DIVULGE_EXAMPLE_PORT (5000)
 #define DIVULGE_EXAMPLE_MAX_WAITING_CONNECTIONS (100)
 #define DIVULGE_EXAMPLE_THREAD_POOL_SIZE (20)
 #define DIVULGE_EXAMPLE_BUFFER_SIZE (1024)
+#define DIVULGE_EXAMPLE_REQUEST_ARENA_SIZE (4096)
+#define DIVULGE_EXAMPLE_HTTP2_MAX_CONCURRENT_STREAMS (8)
+#define DIVULGE_EXAMPLE_COMPRESSION_MIN_PAYLOAD_SIZE (256)
+#define DIVULGE_EXAMPLE_READING_COUNT (200)
+#define DIVULGE_EXAMPLE_CREDENTIAL_CACHE_SIZE (8)
+#define DIVULGE_EXAMPLE_CREDENTIAL_CACHE_TTL_MS (60000)
+#define DIVULGE_EXAMPLE_TELEMETRY_MAX_CONNECTIONS (8)
+#define DIVULGE_EXAMPLE_TELEMETRY_PERIOD_US (500000)
+#define DIVULGE_EXAMPLE_TELEMETRY_MAX_PENDING_REQUESTS (32)
 
 static void socket_send_response(void* connection_context, const char* data, size_t data_size) {
     stream_server_connection_t* connection = (stream_server_connection_t*)connection_context;
     stream_server_write(connection, data, data_size);
 }
 
+static void socket_send_vector_response(void* connection_context,
+                                        const divulge_io_vector_t* vectors,
+                                        size_t vector_count) {
+    stream_server_connection_t* connection = (stream_server_connection_t*)connection_context;
+    stream_server_writev(connection, (const stream_server_io_vector_t*)vectors, vector_count);
+}
+
+static size_t socket_send_file(void* connection_context, g2l_fs_file_t* file, size_t offset, size_t size) {
+    stream_server_connection_t* connection = (stream_server_connection_t*)connection_context;
+    return stream_server_send_file(connection, g2l_fs_file_get_descriptor(file), offset, size);
+}
+
 static void socket_close(void* connection_context) {
     stream_server_connection_t* connection = (stream_server_connection_t*)connection_context;
     stream_server_close(connection);
 }
 
-static bool root_handler(divulge_request_t* request, void* context) {
-    char* file_buffer = NULL;
-    divulge_header_entry_t header_entries[] = {{.key = "Content-Type", .value = "text/html"}};
-    divulge_response_t response = {
-        .return_code = 200,
-        .header = {.count = 1, .entries = header_entries},
-        .payload = "",
-        .payload_size = 0,
-    };
-    struct stat st;
-    const char* file_name = ROOT_FILE_NAME;
-    int result = stat(file_name, &st);
-    if (result != 0) {
-        response.return_code = 500;
-        response.payload = "Error while accessing file";
-        response.payload_size = strlen(response.payload);
-    } else {
-        size_t file_size = st.st_size;
-        file_buffer = calloc(file_size, sizeof(char));
-        FILE* f = fopen(file_name, "r");
-        size_t bytes_read = fread(file_buffer, file_size, 1, f);
-        fclose(f);
-        response.payload = file_buffer;
-        response.payload_size = bytes_read;
-    }
-    bool status = divulge_respond(request, &response);
-    if (file_buffer) {
-        free(file_buffer);
-    }
-    return status;
+static size_t socket_receive(void* connection_context, char* data, size_t max_data_size) {
+    stream_server_connection_t* connection = (stream_server_connection_t*)connection_context;
+    return stream_server_read(connection, data, max_data_size);
+}
+
+static void socket_set_receive_timeout(void* connection_context, uint32_t timeout_ms) {
+    stream_server_connection_t* connection = (stream_server_connection_t*)connection_context;
+    stream_server_set_read_timeout(connection, timeout_ms);
 }
 
 static bool root_post_handler(divulge_request_t* request, void* context) {
-    I("Received POST /: '%s'", request->payload);
+    I(TAG, "Received POST /: '%.*s'", (int)request->payload_size, request->payload);
     return divulge_redirect(request, "/");
 }
 
 static bool restricted_access_handler(divulge_request_t* request, void* context) {
-    char buffer[DIVULGE_EXAMPLE_BUFFER_SIZE];
-    snprintf(buffer, sizeof(buffer) - 1,
+    char* buffer = divulge_allocate(request, DIVULGE_EXAMPLE_BUFFER_SIZE);
+    if (!buffer) {
+        divulge_response_t error_response = {.return_code = 500};
+        return divulge_respond(request, &error_response);
+    }
+    snprintf(buffer, DIVULGE_EXAMPLE_BUFFER_SIZE - 1,
              "<h2>Restricted access area!</h2><p>If you can see this, it means "
              "you logged in :)</p>");
     divulge_header_entry_t header_entries[] = {{.key = "Content-Type", .value = "text/html"}};
@@ -107,26 +115,66 @@ static bool restricted_access_handler(divulge_request_t* request, void* context)
     return divulge_respond(request, &response);
 }
 
-static divulge_uri_t root_uri = {
-    .uri = "/",
-    .handler = {.handler = root_handler},
+static divulge_uri_t restricted_uri = {
+    .uri = "/restricted",
+    .handler = {.handler = restricted_access_handler},
     .method = DIVULGE_ROUTE_METHOD_GET,
 };
 
-static divulge_uri_t root_post_uri = {
-    .uri = "/",
-    .handler = {.handler = root_post_handler},
+static bool upload_handler(divulge_request_t* request, void* context) {
+    divulge_response_t response = {.return_code = 200, .payload = "Upload complete", .payload_size = 15};
+    return divulge_respond(request, &response);
+}
+
+static bool upload_part_begin(divulge_request_t* request, const divulge_multipart_part_t* part, void* context) {
+    I(TAG, "Upload part '%s' (file: '%s', type: '%s')", part->name.text, part->file_name.text,
+      part->content_type.text);
+    return true;
+}
+
+static bool upload_part_data(divulge_request_t* request,
+                             const divulge_multipart_part_t* part,
+                             const char* data,
+                             size_t data_size,
+                             void* context) {
+    D(TAG, "Upload part '%s': %zu bytes", part->name.text, data_size);
+    return true;
+}
+
+static divulge_uri_t upload_uri = {
+    .uri = "/upload",
+    .handler = {.handler = upload_handler},
     .method = DIVULGE_ROUTE_METHOD_POST,
 };
 
-static divulge_uri_t restricted_uri = {
-    .uri = "/restricted",
-    .handler = {.handler = restricted_access_handler},
+static const divulge_multipart_handlers_t upload_handlers = {
+    .part_begin = upload_part_begin,
+    .part_data = upload_part_data,
+};
+
+static bool readings_handler(divulge_request_t* request, void* context) {
+    divulge_header_entry_t header_entries[] = {{.key = "Content-Type", .value = "application/json"}};
+    divulge_response_t response = {.return_code = 200, .header = {.count = 1, .entries = header_entries}};
+    divulge_begin_chunked_response(request, &response);
+    divulge_send_chunk(request, "[", 1);
+    for (size_t i = 0; i < DIVULGE_EXAMPLE_READING_COUNT; i++) {
+        char reading[64];
+        int size = snprintf(reading, sizeof(reading), "%s{\"sensor\":%zu,\"celsius\":%zu.%zu}", (i > 0) ? "," : "",
+                            i % 8, 20 + (i % 5), i % 10);
+        divulge_send_chunk(request, reading, (size_t)size);
+    }
+    divulge_send_chunk(request, "]", 1);
+    return divulge_end_chunked_response(request);
+}
+
+static divulge_uri_t readings_uri = {
+    .uri = "/readings",
+    .handler = {.handler = readings_handler},
     .method = DIVULGE_ROUTE_METHOD_GET,
 };
 
 static bool logger_middleware_handler(divulge_request_t* request, void* context) {
-    I("[%s] '%s'", divulge_method_name_from_method(request->method), request->route);
+    I(TAG, "[%s] '%s'", divulge_method_name_from_method(request->method), request->route);
     return true;
 }
 
@@ -135,23 +183,138 @@ static divulge_handler_object_t logger_middleware = {
     .context = NULL,
 };
 
+DIVULGE_ROUTE(root_post,
+              DIVULGE_ROUTE_METHOD_POST,
+              "/",
+              root_post_handler,
+              NULL,
+              {.handler = logger_middleware_handler});
+
+static uint64_t get_time_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+}
+
 static bool authenticate_user(void* context, const char* username, const char* password) {
     return ((strcmp(username, "g2") == 0) && (strcmp(password, "g3") == 0));
 }
 
+static bool telemetry_message_handler(divulge_websocket_connection_t* connection,
+                                      divulge_websocket_message_type_t type,
+                                      const char* data,
+                                      size_t data_size,
+                                      void* context) {
+    I(TAG, "Received telemetry message: '%.*s'", (int)data_size, data);
+    return true;
+}
+
+typedef struct telemetry {
+    divulge_websocket_t* websocket;
+    divulge_sse_t* events;
+    pthread_mutex_t mutex;
+    divulge_deferred_response_t* pending_requests[DIVULGE_EXAMPLE_TELEMETRY_MAX_PENDING_REQUESTS];
+    size_t pending_request_count;
+} telemetry_t;
+
+static bool next_sample_handler(divulge_request_t* request, void* context) {
+    telemetry_t* telemetry = (telemetry_t*)context;
+    pthread_mutex_lock(&telemetry->mutex);
+    divulge_deferred_response_t* deferred = NULL;
+    if (telemetry->pending_request_count < DIVULGE_EXAMPLE_TELEMETRY_MAX_PENDING_REQUESTS) {
+        deferred = divulge_defer_response(request);
+    }
+    if (deferred) {
+        telemetry->pending_requests[telemetry->pending_request_count++] = deferred;
+    }
+    pthread_mutex_unlock(&telemetry->mutex);
+    if (!deferred) {
+        divulge_response_t response = {.return_code = 503, .payload = "", .payload_size = 0};
+        return divulge_respond(request, &response);
+    }
+    return true;
+}
+
+static void complete_pending_requests(telemetry_t* telemetry, const char* message, size_t message_size) {
+    pthread_mutex_lock(&telemetry->mutex);
+    for (size_t i = 0; i < telemetry->pending_request_count; i++) {
+        divulge_header_entry_t header_entries[] = {{.key = "Content-Type", .value = "application/json"}};
+        divulge_response_t response = {.return_code = 200,
+                                       .header = {.count = 1, .entries = header_entries},
+                                       .payload = message,
+                                       .payload_size = message_size};
+        divulge_complete_deferred_response(telemetry->pending_requests[i], &response);
+    }
+    telemetry->pending_request_count = 0;
+    pthread_mutex_unlock(&telemetry->mutex);
+}
+
+static void* telemetry_thread(void* context) {
+    telemetry_t* telemetry = (telemetry_t*)context;
+    while (true) {
+        char message[64];
+        int size = snprintf(message, sizeof(message), "{\"uptime_us\":%llu}", (unsigned long long)get_time_us());
+        divulge_websocket_broadcast(telemetry->websocket, DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT, message, (size_t)size);
+        divulge_sse_broadcast(telemetry->events, "uptime", message);
+        complete_pending_requests(telemetry, message, (size_t)size);
+        usleep(DIVULGE_EXAMPLE_TELEMETRY_PERIOD_US);
+    }
+    return NULL;
+}
+
+static void initialize_telemetry(divulge_t* divulge) {
+    static telemetry_t telemetry;
+    divulge_websocket_configuration_t websocket_configuration = {
+        .max_connection_count = DIVULGE_EXAMPLE_TELEMETRY_MAX_CONNECTIONS,
+        .max_message_size = DIVULGE_EXAMPLE_BUFFER_SIZE,
+        .message_handler = telemetry_message_handler,
+    };
+    telemetry.websocket = divulge_websocket_create(&websocket_configuration);
+    divulge_websocket_mount(divulge, telemetry.websocket, "/telemetry");
+    divulge_sse_configuration_t events_configuration = {
+        .max_stream_count = DIVULGE_EXAMPLE_TELEMETRY_MAX_CONNECTIONS,
+    };
+    telemetry.events = divulge_sse_create(&events_configuration);
+    divulge_sse_mount(divulge, telemetry.events, "/events");
+    pthread_mutex_init(&telemetry.mutex, NULL);
+    static divulge_uri_t next_sample_uri = {
+        .uri = "/telemetry/next",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+    };
+    next_sample_uri.handler = (divulge_handler_object_t){.handler = next_sample_handler, .context = &telemetry};
+    divulge_register_uri(divulge, &next_sample_uri);
+    pthread_t thread;
+    pthread_create(&thread, NULL, telemetry_thread, &telemetry);
+    pthread_detach(thread);
+}
+
 static divulge_t* initialize_router(void) {
     divulge_configuration_t configuration = {
         .send = socket_send_response,
+        .sendv = socket_send_vector_response,
+        .send_file = socket_send_file,
         .close = socket_close,
+        .receive = socket_receive,
+        .set_receive_timeout = socket_set_receive_timeout,
+        .get_time_us = get_time_us,
+        .metrics_uri = "/metrics",
+        .request_arena_size = DIVULGE_EXAMPLE_REQUEST_ARENA_SIZE,
+        .http2_max_concurrent_streams = DIVULGE_EXAMPLE_HTTP2_MAX_CONCURRENT_STREAMS,
     };
     divulge_t* divulge = divulge_initialize(&configuration);
-    divulge_register_uri(divulge, &root_uri);
-    divulge_add_middleware_to_uri(divulge, &root_uri, &logger_middleware);
-    divulge_register_uri(divulge, &root_post_uri);
-    divulge_add_middleware_to_uri(divulge, &root_post_uri, &logger_middleware);
+    divulge_uri_t* public_uri = divulge_static_files_mount(divulge, "/", NULL, "index.html");
+    divulge_add_middleware_to_uri(divulge, public_uri, &logger_middleware);
     divulge_register_uri(divulge, &restricted_uri);
-    divulge_add_middleware_to_uri(divulge, &restricted_uri,
-                                  divulge_basic_authentication_create("G2Labs realm", authenticate_user, NULL));
+    divulge_handler_object_t* authentication = divulge_basic_authentication_create_with_cache(
+        "G2Labs realm", authenticate_user, NULL, DIVULGE_EXAMPLE_CREDENTIAL_CACHE_SIZE,
+        DIVULGE_EXAMPLE_CREDENTIAL_CACHE_TTL_MS);
+    divulge_add_middleware_to_uri(divulge, &restricted_uri, authentication);
+    divulge_register_uri(divulge, &upload_uri);
+    divulge_add_middleware_to_uri(divulge, &upload_uri, divulge_multipart_create(&upload_handlers));
+    divulge_register_uri(divulge, &readings_uri);
+    divulge_compression_t* compression = divulge_compression_create(DIVULGE_EXAMPLE_COMPRESSION_MIN_PAYLOAD_SIZE);
+    divulge_add_middleware_to_uri(divulge, &readings_uri, divulge_compression_get_middleware(compression));
+    initialize_telemetry(divulge);
     return divulge;
 }
 
@@ -159,15 +322,14 @@ static void connection_handler(stream_server_t* server, stream_server_connection
     divulge_t* router = (divulge_t*)context;
     char request_buffer[DIVULGE_EXAMPLE_BUFFER_SIZE];
     char response_buffer[DIVULGE_EXAMPLE_BUFFER_SIZE];
-    size_t request_bytes_read = stream_server_read(connection, request_buffer, sizeof(request_buffer) - 1);
-    request_buffer[request_bytes_read] = '\0';
-    divulge_process_request(router, connection, request_buffer, request_bytes_read, response_buffer,
-                            sizeof(response_buffer));
+    divulge_serve_connection(router, connection, request_buffer, sizeof(request_buffer), response_buffer,
+                             sizeof(response_buffer));
 }
 
 int main(void) {
-    I("Divulge example running on x64 platform");
+    I(TAG, "Divulge example running on x64 platform");
 
+    g2l_fs_initialize(PUBLIC_DIRECTORY);
     divulge_t* router = initialize_router();
 
     stream_server_t* server = stream_server_create(DIVULGE_EXAMPLE_PORT, DIVULGE_EXAMPLE_MAX_WAITING_CONNECTIONS,
@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-arena.h"
+#include <stdint.h>
+
+#define DIVULGE_ARENA_ALIGNMENT (_Alignof(max_align_t))
+
+void divulge_arena_initialize(divulge_arena_t* arena, void* buffer, size_t capacity) {
+    if (!arena) {
+        return;
+    }
+    arena->buffer = buffer;
+    arena->capacity = buffer ? capacity : 0;
+    arena->size = 0;
+}
+
+void* divulge_arena_allocate(divulge_arena_t* arena, size_t size) {
+    if (!arena || !arena->buffer) {
+        return NULL;
+    }
+    uintptr_t address = (uintptr_t)(arena->buffer + arena->size);
+    size_t padding = (size_t)((DIVULGE_ARENA_ALIGNMENT - (address % DIVULGE_ARENA_ALIGNMENT)) %
+                              DIVULGE_ARENA_ALIGNMENT);
+    size_t available = arena->capacity - arena->size;
+    if ((padding > available) || (size > (available - padding))) {
+        return NULL;
+    }
+    void* block = arena->buffer + arena->size + padding;
+    arena->size += padding + size;
+    return block;
+}
+
+void divulge_arena_reset(divulge_arena_t* arena) {
+    if (arena) {
+        arena->size = 0;
+    }
+}
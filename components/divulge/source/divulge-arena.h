@@ -0,0 +1,69 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_ARENA_H
+#define DIVULGE_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @defgroup divulge-arena Divulge arena
+ * @ingroup divulge
+ * @brief Bump allocator over a single buffer
+ *
+ * Allocations advance a cursor through the buffer and are never freed one by one; the whole arena is reset at once.
+ * Every allocation is aligned for any object type.
+ * @{
+ */
+
+typedef struct divulge_arena {
+    char* buffer;
+    size_t capacity;
+    size_t size; /**< @brief bytes taken by allocations including alignment padding */
+} divulge_arena_t;
+
+/**
+ * @brief Attach the arena to a buffer
+ * @param[in] arena pointer to the arena
+ * @param[in] buffer memory handed out by the arena; NULL makes every allocation fail
+ * @param[in] capacity size of the buffer
+ */
+void divulge_arena_initialize(divulge_arena_t* arena, void* buffer, size_t capacity);
+
+/**
+ * @brief Take a block from the arena
+ * @param[in] arena pointer to the arena
+ * @param[in] size size of the block
+ * @return pointer to the block or NULL if the arena is exhausted
+ */
+void* divulge_arena_allocate(divulge_arena_t* arena, size_t size);
+
+/**
+ * @brief Release all blocks at once
+ */
+void divulge_arena_reset(divulge_arena_t* arena);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_ARENA_H
@@ -26,36 +26,135 @@
 #include <stdlib.h>
 #include <string.h>
 #include "encodings-base64.h"
+#include "encodings-sha1.h"
+#include "g2l-mutex.h"
+#include "g2l-random.h"
+
+#define AUTHORIZATION_SCHEME "Basic "
+#define CACHE_SALT_SIZE (16)
+
+typedef struct credential_cache_entry {
+    uint8_t digest[ENCODINGS_SHA1_DIGEST_SIZE];
+    uint64_t expiration_time_us;
+    bool is_used;
+} credential_cache_entry_t;
 
 typedef struct divulge_basic_authentication_context {
     const char* realm;
     divulge_basic_authentication_authenticate_user_callback_t authentication_callback;
     void* authentication_context;
+    g2l_mutex_t* cache_mutex;
+    credential_cache_entry_t* cache_entries;
+    size_t cache_entry_count;
+    uint64_t cache_time_to_live_us;
+    uint8_t cache_salt[CACHE_SALT_SIZE];
 } divulge_basic_authentication_context_t;
 
-static bool handler(divulge_request_t* request, void* context) {
-    divulge_basic_authentication_context_t* ctx = (divulge_basic_authentication_context_t*)context;
-    const char* authorization_header = divulge_find_request_header_key(request, "Authorization");
+static void compute_digest(divulge_basic_authentication_context_t* ctx,
+                           const static_string_t* credentials,
+                           uint8_t* digest) {
+    encodings_sha1_t sha1;
+    encodings_sha1_initialize(&sha1);
+    encodings_sha1_update(&sha1, ctx->cache_salt, sizeof(ctx->cache_salt));
+    encodings_sha1_update(&sha1, credentials->text, credentials->length);
+    encodings_sha1_finalize(&sha1, digest);
+}
+
+static bool are_digests_equal(const uint8_t* a, const uint8_t* b) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < ENCODINGS_SHA1_DIGEST_SIZE; i++) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+static bool is_cached(divulge_basic_authentication_context_t* ctx, const uint8_t* digest, uint64_t now_us) {
+    bool result = false;
+    g2l_mutex_lock(ctx->cache_mutex);
+    for (size_t i = 0; i < ctx->cache_entry_count; i++) {
+        credential_cache_entry_t* entry = ctx->cache_entries + i;
+        if (entry->is_used && are_digests_equal(entry->digest, digest)) {
+            result = (now_us < entry->expiration_time_us);
+            entry->is_used = result;
+            break;
+        }
+    }
+    g2l_mutex_unlock(ctx->cache_mutex);
+    return result;
+}
+
+static void store_in_cache(divulge_basic_authentication_context_t* ctx, const uint8_t* digest, uint64_t now_us) {
+    g2l_mutex_lock(ctx->cache_mutex);
+    credential_cache_entry_t* slot = ctx->cache_entries;
+    for (size_t i = 0; i < ctx->cache_entry_count; i++) {
+        credential_cache_entry_t* entry = ctx->cache_entries + i;
+        if (!entry->is_used || are_digests_equal(entry->digest, digest) || (entry->expiration_time_us <= now_us)) {
+            slot = entry;
+            break;
+        } else if (entry->expiration_time_us < slot->expiration_time_us) {
+            slot = entry;
+        }
+    }
+    memcpy(slot->digest, digest, sizeof(slot->digest));
+    slot->is_used = true;
+    slot->expiration_time_us = now_us + ctx->cache_time_to_live_us;
+    g2l_mutex_unlock(ctx->cache_mutex);
+}
+
+static bool verify_credentials(divulge_basic_authentication_context_t* ctx, const static_string_t* credentials) {
+    char encoded[DIVULGE_BASIC_AUTHENTICATION_CREDENTIALS_MAX_SIZE];
+    char decoded[DIVULGE_BASIC_AUTHENTICATION_CREDENTIALS_MAX_SIZE];
+    if ((credentials->length >= sizeof(encoded)) || ((credentials->length % 4) != 0)) {
+        return false;
+    }
+    memcpy(encoded, credentials->text, credentials->length);
+    encoded[credentials->length] = '\0';
+    size_t decoded_size = encodings_base64_get_decode_buffer_size(encoded);
+    encodings_base64_decode(encoded, decoded);
+    decoded[decoded_size] = '\0';
+    char* separator = strchr(decoded, ':');
     bool result = false;
-    if (!authorization_header) {
-        result = false;
-    } else {
-        const char* value = divulge_get_request_header_entry_value(authorization_header);
-        char* encoding = strstr(value, " ") + 1;
-        char* decoded = calloc(encodings_base64_get_decode_buffer_size(encoding) + 1, sizeof(char));
-        encodings_base64_decode(encoding, decoded);
-        char* username = strtok(decoded, ":");
-        char* password = strtok(NULL, ":");
-        if (!username || !password || !ctx->authentication_callback(ctx->authentication_context, username, password)) {
-            result = false;
-        } else {
-            result = true;
+    if (separator && (strlen(decoded) == decoded_size)) {
+        *separator = '\0';
+        result = ctx->authentication_callback(ctx->authentication_context, decoded, separator + 1);
+    }
+    memset(decoded, 0, sizeof(decoded));
+    return result;
+}
+
+static bool is_authorized(divulge_basic_authentication_context_t* ctx, divulge_request_t* request) {
+    static_string_t credentials = divulge_get_request_header(request, "Authorization");
+    size_t scheme_length = strlen(AUTHORIZATION_SCHEME);
+    if (!credentials.text || (credentials.length <= scheme_length) ||
+        (strncmp(credentials.text, AUTHORIZATION_SCHEME, scheme_length) != 0)) {
+        return false;
+    }
+    credentials.text += scheme_length;
+    credentials.length -= scheme_length;
+    uint64_t now_us = 0;
+    uint8_t digest[ENCODINGS_SHA1_DIGEST_SIZE];
+    if (ctx->cache_entries) {
+        now_us = divulge_get_time_us(request);
+        compute_digest(ctx, &credentials, digest);
+        if ((now_us > 0) && is_cached(ctx, digest, now_us)) {
+            return true;
         }
-        free(decoded);
     }
+    if (!verify_credentials(ctx, &credentials)) {
+        return false;
+    }
+    if (ctx->cache_entries && (now_us > 0)) {
+        store_in_cache(ctx, digest, now_us);
+    }
+    return true;
+}
+
+static bool handler(divulge_request_t* request, void* context) {
+    divulge_basic_authentication_context_t* ctx = (divulge_basic_authentication_context_t*)context;
+    bool result = is_authorized(ctx, request);
     if (!result) {
         char realm_buffer[100];
-        sprintf(realm_buffer, "Basic realm=\"%s\"", ctx->realm);
+        snprintf(realm_buffer, sizeof(realm_buffer), "Basic realm=\"%s\"", ctx->realm);
         divulge_header_entry_t header_entries[] = {
             {.key = "WWW-Authenticate", .value = realm_buffer},
         };
@@ -78,6 +177,16 @@ divulge_handler_object_t* divulge_basic_authentication_create(
     const char* realm,
     divulge_basic_authentication_authenticate_user_callback_t authentication_callback,
     void* authentication_context) {
+    return divulge_basic_authentication_create_with_cache(realm, authentication_callback, authentication_context, 0,
+                                                          0);
+}
+
+divulge_handler_object_t* divulge_basic_authentication_create_with_cache(
+    const char* realm,
+    divulge_basic_authentication_authenticate_user_callback_t authentication_callback,
+    void* authentication_context,
+    size_t max_cache_entry_count,
+    uint32_t cache_time_to_live_ms) {
     if (!realm || !authentication_callback) {
         return NULL;
     }
@@ -90,10 +199,23 @@ divulge_handler_object_t* divulge_basic_authentication_create(
         free(object);
         return NULL;
     }
+    if ((max_cache_entry_count > 0) && (cache_time_to_live_ms > 0)) {
+        ctx->cache_entries = calloc(max_cache_entry_count, sizeof(credential_cache_entry_t));
+        ctx->cache_mutex = g2l_mutex_create();
+        if (!ctx->cache_entries || !ctx->cache_mutex || !g2l_random_fill(ctx->cache_salt, sizeof(ctx->cache_salt))) {
+            free(ctx->cache_entries);
+            g2l_mutex_destroy(ctx->cache_mutex);
+            free(ctx);
+            free(object);
+            return NULL;
+        }
+        ctx->cache_entry_count = max_cache_entry_count;
+        ctx->cache_time_to_live_us = (uint64_t)cache_time_to_live_ms * 1000;
+    }
     ctx->authentication_callback = authentication_callback;
     ctx->authentication_context = authentication_context;
     ctx->realm = realm;
     object->context = ctx;
     object->handler = handler;
     return object;
-}
\ No newline at end of file
+}
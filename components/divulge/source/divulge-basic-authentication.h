@@ -26,6 +26,8 @@
 
 #include "divulge.h"
 
+#define DIVULGE_BASIC_AUTHENTICATION_CREDENTIALS_MAX_SIZE (256)
+
 typedef bool (*divulge_basic_authentication_authenticate_user_callback_t)(void* context,
                                                                           const char* username,
                                                                           const char* password);
@@ -35,4 +37,11 @@ divulge_handler_object_t* divulge_basic_authentication_create(
     divulge_basic_authentication_authenticate_user_callback_t authentication_callback,
     void* authentication_context);
 
+divulge_handler_object_t* divulge_basic_authentication_create_with_cache(
+    const char* realm,
+    divulge_basic_authentication_authenticate_user_callback_t authentication_callback,
+    void* authentication_context,
+    size_t max_cache_entry_count,
+    uint32_t cache_time_to_live_ms);
+
 #endif  // DIVULGE_BASIC_AUTHENTICATION_H
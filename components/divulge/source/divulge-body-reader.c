@@ -0,0 +1,185 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-body-reader.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef enum reader_state {
+    STATE_CONTENT,
+    STATE_CHUNK_SIZE_START,
+    STATE_CHUNK_SIZE,
+    STATE_CHUNK_EXTENSION,
+    STATE_CHUNK_SIZE_END,
+    STATE_CHUNK_DATA,
+    STATE_CHUNK_DATA_END,
+    STATE_CHUNK_DATA_LINE_END,
+    STATE_TRAILER_LINE_START,
+    STATE_TRAILER_LINE,
+    STATE_TRAILER_END,
+    STATE_COMPLETE,
+    STATE_ERROR,
+} reader_state_t;
+
+void divulge_body_reader_reset(divulge_body_reader_t* reader, bool is_chunked, size_t content_length) {
+    if (!reader) {
+        return;
+    }
+    if (is_chunked) {
+        reader->state = STATE_CHUNK_SIZE_START;
+        reader->remaining_size = 0;
+    } else {
+        reader->state = (content_length > 0) ? STATE_CONTENT : STATE_COMPLETE;
+        reader->remaining_size = content_length;
+    }
+}
+
+static int decode_hex_digit(char digit) {
+    if ((digit >= '0') && (digit <= '9')) {
+        return digit - '0';
+    } else if ((digit >= 'a') && (digit <= 'f')) {
+        return digit - 'a' + 10;
+    } else if ((digit >= 'A') && (digit <= 'F')) {
+        return digit - 'A' + 10;
+    }
+    return -1;
+}
+
+static size_t copy_data(divulge_body_reader_t* reader,
+                        const char* input,
+                        size_t input_size,
+                        char* output,
+                        size_t* output_size) {
+    size_t size = (input_size < reader->remaining_size) ? input_size : reader->remaining_size;
+    if ((output + *output_size) != input) {
+        memmove(output + *output_size, input, size);
+    }
+    *output_size += size;
+    reader->remaining_size -= size;
+    return size;
+}
+
+static reader_state_t process_chunk_size(divulge_body_reader_t* reader, char c) {
+    int digit = decode_hex_digit(c);
+    if (digit >= 0) {
+        if (reader->remaining_size > ((SIZE_MAX - 15) / 16)) {
+            return STATE_ERROR;
+        }
+        reader->remaining_size = (reader->remaining_size * 16) + (size_t)digit;
+        return STATE_CHUNK_SIZE;
+    } else if ((c == ';') || (c == ' ') || (c == '\t')) {
+        return STATE_CHUNK_EXTENSION;
+    } else if (c == '\r') {
+        return STATE_CHUNK_SIZE_END;
+    } else if (c == '\n') {
+        return (reader->remaining_size > 0) ? STATE_CHUNK_DATA : STATE_TRAILER_LINE_START;
+    }
+    return STATE_ERROR;
+}
+
+static reader_state_t process_line_end(char c, reader_state_t next_state) {
+    return (c == '\n') ? next_state : STATE_ERROR;
+}
+
+divulge_body_reader_status_t divulge_body_reader_execute(divulge_body_reader_t* reader,
+                                                         const char* input,
+                                                         size_t input_size,
+                                                         char* output,
+                                                         size_t* consumed_size,
+                                                         size_t* output_size) {
+    if (!reader || (!input && (input_size > 0)) || !output || !consumed_size || !output_size) {
+        return DIVULGE_BODY_READER_STATUS_ERROR;
+    }
+    size_t position = 0;
+    *output_size = 0;
+    while ((position < input_size) && (reader->state != STATE_COMPLETE) && (reader->state != STATE_ERROR)) {
+        char c = input[position];
+        switch (reader->state) {
+            case STATE_CONTENT:
+            case STATE_CHUNK_DATA:
+                position += copy_data(reader, input + position, input_size - position, output, output_size);
+                if (reader->remaining_size == 0) {
+                    reader->state = (reader->state == STATE_CONTENT) ? STATE_COMPLETE : STATE_CHUNK_DATA_END;
+                }
+                continue;
+            case STATE_CHUNK_SIZE_START:
+                reader->state = (decode_hex_digit(c) >= 0) ? process_chunk_size(reader, c) : STATE_ERROR;
+                break;
+            case STATE_CHUNK_SIZE:
+                reader->state = process_chunk_size(reader, c);
+                break;
+            case STATE_CHUNK_EXTENSION:
+                if (c == '\r') {
+                    reader->state = STATE_CHUNK_SIZE_END;
+                } else if (c == '\n') {
+                    reader->state = (reader->remaining_size > 0) ? STATE_CHUNK_DATA : STATE_TRAILER_LINE_START;
+                }
+                break;
+            case STATE_CHUNK_SIZE_END:
+                reader->state = process_line_end(
+                    c, (reader->remaining_size > 0) ? STATE_CHUNK_DATA : STATE_TRAILER_LINE_START);
+                break;
+            case STATE_CHUNK_DATA_END:
+                if (c == '\r') {
+                    reader->state = STATE_CHUNK_DATA_LINE_END;
+                } else {
+                    reader->state = process_line_end(c, STATE_CHUNK_SIZE_START);
+                }
+                break;
+            case STATE_CHUNK_DATA_LINE_END:
+                reader->state = process_line_end(c, STATE_CHUNK_SIZE_START);
+                break;
+            case STATE_TRAILER_LINE_START:
+                if (c == '\r') {
+                    reader->state = STATE_TRAILER_END;
+                } else if (c == '\n') {
+                    reader->state = STATE_COMPLETE;
+                } else {
+                    reader->state = STATE_TRAILER_LINE;
+                }
+                break;
+            case STATE_TRAILER_LINE:
+                if (c == '\n') {
+                    reader->state = STATE_TRAILER_LINE_START;
+                }
+                break;
+            case STATE_TRAILER_END:
+                reader->state = process_line_end(c, STATE_COMPLETE);
+                break;
+            default:
+                reader->state = STATE_ERROR;
+                break;
+        }
+        position++;
+    }
+    *consumed_size = position;
+    if (reader->state == STATE_ERROR) {
+        return DIVULGE_BODY_READER_STATUS_ERROR;
+    }
+    return (reader->state == STATE_COMPLETE) ? DIVULGE_BODY_READER_STATUS_COMPLETE
+                                             : DIVULGE_BODY_READER_STATUS_INCOMPLETE;
+}
+
+bool divulge_body_reader_is_complete(const divulge_body_reader_t* reader) {
+    return reader && (reader->state == STATE_COMPLETE);
+}
@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_BODY_READER_H
+#define DIVULGE_BODY_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @defgroup divulge-body-reader Divulge body reader
+ * @ingroup divulge
+ * @brief Incremental decoder of request bodies framed by Content-Length or chunked transfer coding
+ *
+ * Input is consumed in pieces of any size. Decoded body bytes are written to an output location that may alias
+ * the input, so chunk framing can be stripped in place without a separate buffer.
+ * @{
+ */
+
+typedef enum divulge_body_reader_status {
+    DIVULGE_BODY_READER_STATUS_INCOMPLETE, /**< @brief more input is needed */
+    DIVULGE_BODY_READER_STATUS_COMPLETE,   /**< @brief the whole body was decoded */
+    DIVULGE_BODY_READER_STATUS_ERROR,      /**< @brief the chunk framing is malformed */
+} divulge_body_reader_status_t;
+
+typedef struct divulge_body_reader {
+    int state;
+    size_t remaining_size; /**< @brief bytes left in the body (Content-Length) or in the current chunk */
+} divulge_body_reader_t;
+
+/**
+ * @brief Prepare the reader for a new body
+ * @param[in] reader pointer to the reader
+ * @param[in] is_chunked true if the body uses chunked transfer coding
+ * @param[in] content_length size of the body if it is not chunked
+ */
+void divulge_body_reader_reset(divulge_body_reader_t* reader, bool is_chunked, size_t content_length);
+
+/**
+ * @brief Decode the next piece of input
+ * @param[in] reader pointer to the reader
+ * @param[in] input pointer to the input bytes
+ * @param[in] input_size number of input bytes
+ * @param[out] output destination of decoded bytes; it may be equal to input or point before it
+ * @param[out] consumed_size number of input bytes consumed; input after the body end is left untouched
+ * @param[out] output_size number of decoded bytes written to output
+ * @return status of the body after this piece
+ */
+divulge_body_reader_status_t divulge_body_reader_execute(divulge_body_reader_t* reader,
+                                                         const char* input,
+                                                         size_t input_size,
+                                                         char* output,
+                                                         size_t* consumed_size,
+                                                         size_t* output_size);
+
+/**
+ * @brief Check if the whole body was decoded
+ */
+bool divulge_body_reader_is_complete(const divulge_body_reader_t* reader);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_BODY_READER_H
@@ -0,0 +1,334 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-compression.h"
+#include <ctype.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encodings-deflate.h"
+
+#define HEADERS_MAX_COUNT (15)
+#define ADDED_HEADERS_COUNT (2)
+#define ETAG_MAX_SIZE (64)
+#define WEAK_ETAG_PREFIX "W/"
+
+typedef struct divulge_compression {
+    divulge_handler_object_t middleware;
+    size_t min_payload_size;
+} divulge_compression_t;
+
+typedef struct content_coding {
+    const char* name;
+    encodings_deflate_format_t format;
+} content_coding_t;
+
+typedef struct compressed_headers {
+    divulge_header_entry_t entries[HEADERS_MAX_COUNT + ADDED_HEADERS_COUNT];
+    char etag[ETAG_MAX_SIZE];
+} compressed_headers_t;
+
+typedef struct compressed_payload {
+    char* data;
+    size_t size;
+    size_t capacity;
+    bool is_overflowed;
+} compressed_payload_t;
+
+/* The deflate state is last so HEAD responses, which never send a body, can allocate only the headers. */
+typedef struct chunk_state {
+    divulge_request_t* request;
+    bool is_body_suppressed;
+    compressed_headers_t headers;
+    encodings_deflate_t deflate;
+} chunk_state_t;
+
+static const content_coding_t content_codings[] = {
+    {.name = "gzip", .format = ENCODINGS_DEFLATE_FORMAT_GZIP},
+    {.name = "deflate", .format = ENCODINGS_DEFLATE_FORMAT_ZLIB},
+};
+
+static const char* const compressible_content_types[] = {
+    "text/", "application/json", "application/javascript", "application/xml", "image/svg+xml",
+};
+
+static bool is_text_equal(const char* text, size_t length, const char* reference) {
+    size_t i = 0;
+    for (; (i < length) && reference[i]; i++) {
+        if (tolower((unsigned char)text[i]) != tolower((unsigned char)reference[i])) {
+            return false;
+        }
+    }
+    return (i == length) && !reference[i];
+}
+
+static bool has_prefix(const char* text, const char* prefix) {
+    for (; *prefix; text++, prefix++) {
+        if (tolower((unsigned char)*text) != *prefix) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_space(char character) {
+    return (character == ' ') || (character == '\t');
+}
+
+static bool is_zero_quality(const char* parameters, size_t length) {
+    for (size_t i = 0; (i + 1) < length; i++) {
+        if ((tolower((unsigned char)parameters[i]) == 'q') && (parameters[i + 1] == '=')) {
+            for (i += 2; i < length; i++) {
+                if ((parameters[i] != '0') && (parameters[i] != '.')) {
+                    return !isdigit((unsigned char)parameters[i]);
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool divulge_compression_is_accepted(divulge_request_t* request, const char* content_coding) {
+    if (!request || !content_coding) {
+        return false;
+    }
+    static_string_t value = divulge_get_request_header(request, "Accept-Encoding");
+    bool is_wildcard_accepted = false;
+    size_t position = 0;
+    while (position < value.length) {
+        while ((position < value.length) && (is_space(value.text[position]) || (value.text[position] == ','))) {
+            position++;
+        }
+        size_t start = position;
+        while ((position < value.length) && (value.text[position] != ',') && (value.text[position] != ';') &&
+               !is_space(value.text[position])) {
+            position++;
+        }
+        size_t token_length = position - start;
+        size_t parameters_start = position;
+        while ((position < value.length) && (value.text[position] != ',')) {
+            position++;
+        }
+        bool is_accepted = !is_zero_quality(value.text + parameters_start, position - parameters_start);
+        if (is_text_equal(value.text + start, token_length, content_coding)) {
+            return is_accepted;
+        } else if (is_text_equal(value.text + start, token_length, "*")) {
+            is_wildcard_accepted = is_accepted;
+        }
+    }
+    return is_wildcard_accepted;
+}
+
+static const content_coding_t* select_content_coding(divulge_request_t* request) {
+    for (size_t i = 0; i < (sizeof(content_codings) / sizeof(content_codings[0])); i++) {
+        if (divulge_compression_is_accepted(request, content_codings[i].name)) {
+            return content_codings + i;
+        }
+    }
+    return NULL;
+}
+
+static const char* find_header(const divulge_response_t* response, const char* key) {
+    for (size_t i = 0; response->header.entries && (i < response->header.count); i++) {
+        const divulge_header_entry_t* entry = response->header.entries + i;
+        if (entry->key && is_text_equal(entry->key, strlen(entry->key), key)) {
+            return entry->value ? entry->value : "";
+        }
+    }
+    return NULL;
+}
+
+static bool is_compressible(const divulge_response_t* response) {
+    int return_code = response->return_code;
+    if ((return_code < 200) || (return_code == 204) || (return_code == 206) || (return_code == 304) ||
+        (response->header.count > HEADERS_MAX_COUNT) || find_header(response, "Content-Encoding") ||
+        find_header(response, "Content-Range")) {
+        return false;
+    }
+    const char* content_type = find_header(response, "Content-Type");
+    if (!content_type) {
+        return true;
+    }
+    for (size_t i = 0; i < (sizeof(compressible_content_types) / sizeof(compressible_content_types[0])); i++) {
+        if (has_prefix(content_type, compressible_content_types[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* The compressed body is a different representation, so a strong entity tag of the original becomes weak. */
+static size_t create_headers(const divulge_response_t* response,
+                             const content_coding_t* coding,
+                             compressed_headers_t* headers) {
+    size_t count = 0;
+    for (size_t i = 0; response->header.entries && (i < response->header.count); i++) {
+        const divulge_header_entry_t* entry = response->header.entries + i;
+        size_t key_length = entry->key ? strlen(entry->key) : 0;
+        if (is_text_equal(entry->key, key_length, "Content-Length")) {
+            continue;
+        }
+        headers->entries[count] = *entry;
+        if (is_text_equal(entry->key, key_length, "ETag") && entry->value && (entry->value[0] == '"') &&
+            ((strlen(entry->value) + strlen(WEAK_ETAG_PREFIX)) < ETAG_MAX_SIZE)) {
+            strcpy(headers->etag, WEAK_ETAG_PREFIX);
+            strcat(headers->etag, entry->value);
+            headers->entries[count].value = headers->etag;
+        }
+        count++;
+    }
+    headers->entries[count++] = (divulge_header_entry_t){.key = "Content-Encoding", .value = coding->name};
+    headers->entries[count++] = (divulge_header_entry_t){.key = "Vary", .value = "Accept-Encoding"};
+    return count;
+}
+
+static void append_payload(void* context, const uint8_t* data, size_t data_size) {
+    compressed_payload_t* payload = (compressed_payload_t*)context;
+    if (payload->is_overflowed || (data_size > (payload->capacity - payload->size))) {
+        payload->is_overflowed = true;
+        return;
+    }
+    memcpy(payload->data + payload->size, data, data_size);
+    payload->size += data_size;
+}
+
+static bool compress_payload(const content_coding_t* coding,
+                             const divulge_response_t* response,
+                             compressed_payload_t* payload) {
+    encodings_deflate_t* deflate = malloc(sizeof(encodings_deflate_t));
+    payload->data = malloc(response->payload_size);
+    payload->capacity = response->payload_size;
+    if (!deflate || !payload->data) {
+        free(deflate);
+        free(payload->data);
+        return false;
+    }
+    encodings_deflate_initialize(deflate, coding->format, append_payload, payload);
+    encodings_deflate_update(deflate, response->payload, response->payload_size);
+    encodings_deflate_finalize(deflate);
+    free(deflate);
+    if (payload->is_overflowed) {
+        free(payload->data);
+        return false;
+    }
+    return true;
+}
+
+/* Bodies that do not shrink are sent as they are. */
+static bool response_filter(divulge_request_t* request, divulge_response_t* response, void* context) {
+    divulge_compression_t* compression = (divulge_compression_t*)context;
+    const content_coding_t* coding = select_content_coding(request);
+    compressed_payload_t payload = {.size = 0, .is_overflowed = false};
+    if (!coding || !response->payload || (response->payload_size == 0) ||
+        (response->payload_size < compression->min_payload_size) || !is_compressible(response) ||
+        !compress_payload(coding, response, &payload)) {
+        return true;
+    }
+    compressed_headers_t headers;
+    divulge_response_t compressed_response = {
+        .return_code = response->return_code,
+        .header = {.entries = headers.entries, .count = create_headers(response, coding, &headers)},
+        .payload = payload.data,
+        .payload_size = payload.size,
+    };
+    divulge_respond(request, &compressed_response);
+    free(payload.data);
+    return false;
+}
+
+static void send_compressed_chunk(void* context, const uint8_t* data, size_t data_size) {
+    chunk_state_t* state = (chunk_state_t*)context;
+    divulge_send_chunk(state->request, (const char*)data, data_size);
+}
+
+static void* begin_chunks(divulge_request_t* request, divulge_response_t* response, void* context) {
+    (void)context;
+    const content_coding_t* coding = select_content_coding(request);
+    if (!coding || !is_compressible(response)) {
+        return NULL;
+    }
+    bool is_body_suppressed = (request->method == DIVULGE_ROUTE_METHOD_HEAD);
+    chunk_state_t* state = malloc(is_body_suppressed ? offsetof(chunk_state_t, deflate) : sizeof(chunk_state_t));
+    if (!state) {
+        return NULL;
+    }
+    state->request = request;
+    state->is_body_suppressed = is_body_suppressed;
+    response->header.count = create_headers(response, coding, &state->headers);
+    response->header.entries = state->headers.entries;
+    if (!is_body_suppressed) {
+        encodings_deflate_initialize(&state->deflate, coding->format, send_compressed_chunk, state);
+    }
+    return state;
+}
+
+static bool write_chunk(divulge_request_t* request, const char* data, size_t data_size, void* state) {
+    (void)request;
+    encodings_deflate_update(&((chunk_state_t*)state)->deflate, data, data_size);
+    return true;
+}
+
+static void end_chunks(divulge_request_t* request, void* state) {
+    (void)request;
+    if (!((chunk_state_t*)state)->is_body_suppressed) {
+        encodings_deflate_finalize(&((chunk_state_t*)state)->deflate);
+    }
+    free(state);
+}
+
+static const divulge_chunk_filter_t chunk_filter = {
+    .begin = begin_chunks,
+    .write = write_chunk,
+    .end = end_chunks,
+};
+
+static bool middleware_handler(divulge_request_t* request, void* context) {
+    if (select_content_coding(request)) {
+        divulge_add_response_filter(request, response_filter, context);
+        divulge_set_chunk_filter(request, &chunk_filter, context);
+    }
+    return true;
+}
+
+divulge_compression_t* divulge_compression_create(size_t min_payload_size) {
+    divulge_compression_t* compression = calloc(1, sizeof(divulge_compression_t));
+    if (!compression) {
+        return NULL;
+    }
+    compression->min_payload_size = min_payload_size;
+    compression->middleware.handler = middleware_handler;
+    compression->middleware.context = compression;
+    return compression;
+}
+
+divulge_handler_object_t* divulge_compression_get_middleware(divulge_compression_t* compression) {
+    if (!compression) {
+        return NULL;
+    }
+    return &compression->middleware;
+}
+
+void divulge_compression_destroy(divulge_compression_t* compression) {
+    free(compression);
+}
@@ -0,0 +1,62 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_COMPRESSION_H
+#define DIVULGE_COMPRESSION_H
+
+#include "divulge.h"
+
+/**
+ * @defgroup divulge-compression Divulge compression
+ * @ingroup divulge
+ * @brief Middleware compressing response bodies with the `gzip` or `deflate` content coding
+ *
+ * Responses sent with divulge_respond() are compressed at once, chunked responses incrementally while the handler
+ * sends them. Only text-like content types are compressed, and only when the client accepts one of the codings.
+ * Every compressed response holds about 33 KiB of compression state while it is built. Placed after the response
+ * cache, the cache keeps uncompressed bodies; responses served from it are sent uncompressed.
+ * @{
+ */
+
+typedef struct divulge_compression divulge_compression_t;
+
+/**
+ * @brief Create compression middleware
+ * @param[in] min_payload_size responses sent with divulge_respond() smaller than this are sent uncompressed
+ * @return pointer to the middleware or NULL
+ */
+divulge_compression_t* divulge_compression_create(size_t min_payload_size);
+
+divulge_handler_object_t* divulge_compression_get_middleware(divulge_compression_t* compression);
+
+void divulge_compression_destroy(divulge_compression_t* compression);
+
+/**
+ * @brief Check if the Accept-Encoding request header allows the given content coding
+ */
+bool divulge_compression_is_accepted(divulge_request_t* request, const char* content_coding);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_COMPRESSION_H
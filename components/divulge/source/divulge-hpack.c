@@ -0,0 +1,644 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-hpack.h"
+#include <string.h>
+
+#define DIVULGE_HPACK_HUFFMAN_SYMBOL_COUNT (257)
+#define DIVULGE_HPACK_HUFFMAN_EOS (256)
+#define DIVULGE_HPACK_HUFFMAN_MAX_CODE_LENGTH (30)
+#define DIVULGE_HPACK_ENTRY_OVERHEAD (32)
+#define DIVULGE_HPACK_INTEGER_MAX_SHIFT (21)
+
+typedef struct static_table_entry {
+    const char* name;
+    const char* value;
+} static_table_entry_t;
+
+static const static_table_entry_t static_table[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+#define DIVULGE_HPACK_STATIC_TABLE_SIZE (sizeof(static_table) / sizeof(static_table[0]))
+
+/* Fields that change with almost every response and would only churn the dynamic table */
+static const char* const volatile_names[] = {
+    "content-length", "content-range", "date", "etag", "last-modified", "set-cookie",
+};
+
+static const uint32_t huffman_codes[DIVULGE_HPACK_HUFFMAN_SYMBOL_COUNT] = {
+    0x00001ff8, 0x007fffd8, 0x0fffffe2, 0x0fffffe3, 0x0fffffe4, 0x0fffffe5, 0x0fffffe6, 0x0fffffe7,
+    0x0fffffe8, 0x00ffffea, 0x3ffffffc, 0x0fffffe9, 0x0fffffea, 0x3ffffffd, 0x0fffffeb, 0x0fffffec,
+    0x0fffffed, 0x0fffffee, 0x0fffffef, 0x0ffffff0, 0x0ffffff1, 0x0ffffff2, 0x3ffffffe, 0x0ffffff3,
+    0x0ffffff4, 0x0ffffff5, 0x0ffffff6, 0x0ffffff7, 0x0ffffff8, 0x0ffffff9, 0x0ffffffa, 0x0ffffffb,
+    0x00000014, 0x000003f8, 0x000003f9, 0x00000ffa, 0x00001ff9, 0x00000015, 0x000000f8, 0x000007fa,
+    0x000003fa, 0x000003fb, 0x000000f9, 0x000007fb, 0x000000fa, 0x00000016, 0x00000017, 0x00000018,
+    0x00000000, 0x00000001, 0x00000002, 0x00000019, 0x0000001a, 0x0000001b, 0x0000001c, 0x0000001d,
+    0x0000001e, 0x0000001f, 0x0000005c, 0x000000fb, 0x00007ffc, 0x00000020, 0x00000ffb, 0x000003fc,
+    0x00001ffa, 0x00000021, 0x0000005d, 0x0000005e, 0x0000005f, 0x00000060, 0x00000061, 0x00000062,
+    0x00000063, 0x00000064, 0x00000065, 0x00000066, 0x00000067, 0x00000068, 0x00000069, 0x0000006a,
+    0x0000006b, 0x0000006c, 0x0000006d, 0x0000006e, 0x0000006f, 0x00000070, 0x00000071, 0x00000072,
+    0x000000fc, 0x00000073, 0x000000fd, 0x00001ffb, 0x0007fff0, 0x00001ffc, 0x00003ffc, 0x00000022,
+    0x00007ffd, 0x00000003, 0x00000023, 0x00000004, 0x00000024, 0x00000005, 0x00000025, 0x00000026,
+    0x00000027, 0x00000006, 0x00000074, 0x00000075, 0x00000028, 0x00000029, 0x0000002a, 0x00000007,
+    0x0000002b, 0x00000076, 0x0000002c, 0x00000008, 0x00000009, 0x0000002d, 0x00000077, 0x00000078,
+    0x00000079, 0x0000007a, 0x0000007b, 0x00007ffe, 0x000007fc, 0x00003ffd, 0x00001ffd, 0x0ffffffc,
+    0x000fffe6, 0x003fffd2, 0x000fffe7, 0x000fffe8, 0x003fffd3, 0x003fffd4, 0x003fffd5, 0x007fffd9,
+    0x003fffd6, 0x007fffda, 0x007fffdb, 0x007fffdc, 0x007fffdd, 0x007fffde, 0x00ffffeb, 0x007fffdf,
+    0x00ffffec, 0x00ffffed, 0x003fffd7, 0x007fffe0, 0x00ffffee, 0x007fffe1, 0x007fffe2, 0x007fffe3,
+    0x007fffe4, 0x001fffdc, 0x003fffd8, 0x007fffe5, 0x003fffd9, 0x007fffe6, 0x007fffe7, 0x00ffffef,
+    0x003fffda, 0x001fffdd, 0x000fffe9, 0x003fffdb, 0x003fffdc, 0x007fffe8, 0x007fffe9, 0x001fffde,
+    0x007fffea, 0x003fffdd, 0x003fffde, 0x00fffff0, 0x001fffdf, 0x003fffdf, 0x007fffeb, 0x007fffec,
+    0x001fffe0, 0x001fffe1, 0x003fffe0, 0x001fffe2, 0x007fffed, 0x003fffe1, 0x007fffee, 0x007fffef,
+    0x000fffea, 0x003fffe2, 0x003fffe3, 0x003fffe4, 0x007ffff0, 0x003fffe5, 0x003fffe6, 0x007ffff1,
+    0x03ffffe0, 0x03ffffe1, 0x000fffeb, 0x0007fff1, 0x003fffe7, 0x007ffff2, 0x003fffe8, 0x01ffffec,
+    0x03ffffe2, 0x03ffffe3, 0x03ffffe4, 0x07ffffde, 0x07ffffdf, 0x03ffffe5, 0x00fffff1, 0x01ffffed,
+    0x0007fff2, 0x001fffe3, 0x03ffffe6, 0x07ffffe0, 0x07ffffe1, 0x03ffffe7, 0x07ffffe2, 0x00fffff2,
+    0x001fffe4, 0x001fffe5, 0x03ffffe8, 0x03ffffe9, 0x0ffffffd, 0x07ffffe3, 0x07ffffe4, 0x07ffffe5,
+    0x000fffec, 0x00fffff3, 0x000fffed, 0x001fffe6, 0x003fffe9, 0x001fffe7, 0x001fffe8, 0x007ffff3,
+    0x003fffea, 0x003fffeb, 0x01ffffee, 0x01ffffef, 0x00fffff4, 0x00fffff5, 0x03ffffea, 0x007ffff4,
+    0x03ffffeb, 0x07ffffe6, 0x03ffffec, 0x03ffffed, 0x07ffffe7, 0x07ffffe8, 0x07ffffe9, 0x07ffffea,
+    0x07ffffeb, 0x0ffffffe, 0x07ffffec, 0x07ffffed, 0x07ffffee, 0x07ffffef, 0x07fffff0, 0x03ffffee,
+    0x3fffffff,
+};
+
+static const uint8_t huffman_lengths[DIVULGE_HPACK_HUFFMAN_SYMBOL_COUNT] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+static const uint16_t huffman_length_counts[DIVULGE_HPACK_HUFFMAN_MAX_CODE_LENGTH + 1] = {
+    0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3,
+    0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4,
+};
+
+static const uint16_t huffman_sorted_symbols[DIVULGE_HPACK_HUFFMAN_SYMBOL_COUNT] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37, 45, 46, 47, 51,
+    52, 53, 54, 55, 56, 57, 61, 65, 95, 98, 100, 102, 103, 104, 108, 109,
+    110, 112, 114, 117, 58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89, 106, 107, 113, 118,
+    119, 120, 121, 122, 38, 42, 44, 59, 88, 90, 33, 34, 40, 41, 63, 39,
+    43, 124, 35, 62, 0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+    179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+    163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+    158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239, 9, 142,
+    144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+    212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+    2, 3, 4, 5, 6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220, 249, 10, 13, 22,
+    256,
+};
+
+static void table_initialize(divulge_hpack_table_t* table) {
+    table->entry_count = 0;
+    table->data_size = 0;
+    table->size = 0;
+    table->max_size = DIVULGE_HPACK_DEFAULT_TABLE_SIZE;
+}
+
+static void table_evict_oldest(divulge_hpack_table_t* table) {
+    const divulge_hpack_table_entry_t* oldest = table->entries;
+    size_t length = (size_t)oldest->name_length + oldest->value_length;
+    table->size -= length + DIVULGE_HPACK_ENTRY_OVERHEAD;
+    table->data_size -= length;
+    memmove(table->data, table->data + length, table->data_size);
+    table->entry_count--;
+    for (size_t i = 0; i < table->entry_count; i++) {
+        table->entries[i] = table->entries[i + 1];
+        table->entries[i].offset -= (uint16_t)length;
+    }
+}
+
+static void table_set_max_size(divulge_hpack_table_t* table, size_t max_size) {
+    table->max_size = max_size;
+    while (table->size > table->max_size) {
+        table_evict_oldest(table);
+    }
+}
+
+static void table_insert(divulge_hpack_table_t* table,
+                         const char* name,
+                         size_t name_length,
+                         const char* value,
+                         size_t value_length) {
+    size_t entry_size = name_length + value_length + DIVULGE_HPACK_ENTRY_OVERHEAD;
+    while ((table->entry_count > 0) && ((table->size + entry_size) > table->max_size)) {
+        table_evict_oldest(table);
+    }
+    if (entry_size > table->max_size) {
+        return;
+    }
+    divulge_hpack_table_entry_t* entry = table->entries + table->entry_count++;
+    entry->offset = (uint16_t)table->data_size;
+    entry->name_length = (uint16_t)name_length;
+    entry->value_length = (uint16_t)value_length;
+    memcpy(table->data + table->data_size, name, name_length);
+    memcpy(table->data + table->data_size + name_length, value, value_length);
+    table->data_size += name_length + value_length;
+    table->size += entry_size;
+}
+
+static bool table_get(const divulge_hpack_table_t* table,
+                      size_t index,
+                      const char** name,
+                      size_t* name_length,
+                      const char** value,
+                      size_t* value_length) {
+    if (index == 0) {
+        return false;
+    } else if (index <= DIVULGE_HPACK_STATIC_TABLE_SIZE) {
+        const static_table_entry_t* entry = static_table + index - 1;
+        *name = entry->name;
+        *name_length = strlen(entry->name);
+        *value = entry->value;
+        *value_length = strlen(entry->value);
+        return true;
+    }
+    size_t dynamic_index = index - DIVULGE_HPACK_STATIC_TABLE_SIZE - 1;
+    if (dynamic_index >= table->entry_count) {
+        return false;
+    }
+    const divulge_hpack_table_entry_t* entry = table->entries + (table->entry_count - 1 - dynamic_index);
+    *name = table->data + entry->offset;
+    *name_length = entry->name_length;
+    *value = table->data + entry->offset + entry->name_length;
+    *value_length = entry->value_length;
+    return true;
+}
+
+static bool is_equal(const char* text, size_t length, const char* reference, size_t reference_length) {
+    return (length == reference_length) && (memcmp(text, reference, length) == 0);
+}
+
+static size_t table_find(const divulge_hpack_table_t* table,
+                         const char* name,
+                         size_t name_length,
+                         const char* value,
+                         size_t value_length,
+                         bool* is_value_matched) {
+    size_t name_index = 0;
+    *is_value_matched = false;
+    for (size_t i = 0; i < DIVULGE_HPACK_STATIC_TABLE_SIZE; i++) {
+        const static_table_entry_t* entry = static_table + i;
+        if (is_equal(name, name_length, entry->name, strlen(entry->name))) {
+            if (is_equal(value, value_length, entry->value, strlen(entry->value))) {
+                *is_value_matched = true;
+                return i + 1;
+            } else if (name_index == 0) {
+                name_index = i + 1;
+            }
+        }
+    }
+    for (size_t i = 0; i < table->entry_count; i++) {
+        const divulge_hpack_table_entry_t* entry = table->entries + (table->entry_count - 1 - i);
+        const char* entry_name = table->data + entry->offset;
+        if (is_equal(name, name_length, entry_name, entry->name_length)) {
+            if (is_equal(value, value_length, entry_name + entry->name_length, entry->value_length)) {
+                *is_value_matched = true;
+                return DIVULGE_HPACK_STATIC_TABLE_SIZE + i + 1;
+            } else if (name_index == 0) {
+                name_index = DIVULGE_HPACK_STATIC_TABLE_SIZE + i + 1;
+            }
+        }
+    }
+    return name_index;
+}
+
+static bool decode_integer(const uint8_t* data, size_t size, size_t* position, unsigned prefix_bits, size_t* value) {
+    size_t prefix_mask = ((size_t)1 << prefix_bits) - 1;
+    *value = data[(*position)++] & prefix_mask;
+    if (*value < prefix_mask) {
+        return true;
+    }
+    for (unsigned shift = 0; (*position < size) && (shift <= DIVULGE_HPACK_INTEGER_MAX_SHIFT); shift += 7) {
+        uint8_t byte = data[(*position)++];
+        *value += (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t encode_integer(uint8_t* output, size_t output_size, uint8_t flags, unsigned prefix_bits, size_t value) {
+    size_t prefix_mask = ((size_t)1 << prefix_bits) - 1;
+    if (output_size == 0) {
+        return 0;
+    }
+    if (value < prefix_mask) {
+        output[0] = flags | (uint8_t)value;
+        return 1;
+    }
+    output[0] = flags | (uint8_t)prefix_mask;
+    value -= prefix_mask;
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7) {
+        if (size >= output_size) {
+            return 0;
+        }
+        output[size++] = (uint8_t)(0x80 | (value & 0x7F));
+    }
+    if (size >= output_size) {
+        return 0;
+    }
+    output[size++] = (uint8_t)value;
+    return size;
+}
+
+size_t divulge_hpack_huffman_encoded_size(const char* data, size_t data_size) {
+    size_t bit_count = 0;
+    for (size_t i = 0; data && (i < data_size); i++) {
+        bit_count += huffman_lengths[(uint8_t)data[i]];
+    }
+    return (bit_count + 7) / 8;
+}
+
+size_t divulge_hpack_huffman_encode(const char* data, size_t data_size, uint8_t* output, size_t output_size) {
+    if (!data || !output || (divulge_hpack_huffman_encoded_size(data, data_size) > output_size)) {
+        return 0;
+    }
+    uint64_t bits = 0;
+    unsigned bit_count = 0;
+    size_t size = 0;
+    for (size_t i = 0; i < data_size; i++) {
+        uint8_t symbol = (uint8_t)data[i];
+        bits = (bits << huffman_lengths[symbol]) | huffman_codes[symbol];
+        bit_count += huffman_lengths[symbol];
+        while (bit_count >= 8) {
+            bit_count -= 8;
+            output[size++] = (uint8_t)(bits >> bit_count);
+        }
+    }
+    if (bit_count > 0) {
+        output[size++] = (uint8_t)((bits << (8 - bit_count)) | (0xFFu >> bit_count));
+    }
+    return size;
+}
+
+bool divulge_hpack_huffman_decode(const uint8_t* data,
+                                  size_t data_size,
+                                  char* output,
+                                  size_t output_size,
+                                  size_t* decoded_size) {
+    if (!data || !output || !decoded_size) {
+        return false;
+    }
+    size_t size = 0;
+    unsigned length = 0;
+    uint32_t code = 0;
+    uint32_t first = 0;
+    uint32_t index = 0;
+    uint32_t pending_bits = 0;
+    for (size_t i = 0; i < data_size; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            uint32_t value = (data[i] >> bit) & 1u;
+            code |= value;
+            pending_bits = (pending_bits << 1) | value;
+            length++;
+            uint32_t count = huffman_length_counts[length];
+            if ((code - first) < count) {
+                uint16_t symbol = huffman_sorted_symbols[index + (code - first)];
+                if ((symbol == DIVULGE_HPACK_HUFFMAN_EOS) || (size >= output_size)) {
+                    return false;
+                }
+                output[size++] = (char)symbol;
+                length = 0;
+                code = 0;
+                first = 0;
+                index = 0;
+                pending_bits = 0;
+            } else if (length >= DIVULGE_HPACK_HUFFMAN_MAX_CODE_LENGTH) {
+                return false;
+            } else {
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+        }
+    }
+    if ((length > 7) || (pending_bits != ((1u << length) - 1))) {
+        return false;
+    }
+    *decoded_size = size;
+    return true;
+}
+
+static bool decode_string(const uint8_t* block,
+                          size_t block_size,
+                          size_t* position,
+                          char* output,
+                          size_t output_size,
+                          size_t* length) {
+    if (*position >= block_size) {
+        return false;
+    }
+    bool is_huffman_coded = (block[*position] & 0x80) != 0;
+    size_t size = 0;
+    if (!decode_integer(block, block_size, position, 7, &size) || (size > (block_size - *position))) {
+        return false;
+    }
+    const uint8_t* data = block + *position;
+    *position += size;
+    if (is_huffman_coded) {
+        return divulge_hpack_huffman_decode(data, size, output, output_size, length);
+    } else if (size > output_size) {
+        return false;
+    }
+    memcpy(output, data, size);
+    *length = size;
+    return true;
+}
+
+static bool decode_literal(divulge_hpack_decoder_t* decoder,
+                           const uint8_t* block,
+                           size_t block_size,
+                           size_t* position,
+                           unsigned prefix_bits,
+                           bool is_indexed,
+                           divulge_hpack_header_callback_t callback,
+                           void* context) {
+    size_t name_index = 0;
+    if (!decode_integer(block, block_size, position, prefix_bits, &name_index)) {
+        return false;
+    }
+    char* name = decoder->strings;
+    size_t name_length = 0;
+    if (name_index > 0) {
+        const char* table_name;
+        const char* table_value;
+        size_t table_value_length;
+        if (!table_get(&decoder->table, name_index, &table_name, &name_length, &table_value, &table_value_length)) {
+            return false;
+        }
+        memcpy(name, table_name, name_length);
+    } else if (!decode_string(block, block_size, position, name, sizeof(decoder->strings), &name_length)) {
+        return false;
+    }
+    char* value = name + name_length;
+    size_t value_length = 0;
+    if (!decode_string(block, block_size, position, value, sizeof(decoder->strings) - name_length, &value_length)) {
+        return false;
+    }
+    if (is_indexed) {
+        table_insert(&decoder->table, name, name_length, value, value_length);
+    }
+    callback(context, name, name_length, value, value_length);
+    return true;
+}
+
+void divulge_hpack_decoder_initialize(divulge_hpack_decoder_t* decoder) {
+    if (decoder) {
+        table_initialize(&decoder->table);
+    }
+}
+
+bool divulge_hpack_decode(divulge_hpack_decoder_t* decoder,
+                          const uint8_t* block,
+                          size_t block_size,
+                          divulge_hpack_header_callback_t callback,
+                          void* context) {
+    if (!decoder || (!block && (block_size > 0)) || !callback) {
+        return false;
+    }
+    size_t position = 0;
+    bool is_field_decoded = false;
+    while (position < block_size) {
+        uint8_t byte = block[position];
+        if (byte & 0x80) {
+            size_t index = 0;
+            const char* name;
+            const char* value;
+            size_t name_length;
+            size_t value_length;
+            if (!decode_integer(block, block_size, &position, 7, &index) ||
+                !table_get(&decoder->table, index, &name, &name_length, &value, &value_length)) {
+                return false;
+            }
+            callback(context, name, name_length, value, value_length);
+            is_field_decoded = true;
+        } else if ((byte & 0xC0) == 0x40) {
+            if (!decode_literal(decoder, block, block_size, &position, 6, true, callback, context)) {
+                return false;
+            }
+            is_field_decoded = true;
+        } else if ((byte & 0xE0) == 0x20) {
+            size_t max_size = 0;
+            if (is_field_decoded || !decode_integer(block, block_size, &position, 5, &max_size) ||
+                (max_size > DIVULGE_HPACK_DEFAULT_TABLE_SIZE)) {
+                return false;
+            }
+            table_set_max_size(&decoder->table, max_size);
+        } else {
+            if (!decode_literal(decoder, block, block_size, &position, 4, false, callback, context)) {
+                return false;
+            }
+            is_field_decoded = true;
+        }
+    }
+    return true;
+}
+
+void divulge_hpack_encoder_initialize(divulge_hpack_encoder_t* encoder) {
+    if (!encoder) {
+        return;
+    }
+    table_initialize(&encoder->table);
+    encoder->pending_min_table_size = DIVULGE_HPACK_DEFAULT_TABLE_SIZE;
+    encoder->is_table_size_update_pending = false;
+}
+
+void divulge_hpack_encoder_set_max_table_size(divulge_hpack_encoder_t* encoder, size_t max_table_size) {
+    if (!encoder) {
+        return;
+    }
+    if (max_table_size > DIVULGE_HPACK_DEFAULT_TABLE_SIZE) {
+        max_table_size = DIVULGE_HPACK_DEFAULT_TABLE_SIZE;
+    }
+    if (!encoder->is_table_size_update_pending || (max_table_size < encoder->pending_min_table_size)) {
+        encoder->pending_min_table_size = max_table_size;
+    }
+    encoder->is_table_size_update_pending = true;
+    table_set_max_size(&encoder->table, max_table_size);
+}
+
+static size_t encode_table_size_update(divulge_hpack_encoder_t* encoder, uint8_t* output, size_t output_size) {
+    size_t size = 0;
+    if (encoder->pending_min_table_size < encoder->table.max_size) {
+        size = encode_integer(output, output_size, 0x20, 5, encoder->pending_min_table_size);
+        if (size == 0) {
+            return 0;
+        }
+    }
+    size_t final_size = encode_integer(output + size, output_size - size, 0x20, 5, encoder->table.max_size);
+    return (final_size == 0) ? 0 : (size + final_size);
+}
+
+static size_t encode_string(const char* text, size_t length, uint8_t* output, size_t output_size) {
+    size_t huffman_size = divulge_hpack_huffman_encoded_size(text, length);
+    bool is_huffman_coded = huffman_size < length;
+    size_t encoded_size = is_huffman_coded ? huffman_size : length;
+    size_t size = encode_integer(output, output_size, is_huffman_coded ? 0x80 : 0x00, 7, encoded_size);
+    if ((size == 0) || (encoded_size > (output_size - size))) {
+        return 0;
+    }
+    if (is_huffman_coded) {
+        divulge_hpack_huffman_encode(text, length, output + size, output_size - size);
+    } else {
+        memcpy(output + size, text, length);
+    }
+    return size + encoded_size;
+}
+
+static bool is_volatile_name(const char* name, size_t name_length) {
+    for (size_t i = 0; i < (sizeof(volatile_names) / sizeof(volatile_names[0])); i++) {
+        if (is_equal(name, name_length, volatile_names[i], strlen(volatile_names[i]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t divulge_hpack_encode(divulge_hpack_encoder_t* encoder,
+                            const char* name,
+                            size_t name_length,
+                            const char* value,
+                            size_t value_length,
+                            uint8_t* output,
+                            size_t output_size) {
+    if (!encoder || !name || !value || !output) {
+        return 0;
+    }
+    size_t size = 0;
+    if (encoder->is_table_size_update_pending) {
+        size = encode_table_size_update(encoder, output, output_size);
+        if (size == 0) {
+            return 0;
+        }
+    }
+    bool is_value_matched = false;
+    size_t index = table_find(&encoder->table, name, name_length, value, value_length, &is_value_matched);
+    bool is_indexed = !is_value_matched && !is_volatile_name(name, name_length);
+    size_t field_size = 0;
+    if (is_value_matched) {
+        field_size = encode_integer(output + size, output_size - size, 0x80, 7, index);
+    } else {
+        field_size = is_indexed ? encode_integer(output + size, output_size - size, 0x40, 6, index)
+                                : encode_integer(output + size, output_size - size, 0x00, 4, index);
+        if ((field_size > 0) && (index == 0)) {
+            size_t name_size = encode_string(name, name_length, output + size + field_size,
+                                             output_size - size - field_size);
+            field_size = (name_size == 0) ? 0 : (field_size + name_size);
+        }
+        if (field_size > 0) {
+            size_t value_size = encode_string(value, value_length, output + size + field_size,
+                                              output_size - size - field_size);
+            field_size = (value_size == 0) ? 0 : (field_size + value_size);
+        }
+    }
+    if (field_size == 0) {
+        return 0;
+    }
+    encoder->is_table_size_update_pending = false;
+    if (is_indexed) {
+        table_insert(&encoder->table, name, name_length, value, value_length);
+    }
+    return size + field_size;
+}
@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_HPACK_H
+#define DIVULGE_HPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup divulge-hpack Divulge HPACK
+ * @ingroup divulge
+ * @brief HTTP/2 header compression (RFC 7541)
+ *
+ * The decoder and the encoder each keep their own dynamic table, bounded by the protocol default of 4096 bytes.
+ * Header names passed to the encoder have to be lowercase already.
+ * @{
+ */
+
+#define DIVULGE_HPACK_DEFAULT_TABLE_SIZE (4096)
+#define DIVULGE_HPACK_TABLE_MAX_ENTRY_COUNT (DIVULGE_HPACK_DEFAULT_TABLE_SIZE / 32)
+#define DIVULGE_HPACK_STRING_MAX_SIZE (4096)
+
+typedef struct divulge_hpack_table_entry {
+    uint16_t offset;
+    uint16_t name_length;
+    uint16_t value_length;
+} divulge_hpack_table_entry_t;
+
+typedef struct divulge_hpack_table {
+    char data[DIVULGE_HPACK_DEFAULT_TABLE_SIZE];
+    divulge_hpack_table_entry_t entries[DIVULGE_HPACK_TABLE_MAX_ENTRY_COUNT]; /**< @brief oldest entry first */
+    size_t entry_count;
+    size_t data_size;
+    size_t size; /**< @brief size as defined by the RFC: names, values and 32 bytes per entry */
+    size_t max_size;
+} divulge_hpack_table_t;
+
+typedef struct divulge_hpack_decoder {
+    divulge_hpack_table_t table;
+    char strings[DIVULGE_HPACK_STRING_MAX_SIZE]; /**< @brief decoded name and value of the current field */
+} divulge_hpack_decoder_t;
+
+typedef struct divulge_hpack_encoder {
+    divulge_hpack_table_t table;
+    size_t pending_min_table_size;
+    bool is_table_size_update_pending;
+} divulge_hpack_encoder_t;
+
+typedef void (*divulge_hpack_header_callback_t)(void* context,
+                                                const char* name,
+                                                size_t name_length,
+                                                const char* value,
+                                                size_t value_length);
+
+/**
+ * @brief Prepare a decoder with an empty table of the default size
+ */
+void divulge_hpack_decoder_initialize(divulge_hpack_decoder_t* decoder);
+
+/**
+ * @brief Decode a complete header block
+ *
+ * Every field is reported in order; the strings are valid only during the callback. Decoding continues past fields
+ * the caller rejects, since the dynamic table has to stay in sync with the peer.
+ * @param[in] decoder pointer to the decoder
+ * @param[in] block header block, i.e. HEADERS and CONTINUATION fragments joined together
+ * @param[in] block_size size of the block
+ * @param[in] callback called for every decoded field
+ * @param[in] context passed to the callback
+ * @return false on a compression error, after which the connection cannot be used anymore
+ */
+bool divulge_hpack_decode(divulge_hpack_decoder_t* decoder,
+                          const uint8_t* block,
+                          size_t block_size,
+                          divulge_hpack_header_callback_t callback,
+                          void* context);
+
+/**
+ * @brief Prepare an encoder with an empty table of the default size
+ */
+void divulge_hpack_encoder_initialize(divulge_hpack_encoder_t* encoder);
+
+/**
+ * @brief Apply the table size announced by the peer in SETTINGS_HEADER_TABLE_SIZE
+ *
+ * Sizes above the default are capped; the change is signalled at the start of the next encoded field.
+ */
+void divulge_hpack_encoder_set_max_table_size(divulge_hpack_encoder_t* encoder, size_t max_table_size);
+
+/**
+ * @brief Append one field to a header block
+ * @param[in] encoder pointer to the encoder
+ * @param[in] name lowercase field name
+ * @param[in] name_length length of the name
+ * @param[in] value field value
+ * @param[in] value_length length of the value
+ * @param[out] output destination of the encoded field
+ * @param[in] output_size space left in the destination
+ * @return size of the encoded field or 0 if it does not fit, in which case the encoder state is unchanged
+ */
+size_t divulge_hpack_encode(divulge_hpack_encoder_t* encoder,
+                            const char* name,
+                            size_t name_length,
+                            const char* value,
+                            size_t value_length,
+                            uint8_t* output,
+                            size_t output_size);
+
+/**
+ * @brief Size of a string after Huffman coding
+ */
+size_t divulge_hpack_huffman_encoded_size(const char* data, size_t data_size);
+
+/**
+ * @brief Huffman-code a string
+ * @return size of the coded string or 0 if it does not fit
+ */
+size_t divulge_hpack_huffman_encode(const char* data, size_t data_size, uint8_t* output, size_t output_size);
+
+/**
+ * @brief Decode a Huffman-coded string
+ * @param[in] data coded string
+ * @param[in] data_size size of the coded string
+ * @param[out] output destination of the decoded string
+ * @param[in] output_size size of the destination
+ * @param[out] decoded_size size of the decoded string
+ * @return false if the string is malformed or does not fit
+ */
+bool divulge_hpack_huffman_decode(const uint8_t* data,
+                                  size_t data_size,
+                                  char* output,
+                                  size_t output_size,
+                                  size_t* decoded_size);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_HPACK_H
@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-html-render.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+static bool is_content_type(const char* key) {
+    const char* reference = "content-type";
+    for (; *key && *reference; key++, reference++) {
+        if (tolower((unsigned char)*key) != *reference) {
+            return false;
+        }
+    }
+    return !*key && !*reference;
+}
+
+typedef struct render_output {
+    divulge_request_t* request;
+    bool has_length;
+    size_t remaining_size;
+} render_output_t;
+
+static bool send_rendered_data(void* context, const char* data, size_t data_size) {
+    render_output_t* output = (render_output_t*)context;
+    if (output->has_length) {
+        if (data_size > output->remaining_size) {
+            data_size = output->remaining_size;
+        }
+        output->remaining_size -= data_size;
+    }
+    return divulge_send_chunk(output->request, data, data_size);
+}
+
+/*
+ * Entry callbacks run twice when the length is precomputed. Should the second pass render a different size, the
+ * body is cut or padded with spaces so that it still matches the announced Content-Length.
+ */
+static bool pad_rendered_data(render_output_t* output) {
+    static const char padding[32] = "                                ";
+    while (output->has_length && (output->remaining_size > 0)) {
+        size_t size = (output->remaining_size < sizeof(padding)) ? output->remaining_size : sizeof(padding);
+        if (!send_rendered_data(output, padding, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool divulge_html_render_respond(divulge_request_t* request,
+                                 divulge_response_t* response,
+                                 g2l_html_render_page_t* page,
+                                 divulge_html_render_mode_t mode) {
+    if (!request || !response || !page ||
+        (response->header.count > DIVULGE_HTML_RENDER_HEADER_ENTRIES_MAX_COUNT) ||
+        (response->header.count && !response->header.entries)) {
+        return false;
+    }
+    divulge_header_entry_t header_entries[DIVULGE_HTML_RENDER_HEADER_ENTRIES_MAX_COUNT + 2];
+    size_t header_count = 0;
+    bool has_content_type = false;
+    for (size_t i = 0; i < response->header.count; i++) {
+        has_content_type |= is_content_type(response->header.entries[i].key);
+        header_entries[header_count++] = response->header.entries[i];
+    }
+    if (!has_content_type) {
+        header_entries[header_count++] = (divulge_header_entry_t){.key = "Content-Type", .value = "text/html"};
+    }
+    char content_length[24];
+    render_output_t output = {
+        .request = request,
+        .has_length = (mode == DIVULGE_HTML_RENDER_MODE_CONTENT_LENGTH),
+    };
+    if (output.has_length) {
+        output.remaining_size = g2l_html_render_get_page_size(page);
+        snprintf(content_length, sizeof(content_length), "%zu", output.remaining_size);
+        header_entries[header_count++] = (divulge_header_entry_t){.key = "Content-Length", .value = content_length};
+    }
+    divulge_response_t rendered_response = {
+        .return_code = response->return_code,
+        .header = {.count = header_count, .entries = header_entries},
+    };
+    if (!divulge_begin_chunked_response(request, &rendered_response)) {
+        return false;
+    }
+    bool result = true;
+    if (request->method != DIVULGE_ROUTE_METHOD_HEAD) {
+        result = g2l_html_render_page_stream(page, send_rendered_data, &output) && pad_rendered_data(&output);
+    }
+    return divulge_end_chunked_response(request) && result;
+}
@@ -0,0 +1,42 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_HTML_RENDER_H
+#define DIVULGE_HTML_RENDER_H
+
+#include "divulge.h"
+#include "g2l-html-render.h"
+
+#define DIVULGE_HTML_RENDER_HEADER_ENTRIES_MAX_COUNT (8)
+
+typedef enum divulge_html_render_mode {
+    DIVULGE_HTML_RENDER_MODE_CHUNKED,
+    DIVULGE_HTML_RENDER_MODE_CONTENT_LENGTH,
+} divulge_html_render_mode_t;
+
+bool divulge_html_render_respond(divulge_request_t* request,
+                                 divulge_response_t* response,
+                                 g2l_html_render_page_t* page,
+                                 divulge_html_render_mode_t mode);
+
+#endif  // DIVULGE_HTML_RENDER_H
@@ -0,0 +1,1178 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-http2.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "divulge-hpack.h"
+#include "encodings-base64.h"
+
+#define TAG "divulge-http2"
+#include "g2l-log.h"
+
+#define PREFACE_SIZE (sizeof(DIVULGE_HTTP2_PREFACE) - 1)
+#define PREFACE_REQUEST_LINE_SIZE (sizeof("PRI * HTTP/2.0\r\n") - 1)
+#define INPUT_BUFFER_SIZE (DIVULGE_HTTP2_FRAME_HEADER_SIZE + DIVULGE_HTTP2_MAX_FRAME_SIZE)
+#define DEFAULT_WINDOW_SIZE (65535)
+#define MAX_WINDOW_SIZE (0x7FFFFFFF)
+#define MAX_PEER_FRAME_SIZE (0xFFFFFF)
+#define STREAM_ID_MASK (0x7FFFFFFFu)
+#define SETTING_SIZE (6)
+#define UPGRADE_SETTINGS_MAX_LENGTH (256)
+#define BODY_OFFSET (sizeof("Content-Length: 18446744073709551615\r\n\r\n"))
+#define REQUEST_LINE_SUFFIX " HTTP/1.1\r\n"
+#define RESPONSE_STATUS_OFFSET (sizeof("HTTP/1.1 ") - 1)
+#define RESPONSE_STATUS_SIZE (3)
+
+typedef enum frame_type {
+    FRAME_TYPE_DATA = 0x0,
+    FRAME_TYPE_HEADERS = 0x1,
+    FRAME_TYPE_PRIORITY = 0x2,
+    FRAME_TYPE_RST_STREAM = 0x3,
+    FRAME_TYPE_SETTINGS = 0x4,
+    FRAME_TYPE_PUSH_PROMISE = 0x5,
+    FRAME_TYPE_PING = 0x6,
+    FRAME_TYPE_GOAWAY = 0x7,
+    FRAME_TYPE_WINDOW_UPDATE = 0x8,
+    FRAME_TYPE_CONTINUATION = 0x9,
+} frame_type_t;
+
+#define FLAG_END_STREAM (0x01)
+#define FLAG_ACK (0x01)
+#define FLAG_END_HEADERS (0x04)
+#define FLAG_PADDED (0x08)
+#define FLAG_PRIORITY (0x20)
+
+typedef enum error_code {
+    ERROR_CODE_NO_ERROR = 0x0,
+    ERROR_CODE_PROTOCOL_ERROR = 0x1,
+    ERROR_CODE_INTERNAL_ERROR = 0x2,
+    ERROR_CODE_FLOW_CONTROL_ERROR = 0x3,
+    ERROR_CODE_STREAM_CLOSED = 0x5,
+    ERROR_CODE_FRAME_SIZE_ERROR = 0x6,
+    ERROR_CODE_REFUSED_STREAM = 0x7,
+    ERROR_CODE_COMPRESSION_ERROR = 0x9,
+    ERROR_CODE_ENHANCE_YOUR_CALM = 0xB,
+    ERROR_CODE_HTTP_1_1_REQUIRED = 0xD,
+} error_code_t;
+
+typedef enum setting {
+    SETTING_HEADER_TABLE_SIZE = 0x1,
+    SETTING_ENABLE_PUSH = 0x2,
+    SETTING_MAX_CONCURRENT_STREAMS = 0x3,
+    SETTING_INITIAL_WINDOW_SIZE = 0x4,
+    SETTING_MAX_FRAME_SIZE = 0x5,
+    SETTING_MAX_HEADER_LIST_SIZE = 0x6,
+} setting_t;
+
+typedef enum stream_state {
+    STREAM_STATE_CLOSED,
+    STREAM_STATE_OPEN,
+    STREAM_STATE_READY,
+    STREAM_STATE_RESPONDING,
+} stream_state_t;
+
+typedef struct frame_header {
+    uint32_t length;
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream_id;
+} frame_header_t;
+
+typedef struct pseudo_header {
+    size_t offset;
+    size_t length;
+    bool is_set;
+} pseudo_header_t;
+
+struct divulge_http2_stream {
+    divulge_http2_connection_t* connection;
+    uint32_t id;
+    stream_state_t state;
+    char* buffer;
+    size_t head_size;
+    size_t body_size;
+    size_t request_size;
+    size_t pseudo_size; /**< @brief pseudo-header values kept at the end of the buffer until the request line */
+    pseudo_header_t method;
+    pseudo_header_t scheme;
+    pseudo_header_t path;
+    pseudo_header_t authority;
+    size_t content_length;
+    bool has_content_length;
+    bool is_request_line_written;
+    bool is_malformed;
+    int error_status;
+    bool is_reset;
+    bool is_http1_required;
+    int64_t send_window;
+};
+
+typedef struct response_state {
+    char head[DIVULGE_HTTP2_RESPONSE_HEAD_MAX_SIZE];
+    size_t head_size;
+    bool is_head_complete;
+    bool are_headers_sent;
+    size_t content_length;
+    bool has_content_length;
+    size_t body_size;
+} response_state_t;
+
+struct divulge_http2_connection {
+    divulge_http2_configuration_t configuration;
+    divulge_http2_stream_t* streams;
+    divulge_hpack_decoder_t decoder;
+    divulge_hpack_encoder_t encoder;
+    uint8_t input[INPUT_BUFFER_SIZE];
+    size_t input_start;
+    size_t input_end;
+    const char* pending;
+    size_t pending_size;
+    uint8_t header_block[DIVULGE_HTTP2_HEADER_BLOCK_MAX_SIZE];
+    size_t header_block_size;
+    uint32_t header_block_stream_id; /**< @brief stream expecting CONTINUATION frames, 0 if none */
+    bool is_header_block_ending_stream;
+    uint8_t output_block[DIVULGE_HTTP2_HEADER_BLOCK_MAX_SIZE];
+    response_state_t response;
+    uint32_t last_stream_id;
+    int64_t send_window;
+    uint32_t peer_initial_window_size;
+    size_t peer_max_frame_size;
+    bool is_preface_received;
+    bool are_settings_received;
+    bool is_peer_going_away;
+    bool is_closed;
+};
+
+static bool process_next_frame(divulge_http2_connection_t* connection);
+
+static uint32_t read_uint32(const uint8_t* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static void write_uint32(uint8_t* data, uint32_t value) {
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+}
+
+static void send_frame(divulge_http2_connection_t* connection,
+                       frame_type_t type,
+                       uint8_t flags,
+                       uint32_t stream_id,
+                       const void* payload,
+                       size_t payload_size) {
+    uint8_t header[DIVULGE_HTTP2_FRAME_HEADER_SIZE];
+    header[0] = (uint8_t)(payload_size >> 16);
+    header[1] = (uint8_t)(payload_size >> 8);
+    header[2] = (uint8_t)payload_size;
+    header[3] = (uint8_t)type;
+    header[4] = flags;
+    write_uint32(header + 5, stream_id & STREAM_ID_MASK);
+    void* context = connection->configuration.connection_context;
+    if (connection->configuration.sendv) {
+        divulge_io_vector_t vectors[] = {
+            {.data = (const char*)header, .size = sizeof(header)},
+            {.data = payload, .size = payload_size},
+        };
+        connection->configuration.sendv(context, vectors, (payload_size > 0) ? 2 : 1);
+        return;
+    }
+    connection->configuration.send(context, (const char*)header, sizeof(header));
+    if (payload_size > 0) {
+        connection->configuration.send(context, payload, payload_size);
+    }
+}
+
+static void send_goaway(divulge_http2_connection_t* connection, error_code_t error_code) {
+    uint8_t payload[8];
+    write_uint32(payload, connection->last_stream_id);
+    write_uint32(payload + 4, error_code);
+    send_frame(connection, FRAME_TYPE_GOAWAY, 0, 0, payload, sizeof(payload));
+    connection->is_closed = true;
+}
+
+static bool fail_connection(divulge_http2_connection_t* connection, error_code_t error_code) {
+    D(TAG, "Connection error 0x%x", (unsigned)error_code);
+    send_goaway(connection, error_code);
+    return false;
+}
+
+static void send_window_update(divulge_http2_connection_t* connection, uint32_t stream_id, uint32_t increment) {
+    uint8_t payload[4];
+    write_uint32(payload, increment);
+    send_frame(connection, FRAME_TYPE_WINDOW_UPDATE, 0, stream_id, payload, sizeof(payload));
+}
+
+static void close_stream(divulge_http2_stream_t* stream) {
+    free(stream->buffer);
+    divulge_http2_connection_t* connection = stream->connection;
+    memset(stream, 0, sizeof(*stream));
+    stream->connection = connection;
+}
+
+static void send_reset(divulge_http2_connection_t* connection, uint32_t stream_id, error_code_t error_code) {
+    uint8_t payload[4];
+    write_uint32(payload, error_code);
+    send_frame(connection, FRAME_TYPE_RST_STREAM, 0, stream_id, payload, sizeof(payload));
+}
+
+static void reset_stream(divulge_http2_stream_t* stream, error_code_t error_code) {
+    send_reset(stream->connection, stream->id, error_code);
+    if (stream->state == STREAM_STATE_RESPONDING) {
+        stream->is_reset = true;
+    } else {
+        close_stream(stream);
+    }
+}
+
+static divulge_http2_stream_t* find_stream(divulge_http2_connection_t* connection, uint32_t stream_id) {
+    for (size_t i = 0; i < connection->configuration.max_concurrent_streams; i++) {
+        divulge_http2_stream_t* stream = connection->streams + i;
+        if ((stream->state != STREAM_STATE_CLOSED) && (stream->id == stream_id)) {
+            return stream;
+        }
+    }
+    return NULL;
+}
+
+static size_t count_active_streams(divulge_http2_connection_t* connection) {
+    size_t count = 0;
+    for (size_t i = 0; i < connection->configuration.max_concurrent_streams; i++) {
+        if (connection->streams[i].state != STREAM_STATE_CLOSED) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static divulge_http2_stream_t* open_stream(divulge_http2_connection_t* connection, uint32_t stream_id) {
+    for (size_t i = 0; i < connection->configuration.max_concurrent_streams; i++) {
+        divulge_http2_stream_t* stream = connection->streams + i;
+        if (stream->state == STREAM_STATE_CLOSED) {
+            stream->buffer = malloc(connection->configuration.stream_buffer_size + 1);
+            if (!stream->buffer) {
+                return NULL;
+            }
+            stream->id = stream_id;
+            stream->state = STREAM_STATE_OPEN;
+            stream->send_window = connection->peer_initial_window_size;
+            return stream;
+        }
+    }
+    return NULL;
+}
+
+static void respond_with_status(divulge_http2_stream_t* stream, int status) {
+    divulge_http2_connection_t* connection = stream->connection;
+    char status_text[RESPONSE_STATUS_SIZE + 1];
+    snprintf(status_text, sizeof(status_text), "%03d", status);
+    size_t block_size = divulge_hpack_encode(&connection->encoder, ":status", 7, status_text, RESPONSE_STATUS_SIZE,
+                                             connection->output_block, sizeof(connection->output_block));
+    send_frame(connection, FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM, stream->id,
+               connection->output_block, block_size);
+    if (stream->state == STREAM_STATE_OPEN) {
+        reset_stream(stream, ERROR_CODE_NO_ERROR);
+    } else {
+        close_stream(stream);
+    }
+}
+
+static bool is_equal(const char* text, size_t length, const char* reference) {
+    return (strlen(reference) == length) && (memcmp(text, reference, length) == 0);
+}
+
+static bool is_valid_field(const char* name, size_t name_length, const char* value, size_t value_length) {
+    if (name_length == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < name_length; i++) {
+        char character = name[i];
+        if ((character <= ' ') || (character >= 0x7F) || ((character >= 'A') && (character <= 'Z')) ||
+            ((character == ':') && (i > 0))) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < value_length; i++) {
+        if ((value[i] == '\0') || (value[i] == '\r') || (value[i] == '\n')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_connection_specific(const char* name, size_t name_length, const char* value, size_t value_length) {
+    if (is_equal(name, name_length, "te")) {
+        return !is_equal(value, value_length, "trailers");
+    }
+    return is_equal(name, name_length, "connection") || is_equal(name, name_length, "keep-alive") ||
+           is_equal(name, name_length, "proxy-connection") || is_equal(name, name_length, "transfer-encoding") ||
+           is_equal(name, name_length, "upgrade");
+}
+
+static bool has_request_space(divulge_http2_stream_t* stream, size_t size) {
+    size_t capacity = stream->connection->configuration.stream_buffer_size;
+    if ((size > capacity) || ((stream->head_size + stream->pseudo_size) > (capacity - size))) {
+        stream->error_status = 431;
+        return false;
+    }
+    return true;
+}
+
+static void store_pseudo_header(divulge_http2_stream_t* stream,
+                                 const char* name,
+                                 size_t name_length,
+                                 const char* value,
+                                 size_t value_length) {
+    pseudo_header_t* header = NULL;
+    if (is_equal(name, name_length, ":method")) {
+        header = &stream->method;
+    } else if (is_equal(name, name_length, ":scheme")) {
+        header = &stream->scheme;
+    } else if (is_equal(name, name_length, ":path")) {
+        header = &stream->path;
+    } else if (is_equal(name, name_length, ":authority")) {
+        header = &stream->authority;
+    }
+    if (!header || header->is_set || stream->is_request_line_written || memchr(value, ' ', value_length)) {
+        stream->is_malformed = true;
+        return;
+    }
+    if (!has_request_space(stream, value_length)) {
+        return;
+    }
+    stream->pseudo_size += value_length;
+    header->offset = stream->connection->configuration.stream_buffer_size - stream->pseudo_size;
+    header->length = value_length;
+    header->is_set = true;
+    memcpy(stream->buffer + header->offset, value, value_length);
+}
+
+static void append_request(divulge_http2_stream_t* stream, const char* data, size_t data_size) {
+    memcpy(stream->buffer + stream->head_size, data, data_size);
+    stream->head_size += data_size;
+}
+
+static bool write_request_line(divulge_http2_stream_t* stream) {
+    if (stream->is_request_line_written) {
+        return true;
+    }
+    if (!stream->method.is_set || !stream->scheme.is_set || !stream->path.is_set || (stream->path.length == 0)) {
+        stream->is_malformed = true;
+        return false;
+    }
+    size_t size = stream->method.length + 1 + stream->path.length + strlen(REQUEST_LINE_SUFFIX);
+    if (stream->authority.is_set) {
+        size += strlen("Host: ") + stream->authority.length + 2;
+    }
+    if (!has_request_space(stream, size)) {
+        return false;
+    }
+    append_request(stream, stream->buffer + stream->method.offset, stream->method.length);
+    append_request(stream, " ", 1);
+    append_request(stream, stream->buffer + stream->path.offset, stream->path.length);
+    append_request(stream, REQUEST_LINE_SUFFIX, strlen(REQUEST_LINE_SUFFIX));
+    if (stream->authority.is_set) {
+        append_request(stream, "Host: ", strlen("Host: "));
+        append_request(stream, stream->buffer + stream->authority.offset, stream->authority.length);
+        append_request(stream, "\r\n", 2);
+    }
+    stream->pseudo_size = 0;
+    stream->is_request_line_written = true;
+    return true;
+}
+
+static bool parse_content_length(const char* value, size_t value_length, size_t* content_length) {
+    *content_length = 0;
+    for (size_t i = 0; i < value_length; i++) {
+        if ((value[i] < '0') || (value[i] > '9') || (*content_length > ((SIZE_MAX - 9) / 10))) {
+            return false;
+        }
+        *content_length = (*content_length * 10) + (size_t)(value[i] - '0');
+    }
+    return value_length > 0;
+}
+
+static void receive_header_field(void* context,
+                                 const char* name,
+                                 size_t name_length,
+                                 const char* value,
+                                 size_t value_length) {
+    divulge_http2_stream_t* stream = context;
+    if (!stream || stream->is_malformed || stream->error_status) {
+        return;
+    }
+    if (!is_valid_field(name, name_length, value, value_length)) {
+        stream->is_malformed = true;
+    } else if (name[0] == ':') {
+        store_pseudo_header(stream, name, name_length, value, value_length);
+    } else if (is_connection_specific(name, name_length, value, value_length)) {
+        stream->is_malformed = true;
+    } else if (write_request_line(stream)) {
+        if (is_equal(name, name_length, "content-length")) {
+            if (stream->has_content_length ||
+                !parse_content_length(value, value_length, &stream->content_length)) {
+                stream->is_malformed = true;
+                return;
+            }
+            stream->has_content_length = true;
+        } else if (is_equal(name, name_length, "host") && stream->authority.is_set) {
+            return;
+        }
+        if (has_request_space(stream, name_length + value_length + 4)) {
+            append_request(stream, name, name_length);
+            append_request(stream, ": ", 2);
+            append_request(stream, value, value_length);
+            append_request(stream, "\r\n", 2);
+        }
+    }
+}
+
+static void complete_request(divulge_http2_stream_t* stream) {
+    if (stream->has_content_length && (stream->content_length != stream->body_size)) {
+        reset_stream(stream, ERROR_CODE_PROTOCOL_ERROR);
+        return;
+    }
+    char line[BODY_OFFSET];
+    size_t size = (stream->has_content_length || (stream->body_size == 0))
+                      ? (size_t)snprintf(line, sizeof(line), "\r\n")
+                      : (size_t)snprintf(line, sizeof(line), "Content-Length: %zu\r\n\r\n", stream->body_size);
+    memcpy(stream->buffer + stream->head_size, line, size);
+    memmove(stream->buffer + stream->head_size + size, stream->buffer + stream->head_size + BODY_OFFSET,
+            stream->body_size);
+    stream->request_size = stream->head_size + size + stream->body_size;
+    stream->buffer[stream->request_size] = '\0';
+    stream->state = STREAM_STATE_READY;
+}
+
+static void complete_request_head(divulge_http2_stream_t* stream, bool is_stream_ending) {
+    write_request_line(stream);
+    if (stream->is_malformed) {
+        reset_stream(stream, ERROR_CODE_PROTOCOL_ERROR);
+    } else if (stream->error_status || !has_request_space(stream, BODY_OFFSET)) {
+        respond_with_status(stream, stream->error_status);
+    } else if (is_stream_ending) {
+        complete_request(stream);
+    }
+}
+
+static void receive_request_body(divulge_http2_stream_t* stream, const uint8_t* data, size_t data_size) {
+    size_t capacity = stream->connection->configuration.stream_buffer_size;
+    size_t body_start = stream->head_size + BODY_OFFSET;
+    if ((data_size > (capacity - body_start)) || (stream->body_size > (capacity - body_start - data_size))) {
+        respond_with_status(stream, 413);
+        return;
+    }
+    memcpy(stream->buffer + body_start + stream->body_size, data, data_size);
+    stream->body_size += data_size;
+}
+
+static bool receive_header_block(divulge_http2_connection_t* connection,
+                                 uint32_t stream_id,
+                                 bool is_stream_ending,
+                                 const uint8_t* block,
+                                 size_t block_size) {
+    divulge_http2_stream_t* stream = find_stream(connection, stream_id);
+    divulge_http2_stream_t* new_stream = NULL;
+    bool is_new = !stream && (stream_id > connection->last_stream_id);
+    if (is_new) {
+        if ((stream_id % 2) == 0) {
+            return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+        }
+        connection->last_stream_id = stream_id;
+        if (!connection->is_peer_going_away) {
+            new_stream = open_stream(connection, stream_id);
+        }
+    }
+    if (!divulge_hpack_decode(&connection->decoder, block, block_size, receive_header_field, new_stream)) {
+        return fail_connection(connection, ERROR_CODE_COMPRESSION_ERROR);
+    }
+    if (new_stream) {
+        complete_request_head(new_stream, is_stream_ending);
+    } else if (is_new) {
+        send_reset(connection, stream_id, ERROR_CODE_REFUSED_STREAM);
+    } else if (stream && (stream->state == STREAM_STATE_OPEN) && is_stream_ending) {
+        complete_request(stream);
+    } else if (stream) {
+        reset_stream(stream, (stream->state == STREAM_STATE_OPEN) ? ERROR_CODE_PROTOCOL_ERROR
+                                                                  : ERROR_CODE_STREAM_CLOSED);
+    }
+    return true;
+}
+
+static bool get_fragment(const frame_header_t* frame,
+                         const uint8_t* payload,
+                         size_t priority_size,
+                         const uint8_t** fragment,
+                         size_t* fragment_size) {
+    size_t position = 0;
+    size_t padding_size = 0;
+    if (frame->flags & FLAG_PADDED) {
+        if (frame->length < 1) {
+            return false;
+        }
+        padding_size = payload[0];
+        position = 1;
+    }
+    if (frame->flags & FLAG_PRIORITY) {
+        position += priority_size;
+    }
+    if ((position + padding_size) > frame->length) {
+        return false;
+    }
+    *fragment = payload + position;
+    *fragment_size = frame->length - position - padding_size;
+    return true;
+}
+
+static bool process_headers(divulge_http2_connection_t* connection,
+                            const frame_header_t* frame,
+                            const uint8_t* payload) {
+    const uint8_t* fragment;
+    size_t fragment_size;
+    if ((frame->stream_id == 0) || !get_fragment(frame, payload, 5, &fragment, &fragment_size)) {
+        return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    }
+    bool is_stream_ending = (frame->flags & FLAG_END_STREAM) != 0;
+    if (frame->flags & FLAG_END_HEADERS) {
+        return receive_header_block(connection, frame->stream_id, is_stream_ending, fragment, fragment_size);
+    } else if (fragment_size > sizeof(connection->header_block)) {
+        return fail_connection(connection, ERROR_CODE_ENHANCE_YOUR_CALM);
+    }
+    memcpy(connection->header_block, fragment, fragment_size);
+    connection->header_block_size = fragment_size;
+    connection->header_block_stream_id = frame->stream_id;
+    connection->is_header_block_ending_stream = is_stream_ending;
+    return true;
+}
+
+static bool process_continuation(divulge_http2_connection_t* connection,
+                                 const frame_header_t* frame,
+                                 const uint8_t* payload) {
+    if (frame->length > (sizeof(connection->header_block) - connection->header_block_size)) {
+        return fail_connection(connection, ERROR_CODE_ENHANCE_YOUR_CALM);
+    }
+    memcpy(connection->header_block + connection->header_block_size, payload, frame->length);
+    connection->header_block_size += frame->length;
+    if (!(frame->flags & FLAG_END_HEADERS)) {
+        return true;
+    }
+    uint32_t stream_id = connection->header_block_stream_id;
+    connection->header_block_stream_id = 0;
+    return receive_header_block(connection, stream_id, connection->is_header_block_ending_stream,
+                                connection->header_block, connection->header_block_size);
+}
+
+static bool process_data(divulge_http2_connection_t* connection, const frame_header_t* frame, const uint8_t* payload) {
+    const uint8_t* data;
+    size_t data_size;
+    if ((frame->stream_id == 0) || !get_fragment(frame, payload, 0, &data, &data_size)) {
+        return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    }
+    if (frame->length > 0) {
+        send_window_update(connection, 0, frame->length);
+    }
+    divulge_http2_stream_t* stream = find_stream(connection, frame->stream_id);
+    if (!stream) {
+        return (frame->stream_id <= connection->last_stream_id) ||
+               fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    } else if (stream->state != STREAM_STATE_OPEN) {
+        reset_stream(stream, ERROR_CODE_STREAM_CLOSED);
+        return true;
+    }
+    receive_request_body(stream, data, data_size);
+    if (stream->state != STREAM_STATE_OPEN) {
+        return true;
+    } else if (frame->flags & FLAG_END_STREAM) {
+        complete_request(stream);
+    } else if (frame->length > 0) {
+        send_window_update(connection, stream->id, frame->length);
+    }
+    return true;
+}
+
+static error_code_t apply_settings(divulge_http2_connection_t* connection, const uint8_t* payload, size_t size) {
+    for (size_t position = 0; (position + SETTING_SIZE) <= size; position += SETTING_SIZE) {
+        uint16_t setting = (uint16_t)((payload[position] << 8) | payload[position + 1]);
+        uint32_t value = read_uint32(payload + position + 2);
+        if (setting == SETTING_HEADER_TABLE_SIZE) {
+            divulge_hpack_encoder_set_max_table_size(&connection->encoder, value);
+        } else if ((setting == SETTING_ENABLE_PUSH) && (value > 1)) {
+            return ERROR_CODE_PROTOCOL_ERROR;
+        } else if (setting == SETTING_INITIAL_WINDOW_SIZE) {
+            if (value > MAX_WINDOW_SIZE) {
+                return ERROR_CODE_FLOW_CONTROL_ERROR;
+            }
+            int64_t delta = (int64_t)value - connection->peer_initial_window_size;
+            for (size_t i = 0; i < connection->configuration.max_concurrent_streams; i++) {
+                divulge_http2_stream_t* stream = connection->streams + i;
+                if (stream->state == STREAM_STATE_CLOSED) {
+                    continue;
+                }
+                stream->send_window += delta;
+                if (stream->send_window > MAX_WINDOW_SIZE) {
+                    return ERROR_CODE_FLOW_CONTROL_ERROR;
+                }
+            }
+            connection->peer_initial_window_size = value;
+        } else if (setting == SETTING_MAX_FRAME_SIZE) {
+            if ((value < DIVULGE_HTTP2_MAX_FRAME_SIZE) || (value > MAX_PEER_FRAME_SIZE)) {
+                return ERROR_CODE_PROTOCOL_ERROR;
+            }
+            connection->peer_max_frame_size = value;
+        }
+    }
+    return ERROR_CODE_NO_ERROR;
+}
+
+static bool process_settings(divulge_http2_connection_t* connection,
+                             const frame_header_t* frame,
+                             const uint8_t* payload) {
+    if (frame->stream_id != 0) {
+        return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    } else if (frame->flags & FLAG_ACK) {
+        return (frame->length == 0) || fail_connection(connection, ERROR_CODE_FRAME_SIZE_ERROR);
+    } else if ((frame->length % SETTING_SIZE) != 0) {
+        return fail_connection(connection, ERROR_CODE_FRAME_SIZE_ERROR);
+    }
+    error_code_t error_code = apply_settings(connection, payload, frame->length);
+    if (error_code != ERROR_CODE_NO_ERROR) {
+        return fail_connection(connection, error_code);
+    }
+    connection->are_settings_received = true;
+    send_frame(connection, FRAME_TYPE_SETTINGS, FLAG_ACK, 0, NULL, 0);
+    return true;
+}
+
+static bool process_window_update(divulge_http2_connection_t* connection,
+                                  const frame_header_t* frame,
+                                  const uint8_t* payload) {
+    if (frame->length != 4) {
+        return fail_connection(connection, ERROR_CODE_FRAME_SIZE_ERROR);
+    }
+    uint32_t increment = read_uint32(payload) & STREAM_ID_MASK;
+    if (frame->stream_id == 0) {
+        connection->send_window += increment;
+        if (increment == 0) {
+            return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+        } else if (connection->send_window > MAX_WINDOW_SIZE) {
+            return fail_connection(connection, ERROR_CODE_FLOW_CONTROL_ERROR);
+        }
+        return true;
+    }
+    divulge_http2_stream_t* stream = find_stream(connection, frame->stream_id);
+    if (!stream) {
+        return (frame->stream_id <= connection->last_stream_id) ||
+               fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    }
+    stream->send_window += increment;
+    if (increment == 0) {
+        reset_stream(stream, ERROR_CODE_PROTOCOL_ERROR);
+    } else if (stream->send_window > MAX_WINDOW_SIZE) {
+        reset_stream(stream, ERROR_CODE_FLOW_CONTROL_ERROR);
+    }
+    return true;
+}
+
+static bool process_reset(divulge_http2_connection_t* connection, const frame_header_t* frame) {
+    if (frame->length != 4) {
+        return fail_connection(connection, ERROR_CODE_FRAME_SIZE_ERROR);
+    }
+    divulge_http2_stream_t* stream = find_stream(connection, frame->stream_id);
+    if (!stream) {
+        return ((frame->stream_id != 0) && (frame->stream_id <= connection->last_stream_id)) ||
+               fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    } else if (stream->state == STREAM_STATE_RESPONDING) {
+        stream->is_reset = true;
+    } else {
+        close_stream(stream);
+    }
+    return true;
+}
+
+static bool process_priority(divulge_http2_connection_t* connection, const frame_header_t* frame) {
+    if (frame->stream_id == 0) {
+        return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    } else if (frame->length != 5) {
+        divulge_http2_stream_t* stream = find_stream(connection, frame->stream_id);
+        if (stream) {
+            reset_stream(stream, ERROR_CODE_FRAME_SIZE_ERROR);
+        } else {
+            send_reset(connection, frame->stream_id, ERROR_CODE_FRAME_SIZE_ERROR);
+        }
+    }
+    return true;
+}
+
+static bool process_frame(divulge_http2_connection_t* connection,
+                          const frame_header_t* frame,
+                          const uint8_t* payload) {
+    if (connection->header_block_stream_id) {
+        if ((frame->type != FRAME_TYPE_CONTINUATION) || (frame->stream_id != connection->header_block_stream_id)) {
+            return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+        }
+        return process_continuation(connection, frame, payload);
+    } else if (!connection->are_settings_received && (frame->type != FRAME_TYPE_SETTINGS)) {
+        return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+    }
+    switch (frame->type) {
+        case FRAME_TYPE_DATA:
+            return process_data(connection, frame, payload);
+        case FRAME_TYPE_HEADERS:
+            return process_headers(connection, frame, payload);
+        case FRAME_TYPE_PRIORITY:
+            return process_priority(connection, frame);
+        case FRAME_TYPE_RST_STREAM:
+            return process_reset(connection, frame);
+        case FRAME_TYPE_SETTINGS:
+            return process_settings(connection, frame, payload);
+        case FRAME_TYPE_PING:
+            if ((frame->stream_id != 0) || (frame->length != 8)) {
+                return fail_connection(connection, (frame->stream_id != 0) ? ERROR_CODE_PROTOCOL_ERROR
+                                                                           : ERROR_CODE_FRAME_SIZE_ERROR);
+            } else if (!(frame->flags & FLAG_ACK)) {
+                send_frame(connection, FRAME_TYPE_PING, FLAG_ACK, 0, payload, frame->length);
+            }
+            return true;
+        case FRAME_TYPE_GOAWAY:
+            connection->is_peer_going_away = true;
+            return (frame->stream_id == 0) || fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+        case FRAME_TYPE_WINDOW_UPDATE:
+            return process_window_update(connection, frame, payload);
+        case FRAME_TYPE_PUSH_PROMISE:
+        case FRAME_TYPE_CONTINUATION:
+            return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+        default:
+            return true;
+    }
+}
+
+static bool fill_input(divulge_http2_connection_t* connection, size_t size) {
+    if ((INPUT_BUFFER_SIZE - connection->input_start) < size) {
+        memmove(connection->input, connection->input + connection->input_start,
+                connection->input_end - connection->input_start);
+        connection->input_end -= connection->input_start;
+        connection->input_start = 0;
+    }
+    while ((connection->input_end - connection->input_start) < size) {
+        char* destination = (char*)connection->input + connection->input_end;
+        size_t space = INPUT_BUFFER_SIZE - connection->input_end;
+        size_t received_size = 0;
+        if (connection->pending_size > 0) {
+            received_size = (connection->pending_size < space) ? connection->pending_size : space;
+            memcpy(destination, connection->pending, received_size);
+            connection->pending += received_size;
+            connection->pending_size -= received_size;
+        } else {
+            received_size =
+                connection->configuration.receive(connection->configuration.connection_context, destination, space);
+        }
+        if (received_size == 0) {
+            return false;
+        }
+        connection->input_end += received_size;
+    }
+    return true;
+}
+
+static bool read_frame(divulge_http2_connection_t* connection, frame_header_t* frame, const uint8_t** payload) {
+    if (!connection->is_preface_received) {
+        if (!fill_input(connection, PREFACE_SIZE)) {
+            return false;
+        } else if (memcmp(connection->input + connection->input_start, DIVULGE_HTTP2_PREFACE, PREFACE_SIZE) != 0) {
+            return fail_connection(connection, ERROR_CODE_PROTOCOL_ERROR);
+        }
+        connection->input_start += PREFACE_SIZE;
+        connection->is_preface_received = true;
+    }
+    if (!fill_input(connection, DIVULGE_HTTP2_FRAME_HEADER_SIZE)) {
+        return false;
+    }
+    const uint8_t* header = connection->input + connection->input_start;
+    frame->length = ((uint32_t)header[0] << 16) | ((uint32_t)header[1] << 8) | (uint32_t)header[2];
+    frame->type = header[3];
+    frame->flags = header[4];
+    frame->stream_id = read_uint32(header + 5) & STREAM_ID_MASK;
+    if (frame->length > DIVULGE_HTTP2_MAX_FRAME_SIZE) {
+        return fail_connection(connection, ERROR_CODE_FRAME_SIZE_ERROR);
+    } else if (!fill_input(connection, DIVULGE_HTTP2_FRAME_HEADER_SIZE + frame->length)) {
+        return false;
+    }
+    *payload = connection->input + connection->input_start + DIVULGE_HTTP2_FRAME_HEADER_SIZE;
+    connection->input_start += DIVULGE_HTTP2_FRAME_HEADER_SIZE + frame->length;
+    return true;
+}
+
+static bool process_next_frame(divulge_http2_connection_t* connection) {
+    frame_header_t frame;
+    const uint8_t* payload;
+    if (!read_frame(connection, &frame, &payload)) {
+        if (!connection->is_closed) {
+            send_goaway(connection, ERROR_CODE_NO_ERROR);
+        }
+        return false;
+    }
+    return process_frame(connection, &frame, payload);
+}
+
+static void lowercase(char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if ((text[i] >= 'A') && (text[i] <= 'Z')) {
+            text[i] = (char)(text[i] - 'A' + 'a');
+        }
+    }
+}
+
+static bool encode_response_field(divulge_http2_connection_t* connection,
+                                  size_t* block_size,
+                                  const char* name,
+                                  size_t name_length,
+                                  const char* value,
+                                  size_t value_length) {
+    size_t size = divulge_hpack_encode(&connection->encoder, name, name_length, value, value_length,
+                                       connection->output_block + *block_size,
+                                       sizeof(connection->output_block) - *block_size);
+    *block_size += size;
+    return size > 0;
+}
+
+static bool encode_response_head(divulge_http2_connection_t* connection, size_t* block_size) {
+    response_state_t* response = &connection->response;
+    *block_size = 0;
+    if (!encode_response_field(connection, block_size, ":status", 7, response->head + RESPONSE_STATUS_OFFSET,
+                               RESPONSE_STATUS_SIZE)) {
+        return false;
+    }
+    char* line = strstr(response->head, "\r\n") + 2;
+    char* end = response->head + response->head_size - 2;
+    while (line < end) {
+        char* line_end = strstr(line, "\r\n");
+        char* colon = memchr(line, ':', (size_t)(line_end - line));
+        if (colon) {
+            size_t name_length = (size_t)(colon - line);
+            char* value = colon + 1;
+            while ((value < line_end) && ((*value == ' ') || (*value == '\t'))) {
+                value++;
+            }
+            size_t value_length = (size_t)(line_end - value);
+            lowercase(line, name_length);
+            if (is_equal(line, name_length, "content-length")) {
+                response->has_content_length = parse_content_length(value, value_length, &response->content_length);
+            }
+            if (!is_connection_specific(line, name_length, value, value_length) &&
+                !encode_response_field(connection, block_size, line, name_length, value, value_length)) {
+                return false;
+            }
+        }
+        line = line_end + 2;
+    }
+    return true;
+}
+
+static bool send_response_headers(divulge_http2_stream_t* stream, bool is_stream_ending) {
+    divulge_http2_connection_t* connection = stream->connection;
+    size_t block_size = 0;
+    if (!encode_response_head(connection, &block_size)) {
+        return fail_connection(connection, ERROR_CODE_INTERNAL_ERROR);
+    }
+    send_frame(connection, FRAME_TYPE_HEADERS, FLAG_END_HEADERS | (is_stream_ending ? FLAG_END_STREAM : 0),
+               stream->id, connection->output_block, block_size);
+    connection->response.are_headers_sent = true;
+    return true;
+}
+
+static bool is_valid_response_head(const response_state_t* response) {
+    if ((response->head_size < (RESPONSE_STATUS_OFFSET + RESPONSE_STATUS_SIZE)) ||
+        (memcmp(response->head, "HTTP/1.", 7) != 0)) {
+        return false;
+    }
+    for (size_t i = 0; i < RESPONSE_STATUS_SIZE; i++) {
+        char digit = response->head[RESPONSE_STATUS_OFFSET + i];
+        if ((digit < '0') || (digit > '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t receive_response_head(divulge_http2_stream_t* stream, const char* data, size_t data_size) {
+    response_state_t* response = &stream->connection->response;
+    size_t previous_size = response->head_size;
+    size_t space = sizeof(response->head) - 1 - response->head_size;
+    size_t size = (data_size < space) ? data_size : space;
+    memcpy(response->head + response->head_size, data, size);
+    response->head_size += size;
+    response->head[response->head_size] = '\0';
+    char* end = strstr(response->head + ((previous_size > 3) ? (previous_size - 3) : 0), "\r\n\r\n");
+    if (end) {
+        response->head_size = (size_t)(end - response->head) + 4;
+        response->head[response->head_size] = '\0';
+        response->is_head_complete = true;
+        if (!is_valid_response_head(response)) {
+            reset_stream(stream, ERROR_CODE_INTERNAL_ERROR);
+        }
+        return response->head_size - previous_size;
+    } else if (response->head_size == (sizeof(response->head) - 1)) {
+        reset_stream(stream, ERROR_CODE_INTERNAL_ERROR);
+    }
+    return size;
+}
+
+static bool wait_for_send_window(divulge_http2_stream_t* stream) {
+    divulge_http2_connection_t* connection = stream->connection;
+    while (!stream->is_reset && !connection->is_closed &&
+           ((connection->send_window <= 0) || (stream->send_window <= 0))) {
+        process_next_frame(connection);
+    }
+    return !stream->is_reset && !connection->is_closed;
+}
+
+static bool send_response_body(divulge_http2_stream_t* stream, const char* data, size_t data_size) {
+    divulge_http2_connection_t* connection = stream->connection;
+    if ((data_size > 0) && !connection->response.are_headers_sent && !send_response_headers(stream, false)) {
+        return false;
+    }
+    while (data_size > 0) {
+        if (!wait_for_send_window(stream)) {
+            return false;
+        }
+        size_t size = data_size;
+        if (size > connection->peer_max_frame_size) {
+            size = connection->peer_max_frame_size;
+        }
+        if ((int64_t)size > connection->send_window) {
+            size = (size_t)connection->send_window;
+        }
+        if ((int64_t)size > stream->send_window) {
+            size = (size_t)stream->send_window;
+        }
+        send_frame(connection, FRAME_TYPE_DATA, 0, stream->id, data, size);
+        connection->send_window -= (int64_t)size;
+        stream->send_window -= (int64_t)size;
+        connection->response.body_size += size;
+        data += size;
+        data_size -= size;
+    }
+    return true;
+}
+
+static void finish_response(divulge_http2_stream_t* stream) {
+    divulge_http2_connection_t* connection = stream->connection;
+    response_state_t* response = &connection->response;
+    if (stream->is_reset || connection->is_closed) {
+        return;
+    } else if (stream->is_http1_required) {
+        reset_stream(stream, ERROR_CODE_HTTP_1_1_REQUIRED);
+    } else if (!response->is_head_complete) {
+        reset_stream(stream, ERROR_CODE_INTERNAL_ERROR);
+    } else if (!response->are_headers_sent) {
+        send_response_headers(stream, true);
+    } else if (response->has_content_length && (response->body_size < response->content_length)) {
+        reset_stream(stream, ERROR_CODE_INTERNAL_ERROR);
+    } else {
+        send_frame(connection, FRAME_TYPE_DATA, FLAG_END_STREAM, stream->id, NULL, 0);
+    }
+}
+
+static divulge_http2_stream_t* find_ready_stream(divulge_http2_connection_t* connection) {
+    divulge_http2_stream_t* ready_stream = NULL;
+    for (size_t i = 0; i < connection->configuration.max_concurrent_streams; i++) {
+        divulge_http2_stream_t* stream = connection->streams + i;
+        if ((stream->state == STREAM_STATE_READY) && (!ready_stream || (stream->id < ready_stream->id))) {
+            ready_stream = stream;
+        }
+    }
+    return ready_stream;
+}
+
+static void dispatch_stream(divulge_http2_connection_t* connection, divulge_http2_stream_t* stream) {
+    response_state_t* response = &connection->response;
+    response->head_size = 0;
+    response->is_head_complete = false;
+    response->are_headers_sent = false;
+    response->has_content_length = false;
+    response->content_length = 0;
+    response->body_size = 0;
+    stream->state = STREAM_STATE_RESPONDING;
+    connection->configuration.dispatch(connection->configuration.dispatch_context, stream, stream->buffer,
+                                       stream->request_size, connection->configuration.stream_buffer_size);
+    finish_response(stream);
+    close_stream(stream);
+}
+
+static void send_settings(divulge_http2_connection_t* connection) {
+    uint8_t payload[2 * SETTING_SIZE];
+    const struct {
+        uint16_t setting;
+        uint32_t value;
+    } settings[] = {
+        {SETTING_MAX_CONCURRENT_STREAMS, (uint32_t)connection->configuration.max_concurrent_streams},
+        {SETTING_MAX_HEADER_LIST_SIZE, (uint32_t)connection->configuration.stream_buffer_size},
+    };
+    for (size_t i = 0; i < (sizeof(settings) / sizeof(settings[0])); i++) {
+        payload[i * SETTING_SIZE] = (uint8_t)(settings[i].setting >> 8);
+        payload[(i * SETTING_SIZE) + 1] = (uint8_t)settings[i].setting;
+        write_uint32(payload + (i * SETTING_SIZE) + 2, settings[i].value);
+    }
+    send_frame(connection, FRAME_TYPE_SETTINGS, 0, 0, payload, sizeof(payload));
+}
+
+bool divulge_http2_is_preface(const char* data, size_t data_size) {
+    size_t size = (data_size < PREFACE_SIZE) ? data_size : PREFACE_SIZE;
+    return data && (size >= PREFACE_REQUEST_LINE_SIZE) && (memcmp(data, DIVULGE_HTTP2_PREFACE, size) == 0);
+}
+
+divulge_http2_connection_t* divulge_http2_create(const divulge_http2_configuration_t* configuration) {
+    if (!configuration || !configuration->send || !configuration->receive || !configuration->dispatch ||
+        (configuration->max_concurrent_streams == 0) || (configuration->stream_buffer_size <= BODY_OFFSET)) {
+        return NULL;
+    }
+    divulge_http2_connection_t* connection = calloc(1, sizeof(divulge_http2_connection_t));
+    if (!connection) {
+        return NULL;
+    }
+    connection->streams = calloc(configuration->max_concurrent_streams, sizeof(divulge_http2_stream_t));
+    if (!connection->streams) {
+        free(connection);
+        return NULL;
+    }
+    memcpy(&connection->configuration, configuration, sizeof(divulge_http2_configuration_t));
+    for (size_t i = 0; i < configuration->max_concurrent_streams; i++) {
+        connection->streams[i].connection = connection;
+    }
+    divulge_hpack_decoder_initialize(&connection->decoder);
+    divulge_hpack_encoder_initialize(&connection->encoder);
+    connection->send_window = DEFAULT_WINDOW_SIZE;
+    connection->peer_initial_window_size = DEFAULT_WINDOW_SIZE;
+    connection->peer_max_frame_size = DIVULGE_HTTP2_MAX_FRAME_SIZE;
+    return connection;
+}
+
+static size_t decode_upgrade_settings(const char* settings, size_t settings_length, uint8_t* payload) {
+    char base64[UPGRADE_SETTINGS_MAX_LENGTH + 4];
+    size_t length = 0;
+    for (; length < settings_length; length++) {
+        char character = settings[length];
+        if (character == '-') {
+            character = '+';
+        } else if (character == '_') {
+            character = '/';
+        } else if (!(((character >= 'A') && (character <= 'Z')) || ((character >= 'a') && (character <= 'z')) ||
+                     ((character >= '0') && (character <= '9')))) {
+            return SIZE_MAX;
+        }
+        base64[length] = character;
+    }
+    while ((length % 4) != 0) {
+        base64[length++] = '=';
+    }
+    base64[length] = '\0';
+    size_t size = encodings_base64_get_decode_buffer_size(base64);
+    encodings_base64_decode(base64, (char*)payload);
+    return size;
+}
+
+bool divulge_http2_upgrade(divulge_http2_connection_t* connection,
+                           const char* settings,
+                           size_t settings_length,
+                           const char* request,
+                           size_t request_size) {
+    if (!connection || (!settings && (settings_length > 0)) || !request ||
+        (settings_length > UPGRADE_SETTINGS_MAX_LENGTH) ||
+        (request_size > connection->configuration.stream_buffer_size)) {
+        return false;
+    }
+    uint8_t payload[(UPGRADE_SETTINGS_MAX_LENGTH / 4 + 1) * 3];
+    size_t payload_size = decode_upgrade_settings(settings, settings_length, payload);
+    if ((payload_size == SIZE_MAX) || ((payload_size % SETTING_SIZE) != 0) ||
+        (apply_settings(connection, payload, payload_size) != ERROR_CODE_NO_ERROR)) {
+        return false;
+    }
+    divulge_http2_stream_t* stream = open_stream(connection, 1);
+    if (!stream) {
+        return false;
+    }
+    memcpy(stream->buffer, request, request_size);
+    stream->buffer[request_size] = '\0';
+    stream->request_size = request_size;
+    stream->state = STREAM_STATE_READY;
+    connection->last_stream_id = 1;
+    return true;
+}
+
+void divulge_http2_serve(divulge_http2_connection_t* connection, const char* received, size_t received_size) {
+    if (!connection || (!received && (received_size > 0))) {
+        return;
+    }
+    connection->pending = received;
+    connection->pending_size = received_size;
+    send_settings(connection);
+    while (!connection->is_closed) {
+        divulge_http2_stream_t* stream = find_ready_stream(connection);
+        if (stream) {
+            dispatch_stream(connection, stream);
+        } else if (connection->is_peer_going_away && (count_active_streams(connection) == 0)) {
+            send_goaway(connection, ERROR_CODE_NO_ERROR);
+        } else {
+            process_next_frame(connection);
+        }
+    }
+}
+
+void divulge_http2_destroy(divulge_http2_connection_t* connection) {
+    if (!connection) {
+        return;
+    }
+    for (size_t i = 0; i < connection->configuration.max_concurrent_streams; i++) {
+        free(connection->streams[i].buffer);
+    }
+    free(connection->streams);
+    free(connection);
+}
+
+bool divulge_http2_stream_write(divulge_http2_stream_t* stream, const char* data, size_t data_size) {
+    if (!stream || (!data && (data_size > 0))) {
+        return false;
+    }
+    divulge_http2_connection_t* connection = stream->connection;
+    if (stream->is_reset || stream->is_http1_required || connection->is_closed) {
+        return false;
+    }
+    if (!connection->response.is_head_complete) {
+        size_t size = receive_response_head(stream, data, data_size);
+        if (stream->is_reset) {
+            return false;
+        }
+        data += size;
+        data_size -= size;
+    }
+    return send_response_body(stream, data, data_size);
+}
+
+void divulge_http2_stream_require_http1(divulge_http2_stream_t* stream) {
+    if (stream) {
+        stream->is_http1_required = true;
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_HTTP2_H
+#define DIVULGE_HTTP2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "divulge.h"
+
+/**
+ * @defgroup divulge-http2 Divulge HTTP/2
+ * @ingroup divulge
+ * @brief HTTP/2 cleartext connections (RFC 9113)
+ *
+ * Streams are multiplexed on the connection and their requests are buffered until complete. Each complete request is
+ * handed to the dispatch callback as an HTTP/1.1 request, and the HTTP/1.1 response it produces through
+ * divulge_http2_stream_write() is turned into HEADERS and DATA frames. Requests are dispatched one at a time; while a
+ * response waits for flow control credit, frames of the other streams keep being received.
+ * @{
+ */
+
+#define DIVULGE_HTTP2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define DIVULGE_HTTP2_FRAME_HEADER_SIZE (9)
+#define DIVULGE_HTTP2_MAX_FRAME_SIZE (16384)
+#define DIVULGE_HTTP2_HEADER_BLOCK_MAX_SIZE (8192)
+#define DIVULGE_HTTP2_RESPONSE_HEAD_MAX_SIZE (2048)
+
+typedef struct divulge_http2_connection divulge_http2_connection_t;
+
+typedef struct divulge_http2_stream divulge_http2_stream_t;
+
+/**
+ * @brief Called for every complete request
+ * @param[in] context dispatch context from the configuration
+ * @param[in] stream stream to write the response to
+ * @param[in] request buffer holding the HTTP/1.1 request, terminated with a NUL character
+ * @param[in] request_size size of the request
+ * @param[in] request_capacity size of the buffer without the terminating NUL character
+ */
+typedef void (*divulge_http2_dispatch_callback_t)(void* context,
+                                                  divulge_http2_stream_t* stream,
+                                                  char* request,
+                                                  size_t request_size,
+                                                  size_t request_capacity);
+
+typedef struct divulge_http2_configuration {
+    divulge_socket_send_callback_t send;
+    divulge_socket_send_vector_callback_t sendv;
+    divulge_socket_receive_callback_t receive;
+    void* connection_context;
+    size_t max_concurrent_streams;
+    size_t stream_buffer_size; /**< @brief limit of a single request, head and body together */
+    divulge_http2_dispatch_callback_t dispatch;
+    void* dispatch_context;
+} divulge_http2_configuration_t;
+
+/**
+ * @brief Check if received data starts like the client connection preface
+ */
+bool divulge_http2_is_preface(const char* data, size_t data_size);
+
+divulge_http2_connection_t* divulge_http2_create(const divulge_http2_configuration_t* configuration);
+
+/**
+ * @brief Take over a connection upgraded from HTTP/1.1 with `Upgrade: h2c`
+ *
+ * The 101 response has to be sent already. The upgrading request becomes stream 1, answered after the server
+ * preface.
+ * @param[in] connection pointer to the connection
+ * @param[in] settings value of the HTTP2-Settings request header
+ * @param[in] settings_length length of the value
+ * @param[in] request the upgrading HTTP/1.1 request without body
+ * @param[in] request_size size of the request
+ * @return false if the settings are malformed or the request does not fit
+ */
+bool divulge_http2_upgrade(divulge_http2_connection_t* connection,
+                           const char* settings,
+                           size_t settings_length,
+                           const char* request,
+                           size_t request_size);
+
+/**
+ * @brief Serve the connection until the peer closes it or a connection error occurs
+ * @param[in] connection pointer to the connection
+ * @param[in] received data already received from the peer, starting with the client connection preface
+ * @param[in] received_size size of the data
+ */
+void divulge_http2_serve(divulge_http2_connection_t* connection, const char* received, size_t received_size);
+
+void divulge_http2_destroy(divulge_http2_connection_t* connection);
+
+/**
+ * @brief Write a part of the HTTP/1.1 response of a stream
+ *
+ * Blocks while the flow control windows are exhausted.
+ * @return false if the stream or the connection is gone and the data was dropped
+ */
+bool divulge_http2_stream_write(divulge_http2_stream_t* stream, const char* data, size_t data_size);
+
+/**
+ * @brief Reset the stream with HTTP_1_1_REQUIRED instead of sending a response
+ *
+ * Used by handlers taking over the connection, like WebSocket and Server-Sent Events, so the client retries over
+ * HTTP/1.1.
+ */
+void divulge_http2_stream_require_http1(divulge_http2_stream_t* stream);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_HTTP2_H
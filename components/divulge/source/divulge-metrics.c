@@ -0,0 +1,316 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-metrics.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITER_BUFFER_SIZE (512)
+#define LABELS_MAX_SIZE (192)
+#define UNMATCHED_ROUTE_NAME "unmatched"
+#define MICROSECONDS_PER_SECOND (1000000)
+
+typedef struct metrics_shard {
+    atomic_uint_fast64_t status_counts[DIVULGE_METRICS_STATUS_CLASS_COUNT];
+    atomic_uint_fast64_t sent_size;
+    atomic_uint_fast64_t latency_sum_us;
+    atomic_uint_fast64_t latency_buckets[DIVULGE_METRICS_LATENCY_BUCKET_COUNT];
+} metrics_shard_t;
+
+struct divulge_route_metrics {
+    divulge_route_metrics_t* next;
+    const char* route;
+    divulge_route_method_t method;
+    metrics_shard_t shards[DIVULGE_METRICS_SHARD_COUNT];
+};
+
+struct divulge_metrics {
+    divulge_route_metrics_t* routes;
+    divulge_route_metrics_t unmatched_route;
+};
+
+typedef struct metrics_totals {
+    uint64_t status_counts[DIVULGE_METRICS_STATUS_CLASS_COUNT];
+    uint64_t sent_size;
+    uint64_t latency_sum_us;
+    uint64_t latency_buckets[DIVULGE_METRICS_LATENCY_BUCKET_COUNT];
+} metrics_totals_t;
+
+typedef struct metrics_writer {
+    divulge_request_t* request;
+    char buffer[WRITER_BUFFER_SIZE];
+    size_t size;
+} metrics_writer_t;
+
+static atomic_size_t next_shard_index;
+static _Thread_local size_t thread_shard_index;
+
+static metrics_shard_t* get_thread_shard(divulge_route_metrics_t* route_metrics) {
+    if (thread_shard_index == 0) {
+        thread_shard_index = (atomic_fetch_add_explicit(&next_shard_index, 1, memory_order_relaxed) %
+                              DIVULGE_METRICS_SHARD_COUNT) +
+                             1;
+    }
+    return route_metrics->shards + (thread_shard_index - 1);
+}
+
+static void add_counter(atomic_uint_fast64_t* counter, uint64_t value) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static uint64_t read_counter(atomic_uint_fast64_t* counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+divulge_metrics_t* divulge_metrics_create(void) {
+    divulge_metrics_t* metrics = calloc(1, sizeof(divulge_metrics_t));
+    if (!metrics) {
+        return NULL;
+    }
+    metrics->unmatched_route.route = UNMATCHED_ROUTE_NAME;
+    metrics->unmatched_route.method = DIVULGE_ROUTE_METHOD_ANY;
+    return metrics;
+}
+
+divulge_route_metrics_t* divulge_metrics_add_route(divulge_metrics_t* metrics,
+                                                   const char* route,
+                                                   divulge_route_method_t method) {
+    if (!metrics || !route) {
+        return NULL;
+    }
+    divulge_route_metrics_t* route_metrics = calloc(1, sizeof(divulge_route_metrics_t));
+    if (!route_metrics) {
+        return NULL;
+    }
+    route_metrics->route = route;
+    route_metrics->method = method;
+    divulge_route_metrics_t** tail = &metrics->routes;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = route_metrics;
+    return route_metrics;
+}
+
+divulge_route_metrics_t* divulge_metrics_get_unmatched_route(divulge_metrics_t* metrics) {
+    return metrics ? &metrics->unmatched_route : NULL;
+}
+
+size_t divulge_metrics_get_latency_bucket_index(uint64_t latency_us) {
+    if (latency_us < (UINT64_C(1) << DIVULGE_METRICS_LATENCY_MIN_EXPONENT)) {
+        return 0;
+    }
+    if (latency_us >= (UINT64_C(1) << DIVULGE_METRICS_LATENCY_MAX_EXPONENT)) {
+        return DIVULGE_METRICS_LATENCY_BUCKET_COUNT - 1;
+    }
+    size_t exponent = DIVULGE_METRICS_LATENCY_MIN_EXPONENT;
+    while ((latency_us >> (exponent + 1)) != 0) {
+        exponent++;
+    }
+    uint64_t sub_bucket =
+        ((latency_us - (UINT64_C(1) << exponent)) * DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT) >> exponent;
+    return ((exponent - DIVULGE_METRICS_LATENCY_MIN_EXPONENT) * DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT) +
+           (size_t)sub_bucket;
+}
+
+uint64_t divulge_metrics_get_latency_bucket_bound_us(size_t bucket_index) {
+    if (bucket_index >= (DIVULGE_METRICS_LATENCY_BUCKET_COUNT - 1)) {
+        return UINT64_MAX;
+    }
+    size_t exponent = DIVULGE_METRICS_LATENCY_MIN_EXPONENT + (bucket_index / DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT);
+    uint64_t sub_bucket = (bucket_index % DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT) + 1;
+    return (UINT64_C(1) << exponent) + ((sub_bucket << exponent) / DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT);
+}
+
+static size_t get_status_class_index(int return_code) {
+    int status_class = (return_code / 100) - 1;
+    if (status_class < 0) {
+        return 0;
+    }
+    return (status_class < DIVULGE_METRICS_STATUS_CLASS_COUNT) ? (size_t)status_class
+                                                               : (DIVULGE_METRICS_STATUS_CLASS_COUNT - 1);
+}
+
+void divulge_metrics_record(divulge_route_metrics_t* route_metrics,
+                            int return_code,
+                            size_t sent_size,
+                            uint64_t latency_us) {
+    if (!route_metrics) {
+        return;
+    }
+    metrics_shard_t* shard = get_thread_shard(route_metrics);
+    add_counter(shard->status_counts + get_status_class_index(return_code), 1);
+    add_counter(&shard->sent_size, sent_size);
+    add_counter(&shard->latency_sum_us, latency_us);
+    add_counter(shard->latency_buckets + divulge_metrics_get_latency_bucket_index(latency_us), 1);
+}
+
+static void collect_totals(divulge_route_metrics_t* route_metrics, metrics_totals_t* totals) {
+    memset(totals, 0, sizeof(*totals));
+    for (size_t i = 0; i < DIVULGE_METRICS_SHARD_COUNT; i++) {
+        metrics_shard_t* shard = route_metrics->shards + i;
+        for (size_t j = 0; j < DIVULGE_METRICS_STATUS_CLASS_COUNT; j++) {
+            totals->status_counts[j] += read_counter(shard->status_counts + j);
+        }
+        totals->sent_size += read_counter(&shard->sent_size);
+        totals->latency_sum_us += read_counter(&shard->latency_sum_us);
+        for (size_t j = 0; j < DIVULGE_METRICS_LATENCY_BUCKET_COUNT; j++) {
+            totals->latency_buckets[j] += read_counter(shard->latency_buckets + j);
+        }
+    }
+}
+
+static void flush_writer(metrics_writer_t* writer) {
+    divulge_send_chunk(writer->request, writer->buffer, writer->size);
+    writer->size = 0;
+}
+
+static void write_line(metrics_writer_t* writer, const char* format, ...) {
+    char line[WRITER_BUFFER_SIZE];
+    va_list arguments;
+    va_start(arguments, format);
+    int size = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+    if (size < 0) {
+        return;
+    }
+    size_t line_size = ((size_t)size < sizeof(line)) ? (size_t)size : (sizeof(line) - 1);
+    if (line_size > (sizeof(writer->buffer) - writer->size)) {
+        flush_writer(writer);
+    }
+    memcpy(writer->buffer + writer->size, line, line_size);
+    writer->size += line_size;
+}
+
+static void format_labels(const divulge_route_metrics_t* route_metrics, char* labels, size_t labels_size) {
+    size_t size = (size_t)snprintf(labels, labels_size, "method=\"%s\",route=\"",
+                                   divulge_method_name_from_method(route_metrics->method));
+    for (const char* c = route_metrics->route; *c && ((size + 3) < labels_size); c++) {
+        if ((*c == '"') || (*c == '\\')) {
+            labels[size++] = '\\';
+        }
+        labels[size++] = *c;
+    }
+    labels[size++] = '"';
+    labels[size] = '\0';
+}
+
+static uint64_t get_request_count(const metrics_totals_t* totals) {
+    uint64_t request_count = 0;
+    for (size_t i = 0; i < DIVULGE_METRICS_STATUS_CLASS_COUNT; i++) {
+        request_count += totals->status_counts[i];
+    }
+    return request_count;
+}
+
+static void write_request_counts(metrics_writer_t* writer, const char* labels, const metrics_totals_t* totals) {
+    for (size_t i = 0; i < DIVULGE_METRICS_STATUS_CLASS_COUNT; i++) {
+        write_line(writer, "divulge_requests_total{%s,code=\"%zuxx\"} %" PRIu64 "\n", labels, i + 1,
+                   totals->status_counts[i]);
+    }
+}
+
+static void write_response_bytes(metrics_writer_t* writer, const char* labels, const metrics_totals_t* totals) {
+    write_line(writer, "divulge_response_bytes_total{%s} %" PRIu64 "\n", labels, totals->sent_size);
+}
+
+static void write_latency_histogram(metrics_writer_t* writer, const char* labels, const metrics_totals_t* totals) {
+    uint64_t cumulative_count = 0;
+    for (size_t i = 0; i < (DIVULGE_METRICS_LATENCY_BUCKET_COUNT - 1); i++) {
+        uint64_t bound_us = divulge_metrics_get_latency_bucket_bound_us(i);
+        cumulative_count += totals->latency_buckets[i];
+        write_line(writer, "divulge_request_duration_seconds_bucket{%s,le=\"%" PRIu64 ".%06" PRIu64 "\"} %" PRIu64 "\n",
+                   labels, bound_us / MICROSECONDS_PER_SECOND, bound_us % MICROSECONDS_PER_SECOND, cumulative_count);
+    }
+    uint64_t request_count = get_request_count(totals);
+    write_line(writer, "divulge_request_duration_seconds_bucket{%s,le=\"+Inf\"} %" PRIu64 "\n", labels,
+               request_count);
+    write_line(writer, "divulge_request_duration_seconds_sum{%s} %" PRIu64 ".%06" PRIu64 "\n", labels,
+               totals->latency_sum_us / MICROSECONDS_PER_SECOND, totals->latency_sum_us % MICROSECONDS_PER_SECOND);
+    write_line(writer, "divulge_request_duration_seconds_count{%s} %" PRIu64 "\n", labels, request_count);
+}
+
+static void write_route_family(metrics_writer_t* writer,
+                               divulge_route_metrics_t* route_metrics,
+                               void (*write_samples)(metrics_writer_t*, const char*, const metrics_totals_t*)) {
+    metrics_totals_t totals;
+    collect_totals(route_metrics, &totals);
+    char labels[LABELS_MAX_SIZE];
+    format_labels(route_metrics, labels, sizeof(labels));
+    write_samples(writer, labels, &totals);
+}
+
+static void write_family(metrics_writer_t* writer,
+                         divulge_metrics_t* metrics,
+                         const char* name,
+                         const char* type,
+                         const char* help,
+                         void (*write_samples)(metrics_writer_t*, const char*, const metrics_totals_t*)) {
+    write_line(writer, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    for (divulge_route_metrics_t* route_metrics = metrics->routes; route_metrics; route_metrics = route_metrics->next) {
+        write_route_family(writer, route_metrics, write_samples);
+    }
+    write_route_family(writer, &metrics->unmatched_route, write_samples);
+}
+
+bool divulge_metrics_respond(divulge_request_t* request, void* context) {
+    divulge_metrics_t* metrics = (divulge_metrics_t*)context;
+    if (!request || !metrics) {
+        return false;
+    }
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Content-Type", .value = "text/plain; version=0.0.4"},
+        {.key = "Cache-Control", .value = "no-store"},
+    };
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.entries = header_entries, .count = 2},
+    };
+    divulge_begin_chunked_response(request, &response);
+    metrics_writer_t writer = {.request = request};
+    write_family(&writer, metrics, "divulge_requests_total", "counter", "Requests handled per route and status class.",
+                 write_request_counts);
+    write_family(&writer, metrics, "divulge_response_bytes_total", "counter", "Bytes sent in responses per route.",
+                 write_response_bytes);
+    write_family(&writer, metrics, "divulge_request_duration_seconds", "histogram", "Request handling latency.",
+                 write_latency_histogram);
+    flush_writer(&writer);
+    return divulge_end_chunked_response(request);
+}
+
+void divulge_metrics_destroy(divulge_metrics_t* metrics) {
+    if (!metrics) {
+        return;
+    }
+    divulge_route_metrics_t* route_metrics = metrics->routes;
+    while (route_metrics) {
+        divulge_route_metrics_t* next = route_metrics->next;
+        free(route_metrics);
+        route_metrics = next;
+    }
+    free(metrics);
+}
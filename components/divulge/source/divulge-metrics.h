@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_METRICS_H
+#define DIVULGE_METRICS_H
+
+#include "divulge.h"
+
+#define DIVULGE_METRICS_SHARD_COUNT (4)
+#define DIVULGE_METRICS_LATENCY_MIN_EXPONENT (4)
+#define DIVULGE_METRICS_LATENCY_MAX_EXPONENT (26)
+#define DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT (2)
+#define DIVULGE_METRICS_LATENCY_BUCKET_COUNT                                              \
+    (((DIVULGE_METRICS_LATENCY_MAX_EXPONENT - DIVULGE_METRICS_LATENCY_MIN_EXPONENT) * \
+      DIVULGE_METRICS_LATENCY_SUB_BUCKET_COUNT) +                                         \
+     1)
+#define DIVULGE_METRICS_STATUS_CLASS_COUNT (5)
+
+typedef struct divulge_metrics divulge_metrics_t;
+
+typedef struct divulge_route_metrics divulge_route_metrics_t;
+
+divulge_metrics_t* divulge_metrics_create(void);
+
+divulge_route_metrics_t* divulge_metrics_add_route(divulge_metrics_t* metrics,
+                                                   const char* route,
+                                                   divulge_route_method_t method);
+
+divulge_route_metrics_t* divulge_metrics_get_unmatched_route(divulge_metrics_t* metrics);
+
+void divulge_metrics_record(divulge_route_metrics_t* route_metrics,
+                            int return_code,
+                            size_t sent_size,
+                            uint64_t latency_us);
+
+size_t divulge_metrics_get_latency_bucket_index(uint64_t latency_us);
+
+uint64_t divulge_metrics_get_latency_bucket_bound_us(size_t bucket_index);
+
+bool divulge_metrics_respond(divulge_request_t* request, void* context);
+
+void divulge_metrics_destroy(divulge_metrics_t* metrics);
+
+#endif  // DIVULGE_METRICS_H
@@ -0,0 +1,445 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-multipart.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEDIA_TYPE "multipart/form-data"
+
+enum {
+    STATE_PREAMBLE,
+    STATE_DELIMITER_END,
+    STATE_DELIMITER_LF,
+    STATE_CLOSING_DASH,
+    STATE_HEADERS,
+    STATE_DATA,
+    STATE_COMPLETE,
+    STATE_ERROR,
+    STATE_ABORTED,
+};
+
+typedef struct read_context {
+    divulge_multipart_parser_t parser;
+    bool is_parser_stopped;
+} read_context_t;
+
+static bool is_equal_ignoring_case(const char* text, size_t length, const char* reference) {
+    size_t i = 0;
+    for (; (i < length) && reference[i]; i++) {
+        if (tolower((unsigned char)text[i]) != reference[i]) {
+            return false;
+        }
+    }
+    return (i == length) && !reference[i];
+}
+
+static bool is_blank(char c) {
+    return (c == ' ') || (c == '\t');
+}
+
+static static_string_t trim(const char* text, size_t length) {
+    while ((length > 0) && is_blank(*text)) {
+        text++;
+        length--;
+    }
+    while ((length > 0) && is_blank(text[length - 1])) {
+        length--;
+    }
+    return (static_string_t){.text = (char*)text, .length = length};
+}
+
+static bool is_boundary_character(char c) {
+    return isalnum((unsigned char)c) || (c && strchr("'()+_,-./:=? ", c));
+}
+
+static bool is_boundary_valid(static_string_t boundary) {
+    if (!boundary.text || (boundary.length == 0) || (boundary.length > DIVULGE_MULTIPART_BOUNDARY_MAX_LENGTH) ||
+        (boundary.text[boundary.length - 1] == ' ')) {
+        return false;
+    }
+    for (size_t i = 0; i < boundary.length; i++) {
+        if (!is_boundary_character(boundary.text[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Parameter values are NUL terminated in place, so the buffer must have one spare byte after `end`. Returns the
+ * position after the parameter and its separator.
+ */
+static char* parse_parameter(char* position, char* end, static_string_t* name, static_string_t* value) {
+    while ((position < end) && is_blank(*position)) {
+        position++;
+    }
+    char* name_start = position;
+    while ((position < end) && (*position != '=') && (*position != ';')) {
+        position++;
+    }
+    *name = trim(name_start, position - name_start);
+    *value = (static_string_t){.text = position, .length = 0};
+    if ((position >= end) || (*position == ';')) {
+        return position + 1;
+    }
+    position++;
+    while ((position < end) && is_blank(*position)) {
+        position++;
+    }
+    char* value_end = NULL;
+    if ((position < end) && (*position == '"')) {
+        value->text = ++position;
+        while ((position < end) && (*position != '"')) {
+            position++;
+        }
+        value_end = position;
+        while ((position < end) && (*position != ';')) {
+            position++;
+        }
+        value->length = value_end - value->text;
+    } else {
+        value->text = position;
+        while ((position < end) && (*position != ';')) {
+            position++;
+        }
+        *value = trim(value->text, position - value->text);
+        value_end = value->text + value->length;
+    }
+    char* next = position + 1;
+    *value_end = '\0';
+    return next;
+}
+
+static void parse_content_disposition(divulge_multipart_part_t* part, char* value, char* end) {
+    char* position = value;
+    while (position < end) {
+        static_string_t name;
+        static_string_t parameter;
+        position = parse_parameter(position, end, &name, &parameter);
+        if (is_equal_ignoring_case(name.text, name.length, "name")) {
+            part->name = parameter;
+        } else if (is_equal_ignoring_case(name.text, name.length, "filename")) {
+            part->file_name = parameter;
+        }
+    }
+}
+
+static bool parse_headers(divulge_multipart_parser_t* parser) {
+    divulge_multipart_part_t* part = &parser->part;
+    *part = (divulge_multipart_part_t){
+        .name = {.text = "", .length = 0},
+        .file_name = {.text = "", .length = 0},
+        .content_type = {.text = "", .length = 0},
+    };
+    bool has_disposition = false;
+    char* position = parser->headers;
+    char* headers_end = parser->headers + parser->headers_size;
+    while (position < headers_end) {
+        char* line_end = memchr(position, '\n', headers_end - position);
+        if (!line_end) {
+            line_end = headers_end;
+        }
+        char* colon = memchr(position, ':', line_end - position);
+        if (!colon) {
+            return false;
+        }
+        static_string_t name = trim(position, colon - position);
+        if (is_equal_ignoring_case(name.text, name.length, "content-disposition")) {
+            parse_content_disposition(part, colon + 1, line_end);
+            has_disposition = true;
+        } else if (is_equal_ignoring_case(name.text, name.length, "content-type")) {
+            part->content_type = trim(colon + 1, line_end - (colon + 1));
+            part->content_type.text[part->content_type.length] = '\0';
+        }
+        position = line_end + 1;
+    }
+    return has_disposition;
+}
+
+static bool emit_data(divulge_multipart_parser_t* parser, const char* data, size_t data_size) {
+    if ((parser->state != STATE_DATA) || (data_size == 0) || !parser->handlers->part_data) {
+        return true;
+    }
+    return parser->handlers->part_data(parser->request, &parser->part, data, data_size, parser->handlers->context);
+}
+
+static bool call_part_handler(divulge_multipart_parser_t* parser, divulge_multipart_part_handler_t handler) {
+    return !handler || handler(parser->request, &parser->part, parser->handlers->context);
+}
+
+/*
+ * Delimiter bytes are held back in `match_length` until they either complete the delimiter or mismatch. Only the
+ * first delimiter byte is a CR and the boundary cannot contain one, so on a mismatch the held back bytes are plain
+ * data and matching restarts at the current byte.
+ */
+static size_t search_delimiter(divulge_multipart_parser_t* parser, const char* data, size_t data_size) {
+    size_t position = 0;
+    while (position < data_size) {
+        if (parser->match_length == 0) {
+            const char* carriage_return = memchr(data + position, '\r', data_size - position);
+            size_t run_end = carriage_return ? (size_t)(carriage_return - data) : data_size;
+            if (!emit_data(parser, data + position, run_end - position)) {
+                parser->state = STATE_ABORTED;
+                return position;
+            }
+            position = run_end;
+            if (carriage_return) {
+                parser->match_length = 1;
+                position++;
+            }
+        } else if (data[position] == parser->delimiter[parser->match_length]) {
+            position++;
+            if (++parser->match_length == parser->delimiter_length) {
+                parser->match_length = 0;
+                if ((parser->state == STATE_DATA) && !call_part_handler(parser, parser->handlers->part_end)) {
+                    parser->state = STATE_ABORTED;
+                } else {
+                    parser->state = STATE_DELIMITER_END;
+                }
+                return position;
+            }
+        } else {
+            if (!emit_data(parser, parser->delimiter, parser->match_length)) {
+                parser->state = STATE_ABORTED;
+                return position;
+            }
+            parser->match_length = 0;
+        }
+    }
+    return position;
+}
+
+static void parse_header_byte(divulge_multipart_parser_t* parser, char c) {
+    if (c == '\r') {
+        return;
+    }
+    if (c != '\n') {
+        if (parser->headers_size >= DIVULGE_MULTIPART_HEADERS_MAX_SIZE) {
+            parser->state = STATE_ERROR;
+            return;
+        }
+        parser->headers[parser->headers_size++] = c;
+        parser->header_line_length++;
+        return;
+    }
+    if (parser->header_line_length > 0) {
+        if (parser->headers_size >= DIVULGE_MULTIPART_HEADERS_MAX_SIZE) {
+            parser->state = STATE_ERROR;
+            return;
+        }
+        parser->headers[parser->headers_size++] = c;
+        parser->header_line_length = 0;
+        return;
+    }
+    if ((parser->headers_size > 0) && (parser->headers[parser->headers_size - 1] == '\n')) {
+        parser->headers_size--;
+    }
+    parser->headers[parser->headers_size] = '\0';
+    if (!parse_headers(parser)) {
+        parser->state = STATE_ERROR;
+    } else if (!call_part_handler(parser, parser->handlers->part_begin)) {
+        parser->state = STATE_ABORTED;
+    } else {
+        parser->state = STATE_DATA;
+    }
+}
+
+static void parse_delimiter_end_byte(divulge_multipart_parser_t* parser, char c) {
+    switch (parser->state) {
+        case STATE_DELIMITER_END:
+            if (c == '-') {
+                parser->state = STATE_CLOSING_DASH;
+            } else if (c == '\r') {
+                parser->state = STATE_DELIMITER_LF;
+            } else if (c == '\n') {
+                parser->headers_size = 0;
+                parser->header_line_length = 0;
+                parser->state = STATE_HEADERS;
+            } else if (!is_blank(c)) {
+                parser->state = STATE_ERROR;
+            }
+            break;
+        case STATE_DELIMITER_LF:
+            parser->headers_size = 0;
+            parser->header_line_length = 0;
+            parser->state = (c == '\n') ? STATE_HEADERS : STATE_ERROR;
+            break;
+        case STATE_CLOSING_DASH:
+            parser->state = (c == '-') ? STATE_COMPLETE : STATE_ERROR;
+            break;
+        default:
+            break;
+    }
+}
+
+bool divulge_multipart_get_boundary(static_string_t content_type, static_string_t* boundary) {
+    if (!content_type.text || !boundary) {
+        return false;
+    }
+    const char* end = content_type.text + content_type.length;
+    const char* separator = memchr(content_type.text, ';', content_type.length);
+    static_string_t media_type = trim(content_type.text, (separator ? separator : end) - content_type.text);
+    if (!separator || !is_equal_ignoring_case(media_type.text, media_type.length, MEDIA_TYPE)) {
+        return false;
+    }
+    const char* position = separator + 1;
+    while (position < end) {
+        const char* parameter_end = memchr(position, ';', end - position);
+        if (!parameter_end) {
+            parameter_end = end;
+        }
+        const char* equals = memchr(position, '=', parameter_end - position);
+        if (equals) {
+            static_string_t name = trim(position, equals - position);
+            static_string_t value = trim(equals + 1, parameter_end - (equals + 1));
+            if (is_equal_ignoring_case(name.text, name.length, "boundary")) {
+                if ((value.length >= 2) && (value.text[0] == '"') && (value.text[value.length - 1] == '"')) {
+                    value.text++;
+                    value.length -= 2;
+                }
+                *boundary = value;
+                return is_boundary_valid(value);
+            }
+        }
+        position = parameter_end + 1;
+    }
+    return false;
+}
+
+bool divulge_multipart_parser_reset(divulge_multipart_parser_t* parser,
+                                    static_string_t boundary,
+                                    const divulge_multipart_handlers_t* handlers,
+                                    divulge_request_t* request) {
+    if (!parser || !handlers || !is_boundary_valid(boundary)) {
+        return false;
+    }
+    memset(parser, 0, sizeof(*parser));
+    memcpy(parser->delimiter, "\r\n--", 4);
+    memcpy(parser->delimiter + 4, boundary.text, boundary.length);
+    parser->delimiter_length = boundary.length + 4;
+    parser->match_length = 2;
+    parser->state = STATE_PREAMBLE;
+    parser->handlers = handlers;
+    parser->request = request;
+    return true;
+}
+
+divulge_multipart_parser_status_t divulge_multipart_parser_execute(divulge_multipart_parser_t* parser,
+                                                                   const char* data,
+                                                                   size_t data_size) {
+    if (!parser || (!data && (data_size > 0))) {
+        return DIVULGE_MULTIPART_PARSER_STATUS_ERROR;
+    }
+    size_t position = 0;
+    while ((position < data_size) && (parser->state != STATE_COMPLETE) && (parser->state != STATE_ERROR) &&
+           (parser->state != STATE_ABORTED)) {
+        if ((parser->state == STATE_PREAMBLE) || (parser->state == STATE_DATA)) {
+            position += search_delimiter(parser, data + position, data_size - position);
+        } else if (parser->state == STATE_HEADERS) {
+            parse_header_byte(parser, data[position++]);
+        } else {
+            parse_delimiter_end_byte(parser, data[position++]);
+        }
+    }
+    switch (parser->state) {
+        case STATE_COMPLETE:
+            return DIVULGE_MULTIPART_PARSER_STATUS_COMPLETE;
+        case STATE_ERROR:
+            return DIVULGE_MULTIPART_PARSER_STATUS_ERROR;
+        case STATE_ABORTED:
+            return DIVULGE_MULTIPART_PARSER_STATUS_ABORTED;
+        default:
+            return DIVULGE_MULTIPART_PARSER_STATUS_INCOMPLETE;
+    }
+}
+
+static bool read_body_chunk(divulge_request_t* request, const char* data, size_t data_size, void* context) {
+    (void)request;
+    read_context_t* ctx = (read_context_t*)context;
+    if (ctx->is_parser_stopped) {
+        return true;
+    }
+    divulge_multipart_parser_status_t status = divulge_multipart_parser_execute(&ctx->parser, data, data_size);
+    if (status == DIVULGE_MULTIPART_PARSER_STATUS_COMPLETE) {
+        ctx->is_parser_stopped = true;
+    }
+    return (status == DIVULGE_MULTIPART_PARSER_STATUS_INCOMPLETE) ||
+           (status == DIVULGE_MULTIPART_PARSER_STATUS_COMPLETE);
+}
+
+static void respond_with_status(divulge_request_t* request, int return_code) {
+    if (divulge_is_response_started(request)) {
+        return;
+    }
+    divulge_response_t response = {
+        .return_code = return_code,
+        .payload = "",
+        .payload_size = 0,
+    };
+    divulge_respond(request, &response);
+}
+
+static bool handler(divulge_request_t* request, void* context) {
+    const divulge_multipart_handlers_t* handlers = (const divulge_multipart_handlers_t*)context;
+    static_string_t boundary;
+    read_context_t ctx = {0};
+    if (!divulge_multipart_get_boundary(divulge_get_request_header(request, "Content-Type"), &boundary) ||
+        !divulge_multipart_parser_reset(&ctx.parser, boundary, handlers, request)) {
+        respond_with_status(request, 415);
+        return false;
+    }
+    if (!divulge_read_body(request, read_body_chunk, &ctx) || !ctx.is_parser_stopped) {
+        respond_with_status(request, 400);
+        return false;
+    }
+    return true;
+}
+
+divulge_handler_object_t* divulge_multipart_create(const divulge_multipart_handlers_t* handlers) {
+    if (!handlers) {
+        return NULL;
+    }
+    divulge_handler_object_t* object = calloc(1, sizeof(divulge_handler_object_t));
+    if (!object) {
+        return NULL;
+    }
+    divulge_multipart_handlers_t* ctx = calloc(1, sizeof(divulge_multipart_handlers_t));
+    if (!ctx) {
+        free(object);
+        return NULL;
+    }
+    *ctx = *handlers;
+    object->context = ctx;
+    object->handler = handler;
+    return object;
+}
+
+void divulge_multipart_destroy(divulge_handler_object_t* middleware) {
+    if (!middleware) {
+        return;
+    }
+    free(middleware->context);
+    free(middleware);
+}
@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_MULTIPART_H
+#define DIVULGE_MULTIPART_H
+
+#include "divulge.h"
+
+/**
+ * @defgroup divulge-multipart Divulge multipart
+ * @ingroup divulge
+ * @brief Streaming multipart/form-data parser and upload middleware
+ *
+ * The parser accepts the request body in pieces of any size and reports every part through callbacks: once when
+ * its headers are parsed, for each piece of its content and once when it ends. Boundary delimiters split between
+ * pieces are recognised without buffering the content, so uploads of any size need only the parser state.
+ * @{
+ */
+
+#define DIVULGE_MULTIPART_BOUNDARY_MAX_LENGTH (70)
+#define DIVULGE_MULTIPART_HEADERS_MAX_SIZE (512)
+
+typedef enum divulge_multipart_parser_status {
+    DIVULGE_MULTIPART_PARSER_STATUS_INCOMPLETE, /**< @brief more input is needed */
+    DIVULGE_MULTIPART_PARSER_STATUS_COMPLETE,   /**< @brief the closing delimiter was parsed */
+    DIVULGE_MULTIPART_PARSER_STATUS_ERROR,      /**< @brief the body is malformed or part headers are too large */
+    DIVULGE_MULTIPART_PARSER_STATUS_ABORTED,    /**< @brief a callback requested to stop parsing */
+} divulge_multipart_parser_status_t;
+
+typedef struct divulge_multipart_part {
+    static_string_t name;         /**< @brief form field name from Content-Disposition */
+    static_string_t file_name;    /**< @brief file name from Content-Disposition, empty if not a file */
+    static_string_t content_type; /**< @brief Content-Type of the part, empty if not given */
+} divulge_multipart_part_t;
+
+typedef bool (*divulge_multipart_part_handler_t)(divulge_request_t* request,
+                                                 const divulge_multipart_part_t* part,
+                                                 void* context);
+
+typedef bool (*divulge_multipart_data_handler_t)(divulge_request_t* request,
+                                                 const divulge_multipart_part_t* part,
+                                                 const char* data,
+                                                 size_t data_size,
+                                                 void* context);
+
+typedef struct divulge_multipart_handlers {
+    divulge_multipart_part_handler_t part_begin; /**< @brief called when headers of a part were parsed */
+    divulge_multipart_data_handler_t part_data;  /**< @brief called for every piece of the part content */
+    divulge_multipart_part_handler_t part_end;   /**< @brief called when the part content ends */
+    void* context;                               /**< @brief context passed to all handlers */
+} divulge_multipart_handlers_t;
+
+typedef struct divulge_multipart_parser {
+    int state;
+    char delimiter[DIVULGE_MULTIPART_BOUNDARY_MAX_LENGTH + 4]; /**< @brief CRLF, two dashes and the boundary */
+    size_t delimiter_length;
+    size_t match_length; /**< @brief number of delimiter bytes matched so far and held back */
+    char headers[DIVULGE_MULTIPART_HEADERS_MAX_SIZE + 1];
+    size_t headers_size;
+    size_t header_line_length;
+    divulge_multipart_part_t part;
+    const divulge_multipart_handlers_t* handlers;
+    divulge_request_t* request;
+} divulge_multipart_parser_t;
+
+/**
+ * @brief Extract the boundary parameter of a multipart/form-data Content-Type
+ * @param[in] content_type value of the Content-Type header
+ * @param[out] boundary boundary text, without quotes
+ * @return true if the content type is multipart/form-data with a valid boundary
+ */
+bool divulge_multipart_get_boundary(static_string_t content_type, static_string_t* boundary);
+
+/**
+ * @brief Prepare the parser for a new body
+ * @param[in] parser pointer to the parser
+ * @param[in] boundary boundary from the Content-Type header
+ * @param[in] handlers callbacks receiving the parts
+ * @param[in] request request passed to the callbacks; may be NULL
+ * @return true if the boundary is valid
+ */
+bool divulge_multipart_parser_reset(divulge_multipart_parser_t* parser,
+                                    static_string_t boundary,
+                                    const divulge_multipart_handlers_t* handlers,
+                                    divulge_request_t* request);
+
+/**
+ * @brief Parse the next piece of the body
+ * @param[in] parser pointer to the parser
+ * @param[in] data pointer to the body bytes
+ * @param[in] data_size number of body bytes
+ * @return status of the body after this piece; data after the closing delimiter is ignored
+ */
+divulge_multipart_parser_status_t divulge_multipart_parser_execute(divulge_multipart_parser_t* parser,
+                                                                   const char* data,
+                                                                   size_t data_size);
+
+/**
+ * @brief Create a middleware streaming multipart/form-data request bodies into the handlers
+ *
+ * The middleware consumes the whole body before the route handler is called. Requests that are not
+ * multipart/form-data get 415, malformed bodies get 400. When a handler returns false the upload is aborted and,
+ * unless the handler already responded, 400 is sent.
+ * @param[in] handlers callbacks receiving the parts; copied
+ * @return middleware object or NULL if allocation failed
+ */
+divulge_handler_object_t* divulge_multipart_create(const divulge_multipart_handlers_t* handlers);
+
+/**
+ * @brief Destroy a middleware created with divulge_multipart_create()
+ */
+void divulge_multipart_destroy(divulge_handler_object_t* middleware);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_MULTIPART_H
@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-range.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define RANGE_UNIT "bytes="
+
+typedef struct range_cursor {
+    const char* text;
+    size_t length;
+    size_t position;
+} range_cursor_t;
+
+static void skip_blanks(range_cursor_t* cursor) {
+    while ((cursor->position < cursor->length) &&
+           ((cursor->text[cursor->position] == ' ') || (cursor->text[cursor->position] == '\t'))) {
+        cursor->position++;
+    }
+}
+
+static bool is_digit_at(const range_cursor_t* cursor) {
+    return (cursor->position < cursor->length) && (cursor->text[cursor->position] >= '0') &&
+           (cursor->text[cursor->position] <= '9');
+}
+
+static bool parse_number(range_cursor_t* cursor, size_t* number) {
+    if (!is_digit_at(cursor)) {
+        return false;
+    }
+    size_t value = 0;
+    while (is_digit_at(cursor)) {
+        size_t digit = (size_t)(cursor->text[cursor->position++] - '0');
+        if (value > ((SIZE_MAX - digit) / 10)) {
+            value = SIZE_MAX;
+        } else {
+            value = (value * 10) + digit;
+        }
+    }
+    *number = value;
+    return true;
+}
+
+static bool parse_range(range_cursor_t* cursor, size_t content_size, divulge_range_t* range, bool* is_satisfiable) {
+    size_t first = 0;
+    size_t last = 0;
+    bool has_first = parse_number(cursor, &first);
+    if ((cursor->position >= cursor->length) || (cursor->text[cursor->position] != '-')) {
+        return false;
+    }
+    cursor->position++;
+    bool has_last = parse_number(cursor, &last);
+    if (!has_first) {
+        if (!has_last) {
+            return false;
+        }
+        *is_satisfiable = (last > 0) && (content_size > 0);
+        size_t size = (last < content_size) ? last : content_size;
+        *range = (divulge_range_t){.offset = content_size - size, .size = size};
+        return true;
+    }
+    if (has_last && (last < first)) {
+        return false;
+    }
+    *is_satisfiable = (first < content_size);
+    if (*is_satisfiable) {
+        if (!has_last || (last >= content_size)) {
+            last = content_size - 1;
+        }
+        *range = (divulge_range_t){.offset = first, .size = last - first + 1};
+    }
+    return true;
+}
+
+divulge_range_status_t divulge_range_parse(static_string_t value,
+                                           size_t content_size,
+                                           divulge_range_t* ranges,
+                                           size_t max_range_count,
+                                           size_t* range_count) {
+    size_t unit_length = strlen(RANGE_UNIT);
+    if (!value.text || !ranges || !range_count || (value.length <= unit_length) ||
+        (memcmp(value.text, RANGE_UNIT, unit_length) != 0)) {
+        return DIVULGE_RANGE_STATUS_IGNORED;
+    }
+    range_cursor_t cursor = {.text = value.text, .length = value.length, .position = unit_length};
+    size_t count = 0;
+    bool has_range = false;
+    while (cursor.position < cursor.length) {
+        skip_blanks(&cursor);
+        if ((cursor.position < cursor.length) && (cursor.text[cursor.position] == ',')) {
+            cursor.position++;
+            continue;
+        }
+        divulge_range_t range;
+        bool is_satisfiable = false;
+        if (!parse_range(&cursor, content_size, &range, &is_satisfiable)) {
+            return DIVULGE_RANGE_STATUS_IGNORED;
+        }
+        has_range = true;
+        if (is_satisfiable) {
+            if (count >= max_range_count) {
+                return DIVULGE_RANGE_STATUS_IGNORED;
+            }
+            ranges[count++] = range;
+        }
+        skip_blanks(&cursor);
+        if ((cursor.position < cursor.length) && (cursor.text[cursor.position] != ',')) {
+            return DIVULGE_RANGE_STATUS_IGNORED;
+        }
+    }
+    if (!has_range) {
+        return DIVULGE_RANGE_STATUS_IGNORED;
+    }
+    *range_count = count;
+    return (count > 0) ? DIVULGE_RANGE_STATUS_SATISFIABLE : DIVULGE_RANGE_STATUS_UNSATISFIABLE;
+}
@@ -0,0 +1,71 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_RANGE_H
+#define DIVULGE_RANGE_H
+
+#include <stddef.h>
+#include "static-string.h"
+
+/**
+ * @defgroup divulge-range Divulge range
+ * @ingroup divulge
+ * @brief Parser of the Range request header for byte ranges
+ *
+ * Ranges are resolved against the size of the representation: open ended and suffix ranges are converted to
+ * offsets, ends past the representation are clamped and ranges starting past it are dropped.
+ * @{
+ */
+
+#define DIVULGE_RANGE_MAX_COUNT (8)
+
+typedef enum divulge_range_status {
+    DIVULGE_RANGE_STATUS_IGNORED,       /**< @brief the header is malformed or asks too much; send everything */
+    DIVULGE_RANGE_STATUS_SATISFIABLE,   /**< @brief at least one range overlaps the representation */
+    DIVULGE_RANGE_STATUS_UNSATISFIABLE, /**< @brief no range overlaps the representation */
+} divulge_range_status_t;
+
+typedef struct divulge_range {
+    size_t offset;
+    size_t size;
+} divulge_range_t;
+
+/**
+ * @brief Parse the value of a Range header
+ * @param[in] value value of the Range header
+ * @param[in] content_size size of the representation
+ * @param[out] ranges satisfiable ranges in the order of the header
+ * @param[in] max_range_count capacity of ranges; more satisfiable ranges make the header ignored
+ * @param[out] range_count number of satisfiable ranges
+ * @return status of the header
+ */
+divulge_range_status_t divulge_range_parse(static_string_t value,
+                                           size_t content_size,
+                                           divulge_range_t* ranges,
+                                           size_t max_range_count,
+                                           size_t* range_count);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_RANGE_H
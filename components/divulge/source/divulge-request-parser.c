@@ -0,0 +1,206 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-request-parser.h"
+#include <string.h>
+
+#define METHOD_MAX_LENGTH (16)
+#define VERSION_PREFIX "HTTP/1."
+#define VERSION_LENGTH (sizeof(VERSION_PREFIX))
+
+typedef enum parser_state {
+    STATE_METHOD,
+    STATE_PATH_START,
+    STATE_PATH,
+    STATE_QUERY,
+    STATE_VERSION,
+    STATE_REQUEST_LINE_END,
+    STATE_HEADER_LINE_START,
+    STATE_HEADER_NAME,
+    STATE_HEADER_VALUE_START,
+    STATE_HEADER_VALUE,
+    STATE_HEADER_LINE_END,
+    STATE_HEAD_END,
+    STATE_COMPLETE,
+    STATE_ERROR,
+    STATE_TOO_MANY_HEADERS,
+} parser_state_t;
+
+void divulge_request_parser_reset(divulge_request_parser_t* parser) {
+    if (!parser) {
+        return;
+    }
+    memset(parser, 0, sizeof(*parser));
+    parser->state = STATE_METHOD;
+}
+
+static bool is_token_character(char c) {
+    if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))) {
+        return true;
+    }
+    return (strchr("!#$%&'*+-.^_`|~", c) != NULL) && (c != '\0');
+}
+
+static bool is_control_character(char c) {
+    return ((unsigned char)c < 0x20) || (c == 0x7F);
+}
+
+static bool is_whitespace(char c) {
+    return (c == ' ') || (c == '\t');
+}
+
+static void close_span(divulge_request_span_t* span, size_t mark, size_t position) {
+    span->offset = mark;
+    span->length = position - mark;
+}
+
+static bool is_version_valid(const char* buffer, const divulge_request_span_t* version) {
+    if (version->length != VERSION_LENGTH) {
+        return false;
+    }
+    const char* text = buffer + version->offset;
+    char minor = text[VERSION_LENGTH - 1];
+    return (memcmp(text, VERSION_PREFIX, VERSION_LENGTH - 1) == 0) && (minor >= '0') && (minor <= '9');
+}
+
+static parser_state_t finish_request_line(divulge_request_parser_t* parser,
+                                          const char* buffer,
+                                          size_t position,
+                                          parser_state_t next_state) {
+    close_span(&parser->version, parser->mark, position);
+    return is_version_valid(buffer, &parser->version) ? next_state : STATE_ERROR;
+}
+
+static parser_state_t finish_header(divulge_request_parser_t* parser, parser_state_t next_state) {
+    parser->header_count++;
+    return next_state;
+}
+
+static parser_state_t start_header(divulge_request_parser_t* parser, size_t position) {
+    if (parser->header_count >= DIVULGE_REQUEST_PARSER_HEADERS_MAX_COUNT) {
+        return STATE_TOO_MANY_HEADERS;
+    }
+    parser->mark = position;
+    return STATE_HEADER_NAME;
+}
+
+static parser_state_t step(divulge_request_parser_t* parser, const char* buffer, size_t position) {
+    char c = buffer[position];
+    divulge_request_parser_header_t* header = parser->headers + parser->header_count;
+    switch ((parser_state_t)parser->state) {
+        case STATE_METHOD:
+            if (c == ' ') {
+                close_span(&parser->method, parser->mark, position);
+                return (parser->method.length > 0) ? STATE_PATH_START : STATE_ERROR;
+            }
+            return (is_token_character(c) && ((position - parser->mark) < METHOD_MAX_LENGTH)) ? STATE_METHOD
+                                                                                              : STATE_ERROR;
+        case STATE_PATH_START:
+            parser->mark = position;
+            return ((c == '/') || (c == '*')) ? STATE_PATH : STATE_ERROR;
+        case STATE_PATH:
+            if ((c == ' ') || (c == '?')) {
+                close_span(&parser->path, parser->mark, position);
+                parser->mark = position + 1;
+                parser->has_query = (c == '?');
+                return parser->has_query ? STATE_QUERY : STATE_VERSION;
+            }
+            return is_control_character(c) ? STATE_ERROR : STATE_PATH;
+        case STATE_QUERY:
+            if (c == ' ') {
+                close_span(&parser->query, parser->mark, position);
+                parser->mark = position + 1;
+                return STATE_VERSION;
+            }
+            return is_control_character(c) ? STATE_ERROR : STATE_QUERY;
+        case STATE_VERSION:
+            if (c == '\r') {
+                return finish_request_line(parser, buffer, position, STATE_REQUEST_LINE_END);
+            } else if (c == '\n') {
+                return finish_request_line(parser, buffer, position, STATE_HEADER_LINE_START);
+            }
+            return ((position - parser->mark) < VERSION_LENGTH) ? STATE_VERSION : STATE_ERROR;
+        case STATE_REQUEST_LINE_END:
+        case STATE_HEADER_LINE_END:
+            return (c == '\n') ? STATE_HEADER_LINE_START : STATE_ERROR;
+        case STATE_HEADER_LINE_START:
+            if (c == '\r') {
+                return STATE_HEAD_END;
+            } else if (c == '\n') {
+                return STATE_COMPLETE;
+            }
+            return is_token_character(c) ? start_header(parser, position) : STATE_ERROR;
+        case STATE_HEADER_NAME:
+            if (c == ':') {
+                close_span(&header->name, parser->mark, position);
+                header->value.offset = position + 1;
+                header->value.length = 0;
+                return STATE_HEADER_VALUE_START;
+            }
+            return is_token_character(c) ? STATE_HEADER_NAME : STATE_ERROR;
+        case STATE_HEADER_VALUE_START:
+            if (is_whitespace(c)) {
+                header->value.offset = position + 1;
+                return STATE_HEADER_VALUE_START;
+            }
+            // fall through
+        case STATE_HEADER_VALUE:
+            if (c == '\r') {
+                return finish_header(parser, STATE_HEADER_LINE_END);
+            } else if (c == '\n') {
+                return finish_header(parser, STATE_HEADER_LINE_START);
+            } else if (is_control_character(c) && (c != '\t')) {
+                return STATE_ERROR;
+            }
+            if (!is_whitespace(c)) {
+                header->value.length = position + 1 - header->value.offset;
+            }
+            return STATE_HEADER_VALUE;
+        case STATE_HEAD_END:
+            return (c == '\n') ? STATE_COMPLETE : STATE_ERROR;
+        default:
+            return STATE_ERROR;
+    }
+}
+
+divulge_request_parser_status_t divulge_request_parser_execute(divulge_request_parser_t* parser,
+                                                               const char* buffer,
+                                                               size_t buffer_size) {
+    if (!parser || !buffer) {
+        return DIVULGE_REQUEST_PARSER_STATUS_ERROR;
+    }
+    while ((parser->position < buffer_size) && (parser->state != STATE_COMPLETE) && (parser->state != STATE_ERROR) &&
+           (parser->state != STATE_TOO_MANY_HEADERS)) {
+        parser->state = step(parser, buffer, parser->position);
+        parser->position++;
+    }
+    if (parser->state == STATE_COMPLETE) {
+        parser->head_size = parser->position;
+        return DIVULGE_REQUEST_PARSER_STATUS_COMPLETE;
+    } else if (parser->state == STATE_ERROR) {
+        return DIVULGE_REQUEST_PARSER_STATUS_ERROR;
+    } else if (parser->state == STATE_TOO_MANY_HEADERS) {
+        return DIVULGE_REQUEST_PARSER_STATUS_TOO_MANY_HEADERS;
+    }
+    return DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE;
+}
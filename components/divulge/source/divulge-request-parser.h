@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_REQUEST_PARSER_H
+#define DIVULGE_REQUEST_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @defgroup divulge-request-parser Divulge request parser
+ * @ingroup divulge
+ * @brief Incremental, zero-copy HTTP/1.1 request head parser
+ *
+ * The parser is fed with a growing buffer: every call continues from where the previous one stopped, so data
+ * arriving in several reads is scanned exactly once. Parsed elements are recorded as offsets into the buffer,
+ * which is neither modified nor copied.
+ * @{
+ */
+
+#define DIVULGE_REQUEST_PARSER_HEADERS_MAX_COUNT (32)
+
+typedef enum divulge_request_parser_status {
+    DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE,       /**< @brief more data is needed */
+    DIVULGE_REQUEST_PARSER_STATUS_COMPLETE,         /**< @brief request line and all headers were parsed */
+    DIVULGE_REQUEST_PARSER_STATUS_ERROR,            /**< @brief the request is malformed */
+    DIVULGE_REQUEST_PARSER_STATUS_TOO_MANY_HEADERS, /**< @brief more than DIVULGE_REQUEST_PARSER_HEADERS_MAX_COUNT */
+} divulge_request_parser_status_t;
+
+/**
+ * @brief Location of a parsed element inside the request buffer
+ */
+typedef struct divulge_request_span {
+    size_t offset; /**< @brief offset of the first character */
+    size_t length; /**< @brief number of characters */
+} divulge_request_span_t;
+
+typedef struct divulge_request_parser_header {
+    divulge_request_span_t name;
+    divulge_request_span_t value;
+} divulge_request_parser_header_t;
+
+/**
+ * @brief Parser state and results. Allocate it anywhere and use divulge_request_parser_reset() before first use.
+ */
+typedef struct divulge_request_parser {
+    int state;
+    size_t position;
+    size_t mark;
+    divulge_request_span_t method;
+    divulge_request_span_t path;
+    divulge_request_span_t query;
+    divulge_request_span_t version;
+    divulge_request_parser_header_t headers[DIVULGE_REQUEST_PARSER_HEADERS_MAX_COUNT];
+    size_t header_count;
+    size_t head_size; /**< @brief size of the request line and headers, including the terminating empty line */
+    bool has_query;
+} divulge_request_parser_t;
+
+/**
+ * @brief Prepare the parser for a new request
+ * @param[in] parser pointer to the parser
+ */
+void divulge_request_parser_reset(divulge_request_parser_t* parser);
+
+/**
+ * @brief Continue parsing the request
+ * @param[in] parser pointer to the parser
+ * @param[in] buffer pointer to the request buffer; it has to start with the same bytes as on previous calls
+ * @param[in] buffer_size number of valid bytes in the buffer
+ * @return DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE if the request head is not complete yet
+ * @return DIVULGE_REQUEST_PARSER_STATUS_COMPLETE if the request head was parsed
+ * @return DIVULGE_REQUEST_PARSER_STATUS_ERROR if the request is malformed or pointers are invalid
+ * @return DIVULGE_REQUEST_PARSER_STATUS_TOO_MANY_HEADERS if the request has more headers than the parser can hold
+ */
+divulge_request_parser_status_t divulge_request_parser_execute(divulge_request_parser_t* parser,
+                                                               const char* buffer,
+                                                               size_t buffer_size);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_REQUEST_PARSER_H
@@ -0,0 +1,454 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-response-cache.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "g2l-mutex.h"
+
+#define FNV_OFFSET_BASIS (0xcbf29ce484222325ULL)
+#define FNV_PRIME (0x100000001b3ULL)
+#define ETAG_SIZE (19)
+#define HEADERS_MAX_COUNT (15)
+
+typedef struct cache_entry {
+    uint64_t key_hash;
+    divulge_route_method_t method;
+    char* key;
+    char etag[ETAG_SIZE];
+    divulge_header_entry_t* headers;
+    size_t header_count;
+    char* payload;
+    size_t payload_size;
+    size_t reference_count;
+    uint64_t last_use;
+    bool is_detached;
+} cache_entry_t;
+
+typedef struct request_key {
+    divulge_response_cache_t* cache;
+    uint64_t hash;
+    divulge_route_method_t method;
+    char text[];
+} request_key_t;
+
+typedef struct divulge_response_cache {
+    divulge_handler_object_t middleware;
+    g2l_mutex_t* mutex;
+    cache_entry_t** entries;
+    size_t max_entry_count;
+    size_t max_payload_size;
+    uint64_t use_counter;
+} divulge_response_cache_t;
+
+static uint64_t hash_text(uint64_t hash, const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)text[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t hash_request_key(const divulge_request_t* request) {
+    uint64_t hash = hash_text(FNV_OFFSET_BASIS, request->route, strlen(request->route));
+    if (request->url_query) {
+        hash = hash_text(hash, "?", 1);
+        hash = hash_text(hash, request->url_query, strlen(request->url_query));
+    }
+    return hash_text(hash, (const char*)&request->method, sizeof(request->method));
+}
+
+static bool is_request_key_equal(const cache_entry_t* entry, const divulge_request_t* request) {
+    size_t route_length = strlen(request->route);
+    if ((entry->method != request->method) || (strncmp(entry->key, request->route, route_length) != 0)) {
+        return false;
+    }
+    const char* query = entry->key + route_length;
+    if (!request->url_query) {
+        return (*query == '\0');
+    }
+    return (*query == '?') && (strcmp(query + 1, request->url_query) == 0);
+}
+
+static bool is_cacheable_request(divulge_request_t* request) {
+    if ((request->method != DIVULGE_ROUTE_METHOD_GET) && (request->method != DIVULGE_ROUTE_METHOD_HEAD)) {
+        return false;
+    }
+    return divulge_get_request_header(request, "Authorization").length == 0;
+}
+
+static bool is_text_equal(const char* text, size_t length, const char* reference) {
+    size_t i = 0;
+    for (; (i < length) && reference[i]; i++) {
+        if (tolower((unsigned char)text[i]) != tolower((unsigned char)reference[i])) {
+            return false;
+        }
+    }
+    return (i == length) && !reference[i];
+}
+
+static bool has_directive(const char* value, const char* directive) {
+    while (*value) {
+        if ((*value == ' ') || (*value == '\t') || (*value == ',')) {
+            value++;
+            continue;
+        }
+        size_t length = strcspn(value, " \t,=");
+        if (is_text_equal(value, length, directive)) {
+            return true;
+        }
+        value += length;
+        value += strcspn(value, ",");
+    }
+    return false;
+}
+
+static bool is_cacheable_response(const divulge_response_cache_t* cache, const divulge_response_t* response) {
+    if ((response->return_code != 200) || (response->payload_size > cache->max_payload_size) ||
+        (response->header.count > HEADERS_MAX_COUNT)) {
+        return false;
+    }
+    for (size_t i = 0; i < response->header.count; i++) {
+        const char* key = response->header.entries[i].key;
+        const char* value = response->header.entries[i].value ? response->header.entries[i].value : "";
+        size_t key_length = key ? strlen(key) : 0;
+        if (is_text_equal(key, key_length, "Set-Cookie") || is_text_equal(key, key_length, "Vary") ||
+            is_text_equal(key, key_length, "Content-Encoding")) {
+            return false;
+        }
+        if (is_text_equal(key, key_length, "Cache-Control") &&
+            (has_directive(value, "no-store") || has_directive(value, "private"))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void release_entry(cache_entry_t* entry) {
+    if (--entry->reference_count == 0) {
+        free(entry);
+    }
+}
+
+static void detach_entry(divulge_response_cache_t* cache, size_t index) {
+    cache_entry_t* entry = cache->entries[index];
+    cache->entries[index] = NULL;
+    entry->is_detached = true;
+    release_entry(entry);
+}
+
+static cache_entry_t* acquire_entry(divulge_response_cache_t* cache, const divulge_request_t* request) {
+    uint64_t key_hash = hash_request_key(request);
+    cache_entry_t* result = NULL;
+    g2l_mutex_lock(cache->mutex);
+    for (size_t i = 0; i < cache->max_entry_count; i++) {
+        cache_entry_t* entry = cache->entries[i];
+        if (entry && (entry->key_hash == key_hash) && is_request_key_equal(entry, request)) {
+            entry->reference_count++;
+            entry->last_use = ++cache->use_counter;
+            result = entry;
+            break;
+        }
+    }
+    g2l_mutex_unlock(cache->mutex);
+    return result;
+}
+
+static void release_acquired_entry(divulge_response_cache_t* cache, cache_entry_t* entry) {
+    g2l_mutex_lock(cache->mutex);
+    release_entry(entry);
+    g2l_mutex_unlock(cache->mutex);
+}
+
+static size_t find_store_slot(const divulge_response_cache_t* cache, const cache_entry_t* new_entry) {
+    for (size_t i = 0; i < cache->max_entry_count; i++) {
+        const cache_entry_t* entry = cache->entries[i];
+        if (entry && (entry->key_hash == new_entry->key_hash) && (entry->method == new_entry->method) &&
+            (strcmp(entry->key, new_entry->key) == 0)) {
+            return i;
+        }
+    }
+    size_t slot = 0;
+    for (size_t i = 0; i < cache->max_entry_count; i++) {
+        if (!cache->entries[i]) {
+            return i;
+        } else if (cache->entries[i]->last_use < cache->entries[slot]->last_use) {
+            slot = i;
+        }
+    }
+    return slot;
+}
+
+static void store_entry(divulge_response_cache_t* cache, cache_entry_t* new_entry) {
+    g2l_mutex_lock(cache->mutex);
+    size_t slot = find_store_slot(cache, new_entry);
+    if (cache->entries[slot]) {
+        detach_entry(cache, slot);
+    }
+    new_entry->last_use = ++cache->use_counter;
+    cache->entries[slot] = new_entry;
+    g2l_mutex_unlock(cache->mutex);
+}
+
+static size_t get_copy_size(const char* text) {
+    return text ? (strlen(text) + 1) : 1;
+}
+
+static char* copy_text(char** storage, const char* text) {
+    char* copy = *storage;
+    size_t size = get_copy_size(text);
+    memcpy(copy, text ? text : "", size);
+    *storage += size;
+    return copy;
+}
+
+static request_key_t* create_request_key(divulge_request_t* request, divulge_response_cache_t* cache) {
+    size_t length = strlen(request->route);
+    if (request->url_query) {
+        length += strlen(request->url_query) + 1;
+    }
+    request_key_t* key = divulge_allocate(request, sizeof(request_key_t) + length + 1);
+    if (!key) {
+        return NULL;
+    }
+    key->cache = cache;
+    key->hash = hash_request_key(request);
+    key->method = request->method;
+    strcpy(key->text, request->route);
+    if (request->url_query) {
+        strcat(key->text, "?");
+        strcat(key->text, request->url_query);
+    }
+    return key;
+}
+
+static cache_entry_t* create_entry(const request_key_t* key, const divulge_response_t* response, const char* etag) {
+    size_t size = sizeof(cache_entry_t) + (response->header.count * sizeof(divulge_header_entry_t)) +
+                  strlen(key->text) + 1 + response->payload_size;
+    for (size_t i = 0; i < response->header.count; i++) {
+        size += get_copy_size(response->header.entries[i].key) + get_copy_size(response->header.entries[i].value);
+    }
+    cache_entry_t* entry = calloc(1, size);
+    if (!entry) {
+        return NULL;
+    }
+    entry->headers = (divulge_header_entry_t*)(entry + 1);
+    char* storage = (char*)(entry->headers + response->header.count);
+    entry->header_count = response->header.count;
+    for (size_t i = 0; i < response->header.count; i++) {
+        entry->headers[i].key = copy_text(&storage, response->header.entries[i].key);
+        entry->headers[i].value = copy_text(&storage, response->header.entries[i].value);
+    }
+    entry->key = storage;
+    strcpy(entry->key, key->text);
+    storage += strlen(entry->key) + 1;
+    entry->payload = storage;
+    memcpy(entry->payload, response->payload, response->payload_size);
+    entry->payload_size = response->payload_size;
+    entry->key_hash = key->hash;
+    entry->method = key->method;
+    entry->reference_count = 1;
+    memcpy(entry->etag, etag, ETAG_SIZE);
+    return entry;
+}
+
+static void compute_etag(const divulge_response_t* response, char* etag) {
+    uint64_t hash = hash_text(FNV_OFFSET_BASIS, response->payload, response->payload_size);
+    snprintf(etag, ETAG_SIZE, "\"%016" PRIx64 "\"", hash);
+}
+
+static bool is_etag_matching(divulge_request_t* request, const char* etag) {
+    static_string_t value = divulge_get_request_header(request, "If-None-Match");
+    size_t etag_length = strlen(etag);
+    size_t position = 0;
+    while (position < value.length) {
+        char c = value.text[position];
+        if ((c == ' ') || (c == '\t') || (c == ',')) {
+            position++;
+            continue;
+        }
+        if (c == '*') {
+            return true;
+        }
+        if (((value.length - position) > 2) && (strncmp(value.text + position, "W/", 2) == 0)) {
+            position += 2;
+        }
+        size_t start = position;
+        while ((position < value.length) && (value.text[position] != ',') && (value.text[position] != ' ') &&
+               (value.text[position] != '\t')) {
+            position++;
+        }
+        if (((position - start) == etag_length) && (strncmp(value.text + start, etag, etag_length) == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool respond_not_modified(divulge_request_t* request, const char* etag) {
+    divulge_header_entry_t header_entries[] = {{.key = "ETag", .value = etag}};
+    divulge_response_t response = {
+        .return_code = 304,
+        .header = {.count = 1, .entries = header_entries},
+        .payload = "",
+        .payload_size = 0,
+    };
+    return divulge_respond(request, &response);
+}
+
+static bool respond_with_etag(divulge_request_t* request,
+                              const divulge_response_t* response,
+                              const divulge_header_entry_t* headers,
+                              size_t header_count,
+                              const char* etag) {
+    divulge_header_entry_t header_entries[HEADERS_MAX_COUNT + 1];
+    memcpy(header_entries, headers, header_count * sizeof(divulge_header_entry_t));
+    header_entries[header_count].key = "ETag";
+    header_entries[header_count].value = etag;
+    divulge_response_t tagged_response = {
+        .return_code = response->return_code,
+        .header = {.count = header_count + 1, .entries = header_entries},
+        .payload = response->payload,
+        .payload_size = response->payload_size,
+    };
+    return divulge_respond(request, &tagged_response);
+}
+
+static bool response_filter(divulge_request_t* request, divulge_response_t* response, void* context) {
+    request_key_t* key = (request_key_t*)context;
+    divulge_response_cache_t* cache = key->cache;
+    if (!is_cacheable_response(cache, response)) {
+        return true;
+    }
+    char etag[ETAG_SIZE];
+    compute_etag(response, etag);
+    cache_entry_t* entry = create_entry(key, response, etag);
+    if (entry) {
+        store_entry(cache, entry);
+    }
+    if (is_etag_matching(request, etag)) {
+        respond_not_modified(request, etag);
+    } else {
+        respond_with_etag(request, response, response->header.entries, response->header.count, etag);
+    }
+    return false;
+}
+
+static bool middleware_handler(divulge_request_t* request, void* context) {
+    divulge_response_cache_t* cache = (divulge_response_cache_t*)context;
+    if (!is_cacheable_request(request)) {
+        return true;
+    }
+    cache_entry_t* entry = acquire_entry(cache, request);
+    if (!entry) {
+        request_key_t* key = create_request_key(request, cache);
+        if (key) {
+            divulge_add_response_filter(request, response_filter, key);
+        }
+        return true;
+    }
+    if (is_etag_matching(request, entry->etag)) {
+        respond_not_modified(request, entry->etag);
+    } else {
+        divulge_response_t response = {
+            .return_code = 200,
+            .payload = entry->payload,
+            .payload_size = entry->payload_size,
+        };
+        respond_with_etag(request, &response, entry->headers, entry->header_count, entry->etag);
+    }
+    release_acquired_entry(cache, entry);
+    return false;
+}
+
+divulge_response_cache_t* divulge_response_cache_create(size_t max_entry_count, size_t max_payload_size) {
+    if (max_entry_count == 0) {
+        return NULL;
+    }
+    divulge_response_cache_t* cache = calloc(1, sizeof(divulge_response_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+    cache->entries = calloc(max_entry_count, sizeof(cache_entry_t*));
+    cache->mutex = g2l_mutex_create();
+    if (!cache->entries || !cache->mutex) {
+        divulge_response_cache_destroy(cache);
+        return NULL;
+    }
+    cache->max_entry_count = max_entry_count;
+    cache->max_payload_size = max_payload_size;
+    cache->middleware.handler = middleware_handler;
+    cache->middleware.context = cache;
+    return cache;
+}
+
+divulge_handler_object_t* divulge_response_cache_get_middleware(divulge_response_cache_t* cache) {
+    if (!cache) {
+        return NULL;
+    }
+    return &cache->middleware;
+}
+
+void divulge_response_cache_invalidate(divulge_response_cache_t* cache, const char* route) {
+    if (!cache || !route) {
+        return;
+    }
+    size_t route_length = strlen(route);
+    g2l_mutex_lock(cache->mutex);
+    for (size_t i = 0; i < cache->max_entry_count; i++) {
+        cache_entry_t* entry = cache->entries[i];
+        if (entry && (strncmp(entry->key, route, route_length) == 0) &&
+            ((entry->key[route_length] == '\0') || (entry->key[route_length] == '?'))) {
+            detach_entry(cache, i);
+        }
+    }
+    g2l_mutex_unlock(cache->mutex);
+}
+
+void divulge_response_cache_invalidate_all(divulge_response_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    g2l_mutex_lock(cache->mutex);
+    for (size_t i = 0; i < cache->max_entry_count; i++) {
+        if (cache->entries[i]) {
+            detach_entry(cache, i);
+        }
+    }
+    g2l_mutex_unlock(cache->mutex);
+}
+
+void divulge_response_cache_destroy(divulge_response_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    if (cache->entries) {
+        divulge_response_cache_invalidate_all(cache);
+        free(cache->entries);
+    }
+    g2l_mutex_destroy(cache->mutex);
+    free(cache);
+}
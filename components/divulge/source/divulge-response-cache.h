@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_RESPONSE_CACHE_H
+#define DIVULGE_RESPONSE_CACHE_H
+
+#include "divulge.h"
+
+typedef struct divulge_response_cache divulge_response_cache_t;
+
+/**
+ * @brief Create a cache of 200 responses to GET and HEAD requests, keyed by route, query and method
+ *
+ * The key is taken before the handler runs and kept in the request arena until the response is stored, so
+ * responses are only cached when divulge is configured with a request arena that can hold it. Requests carrying
+ * Authorization bypass the cache, and responses with Set-Cookie, Vary, Content-Encoding or a Cache-Control of
+ * no-store or private are passed through uncached.
+ *
+ * Cached responses are sent without running the middlewares that follow, so add the cache after any
+ * authentication middleware. Add compression after the cache, which then keeps uncompressed bodies; added before
+ * it, compressed responses carry Content-Encoding and are not cached.
+ */
+divulge_response_cache_t* divulge_response_cache_create(size_t max_entry_count, size_t max_payload_size);
+
+divulge_handler_object_t* divulge_response_cache_get_middleware(divulge_response_cache_t* cache);
+
+void divulge_response_cache_invalidate(divulge_response_cache_t* cache, const char* route);
+
+void divulge_response_cache_invalidate_all(divulge_response_cache_t* cache);
+
+void divulge_response_cache_destroy(divulge_response_cache_t* cache);
+
+#endif  // DIVULGE_RESPONSE_CACHE_H
@@ -0,0 +1,290 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-route-tree.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PARAMETER_OPEN '{'
+#define PARAMETER_CLOSE '}'
+#define WILDCARD '*'
+#define SEGMENT_SEPARATOR '/'
+
+typedef struct route_node {
+    const char* prefix;
+    size_t prefix_length;
+    struct route_node** children;
+    size_t children_count;
+    struct route_node* parameter;
+    struct route_node* wildcard;
+    void* values[DIVULGE_ROUTE_TREE_METHOD_COUNT];
+} route_node_t;
+
+typedef struct divulge_route_tree {
+    route_node_t root;
+} divulge_route_tree_t;
+
+divulge_route_tree_t* divulge_route_tree_create(void) {
+    return calloc(1, sizeof(divulge_route_tree_t));
+}
+
+static void release_node_children(route_node_t* node) {
+    for (size_t i = 0; i < node->children_count; i++) {
+        release_node_children(node->children[i]);
+        free(node->children[i]);
+    }
+    free(node->children);
+    if (node->parameter) {
+        release_node_children(node->parameter);
+        free(node->parameter);
+    }
+    if (node->wildcard) {
+        release_node_children(node->wildcard);
+        free(node->wildcard);
+    }
+}
+
+void divulge_route_tree_destroy(divulge_route_tree_t* tree) {
+    if (!tree) {
+        return;
+    }
+    release_node_children(&tree->root);
+    free(tree);
+}
+
+static route_node_t* create_node(const char* prefix, size_t prefix_length) {
+    route_node_t* node = calloc(1, sizeof(route_node_t));
+    if (node) {
+        node->prefix = prefix;
+        node->prefix_length = prefix_length;
+    }
+    return node;
+}
+
+static bool append_child(route_node_t* node, route_node_t* child) {
+    route_node_t** children = realloc(node->children, (node->children_count + 1) * sizeof(route_node_t*));
+    if (!children) {
+        return false;
+    }
+    children[node->children_count] = child;
+    node->children = children;
+    node->children_count++;
+    return true;
+}
+
+static route_node_t* find_static_child(const route_node_t* node, char first, size_t* index) {
+    for (size_t i = 0; i < node->children_count; i++) {
+        if (node->children[i]->prefix[0] == first) {
+            if (index) {
+                *index = i;
+            }
+            return node->children[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t common_prefix_length(const char* a, size_t a_length, const char* b, size_t b_length) {
+    size_t length = 0;
+    while ((length < a_length) && (length < b_length) && (a[length] == b[length])) {
+        length++;
+    }
+    return length;
+}
+
+static route_node_t* walk_static(route_node_t* node, const char* text, size_t length, bool create) {
+    while (node && (length > 0)) {
+        size_t index = 0;
+        route_node_t* child = find_static_child(node, text[0], &index);
+        if (!child) {
+            if (!create) {
+                return NULL;
+            }
+            child = create_node(text, length);
+            if (!child || !append_child(node, child)) {
+                free(child);
+                return NULL;
+            }
+            return child;
+        }
+        size_t common = common_prefix_length(child->prefix, child->prefix_length, text, length);
+        if (common < child->prefix_length) {
+            if (!create) {
+                return NULL;
+            }
+            route_node_t* middle = create_node(child->prefix, common);
+            if (!middle || !append_child(middle, child)) {
+                free(middle);
+                return NULL;
+            }
+            child->prefix += common;
+            child->prefix_length -= common;
+            node->children[index] = middle;
+            child = middle;
+        }
+        node = child;
+        text += common;
+        length -= common;
+    }
+    return node;
+}
+
+static route_node_t* walk_special(route_node_t** slot, bool create) {
+    if (!*slot && create) {
+        *slot = create_node("", 0);
+    }
+    return *slot;
+}
+
+static route_node_t* walk_pattern(divulge_route_tree_t* tree, const char* pattern, bool create) {
+    route_node_t* node = &tree->root;
+    size_t parameter_count = 0;
+    const char* end = pattern + strlen(pattern);
+    const char* position = pattern;
+    while (node && (position < end)) {
+        if ((*position == WILDCARD) && ((position + 1) == end)) {
+            if (parameter_count >= DIVULGE_ROUTE_PARAMETERS_MAX_COUNT) {
+                return NULL;
+            }
+            return walk_special(&node->wildcard, create);
+        } else if (*position == PARAMETER_OPEN) {
+            const char* close = memchr(position, PARAMETER_CLOSE, (size_t)(end - position));
+            if (!close || (close == (position + 1)) || (parameter_count >= DIVULGE_ROUTE_PARAMETERS_MAX_COUNT)) {
+                return NULL;
+            }
+            parameter_count++;
+            if (*(close - 1) == WILDCARD) {
+                if ((close + 1) != end) {
+                    return NULL;
+                }
+                return walk_special(&node->wildcard, create);
+            }
+            if (((close + 1) != end) && (*(close + 1) != SEGMENT_SEPARATOR)) {
+                return NULL;
+            }
+            node = walk_special(&node->parameter, create);
+            position = close + 1;
+        } else {
+            const char* static_end = position;
+            while ((static_end < end) && (*static_end != PARAMETER_OPEN) &&
+                   !((*static_end == WILDCARD) && ((static_end + 1) == end))) {
+                static_end++;
+            }
+            node = walk_static(node, position, (size_t)(static_end - position), create);
+            position = static_end;
+        }
+    }
+    return node;
+}
+
+bool divulge_route_tree_insert(divulge_route_tree_t* tree,
+                               const char* pattern,
+                               divulge_route_method_t method,
+                               void* value) {
+    if (!tree || !pattern || !value || (method >= DIVULGE_ROUTE_TREE_METHOD_COUNT)) {
+        return false;
+    }
+    route_node_t* node = walk_pattern(tree, pattern, true);
+    if (!node || node->values[method]) {
+        return false;
+    }
+    node->values[method] = value;
+    return true;
+}
+
+void* divulge_route_tree_find(divulge_route_tree_t* tree, const char* pattern, divulge_route_method_t method) {
+    if (!tree || !pattern || (method >= DIVULGE_ROUTE_TREE_METHOD_COUNT)) {
+        return NULL;
+    }
+    route_node_t* node = walk_pattern(tree, pattern, false);
+    return node ? node->values[method] : NULL;
+}
+
+static void* get_value_for_method(const route_node_t* node, divulge_route_method_t method) {
+    void* value = node->values[method];
+    if (!value && (method == DIVULGE_ROUTE_METHOD_HEAD)) {
+        value = node->values[DIVULGE_ROUTE_METHOD_GET];
+    }
+    return value ? value : node->values[DIVULGE_ROUTE_METHOD_ANY];
+}
+
+static bool match_node(const route_node_t* node,
+                       const char* path,
+                       size_t length,
+                       divulge_route_method_t method,
+                       divulge_route_tree_match_t* match,
+                       size_t depth) {
+    if (length == 0) {
+        void* value = get_value_for_method(node, method);
+        if (value) {
+            match->value = value;
+            match->capture_count = depth;
+            return true;
+        }
+    } else {
+        const route_node_t* child = find_static_child(node, path[0], NULL);
+        if (child && (child->prefix_length <= length) && (memcmp(child->prefix, path, child->prefix_length) == 0)) {
+            if (match_node(child, path + child->prefix_length, length - child->prefix_length, method, match, depth)) {
+                return true;
+            }
+        }
+        if (node->parameter && (depth < DIVULGE_ROUTE_PARAMETERS_MAX_COUNT)) {
+            size_t segment_length = 0;
+            while ((segment_length < length) && (path[segment_length] != SEGMENT_SEPARATOR)) {
+                segment_length++;
+            }
+            if (segment_length > 0) {
+                match->captures[depth].text = (char*)path;
+                match->captures[depth].length = segment_length;
+                if (match_node(node->parameter, path + segment_length, length - segment_length, method, match,
+                               depth + 1)) {
+                    return true;
+                }
+            }
+        }
+    }
+    if (node->wildcard && (depth < DIVULGE_ROUTE_PARAMETERS_MAX_COUNT)) {
+        void* value = get_value_for_method(node->wildcard, method);
+        if (value) {
+            match->captures[depth].text = (char*)path;
+            match->captures[depth].length = length;
+            match->capture_count = depth + 1;
+            match->value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool divulge_route_tree_match(divulge_route_tree_t* tree,
+                              const char* path,
+                              size_t path_length,
+                              divulge_route_method_t method,
+                              divulge_route_tree_match_t* match) {
+    if (!tree || !path || !match || (method >= DIVULGE_ROUTE_TREE_METHOD_COUNT)) {
+        return false;
+    }
+    match->value = NULL;
+    match->capture_count = 0;
+    return match_node(&tree->root, path, path_length, method, match, 0);
+}
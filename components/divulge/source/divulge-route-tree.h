@@ -0,0 +1,117 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_ROUTE_TREE_H
+#define DIVULGE_ROUTE_TREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "divulge.h"
+#include "static-string.h"
+
+/**
+ * @defgroup divulge-route-tree Divulge route tree
+ * @ingroup divulge
+ * @brief Radix tree index of registered routes
+ *
+ * Route patterns are split into static text, `{name}` parameters (matching one non-empty path segment) and a
+ * trailing `*` or `{name*}` wildcard (matching the rest of the path). Lookup cost depends only on the length of
+ * the requested path, not on the number of registered routes.
+ * @{
+ */
+
+#define DIVULGE_ROUTE_TREE_METHOD_COUNT (DIVULGE_ROUTE_METHOD_ANY + 1)
+
+typedef struct divulge_route_tree divulge_route_tree_t; /**< @brief Route tree abstract type. Use only as pointer */
+
+/**
+ * @brief Result of a successful route lookup
+ */
+typedef struct divulge_route_tree_match {
+    void* value;                                                  /**< @brief value stored for the route */
+    static_string_t captures[DIVULGE_ROUTE_PARAMETERS_MAX_COUNT]; /**< @brief captured parameters, in order */
+    size_t capture_count;                                         /**< @brief number of captured parameters */
+} divulge_route_tree_match_t;
+
+/**
+ * @brief Create a new, empty route tree
+ * @note Uses memory allocation
+ * @return NULL if allocation failed
+ * @return pointer to a new route tree otherwise
+ */
+divulge_route_tree_t* divulge_route_tree_create(void);
+
+/**
+ * @brief Release the tree and all its nodes
+ * @param[in] tree pointer to the route tree; stored values are not released
+ */
+void divulge_route_tree_destroy(divulge_route_tree_t* tree);
+
+/**
+ * @brief Insert a route pattern into the tree
+ * @param[in] tree pointer to the route tree
+ * @param[in] pattern route pattern C-string; it has to stay valid as long as the tree exists
+ * @param[in] method method the route is bound to
+ * @param[in] value pointer to the value stored under the route
+ * @return false if pointers are invalid, the pattern is malformed or the route already exists
+ * @return true if the route was inserted
+ */
+bool divulge_route_tree_insert(divulge_route_tree_t* tree,
+                               const char* pattern,
+                               divulge_route_method_t method,
+                               void* value);
+
+/**
+ * @brief Find the value stored under an exact route pattern
+ * @param[in] tree pointer to the route tree
+ * @param[in] pattern route pattern C-string, as passed to divulge_route_tree_insert()
+ * @param[in] method method the route is bound to
+ * @return NULL if no such route exists
+ * @return pointer to the stored value otherwise
+ */
+void* divulge_route_tree_find(divulge_route_tree_t* tree, const char* pattern, divulge_route_method_t method);
+
+/**
+ * @brief Match a request path against the tree
+ *
+ * Static text is preferred over parameters and parameters over wildcards. A route registered for
+ * DIVULGE_ROUTE_METHOD_ANY matches every method without a route of its own. HEAD requests fall back to the GET route
+ * before the ANY route.
+ * @param[in] tree pointer to the route tree
+ * @param[in] path pointer to the request path (does not need to be NUL-terminated)
+ * @param[in] path_length length of the request path
+ * @param[in] method method of the request
+ * @param[out] match pointer to the match result
+ * @return true if a route was found
+ * @return false otherwise
+ */
+bool divulge_route_tree_match(divulge_route_tree_t* tree,
+                              const char* path,
+                              size_t path_length,
+                              divulge_route_method_t method,
+                              divulge_route_tree_match_t* match);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_ROUTE_TREE_H
@@ -0,0 +1,304 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-sse.h"
+#include <stdlib.h>
+#include <string.h>
+#include "g2l-mutex.h"
+
+#define VECTORS_MAX_COUNT (16)
+#define DISCARD_BUFFER_SIZE (64)
+
+struct divulge_sse_stream {
+    divulge_sse_t* sse;
+    divulge_request_t* request;
+    g2l_mutex_t* mutex;
+    size_t reference_count;
+    bool is_open;
+};
+
+struct divulge_sse {
+    divulge_sse_configuration_t configuration;
+    divulge_uri_t uri;
+    g2l_mutex_t* mutex;
+    divulge_sse_stream_t** streams;
+    size_t stream_count;
+};
+
+typedef struct event_writer {
+    divulge_request_t* request;
+    divulge_io_vector_t vectors[VECTORS_MAX_COUNT];
+    size_t vector_count;
+} event_writer_t;
+
+static void flush_event(event_writer_t* writer) {
+    if (writer->vector_count > 0) {
+        divulge_send_vector(writer->request, writer->vectors, writer->vector_count);
+        writer->vector_count = 0;
+    }
+}
+
+static void append_event(event_writer_t* writer, const char* data, size_t data_size) {
+    if (data_size == 0) {
+        return;
+    }
+    if (writer->vector_count == VECTORS_MAX_COUNT) {
+        flush_event(writer);
+    }
+    writer->vectors[writer->vector_count].data = data;
+    writer->vectors[writer->vector_count].size = data_size;
+    writer->vector_count++;
+}
+
+static bool write_event(divulge_sse_stream_t* stream, const char* event, const char* data) {
+    if (!stream->is_open) {
+        return false;
+    }
+    event_writer_t writer = {.request = stream->request};
+    if (event) {
+        append_event(&writer, "event: ", 7);
+        append_event(&writer, event, strcspn(event, "\r\n"));
+        append_event(&writer, "\n", 1);
+    }
+    while (true) {
+        size_t line_length = strcspn(data, "\r\n");
+        append_event(&writer, "data: ", 6);
+        append_event(&writer, data, line_length);
+        append_event(&writer, "\n", 1);
+        data += line_length;
+        if (*data == '\0') {
+            break;
+        }
+        data += ((data[0] == '\r') && (data[1] == '\n')) ? 2 : 1;
+    }
+    append_event(&writer, "\n", 1);
+    flush_event(&writer);
+    return true;
+}
+
+static bool send_event(divulge_sse_stream_t* stream, const char* event, const char* data) {
+    g2l_mutex_lock(stream->mutex);
+    bool result = write_event(stream, event, data);
+    g2l_mutex_unlock(stream->mutex);
+    return result;
+}
+
+static divulge_sse_stream_t* create_stream(divulge_sse_t* sse, divulge_request_t* request) {
+    divulge_sse_stream_t* stream = calloc(1, sizeof(divulge_sse_stream_t));
+    if (!stream) {
+        return NULL;
+    }
+    stream->mutex = g2l_mutex_create();
+    if (!stream->mutex) {
+        free(stream);
+        return NULL;
+    }
+    stream->sse = sse;
+    stream->request = request;
+    stream->reference_count = 1;
+    return stream;
+}
+
+static bool add_stream(divulge_sse_t* sse, divulge_sse_stream_t* stream) {
+    g2l_mutex_lock(sse->mutex);
+    bool result = sse->stream_count < sse->configuration.max_stream_count;
+    if (result) {
+        sse->streams[sse->stream_count++] = stream;
+    }
+    g2l_mutex_unlock(sse->mutex);
+    return result;
+}
+
+static void remove_stream(divulge_sse_t* sse, divulge_sse_stream_t* stream) {
+    g2l_mutex_lock(stream->mutex);
+    stream->is_open = false;
+    stream->request = NULL;
+    g2l_mutex_unlock(stream->mutex);
+    g2l_mutex_lock(sse->mutex);
+    for (size_t i = 0; i < sse->stream_count; i++) {
+        if (sse->streams[i] == stream) {
+            sse->streams[i] = sse->streams[--sse->stream_count];
+            break;
+        }
+    }
+    g2l_mutex_unlock(sse->mutex);
+}
+
+static bool handler(divulge_request_t* request, void* context) {
+    divulge_sse_t* sse = (divulge_sse_t*)context;
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Content-Type", .value = "text/event-stream"},
+        {.key = "Cache-Control", .value = "no-cache"},
+    };
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.entries = header_entries, .count = 2},
+        .payload = "",
+        .payload_size = 0,
+    };
+    if (request->method == DIVULGE_ROUTE_METHOD_HEAD) {
+        return divulge_respond(request, &response);
+    }
+    divulge_sse_stream_t* stream = create_stream(sse, request);
+    if (!stream || !add_stream(sse, stream)) {
+        divulge_sse_release(stream);
+        divulge_response_t unavailable_response = {
+            .return_code = 503,
+            .payload = "",
+            .payload_size = 0,
+        };
+        return divulge_respond(request, &unavailable_response);
+    }
+    if (!divulge_upgrade_connection(request, &response)) {
+        remove_stream(sse, stream);
+        divulge_sse_release(stream);
+        return true;
+    }
+    g2l_mutex_lock(stream->mutex);
+    stream->is_open = true;
+    g2l_mutex_unlock(stream->mutex);
+    if (sse->configuration.stream_handler) {
+        sse->configuration.stream_handler(stream, true, sse->configuration.context);
+    }
+    char buffer[DISCARD_BUFFER_SIZE];
+    while (divulge_receive(request, buffer, sizeof(buffer)) > 0) {
+    }
+    remove_stream(sse, stream);
+    if (sse->configuration.stream_handler) {
+        sse->configuration.stream_handler(stream, false, sse->configuration.context);
+    }
+    divulge_sse_release(stream);
+    return true;
+}
+
+divulge_sse_t* divulge_sse_create(const divulge_sse_configuration_t* configuration) {
+    if (!configuration || (configuration->max_stream_count == 0)) {
+        return NULL;
+    }
+    divulge_sse_t* sse = calloc(1, sizeof(divulge_sse_t));
+    if (!sse) {
+        return NULL;
+    }
+    sse->configuration = *configuration;
+    sse->streams = calloc(configuration->max_stream_count, sizeof(divulge_sse_stream_t*));
+    sse->mutex = g2l_mutex_create();
+    if (!sse->streams || !sse->mutex) {
+        divulge_sse_destroy(sse);
+        return NULL;
+    }
+    return sse;
+}
+
+divulge_uri_t* divulge_sse_mount(divulge_t* divulge, divulge_sse_t* sse, const char* uri) {
+    if (!divulge || !sse || !uri || sse->uri.uri) {
+        return NULL;
+    }
+    sse->uri.uri = uri;
+    sse->uri.method = DIVULGE_ROUTE_METHOD_GET;
+    sse->uri.handler.handler = handler;
+    sse->uri.handler.context = sse;
+    divulge_register_uri(divulge, &sse->uri);
+    return &sse->uri;
+}
+
+divulge_request_t* divulge_sse_get_request(divulge_sse_stream_t* stream) {
+    if (!stream) {
+        return NULL;
+    }
+    g2l_mutex_lock(stream->mutex);
+    divulge_request_t* request = stream->request;
+    g2l_mutex_unlock(stream->mutex);
+    return request;
+}
+
+void divulge_sse_retain(divulge_sse_stream_t* stream) {
+    if (!stream) {
+        return;
+    }
+    g2l_mutex_lock(stream->mutex);
+    stream->reference_count++;
+    g2l_mutex_unlock(stream->mutex);
+}
+
+void divulge_sse_release(divulge_sse_stream_t* stream) {
+    if (!stream) {
+        return;
+    }
+    g2l_mutex_lock(stream->mutex);
+    bool is_last = (--stream->reference_count == 0);
+    g2l_mutex_unlock(stream->mutex);
+    if (is_last) {
+        g2l_mutex_destroy(stream->mutex);
+        free(stream);
+    }
+}
+
+bool divulge_sse_send(divulge_sse_stream_t* stream, const char* event, const char* data) {
+    if (!stream || !data) {
+        return false;
+    }
+    return send_event(stream, event, data);
+}
+
+size_t divulge_sse_broadcast(divulge_sse_t* sse, const char* event, const char* data) {
+    if (!sse || !data) {
+        return 0;
+    }
+    divulge_sse_stream_t** streams = calloc(sse->configuration.max_stream_count, sizeof(divulge_sse_stream_t*));
+    if (!streams) {
+        return 0;
+    }
+    g2l_mutex_lock(sse->mutex);
+    size_t stream_count = sse->stream_count;
+    for (size_t i = 0; i < stream_count; i++) {
+        streams[i] = sse->streams[i];
+        divulge_sse_retain(streams[i]);
+    }
+    g2l_mutex_unlock(sse->mutex);
+    size_t sent_count = 0;
+    for (size_t i = 0; i < stream_count; i++) {
+        sent_count += send_event(streams[i], event, data) ? 1 : 0;
+        divulge_sse_release(streams[i]);
+    }
+    free(streams);
+    return sent_count;
+}
+
+size_t divulge_sse_get_stream_count(divulge_sse_t* sse) {
+    if (!sse) {
+        return 0;
+    }
+    g2l_mutex_lock(sse->mutex);
+    size_t count = sse->stream_count;
+    g2l_mutex_unlock(sse->mutex);
+    return count;
+}
+
+void divulge_sse_destroy(divulge_sse_t* sse) {
+    if (!sse) {
+        return;
+    }
+    free(sse->streams);
+    g2l_mutex_destroy(sse->mutex);
+    free(sse);
+}
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_SSE_H
+#define DIVULGE_SSE_H
+
+#include "divulge.h"
+
+typedef struct divulge_sse divulge_sse_t;
+
+typedef struct divulge_sse_stream divulge_sse_stream_t;
+
+/**
+ * Called with is_connected set once a stream is open and again when it closes. The stream pointer stays valid until
+ * the closing call returns; call divulge_sse_retain() to keep it longer. Sending to a closed stream fails.
+ */
+typedef void (*divulge_sse_stream_handler_t)(divulge_sse_stream_t* stream, bool is_connected, void* context);
+
+typedef struct divulge_sse_configuration {
+    size_t max_stream_count;
+    divulge_sse_stream_handler_t stream_handler;
+    void* context;
+} divulge_sse_configuration_t;
+
+divulge_sse_t* divulge_sse_create(const divulge_sse_configuration_t* configuration);
+
+divulge_uri_t* divulge_sse_mount(divulge_t* divulge, divulge_sse_t* sse, const char* uri);
+
+divulge_request_t* divulge_sse_get_request(divulge_sse_stream_t* stream);
+
+/** Keep a stream allocated past its closing callback; every call needs a matching divulge_sse_release() */
+void divulge_sse_retain(divulge_sse_stream_t* stream);
+
+void divulge_sse_release(divulge_sse_stream_t* stream);
+
+bool divulge_sse_send(divulge_sse_stream_t* stream, const char* event, const char* data);
+
+size_t divulge_sse_broadcast(divulge_sse_t* sse, const char* event, const char* data);
+
+size_t divulge_sse_get_stream_count(divulge_sse_t* sse);
+
+void divulge_sse_destroy(divulge_sse_t* sse);
+
+#endif  // DIVULGE_SSE_H
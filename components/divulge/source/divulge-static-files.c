@@ -0,0 +1,261 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-static-files.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "divulge-compression.h"
+
+#define SEGMENT_SEPARATOR '/'
+#define PRECOMPRESSED_FILE_EXTENSION ".gz"
+
+typedef struct divulge_static_files_context {
+    const char* directory;
+    const char* index_file_name;
+    divulge_uri_t uri;
+    char pattern[];
+} divulge_static_files_context_t;
+
+typedef struct content_type_entry {
+    const char* extension;
+    const char* content_type;
+} content_type_entry_t;
+
+static const content_type_entry_t content_types[] = {
+    {.extension = "html", .content_type = "text/html"},
+    {.extension = "htm", .content_type = "text/html"},
+    {.extension = "css", .content_type = "text/css"},
+    {.extension = "js", .content_type = "application/javascript"},
+    {.extension = "mjs", .content_type = "application/javascript"},
+    {.extension = "json", .content_type = "application/json"},
+    {.extension = "map", .content_type = "application/json"},
+    {.extension = "txt", .content_type = "text/plain"},
+    {.extension = "csv", .content_type = "text/csv"},
+    {.extension = "xml", .content_type = "application/xml"},
+    {.extension = "svg", .content_type = "image/svg+xml"},
+    {.extension = "png", .content_type = "image/png"},
+    {.extension = "jpg", .content_type = "image/jpeg"},
+    {.extension = "jpeg", .content_type = "image/jpeg"},
+    {.extension = "gif", .content_type = "image/gif"},
+    {.extension = "ico", .content_type = "image/x-icon"},
+    {.extension = "webp", .content_type = "image/webp"},
+    {.extension = "woff", .content_type = "font/woff"},
+    {.extension = "woff2", .content_type = "font/woff2"},
+    {.extension = "ttf", .content_type = "font/ttf"},
+    {.extension = "wasm", .content_type = "application/wasm"},
+    {.extension = "pdf", .content_type = "application/pdf"},
+    {.extension = "gz", .content_type = "application/gzip"},
+};
+
+static const char* default_content_type = "application/octet-stream";
+
+static bool is_extension_equal(const char* extension, const char* reference) {
+    for (; *extension && *reference; extension++, reference++) {
+        if (tolower((unsigned char)*extension) != *reference) {
+            return false;
+        }
+    }
+    return (*extension == *reference);
+}
+
+const char* divulge_static_files_get_content_type(const char* file_name) {
+    if (!file_name) {
+        return default_content_type;
+    }
+    const char* extension = strrchr(file_name, '.');
+    if (!extension || strchr(extension, SEGMENT_SEPARATOR)) {
+        return default_content_type;
+    }
+    extension++;
+    for (size_t i = 0; i < (sizeof(content_types) / sizeof(content_types[0])); i++) {
+        if (is_extension_equal(extension, content_types[i].extension)) {
+            return content_types[i].content_type;
+        }
+    }
+    return default_content_type;
+}
+
+static int decode_hex_digit(char digit) {
+    if ((digit >= '0') && (digit <= '9')) {
+        return digit - '0';
+    } else if ((digit >= 'a') && (digit <= 'f')) {
+        return digit - 'a' + 10;
+    } else if ((digit >= 'A') && (digit <= 'F')) {
+        return digit - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool append_decoded_path(char* file_name, size_t* size, const static_string_t* path) {
+    size_t segment_start = *size;
+    for (size_t i = 0; i < path->length; i++) {
+        char c = path->text[i];
+        if (c == '%') {
+            int high = ((i + 2) < path->length) ? decode_hex_digit(path->text[i + 1]) : -1;
+            int low = ((i + 2) < path->length) ? decode_hex_digit(path->text[i + 2]) : -1;
+            if ((high < 0) || (low < 0)) {
+                return false;
+            }
+            c = (char)((high << 4) | low);
+            i += 2;
+        }
+        if ((c == '\0') || (c == '\\') || (*size >= (DIVULGE_STATIC_FILES_NAME_MAX_LENGTH - 1))) {
+            return false;
+        }
+        if (c == SEGMENT_SEPARATOR) {
+            if (((*size - segment_start) == 2) && (memcmp(file_name + segment_start, "..", 2) == 0)) {
+                return false;
+            }
+            segment_start = *size + 1;
+        }
+        file_name[(*size)++] = c;
+    }
+    return !(((*size - segment_start) == 2) && (memcmp(file_name + segment_start, "..", 2) == 0));
+}
+
+static bool create_file_name(const divulge_static_files_context_t* ctx,
+                             const static_string_t* path,
+                             char* file_name) {
+    size_t size = 0;
+    if (ctx->directory && ctx->directory[0]) {
+        size = strlen(ctx->directory);
+        if (size >= (DIVULGE_STATIC_FILES_NAME_MAX_LENGTH - 1)) {
+            return false;
+        }
+        memcpy(file_name, ctx->directory, size);
+        file_name[size++] = SEGMENT_SEPARATOR;
+    }
+    if (!append_decoded_path(file_name, &size, path)) {
+        return false;
+    }
+    if ((size == 0) || (file_name[size - 1] == SEGMENT_SEPARATOR)) {
+        if (!ctx->index_file_name) {
+            return false;
+        }
+        size_t index_size = strlen(ctx->index_file_name);
+        if ((size + index_size) >= DIVULGE_STATIC_FILES_NAME_MAX_LENGTH) {
+            return false;
+        }
+        memcpy(file_name + size, ctx->index_file_name, index_size);
+        size += index_size;
+    }
+    file_name[size] = '\0';
+    return size <= g2l_fs_get_max_file_name_length();
+}
+
+static bool respond_with_not_found(divulge_request_t* request) {
+    divulge_response_t response = {
+        .return_code = 404,
+        .payload = "",
+        .payload_size = 0,
+    };
+    return divulge_respond(request, &response);
+}
+
+static bool find_precompressed_file(const char* file_name, char* compressed_file_name) {
+    size_t file_name_length = strlen(file_name);
+    size_t compressed_file_name_length = file_name_length + strlen(PRECOMPRESSED_FILE_EXTENSION);
+    if ((compressed_file_name_length >= DIVULGE_STATIC_FILES_NAME_MAX_LENGTH) ||
+        (compressed_file_name_length > g2l_fs_get_max_file_name_length())) {
+        return false;
+    }
+    memcpy(compressed_file_name, file_name, file_name_length);
+    strcpy(compressed_file_name + file_name_length, PRECOMPRESSED_FILE_EXTENSION);
+    return g2l_fs_file_is_regular(compressed_file_name);
+}
+
+static bool send_precompressed_file(divulge_request_t* request,
+                                    const char* file_name,
+                                    const char* compressed_file_name) {
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Content-Type", .value = divulge_static_files_get_content_type(file_name)},
+        {.key = "Content-Encoding", .value = "gzip"},
+        {.key = "Vary", .value = "Accept-Encoding"},
+    };
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.count = 3, .entries = header_entries},
+    };
+    return divulge_send_file(request, &response, compressed_file_name);
+}
+
+static bool handler(divulge_request_t* request, void* context) {
+    divulge_static_files_context_t* ctx = (divulge_static_files_context_t*)context;
+    static_string_t path = divulge_get_route_parameter(request, "path");
+    char file_name[DIVULGE_STATIC_FILES_NAME_MAX_LENGTH];
+    if (!path.text || !create_file_name(ctx, &path, file_name)) {
+        return respond_with_not_found(request);
+    }
+    char compressed_file_name[DIVULGE_STATIC_FILES_NAME_MAX_LENGTH];
+    bool has_precompressed_file = find_precompressed_file(file_name, compressed_file_name);
+    if (has_precompressed_file && divulge_compression_is_accepted(request, "gzip") &&
+        send_precompressed_file(request, file_name, compressed_file_name)) {
+        return true;
+    }
+    if (!g2l_fs_file_is_regular(file_name)) {
+        return respond_with_not_found(request);
+    }
+    /* The representation depends on Accept-Encoding once a compressed sibling exists, so caches must vary on it. */
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Content-Type", .value = divulge_static_files_get_content_type(file_name)},
+        {.key = "Vary", .value = "Accept-Encoding"},
+    };
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.count = has_precompressed_file ? 2 : 1, .entries = header_entries},
+    };
+    if (!divulge_send_file(request, &response, file_name)) {
+        return respond_with_not_found(request);
+    }
+    return true;
+}
+
+divulge_uri_t* divulge_static_files_mount(divulge_t* divulge,
+                                          const char* prefix,
+                                          const char* directory,
+                                          const char* index_file_name) {
+    if (!divulge || !prefix || (prefix[0] != SEGMENT_SEPARATOR)) {
+        return NULL;
+    }
+    size_t prefix_length = strlen(prefix);
+    while ((prefix_length > 0) && (prefix[prefix_length - 1] == SEGMENT_SEPARATOR)) {
+        prefix_length--;
+    }
+    static const char* path_pattern = "/{path*}";
+    size_t pattern_size = prefix_length + strlen(path_pattern) + 1;
+    divulge_static_files_context_t* ctx = calloc(1, sizeof(divulge_static_files_context_t) + pattern_size);
+    if (!ctx) {
+        return NULL;
+    }
+    memcpy(ctx->pattern, prefix, prefix_length);
+    strcpy(ctx->pattern + prefix_length, path_pattern);
+    ctx->directory = directory;
+    ctx->index_file_name = index_file_name;
+    ctx->uri.uri = ctx->pattern;
+    ctx->uri.method = DIVULGE_ROUTE_METHOD_GET;
+    ctx->uri.handler.handler = handler;
+    ctx->uri.handler.context = ctx;
+    divulge_register_uri(divulge, &ctx->uri);
+    return &ctx->uri;
+}
@@ -0,0 +1,221 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-url-query.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARAMETER_SEPARATOR '&'
+#define VALUE_SEPARATOR '='
+
+static int decode_hex_digit(char digit) {
+    if ((digit >= '0') && (digit <= '9')) {
+        return digit - '0';
+    } else if ((digit >= 'a') && (digit <= 'f')) {
+        return digit - 'a' + 10;
+    } else if ((digit >= 'A') && (digit <= 'F')) {
+        return digit - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool decode(divulge_url_query_t* query, static_string_t* text) {
+    if ((DIVULGE_URL_QUERY_DECODED_BUFFER_SIZE - query->decoded_size) <= text->length) {
+        return false;
+    }
+    char* decoded = query->decoded + query->decoded_size;
+    size_t length = 0;
+    for (size_t i = 0; i < text->length; i++) {
+        char c = text->text[i];
+        if (c == '+') {
+            c = ' ';
+        } else if ((c == '%') && ((i + 2) < text->length)) {
+            int high = decode_hex_digit(text->text[i + 1]);
+            int low = decode_hex_digit(text->text[i + 2]);
+            if ((high >= 0) && (low >= 0)) {
+                c = (char)((high << 4) | low);
+                i += 2;
+            }
+        }
+        decoded[length++] = c;
+    }
+    decoded[length] = '\0';
+    query->decoded_size += length + 1;
+    text->text = decoded;
+    text->length = length;
+    return true;
+}
+
+static const static_string_t empty_string = {.text = NULL, .length = 0};
+
+divulge_url_query_t divulge_url_query_create_from_raw_query(const char* raw_query) {
+    divulge_url_query_t query = {.parameter_count = 0, .decoded_size = 0};
+    if (!raw_query) {
+        return query;
+    }
+    const char* position = raw_query;
+    while (*position && (query.parameter_count < DIVULGE_URL_QUERY_PARAMETERS_MAX_COUNT)) {
+        const char* end = position;
+        const char* separator = NULL;
+        while (*end && (*end != PARAMETER_SEPARATOR)) {
+            if ((*end == VALUE_SEPARATOR) && !separator) {
+                separator = end;
+            }
+            end++;
+        }
+        if (end != position) {
+            divulge_url_query_parameter_t* parameter = query.parameters + query.parameter_count++;
+            parameter->key.text = (char*)position;
+            parameter->key.length = (size_t)((separator ? separator : end) - position);
+            parameter->value.text = (char*)(separator ? (separator + 1) : end);
+            parameter->value.length = separator ? (size_t)(end - separator - 1) : 0;
+            parameter->is_key_decoded = false;
+            parameter->is_value_decoded = false;
+        }
+        position = *end ? (end + 1) : end;
+    }
+    return query;
+}
+
+divulge_url_query_t divulge_url_query_create_from_request(divulge_request_t* request) {
+    return divulge_url_query_create_from_raw_query(request ? request->url_query : NULL);
+}
+
+static_string_t divulge_url_query_get_key(divulge_url_query_t* query, size_t index) {
+    if (!query || (index >= query->parameter_count)) {
+        return empty_string;
+    }
+    divulge_url_query_parameter_t* parameter = query->parameters + index;
+    if (!parameter->is_key_decoded) {
+        if (!decode(query, &parameter->key)) {
+            return empty_string;
+        }
+        parameter->is_key_decoded = true;
+    }
+    return parameter->key;
+}
+
+static_string_t divulge_url_query_get_value(divulge_url_query_t* query, size_t index) {
+    if (!query || (index >= query->parameter_count)) {
+        return empty_string;
+    }
+    divulge_url_query_parameter_t* parameter = query->parameters + index;
+    if (!parameter->is_value_decoded) {
+        if (!decode(query, &parameter->value)) {
+            return empty_string;
+        }
+        parameter->is_value_decoded = true;
+    }
+    return parameter->value;
+}
+
+static bool find_parameter(divulge_url_query_t* query, const char* key, size_t* index) {
+    if (!query || !key) {
+        return false;
+    }
+    size_t key_length = strlen(key);
+    for (size_t i = 0; i < query->parameter_count; i++) {
+        static_string_t parameter_key = divulge_url_query_get_key(query, i);
+        if ((parameter_key.length == key_length) && (memcmp(parameter_key.text, key, key_length) == 0)) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static_string_t divulge_url_query_find(divulge_url_query_t* query, const char* key) {
+    size_t index = 0;
+    if (!find_parameter(query, key, &index)) {
+        return empty_string;
+    }
+    return divulge_url_query_get_value(query, index);
+}
+
+bool divulge_url_query_has(divulge_url_query_t* query, const char* key) {
+    size_t index = 0;
+    return find_parameter(query, key, &index);
+}
+
+bool divulge_url_query_get_int(divulge_url_query_t* query, const char* key, int* value) {
+    static_string_t text = divulge_url_query_find(query, key);
+    if (!text.text || (text.length == 0) || !value || isspace((unsigned char)text.text[0])) {
+        return false;
+    }
+    char* end = NULL;
+    errno = 0;
+    long result = strtol(text.text, &end, 10);
+    if ((errno != 0) || (end != (text.text + text.length)) || (result < INT_MIN) || (result > INT_MAX)) {
+        return false;
+    }
+    *value = (int)result;
+    return true;
+}
+
+bool divulge_url_query_get_float(divulge_url_query_t* query, const char* key, float* value) {
+    static_string_t text = divulge_url_query_find(query, key);
+    if (!text.text || (text.length == 0) || !value || isspace((unsigned char)text.text[0])) {
+        return false;
+    }
+    char* end = NULL;
+    errno = 0;
+    float result = strtof(text.text, &end);
+    if ((errno != 0) || (end != (text.text + text.length))) {
+        return false;
+    }
+    *value = result;
+    return true;
+}
+
+static bool is_text_equal(const static_string_t* text, const char* reference) {
+    size_t length = strlen(reference);
+    if (text->length != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (tolower((unsigned char)text->text[i]) != reference[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool divulge_url_query_get_bool(divulge_url_query_t* query, const char* key, bool* value) {
+    static_string_t text = divulge_url_query_find(query, key);
+    if (!text.text || !value) {
+        return false;
+    }
+    if ((text.length == 0) || is_text_equal(&text, "true") || is_text_equal(&text, "1") ||
+        is_text_equal(&text, "yes") || is_text_equal(&text, "on")) {
+        *value = true;
+    } else if (is_text_equal(&text, "false") || is_text_equal(&text, "0") || is_text_equal(&text, "no") ||
+               is_text_equal(&text, "off")) {
+        *value = false;
+    } else {
+        return false;
+    }
+    return true;
+}
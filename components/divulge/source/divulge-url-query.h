@@ -26,11 +26,87 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include "divulge.h"
 #include "static-string.h"
 
+/**
+ * @defgroup divulge-url-query Divulge URL query
+ * @ingroup divulge
+ * @brief Zero-copy query string parser
+ *
+ * The query is split into key/value views pointing into the original buffer, which is never modified and has to
+ * outlive the query object. Percent-encoding and '+' are decoded the first time a key or value is accessed, into
+ * NUL-terminated storage inside the query object; do not copy the object once elements were accessed. Elements that
+ * no longer fit the storage read as missing.
+ * @{
+ */
+
+#define DIVULGE_URL_QUERY_PARAMETERS_MAX_COUNT (16)
+#define DIVULGE_URL_QUERY_DECODED_BUFFER_SIZE (256)
+
+typedef struct divulge_url_query_parameter {
+    static_string_t key;
+    static_string_t value;
+    bool is_key_decoded;
+    bool is_value_decoded;
+} divulge_url_query_parameter_t;
+
 typedef struct divulge_url_query {
+    divulge_url_query_parameter_t parameters[DIVULGE_URL_QUERY_PARAMETERS_MAX_COUNT];
+    size_t parameter_count;
+    char decoded[DIVULGE_URL_QUERY_DECODED_BUFFER_SIZE];
+    size_t decoded_size;
 } divulge_url_query_t;
 
+/**
+ * @brief Split a raw query (without the leading '?') into parameters. Excess parameters are ignored.
+ */
 divulge_url_query_t divulge_url_query_create_from_raw_query(const char* raw_query);
 
-#endif  // DIVULGE_URL_QUERY_H
\ No newline at end of file
+/**
+ * @brief Split the query of a request being handled
+ */
+divulge_url_query_t divulge_url_query_create_from_request(divulge_request_t* request);
+
+/**
+ * @brief Decoded key of the parameter at given index, or an empty string with NULL text
+ */
+static_string_t divulge_url_query_get_key(divulge_url_query_t* query, size_t index);
+
+/**
+ * @brief Decoded value of the parameter at given index, or an empty string with NULL text
+ */
+static_string_t divulge_url_query_get_value(divulge_url_query_t* query, size_t index);
+
+/**
+ * @brief Decoded value of the first parameter with given key, or an empty string with NULL text when missing
+ */
+static_string_t divulge_url_query_find(divulge_url_query_t* query, const char* key);
+
+/**
+ * @brief Check if a parameter with given key is present, with or without a value
+ */
+bool divulge_url_query_has(divulge_url_query_t* query, const char* key);
+
+/**
+ * @brief Read a decimal integer parameter
+ * @return false when the key is missing or the value is not a valid number
+ */
+bool divulge_url_query_get_int(divulge_url_query_t* query, const char* key, int* value);
+
+/**
+ * @brief Read a floating point parameter
+ * @return false when the key is missing or the value is not a valid number
+ */
+bool divulge_url_query_get_float(divulge_url_query_t* query, const char* key, float* value);
+
+/**
+ * @brief Read a boolean parameter: true/false, 1/0, yes/no, on/off. A key without a value reads as true.
+ * @return false when the key is missing or the value is not recognized
+ */
+bool divulge_url_query_get_bool(divulge_url_query_t* query, const char* key, bool* value);
+
+/**
+ * @}
+ */
+#endif  // DIVULGE_URL_QUERY_H
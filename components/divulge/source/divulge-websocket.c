@@ -0,0 +1,595 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "divulge-websocket.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encodings-base64.h"
+#include "encodings-sha1.h"
+#include "g2l-mutex.h"
+
+#define ACCEPT_KEY_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define CLIENT_KEY_LENGTH (24)
+#define PROTOCOL_VERSION "13"
+#define INPUT_BUFFER_SIZE (512)
+#define FRAME_HEADER_MAX_SIZE (14)
+
+#define FRAME_FINAL_BIT (0x80)
+#define FRAME_RESERVED_BITS (0x70)
+#define FRAME_OPCODE_MASK (0x0F)
+#define FRAME_MASK_BIT (0x80)
+#define FRAME_LENGTH_MASK (0x7F)
+#define FRAME_LENGTH_16_BIT (126)
+#define FRAME_LENGTH_64_BIT (127)
+
+#define OPCODE_CONTINUATION (0x0)
+#define OPCODE_CONTROL_BIT (0x8)
+#define OPCODE_CLOSE (0x8)
+#define OPCODE_PING (0x9)
+#define OPCODE_PONG (0xA)
+
+#define STATUS_NORMAL_CLOSURE (1000)
+#define STATUS_PROTOCOL_ERROR (1002)
+#define STATUS_INVALID_PAYLOAD (1007)
+#define STATUS_MESSAGE_TOO_BIG (1009)
+
+struct divulge_websocket_connection {
+    divulge_websocket_t* websocket;
+    divulge_request_t* request;
+    g2l_mutex_t* mutex;
+    size_t reference_count;
+    bool is_open;
+    bool is_closing;
+    char input[INPUT_BUFFER_SIZE];
+    size_t input_size;
+    size_t input_position;
+    uint8_t message_opcode;
+    size_t message_size;
+    char message[];
+};
+
+struct divulge_websocket {
+    divulge_websocket_configuration_t configuration;
+    divulge_uri_t uri;
+    g2l_mutex_t* mutex;
+    divulge_websocket_connection_t** connections;
+    size_t connection_count;
+};
+
+static bool has_header_token(static_string_t value, const char* token) {
+    size_t token_length = strlen(token);
+    size_t position = 0;
+    while (position < value.length) {
+        while ((position < value.length) && ((value.text[position] == ' ') || (value.text[position] == ','))) {
+            position++;
+        }
+        size_t start = position;
+        while ((position < value.length) && (value.text[position] != ',')) {
+            position++;
+        }
+        size_t end = position;
+        while ((end > start) && ((value.text[end - 1] == ' ') || (value.text[end - 1] == '\t'))) {
+            end--;
+        }
+        if ((end - start) == token_length) {
+            size_t i = 0;
+            while ((i < token_length) && (tolower((unsigned char)value.text[start + i]) == token[i])) {
+                i++;
+            }
+            if (i == token_length) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void create_accept_key(static_string_t client_key, char* accept_key) {
+    uint8_t digest[ENCODINGS_SHA1_DIGEST_SIZE];
+    encodings_sha1_t sha1;
+    encodings_sha1_initialize(&sha1);
+    encodings_sha1_update(&sha1, client_key.text, client_key.length);
+    encodings_sha1_update(&sha1, ACCEPT_KEY_GUID, strlen(ACCEPT_KEY_GUID));
+    encodings_sha1_finalize(&sha1, digest);
+    encodings_base64_encode(digest, sizeof(digest), accept_key);
+}
+
+static bool write_frame(divulge_websocket_connection_t* connection,
+                        uint8_t opcode,
+                        const char* data,
+                        size_t data_size) {
+    if (!connection->is_open || connection->is_closing) {
+        return false;
+    }
+    uint8_t header[FRAME_HEADER_MAX_SIZE];
+    size_t header_size = 2;
+    header[0] = FRAME_FINAL_BIT | opcode;
+    if (data_size < FRAME_LENGTH_16_BIT) {
+        header[1] = (uint8_t)data_size;
+    } else if (data_size <= UINT16_MAX) {
+        header[1] = FRAME_LENGTH_16_BIT;
+        header[header_size++] = (uint8_t)(data_size >> 8);
+        header[header_size++] = (uint8_t)data_size;
+    } else {
+        header[1] = FRAME_LENGTH_64_BIT;
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            header[header_size++] = (uint8_t)((uint64_t)data_size >> shift);
+        }
+    }
+    divulge_io_vector_t vectors[] = {
+        {.data = (const char*)header, .size = header_size},
+        {.data = data, .size = data_size},
+    };
+    connection->is_closing = (opcode == OPCODE_CLOSE);
+    return divulge_send_vector(connection->request, vectors, (data_size > 0) ? 2 : 1);
+}
+
+static bool send_frame(divulge_websocket_connection_t* connection, uint8_t opcode, const char* data, size_t data_size) {
+    g2l_mutex_lock(connection->mutex);
+    bool result = write_frame(connection, opcode, data, data_size);
+    g2l_mutex_unlock(connection->mutex);
+    return result;
+}
+
+static bool send_close_frame(divulge_websocket_connection_t* connection, uint16_t status_code) {
+    char payload[] = {(char)(status_code >> 8), (char)status_code};
+    return send_frame(connection, OPCODE_CLOSE, payload, sizeof(payload));
+}
+
+static bool read_input(divulge_websocket_connection_t* connection, void* data, size_t data_size) {
+    char* output = (char*)data;
+    while (data_size > 0) {
+        if (connection->input_position == connection->input_size) {
+            if (data_size >= sizeof(connection->input)) {
+                size_t size = divulge_receive(connection->request, output, data_size);
+                if (size == 0) {
+                    return false;
+                }
+                output += size;
+                data_size -= size;
+                continue;
+            }
+            connection->input_size = divulge_receive(connection->request, connection->input, sizeof(connection->input));
+            connection->input_position = 0;
+            if (connection->input_size == 0) {
+                return false;
+            }
+        }
+        size_t size = connection->input_size - connection->input_position;
+        if (size > data_size) {
+            size = data_size;
+        }
+        memcpy(output, connection->input + connection->input_position, size);
+        connection->input_position += size;
+        output += size;
+        data_size -= size;
+    }
+    return true;
+}
+
+static void unmask_payload(char* payload, size_t payload_size, const uint8_t* mask) {
+    for (size_t i = 0; i < payload_size; i++) {
+        payload[i] ^= (char)mask[i & 3];
+    }
+}
+
+static bool read_payload_length(divulge_websocket_connection_t* connection, uint8_t length, uint64_t* payload_size) {
+    size_t extended_size = (length == FRAME_LENGTH_64_BIT) ? 8 : (length == FRAME_LENGTH_16_BIT) ? 2 : 0;
+    uint8_t extended[8];
+    if (!read_input(connection, extended, extended_size)) {
+        return false;
+    }
+    *payload_size = (extended_size == 0) ? length : 0;
+    for (size_t i = 0; i < extended_size; i++) {
+        *payload_size = (*payload_size << 8) | extended[i];
+    }
+    return true;
+}
+
+static bool is_valid_utf8(const char* text, size_t text_size) {
+    const uint8_t* data = (const uint8_t*)text;
+    size_t i = 0;
+    while (i < text_size) {
+        uint8_t byte = data[i++];
+        if (byte < 0x80) {
+            continue;
+        }
+        size_t continuation_count;
+        uint8_t minimum = 0x80;
+        uint8_t maximum = 0xBF;
+        if ((byte >= 0xC2) && (byte <= 0xDF)) {
+            continuation_count = 1;
+        } else if ((byte >= 0xE0) && (byte <= 0xEF)) {
+            continuation_count = 2;
+            minimum = (byte == 0xE0) ? 0xA0 : 0x80;  // overlong forms
+            maximum = (byte == 0xED) ? 0x9F : 0xBF;  // UTF-16 surrogates
+        } else if ((byte >= 0xF0) && (byte <= 0xF4)) {
+            continuation_count = 3;
+            minimum = (byte == 0xF0) ? 0x90 : 0x80;  // overlong forms
+            maximum = (byte == 0xF4) ? 0x8F : 0xBF;  // above U+10FFFF
+        } else {
+            return false;
+        }
+        if ((text_size - i) < continuation_count) {
+            return false;
+        }
+        if ((data[i] < minimum) || (data[i] > maximum)) {
+            return false;
+        }
+        for (size_t j = 1; j < continuation_count; j++) {
+            if ((data[i + j] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += continuation_count;
+    }
+    return true;
+}
+
+static bool handle_control_frame(divulge_websocket_connection_t* connection,
+                                 uint8_t opcode,
+                                 const uint8_t* mask,
+                                 uint64_t payload_size) {
+    char payload[DIVULGE_WEBSOCKET_CONTROL_PAYLOAD_MAX_SIZE];
+    if (!read_input(connection, payload, (size_t)payload_size)) {
+        return false;
+    }
+    unmask_payload(payload, (size_t)payload_size, mask);
+    if (opcode == OPCODE_PING) {
+        send_frame(connection, OPCODE_PONG, payload, (size_t)payload_size);
+        return true;
+    } else if (opcode == OPCODE_PONG) {
+        return true;
+    } else if (opcode == OPCODE_CLOSE) {
+        if ((payload_size > 2) && !is_valid_utf8(payload + 2, (size_t)payload_size - 2)) {
+            send_close_frame(connection, STATUS_INVALID_PAYLOAD);
+        } else {
+            send_frame(connection, OPCODE_CLOSE, payload, (payload_size >= 2) ? 2 : 0);
+        }
+        return false;
+    }
+    send_close_frame(connection, STATUS_PROTOCOL_ERROR);
+    return false;
+}
+
+static bool handle_data_frame(divulge_websocket_connection_t* connection,
+                              uint8_t opcode,
+                              bool is_final,
+                              const uint8_t* mask,
+                              uint64_t payload_size) {
+    divulge_websocket_t* websocket = connection->websocket;
+    if (opcode == OPCODE_CONTINUATION) {
+        if (connection->message_opcode == OPCODE_CONTINUATION) {
+            send_close_frame(connection, STATUS_PROTOCOL_ERROR);
+            return false;
+        }
+    } else if (((opcode == DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT) || (opcode == DIVULGE_WEBSOCKET_MESSAGE_TYPE_BINARY)) &&
+               (connection->message_opcode == OPCODE_CONTINUATION)) {
+        connection->message_opcode = opcode;
+        connection->message_size = 0;
+    } else {
+        send_close_frame(connection, STATUS_PROTOCOL_ERROR);
+        return false;
+    }
+    if (payload_size > (websocket->configuration.max_message_size - connection->message_size)) {
+        send_close_frame(connection, STATUS_MESSAGE_TOO_BIG);
+        return false;
+    }
+    char* payload = connection->message + connection->message_size;
+    if (!read_input(connection, payload, (size_t)payload_size)) {
+        return false;
+    }
+    unmask_payload(payload, (size_t)payload_size, mask);
+    connection->message_size += (size_t)payload_size;
+    if (!is_final) {
+        return true;
+    }
+    divulge_websocket_message_type_t type = (divulge_websocket_message_type_t)connection->message_opcode;
+    connection->message_opcode = OPCODE_CONTINUATION;
+    bool is_text = (type == DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT);
+    if (is_text && !is_valid_utf8(connection->message, connection->message_size)) {
+        send_close_frame(connection, STATUS_INVALID_PAYLOAD);
+        return false;
+    }
+    if (websocket->configuration.message_handler &&
+        !websocket->configuration.message_handler(connection, type, connection->message, connection->message_size,
+                                                  websocket->configuration.context)) {
+        send_close_frame(connection, STATUS_NORMAL_CLOSURE);
+    }
+    return true;
+}
+
+static bool handle_frame(divulge_websocket_connection_t* connection) {
+    uint8_t header[2];
+    if (!read_input(connection, header, sizeof(header))) {
+        return false;
+    }
+    bool is_final = (header[0] & FRAME_FINAL_BIT) != 0;
+    uint8_t opcode = header[0] & FRAME_OPCODE_MASK;
+    uint64_t payload_size = 0;
+    uint8_t mask[4];
+    if ((header[0] & FRAME_RESERVED_BITS) || !(header[1] & FRAME_MASK_BIT)) {
+        send_close_frame(connection, STATUS_PROTOCOL_ERROR);
+        return false;
+    }
+    if (!read_payload_length(connection, header[1] & FRAME_LENGTH_MASK, &payload_size) ||
+        !read_input(connection, mask, sizeof(mask))) {
+        return false;
+    }
+    if (opcode & OPCODE_CONTROL_BIT) {
+        if (!is_final || (payload_size > DIVULGE_WEBSOCKET_CONTROL_PAYLOAD_MAX_SIZE)) {
+            send_close_frame(connection, STATUS_PROTOCOL_ERROR);
+            return false;
+        }
+        return handle_control_frame(connection, opcode, mask, payload_size);
+    }
+    return handle_data_frame(connection, opcode, is_final, mask, payload_size);
+}
+
+static divulge_websocket_connection_t* create_connection(divulge_websocket_t* websocket, divulge_request_t* request) {
+    divulge_websocket_connection_t* connection =
+        calloc(1, sizeof(divulge_websocket_connection_t) + websocket->configuration.max_message_size);
+    if (!connection) {
+        return NULL;
+    }
+    connection->mutex = g2l_mutex_create();
+    if (!connection->mutex) {
+        free(connection);
+        return NULL;
+    }
+    connection->websocket = websocket;
+    connection->request = request;
+    connection->reference_count = 1;
+    return connection;
+}
+
+static bool add_connection(divulge_websocket_t* websocket, divulge_websocket_connection_t* connection) {
+    g2l_mutex_lock(websocket->mutex);
+    bool result = websocket->connection_count < websocket->configuration.max_connection_count;
+    if (result) {
+        websocket->connections[websocket->connection_count++] = connection;
+    }
+    g2l_mutex_unlock(websocket->mutex);
+    return result;
+}
+
+static void remove_connection(divulge_websocket_t* websocket, divulge_websocket_connection_t* connection) {
+    g2l_mutex_lock(connection->mutex);
+    connection->is_open = false;
+    connection->request = NULL;
+    g2l_mutex_unlock(connection->mutex);
+    g2l_mutex_lock(websocket->mutex);
+    for (size_t i = 0; i < websocket->connection_count; i++) {
+        if (websocket->connections[i] == connection) {
+            websocket->connections[i] = websocket->connections[--websocket->connection_count];
+            break;
+        }
+    }
+    g2l_mutex_unlock(websocket->mutex);
+}
+
+static bool respond_upgrade_required(divulge_request_t* request) {
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Upgrade", .value = "websocket"},
+        {.key = "Sec-WebSocket-Version", .value = PROTOCOL_VERSION},
+    };
+    divulge_response_t response = {
+        .return_code = 426,
+        .header = {.entries = header_entries, .count = 2},
+        .payload = "",
+        .payload_size = 0,
+    };
+    return divulge_respond(request, &response);
+}
+
+static bool respond_with_status(divulge_request_t* request, int return_code) {
+    divulge_response_t response = {
+        .return_code = return_code,
+        .payload = "",
+        .payload_size = 0,
+    };
+    return divulge_respond(request, &response);
+}
+
+static bool upgrade_connection(divulge_request_t* request, static_string_t client_key) {
+    char accept_key[32];
+    create_accept_key(client_key, accept_key);
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Upgrade", .value = "websocket"},
+        {.key = "Sec-WebSocket-Accept", .value = accept_key},
+    };
+    divulge_response_t response = {
+        .return_code = 101,
+        .header = {.entries = header_entries, .count = 2},
+        .payload = "",
+        .payload_size = 0,
+    };
+    return divulge_upgrade_connection(request, &response);
+}
+
+static bool handler(divulge_request_t* request, void* context) {
+    divulge_websocket_t* websocket = (divulge_websocket_t*)context;
+    if (!has_header_token(divulge_get_request_header(request, "Upgrade"), "websocket") ||
+        !has_header_token(divulge_get_request_header(request, "Connection"), "upgrade")) {
+        return respond_upgrade_required(request);
+    }
+    static_string_t version = divulge_get_request_header(request, "Sec-WebSocket-Version");
+    if ((version.length != strlen(PROTOCOL_VERSION)) || (memcmp(version.text, PROTOCOL_VERSION, version.length) != 0)) {
+        return respond_upgrade_required(request);
+    }
+    static_string_t client_key = divulge_get_request_header(request, "Sec-WebSocket-Key");
+    if (client_key.length != CLIENT_KEY_LENGTH) {
+        return respond_with_status(request, 400);
+    }
+    divulge_websocket_connection_t* connection = create_connection(websocket, request);
+    if (!connection || !add_connection(websocket, connection)) {
+        divulge_websocket_release(connection);
+        return respond_with_status(request, 503);
+    }
+    if (!upgrade_connection(request, client_key)) {
+        remove_connection(websocket, connection);
+        divulge_websocket_release(connection);
+        return true;
+    }
+    g2l_mutex_lock(connection->mutex);
+    connection->is_open = true;
+    g2l_mutex_unlock(connection->mutex);
+    if (websocket->configuration.connection_handler) {
+        websocket->configuration.connection_handler(connection, true, websocket->configuration.context);
+    }
+    while (handle_frame(connection)) {
+    }
+    remove_connection(websocket, connection);
+    if (websocket->configuration.connection_handler) {
+        websocket->configuration.connection_handler(connection, false, websocket->configuration.context);
+    }
+    divulge_websocket_release(connection);
+    return true;
+}
+
+divulge_websocket_t* divulge_websocket_create(const divulge_websocket_configuration_t* configuration) {
+    if (!configuration || (configuration->max_connection_count == 0)) {
+        return NULL;
+    }
+    divulge_websocket_t* websocket = calloc(1, sizeof(divulge_websocket_t));
+    if (!websocket) {
+        return NULL;
+    }
+    websocket->configuration = *configuration;
+    websocket->connections = calloc(configuration->max_connection_count, sizeof(divulge_websocket_connection_t*));
+    websocket->mutex = g2l_mutex_create();
+    if (!websocket->connections || !websocket->mutex) {
+        divulge_websocket_destroy(websocket);
+        return NULL;
+    }
+    return websocket;
+}
+
+divulge_uri_t* divulge_websocket_mount(divulge_t* divulge, divulge_websocket_t* websocket, const char* uri) {
+    if (!divulge || !websocket || !uri || websocket->uri.uri) {
+        return NULL;
+    }
+    websocket->uri.uri = uri;
+    websocket->uri.method = DIVULGE_ROUTE_METHOD_GET;
+    websocket->uri.handler.handler = handler;
+    websocket->uri.handler.context = websocket;
+    divulge_register_uri(divulge, &websocket->uri);
+    return &websocket->uri;
+}
+
+divulge_request_t* divulge_websocket_get_request(divulge_websocket_connection_t* connection) {
+    if (!connection) {
+        return NULL;
+    }
+    g2l_mutex_lock(connection->mutex);
+    divulge_request_t* request = connection->request;
+    g2l_mutex_unlock(connection->mutex);
+    return request;
+}
+
+void divulge_websocket_retain(divulge_websocket_connection_t* connection) {
+    if (!connection) {
+        return;
+    }
+    g2l_mutex_lock(connection->mutex);
+    connection->reference_count++;
+    g2l_mutex_unlock(connection->mutex);
+}
+
+void divulge_websocket_release(divulge_websocket_connection_t* connection) {
+    if (!connection) {
+        return;
+    }
+    g2l_mutex_lock(connection->mutex);
+    bool is_last = (--connection->reference_count == 0);
+    g2l_mutex_unlock(connection->mutex);
+    if (is_last) {
+        g2l_mutex_destroy(connection->mutex);
+        free(connection);
+    }
+}
+
+bool divulge_websocket_send(divulge_websocket_connection_t* connection,
+                            divulge_websocket_message_type_t type,
+                            const char* data,
+                            size_t data_size) {
+    if (!connection || (!data && (data_size > 0))) {
+        return false;
+    }
+    return send_frame(connection, (uint8_t)type, data, data_size);
+}
+
+size_t divulge_websocket_broadcast(divulge_websocket_t* websocket,
+                                   divulge_websocket_message_type_t type,
+                                   const char* data,
+                                   size_t data_size) {
+    if (!websocket || (!data && (data_size > 0))) {
+        return 0;
+    }
+    divulge_websocket_connection_t** connections =
+        calloc(websocket->configuration.max_connection_count, sizeof(divulge_websocket_connection_t*));
+    if (!connections) {
+        return 0;
+    }
+    g2l_mutex_lock(websocket->mutex);
+    size_t connection_count = websocket->connection_count;
+    for (size_t i = 0; i < connection_count; i++) {
+        connections[i] = websocket->connections[i];
+        divulge_websocket_retain(connections[i]);
+    }
+    g2l_mutex_unlock(websocket->mutex);
+    size_t sent_count = 0;
+    for (size_t i = 0; i < connection_count; i++) {
+        sent_count += send_frame(connections[i], (uint8_t)type, data, data_size) ? 1 : 0;
+        divulge_websocket_release(connections[i]);
+    }
+    free(connections);
+    return sent_count;
+}
+
+bool divulge_websocket_close(divulge_websocket_connection_t* connection, uint16_t status_code) {
+    if (!connection) {
+        return false;
+    }
+    return send_close_frame(connection, status_code);
+}
+
+size_t divulge_websocket_get_connection_count(divulge_websocket_t* websocket) {
+    if (!websocket) {
+        return 0;
+    }
+    g2l_mutex_lock(websocket->mutex);
+    size_t count = websocket->connection_count;
+    g2l_mutex_unlock(websocket->mutex);
+    return count;
+}
+
+void divulge_websocket_destroy(divulge_websocket_t* websocket) {
+    if (!websocket) {
+        return;
+    }
+    free(websocket->connections);
+    g2l_mutex_destroy(websocket->mutex);
+    free(websocket);
+}
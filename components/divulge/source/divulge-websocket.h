@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_WEBSOCKET_H
+#define DIVULGE_WEBSOCKET_H
+
+#include "divulge.h"
+
+#define DIVULGE_WEBSOCKET_CONTROL_PAYLOAD_MAX_SIZE (125)
+
+typedef enum divulge_websocket_message_type {
+    DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT = 0x1,
+    DIVULGE_WEBSOCKET_MESSAGE_TYPE_BINARY = 0x2,
+} divulge_websocket_message_type_t;
+
+typedef struct divulge_websocket divulge_websocket_t;
+
+typedef struct divulge_websocket_connection divulge_websocket_connection_t;
+
+/**
+ * Called with is_connected set once a connection is open and again when it closes. The connection pointer stays valid
+ * until the closing call returns; call divulge_websocket_retain() to keep it longer. Sending to a closed connection
+ * fails.
+ */
+typedef void (*divulge_websocket_connection_handler_t)(divulge_websocket_connection_t* connection,
+                                                       bool is_connected,
+                                                       void* context);
+
+typedef bool (*divulge_websocket_message_handler_t)(divulge_websocket_connection_t* connection,
+                                                    divulge_websocket_message_type_t type,
+                                                    const char* data,
+                                                    size_t data_size,
+                                                    void* context);
+
+typedef struct divulge_websocket_configuration {
+    size_t max_connection_count;
+    size_t max_message_size;
+    divulge_websocket_connection_handler_t connection_handler;
+    divulge_websocket_message_handler_t message_handler;
+    void* context;
+} divulge_websocket_configuration_t;
+
+divulge_websocket_t* divulge_websocket_create(const divulge_websocket_configuration_t* configuration);
+
+divulge_uri_t* divulge_websocket_mount(divulge_t* divulge, divulge_websocket_t* websocket, const char* uri);
+
+divulge_request_t* divulge_websocket_get_request(divulge_websocket_connection_t* connection);
+
+/** Keep a connection allocated past its closing callback; every call needs a matching divulge_websocket_release() */
+void divulge_websocket_retain(divulge_websocket_connection_t* connection);
+
+void divulge_websocket_release(divulge_websocket_connection_t* connection);
+
+bool divulge_websocket_send(divulge_websocket_connection_t* connection,
+                            divulge_websocket_message_type_t type,
+                            const char* data,
+                            size_t data_size);
+
+size_t divulge_websocket_broadcast(divulge_websocket_t* websocket,
+                                   divulge_websocket_message_type_t type,
+                                   const char* data,
+                                   size_t data_size);
+
+bool divulge_websocket_close(divulge_websocket_connection_t* connection, uint16_t status_code);
+
+size_t divulge_websocket_get_connection_count(divulge_websocket_t* websocket);
+
+void divulge_websocket_destroy(divulge_websocket_t* websocket);
+
+#endif  // DIVULGE_WEBSOCKET_H
@@ -22,65 +22,208 @@
  * SOFTWARE.
  */
 #include "divulge.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "divulge-arena.h"
+#include "divulge-body-reader.h"
+#include "divulge-http2.h"
+#include "divulge-metrics.h"
+#include "divulge-range.h"
+#include "divulge-request-parser.h"
+#include "divulge-route-tree.h"
 #include "dynamic-list.h"
 
 #define TAG "divulge"
 #include "g2l-log.h"
 
 #define DIVULGE_SERVER_NAME "Divulge"
+#define DIVULGE_KEEP_ALIVE_DEFAULT_MAX_REQUESTS (100)
+#define DIVULGE_KEEP_ALIVE_DEFAULT_TIMEOUT_MS (5000)
+#define DIVULGE_ETAG_MAX_SIZE (48)
+#define DIVULGE_CONTENT_RANGE_MAX_SIZE (80)
+#define DIVULGE_FILE_HEADER_MAX_ENTRIES (16)
+#define DIVULGE_BYTERANGES_BOUNDARY "divulge-byteranges-5f3a9c0e71d2b846"
+#define DIVULGE_HTTP2_UPGRADE_RESPONSE "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n"
 typedef struct route_entry {
     divulge_uri_t uri;
     dynamic_list_t* middlewares;
+    static_string_t parameter_names[DIVULGE_ROUTE_PARAMETERS_MAX_COUNT];
+    size_t parameter_count;
+    divulge_route_metrics_t* metrics;
+    const divulge_static_route_t* static_route;
 } route_entry_t;
 typedef struct divulge {
     divulge_configuration_t configuration;
-    dynamic_list_t* routes;
+    divulge_route_tree_t* routes;
     divulge_uri_handler_t default_404_handler;
     void* default_404_handler_context;
+    divulge_metrics_t* metrics;
+    route_entry_t* static_routes;
 } divulge_t;
 
+typedef struct matched_route {
+    const divulge_uri_t* uri;
+    route_entry_t* entry;
+    const divulge_static_route_t* static_route;
+    divulge_route_metrics_t* metrics;
+} matched_route_t;
+
+extern const divulge_static_route_t* const __start_divulge_routes[] __attribute__((weak));
+extern const divulge_static_route_t* const __stop_divulge_routes[] __attribute__((weak));
+
+typedef struct request_input {
+    char* buffer;
+    size_t capacity;
+    size_t received_size;
+    size_t request_size;
+    bool can_receive;
+} request_input_t;
+
+typedef enum body_status {
+    BODY_STATUS_COMPLETE,
+    BODY_STATUS_MALFORMED,
+    BODY_STATUS_TOO_LARGE,
+    BODY_STATUS_INTERRUPTED,
+    BODY_STATUS_REJECTED,
+} body_status_t;
+
+typedef enum connection_state {
+    CONNECTION_STATE_KEEP_ALIVE,
+    CONNECTION_STATE_CLOSE,
+    CONNECTION_STATE_DEFERRED,
+} connection_state_t;
+
+typedef struct response_filter_entry {
+    divulge_response_filter_t filter;
+    void* context;
+} response_filter_entry_t;
+
 typedef struct divulge_request_context {
     divulge_t* divulge;
     void* connection_context;
+    request_input_t* input;
+    divulge_arena_t* arena;
+    divulge_http2_stream_t* http2_stream;
+    divulge_body_reader_t body_reader;
     char* response_buffer;
     size_t response_buffer_size;
+    size_t response_size;
+    size_t sent_size;
+    int return_code;
+    uint64_t start_time_us;
+    divulge_route_metrics_t* route_metrics;
     bool was_status_sent;
     bool was_header_sent;
+    bool keep_alive;
+    bool is_legacy_version;
+    bool is_chunked;
+    bool was_chunked_response_started;
+    bool is_upgraded;
+    bool is_deferred;
+    bool is_body_suppressed;
+    response_filter_entry_t response_filters[DIVULGE_RESPONSE_FILTERS_MAX_COUNT];
+    size_t response_filter_count;
+    size_t response_filter_position;
+    const divulge_chunk_filter_t* chunk_filter;
+    void* chunk_filter_context;
+    void* chunk_filter_state;
+    bool is_chunk_filter_running;
 } divulge_request_context_t;
 
+typedef struct divulge_deferred_response {
+    divulge_request_context_t context;
+    divulge_request_t request;
+    request_input_t input;
+    divulge_arena_t arena;
+    char input_buffer[1];
+    char response_buffer[];
+} divulge_deferred_response_t;
+
+typedef struct http2_session {
+    divulge_t* divulge;
+    void* connection_context;
+    divulge_arena_t* arena;
+    char* response_buffer;
+    size_t response_buffer_size;
+} http2_session_t;
+
+static const char* const method_names[] = {
+    [DIVULGE_ROUTE_METHOD_GET] = "GET",
+    [DIVULGE_ROUTE_METHOD_POST] = "POST",
+    [DIVULGE_ROUTE_METHOD_HEAD] = "HEAD",
+    [DIVULGE_ROUTE_METHOD_PUT] = "PUT",
+    [DIVULGE_ROUTE_METHOD_DELETE] = "DELETE",
+    [DIVULGE_ROUTE_METHOD_PATCH] = "PATCH",
+    [DIVULGE_ROUTE_METHOD_OPTIONS] = "OPTIONS",
+    [DIVULGE_ROUTE_METHOD_ANY] = "ANY",
+};
+
 const char* divulge_method_name_from_method(divulge_route_method_t method) {
-    if (method == DIVULGE_ROUTE_METHOD_GET) {
-        return "GET";
-    } else if (method == DIVULGE_ROUTE_METHOD_POST) {
-        return "POST";
-    } else {
-        return "ANY";
+    if ((unsigned)method > DIVULGE_ROUTE_METHOD_ANY) {
+        return method_names[DIVULGE_ROUTE_METHOD_ANY];
     }
+    return method_names[method];
 }
 
-static divulge_route_method_t convert_request_method_to_method_type(
-    const char* method_name) {
-    if (strcmp(method_name, "GET") == 0) {
-        return DIVULGE_ROUTE_METHOD_GET;
-    } else if (strcmp(method_name, "POST") == 0) {
-        return DIVULGE_ROUTE_METHOD_POST;
-    } else {
-        return DIVULGE_ROUTE_METHOD_ANY;
+static divulge_route_method_t convert_request_method_to_method_type(const char* method_name, size_t length) {
+    divulge_route_method_t method;
+    switch (length) {
+        case 3:
+            method = (method_name[0] == 'G') ? DIVULGE_ROUTE_METHOD_GET : DIVULGE_ROUTE_METHOD_PUT;
+            break;
+        case 4:
+            method = (method_name[0] == 'P') ? DIVULGE_ROUTE_METHOD_POST : DIVULGE_ROUTE_METHOD_HEAD;
+            break;
+        case 5:
+            method = DIVULGE_ROUTE_METHOD_PATCH;
+            break;
+        case 6:
+            method = DIVULGE_ROUTE_METHOD_DELETE;
+            break;
+        case 7:
+            method = DIVULGE_ROUTE_METHOD_OPTIONS;
+            break;
+        default:
+            return DIVULGE_ROUTE_METHOD_ANY;
     }
+    return (memcmp(method_name, method_names[method], length) == 0) ? method : DIVULGE_ROUTE_METHOD_ANY;
 }
 
 static const char* convert_return_code_to_text(int return_code) {
-    if (return_code == 200) {
+    if (return_code == 101) {
+        return "Switching Protocols";
+    } else if (return_code == 200) {
         return "OK";
+    } else if (return_code == 206) {
+        return "Partial Content";
     } else if (return_code == 301) {
         return "Moved Permanently";
+    } else if (return_code == 304) {
+        return "Not Modified";
+    } else if (return_code == 400) {
+        return "Bad Request";
+    } else if (return_code == 401) {
+        return "Unauthorized";
     } else if (return_code == 404) {
         return "Not found";
+    } else if (return_code == 413) {
+        return "Payload Too Large";
+    } else if (return_code == 415) {
+        return "Unsupported Media Type";
+    } else if (return_code == 416) {
+        return "Range Not Satisfiable";
+    } else if (return_code == 426) {
+        return "Upgrade Required";
+    } else if (return_code == 431) {
+        return "Request Header Fields Too Large";
     } else if (return_code == 500) {
         return "Internal server error";
+    } else if (return_code == 503) {
+        return "Service Unavailable";
     } else {
         return "Other";
     }
@@ -99,6 +242,45 @@ static bool respond_with_404(divulge_request_t* request, void* context) {
     return true;
 }
 
+static size_t get_static_route_count(void) {
+    if (!__start_divulge_routes || !__stop_divulge_routes) {
+        return 0;
+    }
+    return (size_t)(__stop_divulge_routes - __start_divulge_routes);
+}
+
+static size_t extract_parameter_names(const char* pattern, static_string_t* names);
+
+static bool insert_static_routes(divulge_t* divulge) {
+    size_t count = get_static_route_count();
+    if (count == 0) {
+        return true;
+    }
+    divulge->static_routes = calloc(count, sizeof(route_entry_t));
+    if (!divulge->static_routes) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        route_entry_t* entry = divulge->static_routes + i;
+        entry->static_route = __start_divulge_routes[i];
+        memcpy(&entry->uri, &entry->static_route->uri, sizeof(entry->uri));
+        entry->parameter_count = extract_parameter_names(entry->uri.uri, entry->parameter_names);
+        if (!divulge_route_tree_insert(divulge->routes, entry->uri.uri, entry->uri.method, entry)) {
+            W(TAG, "Could not index [%s] '%s'", divulge_method_name_from_method(entry->uri.method), entry->uri.uri);
+        } else if (divulge->metrics) {
+            entry->metrics = divulge_metrics_add_route(divulge->metrics, entry->uri.uri, entry->uri.method);
+        }
+    }
+    return true;
+}
+
+static void release_divulge(divulge_t* divulge) {
+    divulge_route_tree_destroy(divulge->routes);
+    divulge_metrics_destroy(divulge->metrics);
+    free(divulge->static_routes);
+    free(divulge);
+}
+
 divulge_t* divulge_initialize(divulge_configuration_t* configuration) {
     if (!configuration || !configuration->send || !configuration->close) {
         return NULL;
@@ -109,19 +291,78 @@ divulge_t* divulge_initialize(divulge_configuration_t* configuration) {
     }
     memcpy(&divulge->configuration, configuration,
            sizeof(divulge_configuration_t));
-    divulge->routes = dynamic_list_create();
+    if (!divulge->configuration.keep_alive_max_requests) {
+        divulge->configuration.keep_alive_max_requests = DIVULGE_KEEP_ALIVE_DEFAULT_MAX_REQUESTS;
+    }
+    if (!divulge->configuration.keep_alive_timeout_ms) {
+        divulge->configuration.keep_alive_timeout_ms = DIVULGE_KEEP_ALIVE_DEFAULT_TIMEOUT_MS;
+    }
+    divulge->routes = divulge_route_tree_create();
+    if (divulge->configuration.metrics_uri) {
+        divulge->metrics = divulge_metrics_create();
+    }
+    if (!divulge->routes || (divulge->configuration.metrics_uri && !divulge->metrics) ||
+        !insert_static_routes(divulge)) {
+        release_divulge(divulge);
+        return NULL;
+    }
     divulge->default_404_handler = respond_with_404;
+    if (divulge->metrics) {
+        divulge_uri_t metrics_uri = {
+            .uri = divulge->configuration.metrics_uri,
+            .method = DIVULGE_ROUTE_METHOD_GET,
+            .handler = {.handler = divulge_metrics_respond, .context = divulge->metrics},
+        };
+        divulge_register_uri(divulge, &metrics_uri);
+    }
     return divulge;
 }
 
+static size_t extract_parameter_names(const char* pattern, static_string_t* names) {
+    size_t count = 0;
+    const char* position = pattern;
+    while (*position && (count < DIVULGE_ROUTE_PARAMETERS_MAX_COUNT)) {
+        static_string_t* name = names + count;
+        if (*position == '{') {
+            const char* close = strchr(position, '}');
+            if (!close) {
+                break;
+            }
+            name->text = (char*)(position + 1);
+            name->length = (size_t)(close - position - 1);
+            if (name->length && (name->text[name->length - 1] == '*')) {
+                name->length--;
+            }
+            count++;
+            position = close;
+        } else if ((*position == '*') && !*(position + 1)) {
+            name->text = (char*)position;
+            name->length = 1;
+            count++;
+        }
+        position++;
+    }
+    return count;
+}
+
 void divulge_register_uri(divulge_t* divulge, divulge_uri_t* uri) {
     if (!divulge || !uri || !uri->handler.handler || !uri->uri) {
         return;
     }
     route_entry_t* entry = calloc(1, sizeof(route_entry_t));
+    if (!entry) {
+        return;
+    }
     entry->middlewares = dynamic_list_create();
     memcpy(&entry->uri, uri, sizeof(*uri));
-    dynamic_list_append(divulge->routes, entry);
+    entry->parameter_count = extract_parameter_names(entry->uri.uri, entry->parameter_names);
+    if (!divulge_route_tree_insert(divulge->routes, entry->uri.uri, entry->uri.method, entry)) {
+        W(TAG, "Could not register [%s] '%s'", divulge_method_name_from_method(uri->method), uri->uri);
+        dynamic_list_destroy(entry->middlewares);
+        free(entry);
+    } else if (divulge->metrics) {
+        entry->metrics = divulge_metrics_add_route(divulge->metrics, entry->uri.uri, entry->uri.method);
+    }
 }
 
 void divulge_add_middleware_to_uri(divulge_t* divulge,
@@ -130,17 +371,16 @@ void divulge_add_middleware_to_uri(divulge_t* divulge,
     if (!divulge || !uri || !middleware) {
         return;
     }
-    for (dynamic_list_iterator_t* it = dynamic_list_begin(divulge->routes); it;
-         it = dynamic_list_next(it)) {
-        route_entry_t* entry = dynamic_list_get(it);
-        if ((entry->uri.method == uri->method) &&
-            (strcmp(entry->uri.uri, uri->uri) == 0)) {
-            divulge_handler_object_t* object =
-                calloc(1, sizeof(divulge_handler_object_t));
-            memcpy(object, middleware, sizeof(*object));
-            dynamic_list_append(entry->middlewares, object);
-        }
+    route_entry_t* entry = divulge_route_tree_find(divulge->routes, uri->uri, uri->method);
+    if (!entry || entry->static_route) {
+        return;
     }
+    divulge_handler_object_t* object = calloc(1, sizeof(divulge_handler_object_t));
+    if (!object) {
+        return;
+    }
+    memcpy(object, middleware, sizeof(*object));
+    dynamic_list_append(entry->middlewares, object);
 }
 
 void divulge_set_default_404_handler(divulge_t* divulge,
@@ -153,93 +393,736 @@ void divulge_set_default_404_handler(divulge_t* divulge,
     divulge->default_404_handler = handler;
 }
 
-static bool are_urls_equal(const char* request_url, const char* route_url) {
-    return ((strcmp(request_url, route_url) == 0) &&
-            (strlen(request_url) == strlen(route_url)));
+static void send_response_data(divulge_request_context_t* context, const char* data, size_t data_size) {
+    if (context->http2_stream) {
+        divulge_http2_stream_write(context->http2_stream, data, data_size);
+    } else {
+        context->divulge->configuration.send(context->connection_context, data, data_size);
+    }
+    context->sent_size += data_size;
 }
 
-static char* extract_query_from_request_url(char* request_url) {
-    char* query_separator = strchr(request_url, '?');
-    if (query_separator) {
-        *query_separator = '\0';
-        query_separator++;
+static void send_response_vectors(divulge_request_context_t* context,
+                                  const divulge_io_vector_t* vectors,
+                                  size_t vector_count) {
+    if (!context->http2_stream) {
+        context->divulge->configuration.sendv(context->connection_context, vectors, vector_count);
+    }
+    for (size_t i = 0; i < vector_count; i++) {
+        if (context->http2_stream) {
+            divulge_http2_stream_write(context->http2_stream, vectors[i].data, vectors[i].size);
+        }
+        context->sent_size += vectors[i].size;
     }
-    return query_separator;
 }
 
-void divulge_process_request(divulge_t* divulge,
-                             void* connection_context,
-                             char* request_buffer,
-                             size_t request_buffer_size,
-                             char* response_buffer,
-                             size_t response_buffer_size) {
-    if (!divulge || !request_buffer || (request_buffer_size == 0) ||
-        !response_buffer || (response_buffer_size == 0)) {
-        return;
+static void flush_response(divulge_request_context_t* context) {
+    if (context->response_size > 0) {
+        send_response_data(context, context->response_buffer, context->response_size);
+        context->response_size = 0;
     }
-    divulge_request_t request = {
-        .header = NULL,
-        .payload = NULL,
+}
+
+static void append_response(divulge_request_context_t* context, const char* data, size_t data_size) {
+    if (data_size > (context->response_buffer_size - context->response_size)) {
+        flush_response(context);
+        if (data_size > context->response_buffer_size) {
+            send_response_data(context, data, data_size);
+            return;
+        }
+    }
+    memcpy(context->response_buffer + context->response_size, data, data_size);
+    context->response_size += data_size;
+}
+
+static void append_response_text(divulge_request_context_t* context, const char* text) {
+    append_response(context, text, strlen(text));
+}
+
+static bool are_names_equal(const char* name, size_t name_length, const char* reference) {
+    if (strlen(reference) != name_length) {
+        return false;
+    }
+    for (size_t i = 0; i < name_length; i++) {
+        if (tolower((unsigned char)name[i]) != tolower((unsigned char)reference[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t hash_header_name(const char* name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)tolower((unsigned char)name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void fill_request_headers(divulge_request_t* request,
+                                 const divulge_request_parser_t* parser,
+                                 char* request_buffer) {
+    request->header_count = 0;
+    for (size_t i = 0; (i < parser->header_count) && (i < DIVULGE_REQUEST_HEADERS_MAX_COUNT); i++) {
+        const divulge_request_parser_header_t* parsed = parser->headers + i;
+        divulge_request_header_t* header = request->headers + request->header_count++;
+        header->name.text = request_buffer + parsed->name.offset;
+        header->name.length = parsed->name.length;
+        header->value.text = request_buffer + parsed->value.offset;
+        header->value.length = parsed->value.length;
+        header->name_hash = hash_header_name(header->name.text, header->name.length);
+    }
+    for (size_t i = 0; i < request->header_count; i++) {
+        request->headers[i].value.text[request->headers[i].value.length] = '\0';
+    }
+}
+
+static void fill_request_from_parser(divulge_request_t* request,
+                                     const divulge_request_parser_t* parser,
+                                     char* request_buffer) {
+    request->method =
+        convert_request_method_to_method_type(request_buffer + parser->method.offset, parser->method.length);
+    request_buffer[parser->path.offset + parser->path.length] = '\0';
+    request->route = request_buffer + parser->path.offset;
+    if (parser->has_query) {
+        request_buffer[parser->query.offset + parser->query.length] = '\0';
+        request->url_query = request_buffer + parser->query.offset;
+    } else {
+        request->url_query = NULL;
+    }
+    request->header = request_buffer + (parser->header_count ? parser->headers[0].name.offset : parser->head_size);
+    fill_request_headers(request, parser, request_buffer);
+    request->payload = request_buffer + parser->head_size;
+    request->payload_size = 0;
+}
+
+static bool match_route(divulge_t* divulge, divulge_request_t* request, matched_route_t* route) {
+    divulge_route_tree_match_t match;
+    if (!divulge_route_tree_match(divulge->routes, request->route, strlen(request->route), request->method, &match)) {
+        return false;
+    }
+    route_entry_t* entry = match.value;
+    *route = (matched_route_t){
+        .uri = &entry->uri,
+        .entry = entry,
+        .static_route = entry->static_route,
+        .metrics = entry->metrics,
     };
+    for (size_t i = 0; i < match.capture_count; i++) {
+        request->parameters[i].name = entry->parameter_names[i];
+        request->parameters[i].value = match.captures[i];
+    }
+    request->parameter_count = match.capture_count;
+    return true;
+}
+
+static bool execute_middlewares(const matched_route_t* route, divulge_request_t* request) {
+    if (route->static_route) {
+        for (size_t i = 0; i < route->static_route->middleware_count; i++) {
+            const divulge_handler_object_t* object = route->static_route->middlewares + i;
+            if (!object->handler(request, object->context)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (dynamic_list_iterator_t* it = dynamic_list_begin(route->entry->middlewares); it; it = dynamic_list_next(it)) {
+        divulge_handler_object_t* object = dynamic_list_get(it);
+        if (!object->handler(request, object->context)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void respond_with_status(divulge_request_t* request, int return_code) {
+    divulge_response_t response = {
+        .return_code = return_code,
+        .payload = "",
+        .payload_size = 0,
+    };
+    divulge_respond(request, &response);
+}
+
+static size_t receive_more(divulge_request_context_t* context) {
+    request_input_t* input = context->input;
+    if (!input->can_receive || (input->received_size >= input->capacity)) {
+        return 0;
+    }
+    size_t size = context->divulge->configuration.receive(
+        context->connection_context, input->buffer + input->received_size, input->capacity - input->received_size);
+    input->received_size += size;
+    input->buffer[input->received_size] = '\0';
+    return size;
+}
+
+static body_status_t convert_reader_status(divulge_body_reader_status_t status) {
+    return (status == DIVULGE_BODY_READER_STATUS_COMPLETE) ? BODY_STATUS_COMPLETE : BODY_STATUS_MALFORMED;
+}
+
+static body_status_t read_buffered_body(divulge_request_t* request) {
+    divulge_request_context_t* context = request->context;
+    request_input_t* input = context->input;
+    size_t body_start = input->request_size;
+    size_t body_size = 0;
+    size_t position = body_start;
+    while (true) {
+        size_t consumed_size = 0;
+        size_t output_size = 0;
+        divulge_body_reader_status_t status =
+            divulge_body_reader_execute(&context->body_reader, input->buffer + position,
+                                        input->received_size - position, input->buffer + body_start + body_size,
+                                        &consumed_size, &output_size);
+        position += consumed_size;
+        body_size += output_size;
+        if (status != DIVULGE_BODY_READER_STATUS_INCOMPLETE) {
+            request->payload = input->buffer + body_start;
+            request->payload_size = body_size;
+            input->request_size = position;
+            return convert_reader_status(status);
+        }
+        size_t framing_size = position - (body_start + body_size);
+        if (framing_size > 0) {
+            input->received_size -= framing_size;
+            position -= framing_size;
+            input->buffer[input->received_size] = '\0';
+        }
+        if (input->received_size >= input->capacity) {
+            return BODY_STATUS_TOO_LARGE;
+        }
+        if (receive_more(context) == 0) {
+            return BODY_STATUS_INTERRUPTED;
+        }
+    }
+}
+
+static body_status_t stream_body(divulge_request_t* request, divulge_body_handler_t body_handler, void* body_context) {
+    divulge_request_context_t* context = request->context;
+    request_input_t* input = context->input;
+    size_t body_start = input->request_size;
+    size_t position = body_start;
+    while (true) {
+        size_t consumed_size = 0;
+        size_t output_size = 0;
+        divulge_body_reader_status_t status = divulge_body_reader_execute(
+            &context->body_reader, input->buffer + position, input->received_size - position, input->buffer + position,
+            &consumed_size, &output_size);
+        if ((output_size > 0) && !body_handler(request, input->buffer + position, output_size, body_context)) {
+            return BODY_STATUS_REJECTED;
+        }
+        position += consumed_size;
+        if (status != DIVULGE_BODY_READER_STATUS_INCOMPLETE) {
+            input->request_size = position;
+            return convert_reader_status(status);
+        }
+        input->received_size = body_start;
+        position = body_start;
+        if (input->received_size >= input->capacity) {
+            return BODY_STATUS_TOO_LARGE;
+        }
+        if (receive_more(context) == 0) {
+            return BODY_STATUS_INTERRUPTED;
+        }
+    }
+}
+
+static void respond_to_body_status(divulge_request_t* request, body_status_t status) {
+    if (status == BODY_STATUS_COMPLETE) {
+        return;
+    }
+    request->context->keep_alive = false;
+    if (!request->context->was_status_sent) {
+        respond_with_status(request, (status == BODY_STATUS_TOO_LARGE) ? 413 : 400);
+    }
+}
+
+static void dispatch_request(divulge_t* divulge, divulge_request_t* request) {
+    bool was_route_handled = false;
+    matched_route_t route = {.uri = NULL};
+    bool is_matched = match_route(divulge, request, &route);
+    if (is_matched) {
+        request->context->route_metrics = route.metrics;
+    }
+    if (!is_matched || execute_middlewares(&route, request)) {
+        body_status_t status = (is_matched && route.uri->body_handler)
+                                   ? stream_body(request, route.uri->body_handler, route.uri->handler.context)
+                                   : read_buffered_body(request);
+        if (status != BODY_STATUS_COMPLETE) {
+            respond_to_body_status(request, status);
+        } else if (is_matched) {
+            route.uri->handler.handler(request, route.uri->handler.context);
+            was_route_handled = true;
+        }
+    }
+    if (!request->context->was_status_sent && !was_route_handled) {
+        divulge->default_404_handler(request, divulge->default_404_handler_context);
+    }
+    if (!divulge_body_reader_is_complete(&request->context->body_reader)) {
+        request->context->keep_alive = false;
+    }
+}
+
+static const divulge_request_span_t* find_parsed_header(const divulge_request_parser_t* parser,
+                                                        const char* request_buffer,
+                                                        const char* name) {
+    for (size_t i = 0; i < parser->header_count; i++) {
+        const divulge_request_parser_header_t* header = parser->headers + i;
+        if (are_names_equal(request_buffer + header->name.offset, header->name.length, name)) {
+            return &header->value;
+        }
+    }
+    return NULL;
+}
+
+static bool has_header_token(const divulge_request_parser_t* parser, const char* request_buffer, const char* name,
+                             const char* token) {
+    const divulge_request_span_t* value = find_parsed_header(parser, request_buffer, name);
+    if (!value) {
+        return false;
+    }
+    const char* position = request_buffer + value->offset;
+    const char* end = position + value->length;
+    while (position < end) {
+        while ((position < end) && ((*position == ' ') || (*position == ','))) {
+            position++;
+        }
+        const char* token_end = position;
+        while ((token_end < end) && (*token_end != ',')) {
+            token_end++;
+        }
+        size_t token_length = (size_t)(token_end - position);
+        while ((token_length > 0) && (position[token_length - 1] == ' ')) {
+            token_length--;
+        }
+        if (are_names_equal(position, token_length, token)) {
+            return true;
+        }
+        position = token_end;
+    }
+    return false;
+}
+
+static bool is_legacy_version(const divulge_request_parser_t* parser, const char* request_buffer) {
+    return request_buffer[parser->version.offset + parser->version.length - 1] == '0';
+}
+
+static bool is_keep_alive_requested(const divulge_request_parser_t* parser, const char* request_buffer) {
+    if (is_legacy_version(parser, request_buffer)) {
+        return has_header_token(parser, request_buffer, "Connection", "keep-alive");
+    }
+    return !has_header_token(parser, request_buffer, "Connection", "close");
+}
+
+static bool parse_content_length(const divulge_request_parser_t* parser,
+                                 const char* request_buffer,
+                                 size_t* content_length) {
+    *content_length = 0;
+    const divulge_request_span_t* value = find_parsed_header(parser, request_buffer, "Content-Length");
+    if (!value) {
+        return true;
+    }
+    if (value->length == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < value->length; i++) {
+        char digit = request_buffer[value->offset + i];
+        if ((digit < '0') || (digit > '9') || (*content_length > ((SIZE_MAX - 9) / 10))) {
+            return false;
+        }
+        *content_length = (*content_length * 10) + (size_t)(digit - '0');
+    }
+    return true;
+}
+
+static bool is_chunked_transfer_encoding(const divulge_request_span_t* value, const char* request_buffer) {
+    const char* text = request_buffer + value->offset;
+    size_t start = value->length;
+    while ((start > 0) && (text[start - 1] != ',')) {
+        start--;
+    }
+    while ((start < value->length) && ((text[start] == ' ') || (text[start] == '\t'))) {
+        start++;
+    }
+    return are_names_equal(text + start, value->length - start, "chunked");
+}
+
+static bool reset_body_reader(divulge_request_context_t* context,
+                              const divulge_request_parser_t* parser,
+                              const char* request_buffer) {
+    const divulge_request_span_t* transfer_encoding = find_parsed_header(parser, request_buffer, "Transfer-Encoding");
+    if (transfer_encoding) {
+        if (!is_chunked_transfer_encoding(transfer_encoding, request_buffer)) {
+            return false;
+        }
+        if (find_parsed_header(parser, request_buffer, "Content-Length")) {
+            context->keep_alive = false;
+        }
+        divulge_body_reader_reset(&context->body_reader, true, 0);
+        return true;
+    }
+    size_t content_length = 0;
+    if (!parse_content_length(parser, request_buffer, &content_length)) {
+        return false;
+    }
+    divulge_body_reader_reset(&context->body_reader, false, content_length);
+    return true;
+}
+
+static uint64_t get_time_us(divulge_t* divulge) {
+    return divulge->configuration.get_time_us ? divulge->configuration.get_time_us() : 0;
+}
+
+static void finish_response(divulge_request_t* request) {
+    divulge_request_context_t* context = request->context;
+    if (context->was_chunked_response_started) {
+        divulge_end_chunked_response(request);
+    }
+    flush_response(context);
+    divulge_t* divulge = context->divulge;
+    if (divulge->metrics && !context->is_upgraded) {
+        divulge_route_metrics_t* route_metrics =
+            context->route_metrics ? context->route_metrics : divulge_metrics_get_unmatched_route(divulge->metrics);
+        divulge_metrics_record(route_metrics, context->return_code, context->sent_size,
+                               get_time_us(divulge) - context->start_time_us);
+    }
+}
+
+static connection_state_t handle_parsed_request(divulge_t* divulge,
+                                                void* connection_context,
+                                                divulge_request_parser_status_t status,
+                                                const divulge_request_parser_t* parser,
+                                                request_input_t* input,
+                                                divulge_arena_t* arena,
+                                                char* response_buffer,
+                                                size_t response_buffer_size,
+                                                bool keep_alive,
+                                                divulge_http2_stream_t* http2_stream) {
+    char* request_buffer = input->buffer;
     divulge_request_context_t request_context = {
         .divulge = divulge,
         .connection_context = connection_context,
+        .input = input,
+        .arena = arena,
+        .http2_stream = http2_stream,
         .response_buffer = response_buffer,
         .response_buffer_size = response_buffer_size,
+        .start_time_us = divulge->metrics ? get_time_us(divulge) : 0,
         .was_status_sent = false,
         .was_header_sent = false,
+        .keep_alive = keep_alive,
+        .is_legacy_version =
+            (status == DIVULGE_REQUEST_PARSER_STATUS_COMPLETE) && is_legacy_version(parser, request_buffer),
     };
-    request.header = strstr(request_buffer, "\r\n") + 2;
-    request.payload = strstr(request_buffer, "\r\n\r\n") + 4;
-    char* method_name = strtok(request_buffer, " ");
-    request.route = strtok(NULL, " ");
-    request.url_query = extract_query_from_request_url((char*)request.route);
-    request.method = convert_request_method_to_method_type(method_name);
-    request.context = &request_context;
-    D("Received request: [%s] %s", method_name, request.route);
-    divulge_route_method_t method =
-        convert_request_method_to_method_type(method_name);
-    bool was_route_handled = false;
-    for (dynamic_list_iterator_t* it = dynamic_list_begin(divulge->routes); it;
-         it = dynamic_list_next(it)) {
-        route_entry_t* entry = dynamic_list_get(it);
-        if ((entry->uri.method == request.method) &&
-            are_urls_equal(request.route, entry->uri.uri)) {
-            bool can_execute_handler = true;
-            for (dynamic_list_iterator_t* jt =
-                     dynamic_list_begin(entry->middlewares);
-                 jt; jt = dynamic_list_next(jt)) {
-                divulge_handler_object_t* object = dynamic_list_get(jt);
-                can_execute_handler =
-                    object->handler(&request, object->context);
-                if (!can_execute_handler) {
-                    break;
-                }
-            }
-            if (can_execute_handler) {
-                entry->uri.handler.handler(&request,
-                                           entry->uri.handler.context);
-                was_route_handled = true;
+    divulge_request_t request = {
+        .context = &request_context,
+        .method = DIVULGE_ROUTE_METHOD_ANY,
+        .route = "",
+        .header = "",
+        .payload = "",
+    };
+    if ((status == DIVULGE_REQUEST_PARSER_STATUS_COMPLETE) &&
+        reset_body_reader(&request_context, parser, request_buffer)) {
+        input->request_size = parser->head_size;
+        fill_request_from_parser(&request, parser, request_buffer);
+        request_context.is_body_suppressed = (request.method == DIVULGE_ROUTE_METHOD_HEAD);
+        D(TAG, "Received request: [%.*s] %s", (int)parser->method.length, request_buffer + parser->method.offset,
+          request.route);
+        dispatch_request(divulge, &request);
+    } else {
+        request_context.keep_alive = false;
+        bool is_head_too_large = (status == DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE) ||
+                                 (status == DIVULGE_REQUEST_PARSER_STATUS_TOO_MANY_HEADERS);
+        respond_with_status(&request, is_head_too_large ? 431 : 400);
+    }
+    if (request_context.is_deferred) {
+        return CONNECTION_STATE_DEFERRED;
+    }
+    finish_response(&request);
+    divulge_arena_reset(arena);
+    return request_context.keep_alive ? CONNECTION_STATE_KEEP_ALIVE : CONNECTION_STATE_CLOSE;
+}
+
+static void create_request_arena(divulge_t* divulge, divulge_arena_t* arena) {
+    size_t size = divulge->configuration.request_arena_size;
+    void* buffer = (size > 0) ? malloc(size) : NULL;
+    if ((size > 0) && !buffer) {
+        E(TAG, "Failed to allocate request arena of %zu bytes", size);
+    }
+    divulge_arena_initialize(arena, buffer, size);
+}
+
+static void destroy_request_arena(divulge_arena_t* arena) {
+    free(arena->buffer);
+    divulge_arena_initialize(arena, NULL, 0);
+}
+
+void divulge_process_request(divulge_t* divulge,
+                             void* connection_context,
+                             char* request_buffer,
+                             size_t request_buffer_size,
+                             char* response_buffer,
+                             size_t response_buffer_size) {
+    if (!divulge || !request_buffer || (request_buffer_size == 0) || !response_buffer ||
+        (response_buffer_size == 0)) {
+        return;
+    }
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    divulge_request_parser_status_t status =
+        divulge_request_parser_execute(&parser, request_buffer, request_buffer_size);
+    if (status == DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE) {
+        status = DIVULGE_REQUEST_PARSER_STATUS_ERROR;
+    }
+    request_input_t input = {
+        .buffer = request_buffer,
+        .capacity = request_buffer_size,
+        .received_size = request_buffer_size,
+        .request_size = request_buffer_size,
+        .can_receive = false,
+    };
+    divulge_arena_t arena;
+    create_request_arena(divulge, &arena);
+    connection_state_t state = handle_parsed_request(divulge, connection_context, status, &parser, &input, &arena,
+                                                     response_buffer, response_buffer_size, false, NULL);
+    destroy_request_arena(&arena);
+    if (state != CONNECTION_STATE_DEFERRED) {
+        divulge->configuration.close(connection_context);
+    }
+}
+
+static bool receive_request_head(divulge_t* divulge,
+                                 void* connection_context,
+                                 divulge_request_parser_t* parser,
+                                 divulge_request_parser_status_t* status,
+                                 char* request_buffer,
+                                 size_t request_buffer_capacity,
+                                 size_t* received_size) {
+    *status = divulge_request_parser_execute(parser, request_buffer, *received_size);
+    while ((*status == DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE) && (*received_size < request_buffer_capacity)) {
+        size_t size = divulge->configuration.receive(connection_context, request_buffer + *received_size,
+                                                     request_buffer_capacity - *received_size);
+        if (size == 0) {
+            return false;
+        }
+        *received_size += size;
+        request_buffer[*received_size] = '\0';
+        *status = divulge_request_parser_execute(parser, request_buffer, *received_size);
+    }
+    return true;
+}
+
+static void dispatch_http2_request(void* context,
+                                   divulge_http2_stream_t* stream,
+                                   char* request,
+                                   size_t request_size,
+                                   size_t request_capacity) {
+    http2_session_t* session = context;
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    divulge_request_parser_status_t status = divulge_request_parser_execute(&parser, request, request_size);
+    if (status == DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE) {
+        status = DIVULGE_REQUEST_PARSER_STATUS_ERROR;
+    }
+    request_input_t input = {
+        .buffer = request,
+        .capacity = request_capacity,
+        .received_size = request_size,
+        .request_size = request_size,
+        .can_receive = false,
+    };
+    handle_parsed_request(session->divulge, session->connection_context, status, &parser, &input, session->arena,
+                          session->response_buffer, session->response_buffer_size, true, stream);
+}
+
+static const divulge_request_span_t* find_http2_upgrade_settings(const divulge_request_parser_t* parser,
+                                                                 divulge_request_parser_status_t status,
+                                                                 const char* request_buffer) {
+    if ((status != DIVULGE_REQUEST_PARSER_STATUS_COMPLETE) ||
+        !has_header_token(parser, request_buffer, "Upgrade", "h2c") ||
+        !has_header_token(parser, request_buffer, "Connection", "HTTP2-Settings") ||
+        find_parsed_header(parser, request_buffer, "Content-Length") ||
+        find_parsed_header(parser, request_buffer, "Transfer-Encoding")) {
+        return NULL;
+    }
+    return find_parsed_header(parser, request_buffer, "HTTP2-Settings");
+}
+
+static bool serve_http2(http2_session_t* session,
+                        const divulge_request_parser_t* parser,
+                        divulge_request_parser_status_t status,
+                        const char* request_buffer,
+                        size_t request_buffer_capacity,
+                        size_t received_size) {
+    divulge_t* divulge = session->divulge;
+    bool is_preface = divulge_http2_is_preface(request_buffer, received_size);
+    const divulge_request_span_t* settings =
+        is_preface ? NULL : find_http2_upgrade_settings(parser, status, request_buffer);
+    if (!is_preface && !settings) {
+        return false;
+    }
+    divulge_http2_configuration_t configuration = {
+        .send = divulge->configuration.send,
+        .sendv = divulge->configuration.sendv,
+        .receive = divulge->configuration.receive,
+        .connection_context = session->connection_context,
+        .max_concurrent_streams = divulge->configuration.http2_max_concurrent_streams,
+        .stream_buffer_size = request_buffer_capacity,
+        .dispatch = dispatch_http2_request,
+        .dispatch_context = session,
+    };
+    divulge_http2_connection_t* connection = divulge_http2_create(&configuration);
+    size_t request_size = is_preface ? 0 : parser->head_size;
+    if (!connection || (settings && !divulge_http2_upgrade(connection, request_buffer + settings->offset,
+                                                           settings->length, request_buffer, request_size))) {
+        divulge_http2_destroy(connection);
+        return false;
+    }
+    if (settings) {
+        divulge->configuration.send(session->connection_context, DIVULGE_HTTP2_UPGRADE_RESPONSE,
+                                    strlen(DIVULGE_HTTP2_UPGRADE_RESPONSE));
+    }
+    if (divulge->configuration.set_receive_timeout) {
+        divulge->configuration.set_receive_timeout(session->connection_context,
+                                                   divulge->configuration.keep_alive_timeout_ms);
+    }
+    divulge_http2_serve(connection, request_buffer + request_size, received_size - request_size);
+    divulge_http2_destroy(connection);
+    return true;
+}
+
+void divulge_serve_connection(divulge_t* divulge,
+                              void* connection_context,
+                              char* request_buffer,
+                              size_t request_buffer_size,
+                              char* response_buffer,
+                              size_t response_buffer_size) {
+    if (!divulge || !divulge->configuration.receive || !request_buffer || (request_buffer_size < 2) ||
+        !response_buffer || (response_buffer_size == 0)) {
+        return;
+    }
+    size_t request_buffer_capacity = request_buffer_size - 1;
+    size_t received_size = 0;
+    request_buffer[0] = '\0';
+    divulge_arena_t arena;
+    create_request_arena(divulge, &arena);
+    for (size_t request_count = 1;; request_count++) {
+        divulge_request_parser_t parser;
+        divulge_request_parser_reset(&parser);
+        divulge_request_parser_status_t status;
+        if (!receive_request_head(divulge, connection_context, &parser, &status, request_buffer,
+                                  request_buffer_capacity, &received_size)) {
+            break;
+        }
+        if ((request_count == 1) && divulge->configuration.http2_max_concurrent_streams) {
+            http2_session_t session = {
+                .divulge = divulge,
+                .connection_context = connection_context,
+                .arena = &arena,
+                .response_buffer = response_buffer,
+                .response_buffer_size = response_buffer_size,
+            };
+            if (serve_http2(&session, &parser, status, request_buffer, request_buffer_capacity, received_size)) {
+                break;
             }
         }
+        bool keep_alive = (status == DIVULGE_REQUEST_PARSER_STATUS_COMPLETE) &&
+                          (request_count < divulge->configuration.keep_alive_max_requests) &&
+                          is_keep_alive_requested(&parser, request_buffer);
+        request_input_t input = {
+            .buffer = request_buffer,
+            .capacity = request_buffer_capacity,
+            .received_size = received_size,
+            .request_size = received_size,
+            .can_receive = true,
+        };
+        connection_state_t state = handle_parsed_request(divulge, connection_context, status, &parser, &input, &arena,
+                                                         response_buffer, response_buffer_size, keep_alive, NULL);
+        if (state == CONNECTION_STATE_DEFERRED) {
+            destroy_request_arena(&arena);
+            return;
+        } else if (state == CONNECTION_STATE_CLOSE) {
+            break;
+        }
+        received_size = input.received_size - input.request_size;
+        memmove(request_buffer, request_buffer + input.request_size, received_size);
+        request_buffer[received_size] = '\0';
+        if ((request_count == 1) && divulge->configuration.set_receive_timeout) {
+            divulge->configuration.set_receive_timeout(connection_context,
+                                                       divulge->configuration.keep_alive_timeout_ms);
+        }
     }
-    if (!request.context->was_status_sent && !was_route_handled) {
-        divulge->default_404_handler(&request,
-                                     divulge->default_404_handler_context);
+    destroy_request_arena(&arena);
+    divulge->configuration.close(connection_context);
+}
+
+void* divulge_allocate(divulge_request_t* request, size_t size) {
+    if (!request || (size == 0)) {
+        return NULL;
     }
-    if (divulge->configuration.close) {
-        divulge->configuration.close(connection_context);
+    return divulge_arena_allocate(request->context->arena, size);
+}
+
+uint64_t divulge_get_time_us(divulge_request_t* request) {
+    if (!request) {
+        return 0;
+    }
+    return get_time_us(request->context->divulge);
+}
+
+static_string_t divulge_get_route_parameter(divulge_request_t* request, const char* name) {
+    static_string_t value = {.text = NULL, .length = 0};
+    if (!request || !name) {
+        return value;
+    }
+    size_t name_length = strlen(name);
+    for (size_t i = 0; i < request->parameter_count; i++) {
+        const static_string_t* parameter_name = &request->parameters[i].name;
+        if ((parameter_name->length == name_length) && (memcmp(parameter_name->text, name, name_length) == 0)) {
+            return request->parameters[i].value;
+        }
     }
+    return value;
 }
+
+static const divulge_request_header_t* find_request_header(const divulge_request_t* request, const char* name) {
+    size_t name_length = strlen(name);
+    uint32_t name_hash = hash_header_name(name, name_length);
+    for (size_t i = 0; i < request->header_count; i++) {
+        const divulge_request_header_t* header = request->headers + i;
+        if ((header->name_hash == name_hash) && are_names_equal(header->name.text, header->name.length, name)) {
+            return header;
+        }
+    }
+    return NULL;
+}
+
+static_string_t divulge_get_request_header(divulge_request_t* request, const char* name) {
+    static_string_t value = {.text = NULL, .length = 0};
+    if (!request || !name) {
+        return value;
+    }
+    const divulge_request_header_t* header = find_request_header(request, name);
+    return header ? header->value : value;
+}
+
 const char* divulge_find_request_header_key(divulge_request_t* request,
                                             const char* key) {
-    return strstr(request->header, key);
+    if (!request || !key) {
+        return NULL;
+    }
+    const divulge_request_header_t* header = find_request_header(request, key);
+    return header ? header->name.text : NULL;
 }
 
 const char* divulge_get_request_header_entry_value(const char* header_entry) {
-    char* value = strstr(header_entry, ": ") + 2;
-    char* end = strstr(value, "\r\n");
-    *end = '\0';
+    if (!header_entry) {
+        return NULL;
+    }
+    const char* value = strchr(header_entry, ':') + 1;
+    while ((*value == ' ') || (*value == '\t')) {
+        value++;
+    }
     return value;
 }
 
@@ -247,12 +1130,12 @@ bool divulge_send_status(divulge_request_t* request, int return_code) {
     if (!request || request->context->was_status_sent) {
         return false;
     }
-    size_t size =
-        (size_t)sprintf(request->context->response_buffer, "HTTP/1.1 %d %s\r\n",
-                        return_code, convert_return_code_to_text(return_code));
-    request->context->divulge->configuration.send(
-        request->context->connection_context, request->context->response_buffer,
-        size);
+    char status_line[32];
+    size_t size = (size_t)snprintf(status_line, sizeof(status_line), "HTTP/1.1 %d ", return_code);
+    request->context->return_code = return_code;
+    append_response(request->context, status_line, size);
+    append_response_text(request->context, convert_return_code_to_text(return_code));
+    append_response(request->context, "\r\n", 2);
     request->context->was_status_sent = true;
     return true;
 }
@@ -263,32 +1146,64 @@ static void send_header_entry(divulge_request_t* request,
     if (!request->context->was_status_sent) {
         return;
     }
-    size_t size = (size_t)sprintf(request->context->response_buffer,
-                                  "%s: %s\r\n", key, value);
-    request->context->divulge->configuration.send(
-        request->context->connection_context, request->context->response_buffer,
-        size);
+    append_response_text(request->context, key);
+    append_response(request->context, ": ", 2);
+    append_response_text(request->context, value);
+    append_response(request->context, "\r\n", 2);
 }
 
-bool divulge_send_header(divulge_request_t* request,
-                         divulge_response_t* response) {
-    if (!request || !response || request->context->was_header_sent) {
+static bool has_content_length(const divulge_response_t* response) {
+    for (size_t i = 0; response->header.entries && (i < response->header.count); i++) {
+        const char* key = response->header.entries[i].key;
+        if (are_names_equal(key, strlen(key), "Content-Length")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool send_response_header(divulge_request_t* request, divulge_response_t* response) {
+    if (request->context->was_header_sent) {
         return false;
     }
     if (!request->context->was_status_sent) {
         divulge_send_status(request, response->return_code);
     }
     send_header_entry(request, "Server", DIVULGE_SERVER_NAME);
+    if (request->context->is_upgraded && (response->return_code == 101)) {
+        send_header_entry(request, "Connection", "Upgrade");
+    } else if (!request->context->keep_alive) {
+        send_header_entry(request, "Connection", "close");
+    } else if (request->context->is_legacy_version) {
+        send_header_entry(request, "Connection", "keep-alive");
+    }
     if (response->header.entries && (response->header.count > 0)) {
         for (size_t i = 0; i < response->header.count; i++) {
             divulge_header_entry_t* entry = response->header.entries + i;
             send_header_entry(request, entry->key, entry->value);
         }
     }
+    if (request->context->is_chunked) {
+        send_header_entry(request, "Transfer-Encoding", "chunked");
+    } else if (!has_content_length(response) && !request->context->was_chunked_response_started &&
+               !request->context->is_upgraded &&
+               (response->return_code != 204) && (response->return_code != 304)) {
+        char content_length[24];
+        snprintf(content_length, sizeof(content_length), "%zu", response->payload_size);
+        send_header_entry(request, "Content-Length", content_length);
+    }
     request->context->was_header_sent = true;
     return true;
 }
 
+bool divulge_send_header(divulge_request_t* request,
+                         divulge_response_t* response) {
+    if (!request || !response) {
+        return false;
+    }
+    return send_response_header(request, response);
+}
+
 bool divulge_send_payload(divulge_request_t* request,
                           divulge_response_t* response) {
     if (!request || !response) {
@@ -297,14 +1212,45 @@ bool divulge_send_payload(divulge_request_t* request,
     if (!request->context->was_header_sent) {
         divulge_send_header(request, response);
     }
-    size_t response_size =
-        (size_t)snprintf(request->context->response_buffer,
-                         request->context->response_buffer_size - 1, "\r\n%*s",
-                         (int)response->payload_size, response->payload);
+    divulge_request_context_t* context = request->context;
+    append_response(context, "\r\n", 2);
+    size_t payload_size = (response->payload && !context->is_body_suppressed) ? response->payload_size : 0;
+    if (payload_size <= (context->response_buffer_size - context->response_size)) {
+        append_response(context, response->payload, payload_size);
+    } else if (context->divulge->configuration.sendv) {
+        divulge_io_vector_t vectors[] = {
+            {.data = context->response_buffer, .size = context->response_size},
+            {.data = response->payload, .size = payload_size},
+        };
+        send_response_vectors(context, vectors, 2);
+        context->response_size = 0;
+        return true;
+    } else {
+        flush_response(context);
+        send_response_data(context, response->payload, payload_size);
+    }
+    flush_response(context);
+    return true;
+}
 
-    request->context->divulge->configuration.send(
-        request->context->connection_context, request->context->response_buffer,
-        response_size);
+bool divulge_add_response_filter(divulge_request_t* request, divulge_response_filter_t filter, void* context) {
+    if (!request || !filter || request->context->was_status_sent ||
+        (request->context->response_filter_count >= DIVULGE_RESPONSE_FILTERS_MAX_COUNT)) {
+        return false;
+    }
+    response_filter_entry_t* entry = request->context->response_filters + request->context->response_filter_count++;
+    entry->filter = filter;
+    entry->context = context;
+    return true;
+}
+
+bool divulge_set_chunk_filter(divulge_request_t* request, const divulge_chunk_filter_t* filter, void* context) {
+    if (!request || !filter || !filter->begin || !filter->write || !filter->end || request->context->chunk_filter ||
+        request->context->was_status_sent) {
+        return false;
+    }
+    request->context->chunk_filter = filter;
+    request->context->chunk_filter_context = context;
     return true;
 }
 
@@ -312,6 +1258,13 @@ bool divulge_respond(divulge_request_t* request, divulge_response_t* response) {
     if (!request || !response) {
         return false;
     }
+    divulge_request_context_t* context = request->context;
+    while (context->response_filter_position < context->response_filter_count) {
+        response_filter_entry_t* entry = context->response_filters + context->response_filter_position++;
+        if (!entry->filter(request, response, entry->context)) {
+            return true;
+        }
+    }
     divulge_send_status(request, response->return_code);
     divulge_send_header(request, response);
     divulge_send_payload(request, response);
@@ -331,4 +1284,449 @@ bool divulge_redirect(divulge_request_t* request, const char* new_location) {
         .payload_size = 0};
     divulge_respond(request, &response);
     return true;
-}
\ No newline at end of file
+}
+
+static void send_file_contents(divulge_request_context_t* context,
+                               g2l_fs_file_t* file,
+                               size_t offset,
+                               size_t size) {
+    if (context->is_body_suppressed) {
+        flush_response(context);
+        return;
+    }
+    size_t sent_size = 0;
+    if (context->divulge->configuration.send_file && !context->http2_stream) {
+        flush_response(context);
+        sent_size = context->divulge->configuration.send_file(context->connection_context, file, offset, size);
+        context->sent_size += sent_size;
+    }
+    bool is_positioned = (sent_size == size) || g2l_fs_file_seek(file, G2L_FS_SEEK_SET, offset + sent_size);
+    while (is_positioned && (sent_size < size)) {
+        if (context->response_size == context->response_buffer_size) {
+            flush_response(context);
+        }
+        size_t read_size = context->response_buffer_size - context->response_size;
+        if (read_size > (size - sent_size)) {
+            read_size = size - sent_size;
+        }
+        read_size = g2l_fs_file_read(file, context->response_buffer + context->response_size, read_size);
+        if (read_size == 0) {
+            break;
+        }
+        context->response_size += read_size;
+        sent_size += read_size;
+    }
+    flush_response(context);
+    if (sent_size < size) {
+        W(TAG, "File transfer ended after %zu of %zu bytes", sent_size, size);
+        context->keep_alive = false;
+    }
+}
+
+static bool create_file_etag(const char* file_name, size_t file_size, char* etag, size_t etag_size) {
+    uint64_t modification_time = g2l_fs_file_modification_time(file_name);
+    if (modification_time == 0) {
+        return false;
+    }
+    snprintf(etag, etag_size, "\"%zx-%" PRIx64 "\"", file_size, modification_time);
+    return true;
+}
+
+static divulge_range_status_t parse_file_ranges(divulge_request_t* request,
+                                                const char* etag,
+                                                size_t file_size,
+                                                divulge_range_t* ranges,
+                                                size_t* range_count) {
+    static_string_t range = divulge_get_request_header(request, "Range");
+    if (!range.text || (request->method != DIVULGE_ROUTE_METHOD_GET)) {
+        return DIVULGE_RANGE_STATUS_IGNORED;
+    }
+    static_string_t if_range = divulge_get_request_header(request, "If-Range");
+    if (if_range.text &&
+        (!etag || (strlen(etag) != if_range.length) || (memcmp(etag, if_range.text, if_range.length) != 0))) {
+        return DIVULGE_RANGE_STATUS_IGNORED;
+    }
+    return divulge_range_parse(range, file_size, ranges, DIVULGE_RANGE_MAX_COUNT, range_count);
+}
+
+static const char* find_response_header(const divulge_response_t* response, const char* key) {
+    for (size_t i = 0; response->header.entries && (i < response->header.count); i++) {
+        const divulge_header_entry_t* entry = response->header.entries + i;
+        if (are_names_equal(entry->key, strlen(entry->key), key)) {
+            return entry->value;
+        }
+    }
+    return NULL;
+}
+
+static size_t format_content_range(char* buffer, size_t buffer_size, const divulge_range_t* range, size_t file_size) {
+    if (!range) {
+        return (size_t)snprintf(buffer, buffer_size, "bytes */%zu", file_size);
+    }
+    return (size_t)snprintf(buffer, buffer_size, "bytes %zu-%zu/%zu", range->offset, range->offset + range->size - 1,
+                            file_size);
+}
+
+static size_t send_byteranges_part_header(divulge_request_context_t* context,
+                                          const char* content_type,
+                                          const divulge_range_t* range,
+                                          size_t file_size) {
+    char content_range[DIVULGE_CONTENT_RANGE_MAX_SIZE];
+    size_t content_range_size = format_content_range(content_range, sizeof(content_range), range, file_size);
+    static const char* delimiter = "\r\n--" DIVULGE_BYTERANGES_BOUNDARY "\r\nContent-Type: ";
+    size_t size = strlen(delimiter) + strlen(content_type) + strlen("\r\nContent-Range: ") + content_range_size +
+                  strlen("\r\n\r\n");
+    if (context) {
+        append_response_text(context, delimiter);
+        append_response_text(context, content_type);
+        append_response_text(context, "\r\nContent-Range: ");
+        append_response(context, content_range, content_range_size);
+        append_response_text(context, "\r\n\r\n");
+    }
+    return size;
+}
+
+static void send_file_header(divulge_request_t* request,
+                             const divulge_response_t* response,
+                             size_t payload_size,
+                             const char* etag,
+                             const char* content_range,
+                             const char* content_type) {
+    divulge_header_entry_t entries[DIVULGE_FILE_HEADER_MAX_ENTRIES];
+    size_t count = 0;
+    for (size_t i = 0; response->header.entries && (i < response->header.count); i++) {
+        const divulge_header_entry_t* entry = response->header.entries + i;
+        if ((count < (DIVULGE_FILE_HEADER_MAX_ENTRIES - 4)) &&
+            !are_names_equal(entry->key, strlen(entry->key), "Content-Length") &&
+            (!content_type || !are_names_equal(entry->key, strlen(entry->key), "Content-Type"))) {
+            entries[count++] = *entry;
+        }
+    }
+    if (content_type) {
+        entries[count++] = (divulge_header_entry_t){.key = "Content-Type", .value = content_type};
+    }
+    entries[count++] = (divulge_header_entry_t){.key = "Accept-Ranges", .value = "bytes"};
+    if (etag) {
+        entries[count++] = (divulge_header_entry_t){.key = "ETag", .value = etag};
+    }
+    if (content_range) {
+        entries[count++] = (divulge_header_entry_t){.key = "Content-Range", .value = content_range};
+    }
+    divulge_response_t file_response = {
+        .return_code = response->return_code,
+        .header = {.entries = entries, .count = count},
+        .payload_size = payload_size,
+    };
+    send_response_header(request, &file_response);
+}
+
+static void send_file_byteranges(divulge_request_t* request,
+                                 divulge_response_t* response,
+                                 g2l_fs_file_t* file,
+                                 size_t file_size,
+                                 const char* etag,
+                                 const divulge_range_t* ranges,
+                                 size_t range_count) {
+    const char* content_type = find_response_header(response, "Content-Type");
+    if (!content_type) {
+        content_type = "application/octet-stream";
+    }
+    size_t payload_size = strlen("\r\n--" DIVULGE_BYTERANGES_BOUNDARY "--\r\n");
+    for (size_t i = 0; i < range_count; i++) {
+        payload_size += send_byteranges_part_header(NULL, content_type, ranges + i, file_size) + ranges[i].size;
+    }
+    response->return_code = 206;
+    send_file_header(request, response, payload_size, etag, NULL,
+                     "multipart/byteranges; boundary=" DIVULGE_BYTERANGES_BOUNDARY);
+    append_response(request->context, "\r\n", 2);
+    for (size_t i = 0; i < range_count; i++) {
+        if (!request->context->is_body_suppressed) {
+            send_byteranges_part_header(request->context, content_type, ranges + i, file_size);
+        }
+        send_file_contents(request->context, file, ranges[i].offset, ranges[i].size);
+    }
+    if (!request->context->is_body_suppressed) {
+        append_response_text(request->context, "\r\n--" DIVULGE_BYTERANGES_BOUNDARY "--\r\n");
+    }
+    flush_response(request->context);
+}
+
+bool divulge_send_file(divulge_request_t* request, divulge_response_t* response, const char* file_name) {
+    if (!request || !response || !file_name || request->context->was_header_sent ||
+        !g2l_fs_file_is_regular(file_name)) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    g2l_fs_file_t* file = NULL;
+    if (!context->is_body_suppressed) {
+        file = g2l_fs_file_open(file_name, G2L_FS_MODE_READ);
+        if (!file) {
+            return false;
+        }
+    }
+    size_t file_size = g2l_fs_file_size(file_name);
+    char etag_buffer[DIVULGE_ETAG_MAX_SIZE];
+    const char* etag = create_file_etag(file_name, file_size, etag_buffer, sizeof(etag_buffer)) ? etag_buffer : NULL;
+    divulge_range_t ranges[DIVULGE_RANGE_MAX_COUNT];
+    size_t range_count = 0;
+    divulge_range_status_t range_status = DIVULGE_RANGE_STATUS_IGNORED;
+    if ((response->return_code == 200) && !context->was_status_sent) {
+        range_status = parse_file_ranges(request, etag, file_size, ranges, &range_count);
+    }
+    response->payload = NULL;
+    response->payload_size = file_size;
+    char content_range[DIVULGE_CONTENT_RANGE_MAX_SIZE];
+    if (range_status == DIVULGE_RANGE_STATUS_UNSATISFIABLE) {
+        response->return_code = 416;
+        response->payload_size = 0;
+        format_content_range(content_range, sizeof(content_range), NULL, file_size);
+        send_file_header(request, response, 0, NULL, content_range, NULL);
+        append_response(context, "\r\n", 2);
+        flush_response(context);
+    } else if ((range_status == DIVULGE_RANGE_STATUS_SATISFIABLE) && (range_count > 1)) {
+        send_file_byteranges(request, response, file, file_size, etag, ranges, range_count);
+    } else {
+        size_t offset = 0;
+        const char* content_range_value = NULL;
+        if (range_status == DIVULGE_RANGE_STATUS_SATISFIABLE) {
+            response->return_code = 206;
+            offset = ranges[0].offset;
+            response->payload_size = ranges[0].size;
+            format_content_range(content_range, sizeof(content_range), ranges, file_size);
+            content_range_value = content_range;
+        }
+        send_file_header(request, response, response->payload_size, etag, content_range_value, NULL);
+        append_response(context, "\r\n", 2);
+        send_file_contents(context, file, offset, response->payload_size);
+    }
+    if (file) {
+        g2l_fs_file_close(file);
+    }
+    return true;
+}
+
+bool divulge_begin_chunked_response(divulge_request_t* request, divulge_response_t* response) {
+    if (!request || !response || request->context->was_header_sent) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    divulge_response_t filtered_response = *response;
+    if (context->chunk_filter) {
+        context->chunk_filter_state =
+            context->chunk_filter->begin(request, &filtered_response, context->chunk_filter_context);
+        response = &filtered_response;
+    }
+    context->was_chunked_response_started = true;
+    if (has_content_length(response) || context->http2_stream) {
+        context->is_chunked = false;
+    } else if (context->is_legacy_version) {
+        context->keep_alive = false;
+    } else {
+        context->is_chunked = true;
+    }
+    if (!context->was_status_sent) {
+        divulge_send_status(request, response->return_code);
+    }
+    send_response_header(request, response);
+    append_response(context, "\r\n", 2);
+    return true;
+}
+
+bool divulge_send_chunk(divulge_request_t* request, const char* data, size_t data_size) {
+    if (!request || !request->context->was_chunked_response_started || (!data && (data_size > 0))) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    if ((data_size == 0) || context->is_body_suppressed) {
+        return true;
+    }
+    if (context->chunk_filter_state && !context->is_chunk_filter_running) {
+        context->is_chunk_filter_running = true;
+        bool result = context->chunk_filter->write(request, data, data_size, context->chunk_filter_state);
+        context->is_chunk_filter_running = false;
+        return result;
+    }
+    if (context->is_chunked) {
+        char chunk_size[24];
+        size_t size = (size_t)snprintf(chunk_size, sizeof(chunk_size), "%zx\r\n", data_size);
+        append_response(context, chunk_size, size);
+    }
+    if (data_size <= (context->response_buffer_size - context->response_size)) {
+        append_response(context, data, data_size);
+    } else if (context->divulge->configuration.sendv) {
+        divulge_io_vector_t vectors[] = {
+            {.data = context->response_buffer, .size = context->response_size},
+            {.data = data, .size = data_size},
+        };
+        send_response_vectors(context, vectors, 2);
+        context->response_size = 0;
+    } else {
+        flush_response(context);
+        send_response_data(context, data, data_size);
+    }
+    if (context->is_chunked) {
+        append_response(context, "\r\n", 2);
+    }
+    return true;
+}
+
+bool divulge_end_chunked_response(divulge_request_t* request) {
+    if (!request || !request->context->was_chunked_response_started) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    if (context->chunk_filter_state) {
+        context->is_chunk_filter_running = true;
+        context->chunk_filter->end(request, context->chunk_filter_state);
+        context->is_chunk_filter_running = false;
+        context->chunk_filter_state = NULL;
+    }
+    if (context->is_chunked && !context->is_body_suppressed) {
+        append_response(context, "0\r\n\r\n", 5);
+    }
+    flush_response(context);
+    context->was_chunked_response_started = false;
+    context->is_chunked = false;
+    return true;
+}
+
+bool divulge_read_body(divulge_request_t* request, divulge_body_handler_t handler, void* context) {
+    if (!request || !handler) {
+        return false;
+    }
+    if (stream_body(request, handler, context) != BODY_STATUS_COMPLETE) {
+        request->context->keep_alive = false;
+        return false;
+    }
+    return true;
+}
+
+bool divulge_is_response_started(divulge_request_t* request) {
+    return request && request->context->was_status_sent;
+}
+
+bool divulge_upgrade_connection(divulge_request_t* request, divulge_response_t* response) {
+    if (!request || !response || request->context->was_header_sent || request->context->was_chunked_response_started) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    if (context->http2_stream) {
+        divulge_http2_stream_require_http1(context->http2_stream);
+        return false;
+    }
+    context->is_upgraded = true;
+    context->keep_alive = false;
+    if (!context->was_status_sent) {
+        divulge_send_status(request, response->return_code);
+    }
+    send_response_header(request, response);
+    append_response(context, "\r\n", 2);
+    flush_response(context);
+    if (context->divulge->configuration.set_receive_timeout) {
+        context->divulge->configuration.set_receive_timeout(context->connection_context, 0);
+    }
+    return true;
+}
+
+size_t divulge_receive(divulge_request_t* request, char* buffer, size_t buffer_size) {
+    if (!request || !request->context->is_upgraded || !buffer || (buffer_size == 0)) {
+        return 0;
+    }
+    divulge_request_context_t* context = request->context;
+    request_input_t* input = context->input;
+    size_t pending_size = input->received_size - input->request_size;
+    if (pending_size > 0) {
+        size_t size = (pending_size < buffer_size) ? pending_size : buffer_size;
+        memcpy(buffer, input->buffer + input->request_size, size);
+        input->request_size += size;
+        return size;
+    }
+    if (!input->can_receive) {
+        return 0;
+    }
+    return context->divulge->configuration.receive(context->connection_context, buffer, buffer_size);
+}
+
+bool divulge_send(divulge_request_t* request, const char* data, size_t data_size) {
+    if (!request || !request->context->is_upgraded || (!data && (data_size > 0))) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    if (data_size > 0) {
+        context->divulge->configuration.send(context->connection_context, data, data_size);
+    }
+    return true;
+}
+
+bool divulge_send_vector(divulge_request_t* request, const divulge_io_vector_t* vectors, size_t vector_count) {
+    if (!request || !request->context->is_upgraded || (!vectors && (vector_count > 0))) {
+        return false;
+    }
+    divulge_request_context_t* context = request->context;
+    if (context->divulge->configuration.sendv) {
+        context->divulge->configuration.sendv(context->connection_context, vectors, vector_count);
+        return true;
+    }
+    for (size_t i = 0; i < vector_count; i++) {
+        if (vectors[i].size > 0) {
+            context->divulge->configuration.send(context->connection_context, vectors[i].data, vectors[i].size);
+        }
+    }
+    return true;
+}
+
+divulge_deferred_response_t* divulge_defer_response(divulge_request_t* request) {
+    if (!request || request->context->is_deferred || request->context->is_upgraded ||
+        request->context->was_status_sent || request->context->http2_stream) {
+        return NULL;
+    }
+    divulge_request_context_t* context = request->context;
+    divulge_deferred_response_t* deferred = malloc(sizeof(divulge_deferred_response_t) + context->response_buffer_size);
+    if (!deferred) {
+        return NULL;
+    }
+    deferred->context = *context;
+    deferred->input_buffer[0] = '\0';
+    deferred->input = (request_input_t){
+        .buffer = deferred->input_buffer,
+        .can_receive = false,
+    };
+    deferred->context.input = &deferred->input;
+    deferred->arena = *context->arena;
+    divulge_arena_initialize(context->arena, NULL, 0);
+    deferred->context.arena = &deferred->arena;
+    deferred->context.response_buffer = deferred->response_buffer;
+    deferred->context.response_size = 0;
+    deferred->context.keep_alive = false;
+    deferred->request = (divulge_request_t){
+        .context = &deferred->context,
+        .method = request->method,
+        .route = "",
+        .header = "",
+        .payload = "",
+    };
+    context->is_deferred = true;
+    return deferred;
+}
+
+divulge_request_t* divulge_get_deferred_request(divulge_deferred_response_t* deferred) {
+    return deferred ? &deferred->request : NULL;
+}
+
+bool divulge_complete_deferred_response(divulge_deferred_response_t* deferred, divulge_response_t* response) {
+    if (!deferred) {
+        return false;
+    }
+    divulge_request_t* request = &deferred->request;
+    bool result = true;
+    if (response) {
+        result = divulge_respond(request, response);
+    } else if (!deferred->context.was_status_sent) {
+        respond_with_status(request, 500);
+    }
+    finish_response(request);
+    deferred->context.divulge->configuration.close(deferred->context.connection_context);
+    free(deferred->arena.buffer);
+    free(deferred);
+    return result;
+}
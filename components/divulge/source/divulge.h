@@ -26,6 +26,9 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "g2l-fs.h"
+#include "static-string.h"
 /**
  * @defgroup divulge Divulge
  * @brief Small HTTP router in C
@@ -33,14 +36,36 @@
  */
 typedef struct divulge divulge_t;
 
+#define DIVULGE_ROUTE_PARAMETERS_MAX_COUNT (8)
+#define DIVULGE_RESPONSE_FILTERS_MAX_COUNT (4)
+#define DIVULGE_REQUEST_HEADERS_MAX_COUNT (32)
+
 typedef enum divulge_route_method {
     DIVULGE_ROUTE_METHOD_GET,
     DIVULGE_ROUTE_METHOD_POST,
+    DIVULGE_ROUTE_METHOD_HEAD,
+    DIVULGE_ROUTE_METHOD_PUT,
+    DIVULGE_ROUTE_METHOD_DELETE,
+    DIVULGE_ROUTE_METHOD_PATCH,
+    DIVULGE_ROUTE_METHOD_OPTIONS,
     DIVULGE_ROUTE_METHOD_ANY,
 } divulge_route_method_t;
 
 typedef struct divulge_request_context divulge_request_context_t;
 
+typedef struct divulge_deferred_response divulge_deferred_response_t;
+
+typedef struct divulge_route_parameter {
+    static_string_t name;
+    static_string_t value;
+} divulge_route_parameter_t;
+
+typedef struct divulge_request_header {
+    static_string_t name;
+    static_string_t value;
+    uint32_t name_hash;
+} divulge_request_header_t;
+
 typedef struct divulge_request {
     divulge_request_context_t* context;
     divulge_route_method_t method;
@@ -48,6 +73,11 @@ typedef struct divulge_request {
     const char* url_query;
     const char* header;
     const char* payload;
+    size_t payload_size;
+    divulge_route_parameter_t parameters[DIVULGE_ROUTE_PARAMETERS_MAX_COUNT];
+    size_t parameter_count;
+    divulge_request_header_t headers[DIVULGE_REQUEST_HEADERS_MAX_COUNT];
+    size_t header_count;
 } divulge_request_t;
 
 typedef struct divulge_header_entry {
@@ -67,26 +97,107 @@ typedef struct divulge_response {
     size_t payload_size;
 } divulge_response_t;
 
+/**
+ * HEAD requests without a route of their own are answered by the GET handler with the body suppressed:
+ * divulge_send_file() does not open the file and divulge_send_chunk() drops its data before any chunk filter sees it.
+ * Handlers building a body anyway can check `request->method == DIVULGE_ROUTE_METHOD_HEAD` to skip that work.
+ */
 typedef bool (*divulge_uri_handler_t)(divulge_request_t* request, void* context);
 
+typedef bool (*divulge_response_filter_t)(divulge_request_t* request, divulge_response_t* response, void* context);
+
+/**
+ * @brief Transforms the body of chunked responses, e.g. to compress it
+ *
+ * `begin` may adjust a copy of the response before its head is sent and returns the state passed to the other
+ * callbacks, or NULL to leave the body untouched. `write` receives every chunk and `end` is called once before the
+ * response ends and has to release the state. Both pass their output on with divulge_send_chunk(), which bypasses the
+ * filter meanwhile. `write` is never called for HEAD requests, so `begin` should only prepare the headers for them.
+ */
+typedef struct divulge_chunk_filter {
+    void* (*begin)(divulge_request_t* request, divulge_response_t* response, void* context);
+    bool (*write)(divulge_request_t* request, const char* data, size_t data_size, void* state);
+    void (*end)(divulge_request_t* request, void* state);
+} divulge_chunk_filter_t;
+
 typedef struct divulge_handler_object {
     divulge_uri_handler_t handler;
     void* context;
 } divulge_handler_object_t;
 
+typedef bool (*divulge_body_handler_t)(divulge_request_t* request, const char* data, size_t data_size, void* context);
+
 typedef struct divulge_uri {
     const char* uri;
     divulge_route_method_t method;
     divulge_handler_object_t handler;
+    divulge_body_handler_t body_handler;
 } divulge_uri_t;
 
+typedef struct divulge_static_route {
+    divulge_uri_t uri;
+    const divulge_handler_object_t* middlewares;
+    size_t middleware_count;
+} divulge_static_route_t;
+
+/**
+ * @brief Declare a route at compile time, without a registration call
+ *
+ * The descriptor is placed in the `divulge_routes` linker section. Every divulge instance indexes these routes in its
+ * route tree during divulge_initialize(), so they are matched together with the registered routes and the more
+ * specific pattern wins; registering the same pattern and method again fails. Optional trailing arguments are
+ * middleware handler objects, e.g. `{.handler = check_token}`, executed in the given order. The translation unit
+ * defining the route has to be linked in: objects of a static library are dropped when nothing else references them.
+ */
+#define DIVULGE_ROUTE(name, route_method, route_uri, route_handler, route_context, ...)                                \
+    static const divulge_handler_object_t divulge_route_middlewares_##name[] = {{NULL, NULL}, __VA_ARGS__};            \
+    static const divulge_static_route_t divulge_route_##name = {                                                       \
+        .uri = {.uri = (route_uri),                                                                                    \
+                .method = (route_method),                                                                              \
+                .handler = {.handler = (route_handler), .context = (route_context)}},                                  \
+        .middlewares = divulge_route_middlewares_##name + 1,                                                           \
+        .middleware_count = (sizeof(divulge_route_middlewares_##name) / sizeof(divulge_handler_object_t)) - 1,         \
+    };                                                                                                                 \
+    static const divulge_static_route_t* const divulge_route_pointer_##name                                            \
+        __attribute__((used, section("divulge_routes"))) = &divulge_route_##name
+
+typedef struct divulge_io_vector {
+    const char* data;
+    size_t size;
+} divulge_io_vector_t;
+
 typedef void (*divulge_socket_send_callback_t)(void* connection_context, const char* data, size_t data_size);
 
+typedef void (*divulge_socket_send_vector_callback_t)(void* connection_context,
+                                                      const divulge_io_vector_t* vectors,
+                                                      size_t vector_count);
+
+typedef size_t (*divulge_socket_send_file_callback_t)(void* connection_context,
+                                                      g2l_fs_file_t* file,
+                                                      size_t offset,
+                                                      size_t size);
+
 typedef void (*divulge_socket_close_callback_t)(void* connection_context);
 
+typedef size_t (*divulge_socket_receive_callback_t)(void* connection_context, char* data, size_t max_data_size);
+
+typedef void (*divulge_socket_set_receive_timeout_callback_t)(void* connection_context, uint32_t timeout_ms);
+
+typedef uint64_t (*divulge_get_time_us_callback_t)(void);
+
 typedef struct divulge_configuration {
     divulge_socket_send_callback_t send;
+    divulge_socket_send_vector_callback_t sendv;
+    divulge_socket_send_file_callback_t send_file;
     divulge_socket_close_callback_t close;
+    divulge_socket_receive_callback_t receive;
+    divulge_socket_set_receive_timeout_callback_t set_receive_timeout;
+    divulge_get_time_us_callback_t get_time_us;
+    const char* metrics_uri;
+    size_t keep_alive_max_requests;
+    uint32_t keep_alive_timeout_ms;
+    size_t request_arena_size;
+    size_t http2_max_concurrent_streams; /**< @brief 0 serves HTTP/1.1 only, otherwise h2c is accepted as well */
 } divulge_configuration_t;
 
 const char* divulge_method_name_from_method(divulge_route_method_t method);
@@ -106,10 +217,29 @@ void divulge_process_request(divulge_t* divulge,
                              char* response_buffer,
                              size_t response_buffer_size);
 
+void divulge_serve_connection(divulge_t* divulge,
+                              void* connection_context,
+                              char* request_buffer,
+                              size_t request_buffer_size,
+                              char* response_buffer,
+                              size_t response_buffer_size);
+
+void* divulge_allocate(divulge_request_t* request, size_t size);
+
+uint64_t divulge_get_time_us(divulge_request_t* request);
+
+static_string_t divulge_get_route_parameter(divulge_request_t* request, const char* name);
+
+static_string_t divulge_get_request_header(divulge_request_t* request, const char* name);
+
 const char* divulge_find_request_header_key(divulge_request_t* request, const char* key);
 
 const char* divulge_get_request_header_entry_value(const char* header_entry);
 
+bool divulge_add_response_filter(divulge_request_t* request, divulge_response_filter_t filter, void* context);
+
+bool divulge_set_chunk_filter(divulge_request_t* request, const divulge_chunk_filter_t* filter, void* context);
+
 bool divulge_send_status(divulge_request_t* request, int return_code);
 
 bool divulge_send_header(divulge_request_t* request, divulge_response_t* response);
@@ -119,6 +249,40 @@ bool divulge_send_payload(divulge_request_t* request, divulge_response_t* respon
 bool divulge_respond(divulge_request_t* request, divulge_response_t* response);
 
 bool divulge_redirect(divulge_request_t* request, const char* new_location);
+
+bool divulge_send_file(divulge_request_t* request, divulge_response_t* response, const char* file_name);
+
+bool divulge_begin_chunked_response(divulge_request_t* request, divulge_response_t* response);
+
+bool divulge_send_chunk(divulge_request_t* request, const char* data, size_t data_size);
+
+bool divulge_end_chunked_response(divulge_request_t* request);
+
+bool divulge_read_body(divulge_request_t* request, divulge_body_handler_t handler, void* context);
+
+bool divulge_is_response_started(divulge_request_t* request);
+
+/**
+ * @brief Take the request away from the worker so it can be answered later from another thread
+ *
+ * The connection outlives the handler, so the transport must keep it open until the close callback is called. The
+ * Linux stream server does: a connection keeps its slot until stream_server_close().
+ * @return token for divulge_complete_deferred_response(), NULL if the request was already deferred, answered or
+ *         upgraded, is an HTTP/2 stream or memory ran out
+ */
+divulge_deferred_response_t* divulge_defer_response(divulge_request_t* request);
+
+divulge_request_t* divulge_get_deferred_request(divulge_deferred_response_t* deferred);
+
+bool divulge_complete_deferred_response(divulge_deferred_response_t* deferred, divulge_response_t* response);
+
+bool divulge_upgrade_connection(divulge_request_t* request, divulge_response_t* response);
+
+size_t divulge_receive(divulge_request_t* request, char* buffer, size_t buffer_size);
+
+bool divulge_send(divulge_request_t* request, const char* data, size_t data_size);
+
+bool divulge_send_vector(divulge_request_t* request, const divulge_io_vector_t* vectors, size_t vector_count);
 /**
  * @}
  */
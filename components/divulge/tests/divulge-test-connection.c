@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-test-connection.h"
+
+void test_send(void* connection_context, const char* data, size_t data_size) {
+    test_connection_t* connection = (test_connection_t*)connection_context;
+    assert_true((connection->output_size + data_size) < sizeof(connection->output));
+    memcpy(connection->output + connection->output_size, data, data_size);
+    connection->output_size += data_size;
+    connection->output[connection->output_size] = '\0';
+    connection->send_count++;
+}
+
+void test_send_vector(void* connection_context, const divulge_io_vector_t* vectors, size_t vector_count) {
+    test_connection_t* connection = (test_connection_t*)connection_context;
+    size_t send_count = connection->send_count;
+    for (size_t i = 0; i < vector_count; i++) {
+        test_send(connection_context, vectors[i].data, vectors[i].size);
+    }
+    connection->send_count = send_count;
+    connection->vector_send_count++;
+}
+
+void test_close(void* connection_context) {
+    test_connection_t* connection = (test_connection_t*)connection_context;
+    connection->was_closed = true;
+}
+
+size_t test_receive(void* connection_context, char* data, size_t max_data_size) {
+    test_connection_t* connection = (test_connection_t*)connection_context;
+    size_t size = connection->input_size - connection->input_position;
+    if ((connection->input_chunk_size > 0) && (size > connection->input_chunk_size)) {
+        size = connection->input_chunk_size;
+    }
+    if (size > max_data_size) {
+        size = max_data_size;
+    }
+    memcpy(data, connection->input + connection->input_position, size);
+    connection->input_position += size;
+    return size;
+}
+
+void test_set_receive_timeout(void* connection_context, uint32_t timeout_ms) {
+    test_connection_t* connection = (test_connection_t*)connection_context;
+    connection->receive_timeout_ms = timeout_ms;
+}
+
+divulge_configuration_t test_connection_create_configuration(void) {
+    divulge_configuration_t configuration = {
+        .send = test_send,
+        .close = test_close,
+        .receive = test_receive,
+        .set_receive_timeout = test_set_receive_timeout,
+    };
+    return configuration;
+}
+
+void test_connection_reset(test_connection_t* connection, const char* input) {
+    memset(connection, 0, sizeof(*connection));
+    connection->input = input;
+    connection->input_size = input ? strlen(input) : 0;
+}
+
+void test_connection_process(divulge_t* divulge, test_connection_t* connection, const char* raw_request) {
+    char request_buffer[TEST_BUFFER_SIZE];
+    char response_buffer[TEST_BUFFER_SIZE];
+    test_connection_reset(connection, NULL);
+    assert_true(strlen(raw_request) < sizeof(request_buffer));
+    strcpy(request_buffer, raw_request);
+    divulge_process_request(divulge, connection, request_buffer, strlen(request_buffer), response_buffer,
+                            sizeof(response_buffer));
+}
+
+void test_connection_serve(divulge_t* divulge, test_connection_t* connection) {
+    char request_buffer[TEST_BUFFER_SIZE];
+    char response_buffer[TEST_BUFFER_SIZE];
+    divulge_serve_connection(divulge, connection, request_buffer, sizeof(request_buffer), response_buffer,
+                             sizeof(response_buffer));
+}
+
+bool test_connection_contains(const test_connection_t* connection, const char* text) {
+    return (strstr(connection->output, text) != NULL);
+}
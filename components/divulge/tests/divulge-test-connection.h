@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIVULGE_TEST_CONNECTION_H
+#define DIVULGE_TEST_CONNECTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "divulge.h"
+
+#define TEST_BUFFER_SIZE (1024)
+#define TEST_OUTPUT_SIZE (64 * 1024)
+
+/**
+ * @brief In-memory socket handed to divulge as the connection context
+ *
+ * Sent data is appended to output and kept NUL terminated; receive hands out input in pieces of at most
+ * input_chunk_size bytes, or all at once when it is 0.
+ */
+typedef struct test_connection {
+    const char* input;
+    size_t input_size;
+    size_t input_position;
+    size_t input_chunk_size;
+    uint32_t receive_timeout_ms;
+    char output[TEST_OUTPUT_SIZE];
+    size_t output_size;
+    size_t send_count;
+    size_t vector_send_count;
+    bool was_closed;
+} test_connection_t;
+
+void test_send(void* connection_context, const char* data, size_t data_size);
+
+void test_send_vector(void* connection_context, const divulge_io_vector_t* vectors, size_t vector_count);
+
+void test_close(void* connection_context);
+
+size_t test_receive(void* connection_context, char* data, size_t max_data_size);
+
+void test_set_receive_timeout(void* connection_context, uint32_t timeout_ms);
+
+/**
+ * @brief Configuration with the socket callbacks pointing at the test connection; sendv stays unset
+ */
+divulge_configuration_t test_connection_create_configuration(void);
+
+/**
+ * @brief Clear the connection and make input the text it will receive
+ * @param[in] input NUL terminated text or NULL
+ */
+void test_connection_reset(test_connection_t* connection, const char* input);
+
+/**
+ * @brief Reset the connection and pass a copy of raw_request to divulge_process_request
+ */
+void test_connection_process(divulge_t* divulge, test_connection_t* connection, const char* raw_request);
+
+/**
+ * @brief Run divulge_serve_connection on the connection as it is
+ */
+void test_connection_serve(divulge_t* divulge, test_connection_t* connection);
+
+bool test_connection_contains(const test_connection_t* connection, const char* text);
+
+#endif  // DIVULGE_TEST_CONNECTION_H
@@ -0,0 +1,69 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cmocka.h"
+
+#include "divulge-arena.h"
+
+#define TEST_ARENA_SIZE (64)
+
+static void test_allocate_and_reset(void** state) {
+    _Alignas(max_align_t) char buffer[TEST_ARENA_SIZE];
+    divulge_arena_t arena;
+    divulge_arena_initialize(&arena, buffer, sizeof(buffer));
+
+    char* first = divulge_arena_allocate(&arena, 3);
+    char* second = divulge_arena_allocate(&arena, 8);
+    assert_ptr_equal(first, buffer);
+    assert_int_equal((uintptr_t)second % _Alignof(max_align_t), 0);
+    assert_true(second >= (first + 3));
+    assert_ptr_equal(divulge_arena_allocate(&arena, TEST_ARENA_SIZE), NULL);
+    assert_ptr_not_equal(divulge_arena_allocate(&arena, TEST_ARENA_SIZE - arena.size - 8), NULL);
+
+    divulge_arena_reset(&arena);
+    assert_int_equal(arena.size, 0);
+    assert_ptr_equal(divulge_arena_allocate(&arena, TEST_ARENA_SIZE), buffer);
+    assert_ptr_equal(divulge_arena_allocate(&arena, 1), NULL);
+    assert_ptr_not_equal(divulge_arena_allocate(&arena, 0), NULL);
+}
+
+static void test_arena_without_buffer(void** state) {
+    divulge_arena_t arena;
+    divulge_arena_initialize(&arena, NULL, TEST_ARENA_SIZE);
+    assert_ptr_equal(divulge_arena_allocate(&arena, 1), NULL);
+    assert_ptr_equal(divulge_arena_allocate(NULL, 1), NULL);
+    assert_ptr_equal(divulge_arena_allocate(&arena, SIZE_MAX), NULL);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_allocate_and_reset),
+        cmocka_unit_test(test_arena_without_buffer),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
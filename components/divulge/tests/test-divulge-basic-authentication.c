@@ -0,0 +1,215 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-basic-authentication.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+
+typedef struct g2l_mutex g2l_mutex_t;
+
+static int test_mutex;
+static bool is_random_source_available = true;
+static uint8_t test_random_byte;
+static uint64_t test_time_us;
+static size_t authentication_count;
+
+g2l_mutex_t* __wrap_g2l_mutex_create(void) {
+    return (g2l_mutex_t*)&test_mutex;
+}
+
+void __wrap_g2l_mutex_destroy(g2l_mutex_t* mutex) {}
+
+void __wrap_g2l_mutex_lock(g2l_mutex_t* mutex) {
+    assert_int_equal(test_mutex, 0);
+    test_mutex = 1;
+}
+
+void __wrap_g2l_mutex_unlock(g2l_mutex_t* mutex) {
+    assert_int_equal(test_mutex, 1);
+    test_mutex = 0;
+}
+
+bool __wrap_g2l_random_fill(void* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        ((uint8_t*)buffer)[i] = test_random_byte++;
+    }
+    return is_random_source_available;
+}
+
+static uint64_t test_get_time_us(void) {
+    return test_time_us;
+}
+
+static bool authenticate_user(void* context, const char* username, const char* password) {
+    authentication_count++;
+    return ((strcmp(username, "g2") == 0) && (strcmp(password, "g3") == 0)) ||
+           ((strcmp(username, "user") == 0) && (strcmp(password, "pa:ss") == 0));
+}
+
+static bool respond_with_secret(divulge_request_t* request, void* context) {
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = "secret",
+        .payload_size = strlen("secret"),
+    };
+    return divulge_respond(request, &response);
+}
+
+static divulge_t* create_router(divulge_handler_object_t* authentication, divulge_get_time_us_callback_t get_time_us) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.get_time_us = get_time_us;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_uri_t uri = {
+        .uri = "/restricted",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = respond_with_secret},
+    };
+    divulge_register_uri(divulge, &uri);
+    divulge_add_middleware_to_uri(divulge, &uri, authentication);
+    authentication_count = 0;
+    test_time_us = 1000;
+    return divulge;
+}
+
+static void process(divulge_t* divulge, test_connection_t* connection, const char* authorization) {
+    char request[TEST_BUFFER_SIZE];
+    snprintf(request, sizeof(request), "GET /restricted HTTP/1.1\r\nAuthorization: %s\r\n\r\n", authorization);
+    test_connection_process(divulge, connection, request);
+}
+
+static bool is_authorized(test_connection_t* connection) {
+    return (strstr(connection->output, "200 OK") != NULL) && (strstr(connection->output, "\r\n\r\nsecret") != NULL);
+}
+
+static bool is_rejected(test_connection_t* connection) {
+    return (strstr(connection->output, "401 Unauthorized") != NULL) &&
+           (strstr(connection->output, "WWW-Authenticate: Basic realm=\"test\"") != NULL);
+}
+
+static void test_verify_credentials(void** state) {
+    divulge_t* divulge = create_router(divulge_basic_authentication_create("test", authenticate_user, NULL), NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    assert_int_equal(authentication_count, 2);
+
+    process(divulge, &connection, "Basic dXNlcjpwYTpzcw==");
+    assert_true(is_authorized(&connection));
+
+    process(divulge, &connection, "Basic ZzI6YmFk");
+    assert_true(is_rejected(&connection));
+    assert_int_equal(authentication_count, 4);
+
+    process(divulge, &connection, "Basic bm9jb2xvbg==");
+    assert_true(is_rejected(&connection));
+    process(divulge, &connection, "Bearer ZzI6ZzM=");
+    assert_true(is_rejected(&connection));
+    process(divulge, &connection, "Basic ZzI6ZzM");
+    assert_true(is_rejected(&connection));
+    process(divulge, &connection, "Basic ");
+    assert_true(is_rejected(&connection));
+    assert_int_equal(authentication_count, 4);
+}
+
+static void test_cache_verified_credentials(void** state) {
+    divulge_t* divulge = create_router(
+        divulge_basic_authentication_create_with_cache("test", authenticate_user, NULL, 2, 1000), test_get_time_us);
+    test_connection_t connection;
+
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    assert_int_equal(authentication_count, 1);
+
+    process(divulge, &connection, "Basic ZzI6YmFk");
+    assert_true(is_rejected(&connection));
+    process(divulge, &connection, "Basic ZzI6YmFk");
+    assert_true(is_rejected(&connection));
+    assert_int_equal(authentication_count, 3);
+
+    test_time_us += 999000;
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    assert_int_equal(authentication_count, 3);
+
+    test_time_us += 1000;
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    assert_int_equal(authentication_count, 4);
+}
+
+static void test_cache_capacity(void** state) {
+    divulge_t* divulge = create_router(
+        divulge_basic_authentication_create_with_cache("test", authenticate_user, NULL, 1, 1000), test_get_time_us);
+    test_connection_t connection;
+
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    process(divulge, &connection, "Basic dXNlcjpwYTpzcw==");
+    process(divulge, &connection, "Basic dXNlcjpwYTpzcw==");
+    assert_int_equal(authentication_count, 2);
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    assert_int_equal(authentication_count, 3);
+}
+
+static void test_cache_requires_clock(void** state) {
+    divulge_t* divulge = create_router(
+        divulge_basic_authentication_create_with_cache("test", authenticate_user, NULL, 4, 1000), NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    process(divulge, &connection, "Basic ZzI6ZzM=");
+    assert_true(is_authorized(&connection));
+    assert_int_equal(authentication_count, 2);
+}
+
+static void test_cache_requires_random_source(void** state) {
+    is_random_source_available = false;
+    assert_ptr_equal(divulge_basic_authentication_create_with_cache("test", authenticate_user, NULL, 4, 1000), NULL);
+    assert_ptr_not_equal(divulge_basic_authentication_create("test", authenticate_user, NULL), NULL);
+    is_random_source_available = true;
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_verify_credentials),
+        cmocka_unit_test(test_cache_verified_credentials),
+        cmocka_unit_test(test_cache_capacity),
+        cmocka_unit_test(test_cache_requires_clock),
+        cmocka_unit_test(test_cache_requires_random_source),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
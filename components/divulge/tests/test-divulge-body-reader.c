@@ -0,0 +1,154 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-body-reader.h"
+
+#define TEST_BUFFER_SIZE (256)
+
+static divulge_body_reader_status_t read_byte_by_byte(divulge_body_reader_t* reader,
+                                                      const char* input,
+                                                      char* output,
+                                                      size_t* consumed_size,
+                                                      size_t* output_size) {
+    divulge_body_reader_status_t status = DIVULGE_BODY_READER_STATUS_INCOMPLETE;
+    *consumed_size = 0;
+    *output_size = 0;
+    while ((status == DIVULGE_BODY_READER_STATUS_INCOMPLETE) && input[*consumed_size]) {
+        size_t consumed = 0;
+        size_t produced = 0;
+        status = divulge_body_reader_execute(reader, input + *consumed_size, 1, output + *output_size, &consumed,
+                                             &produced);
+        *consumed_size += consumed;
+        *output_size += produced;
+    }
+    return status;
+}
+
+static void test_content_length_body(void** state) {
+    const char* input = "hello worldGET /";
+    char output[TEST_BUFFER_SIZE] = {0};
+    size_t consumed_size = 0;
+    size_t output_size = 0;
+    divulge_body_reader_t reader;
+    divulge_body_reader_reset(&reader, false, 11);
+    assert_false(divulge_body_reader_is_complete(&reader));
+    assert_int_equal(divulge_body_reader_execute(&reader, input, 5, output, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_INCOMPLETE);
+    assert_int_equal(consumed_size, 5);
+    assert_int_equal(output_size, 5);
+    assert_int_equal(divulge_body_reader_execute(&reader, input + 5, strlen(input) - 5, output + 5, &consumed_size,
+                                                 &output_size),
+                     DIVULGE_BODY_READER_STATUS_COMPLETE);
+    assert_int_equal(consumed_size, 6);
+    assert_int_equal(output_size, 6);
+    assert_memory_equal(output, "hello world", 11);
+    assert_true(divulge_body_reader_is_complete(&reader));
+
+    divulge_body_reader_reset(&reader, false, 0);
+    assert_true(divulge_body_reader_is_complete(&reader));
+    assert_int_equal(divulge_body_reader_execute(&reader, input, strlen(input), output, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_COMPLETE);
+    assert_int_equal(consumed_size, 0);
+    assert_int_equal(output_size, 0);
+}
+
+static void test_chunked_body(void** state) {
+    const char* input =
+        "5;name=value\r\nhello\r\n"
+        "6\r\n world\r\n"
+        "A\n, chunked!\n"
+        "0\r\nX-Trailer: yes\r\n\r\n"
+        "GET /";
+    char output[TEST_BUFFER_SIZE] = {0};
+    size_t consumed_size = 0;
+    size_t output_size = 0;
+    divulge_body_reader_t reader;
+
+    divulge_body_reader_reset(&reader, true, 0);
+    assert_int_equal(divulge_body_reader_execute(&reader, input, strlen(input), output, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_COMPLETE);
+    assert_int_equal(consumed_size, strlen(input) - strlen("GET /"));
+    assert_int_equal(output_size, 21);
+    assert_memory_equal(output, "hello world, chunked!", 21);
+    assert_true(divulge_body_reader_is_complete(&reader));
+
+    memset(output, 0, sizeof(output));
+    divulge_body_reader_reset(&reader, true, 0);
+    assert_int_equal(read_byte_by_byte(&reader, input, output, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_COMPLETE);
+    assert_int_equal(consumed_size, strlen(input) - strlen("GET /"));
+    assert_int_equal(output_size, 21);
+    assert_memory_equal(output, "hello world, chunked!", 21);
+}
+
+static void test_chunked_body_in_place(void** state) {
+    char buffer[TEST_BUFFER_SIZE];
+    strcpy(buffer, "3\r\nabc\r\n4\r\ndefg\r\n0\r\n\r\n");
+    size_t consumed_size = 0;
+    size_t output_size = 0;
+    divulge_body_reader_t reader;
+    divulge_body_reader_reset(&reader, true, 0);
+    assert_int_equal(divulge_body_reader_execute(&reader, buffer, strlen(buffer), buffer, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_COMPLETE);
+    assert_int_equal(output_size, 7);
+    assert_memory_equal(buffer, "abcdefg", 7);
+}
+
+static void assert_chunked_error(const char* input) {
+    char output[TEST_BUFFER_SIZE];
+    size_t consumed_size = 0;
+    size_t output_size = 0;
+    divulge_body_reader_t reader;
+    divulge_body_reader_reset(&reader, true, 0);
+    assert_int_equal(divulge_body_reader_execute(&reader, input, strlen(input), output, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_ERROR);
+    assert_int_equal(divulge_body_reader_execute(&reader, "0\r\n\r\n", 5, output, &consumed_size, &output_size),
+                     DIVULGE_BODY_READER_STATUS_ERROR);
+}
+
+static void test_malformed_chunked_body(void** state) {
+    assert_chunked_error("\r\n");
+    assert_chunked_error("x\r\n");
+    assert_chunked_error("5\r\nhelloX\r\n");
+    assert_chunked_error("5\rX");
+    assert_chunked_error("fffffffffffffffffffff\r\n");
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_content_length_body),
+        cmocka_unit_test(test_chunked_body),
+        cmocka_unit_test(test_chunked_body_in_place),
+        cmocka_unit_test(test_malformed_chunked_body),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
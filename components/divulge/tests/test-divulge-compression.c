@@ -0,0 +1,271 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-compression.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+#include "encodings-deflate.h"
+
+#define TEST_MIN_PAYLOAD_SIZE (64)
+
+typedef struct test_handler_context {
+    const char* content_type;
+    const char* etag;
+    const char* payload;
+    bool is_chunked;
+} test_handler_context_t;
+
+static size_t deflate_count;
+
+void __real_encodings_deflate_initialize(encodings_deflate_t* deflate,
+                                         encodings_deflate_format_t format,
+                                         encodings_deflate_output_callback_t output,
+                                         void* output_context);
+
+void __wrap_encodings_deflate_initialize(encodings_deflate_t* deflate,
+                                         encodings_deflate_format_t format,
+                                         encodings_deflate_output_callback_t output,
+                                         void* output_context) {
+    deflate_count++;
+    __real_encodings_deflate_initialize(deflate, format, output, output_context);
+}
+
+static const char* text_payload =
+    "<ul><li>temperature: 21.5</li><li>temperature: 21.6</li><li>temperature: 21.7</li><li>temperature: 21.8</li>"
+    "<li>temperature: 21.9</li><li>temperature: 22.0</li><li>temperature: 22.1</li><li>temperature: 22.2</li></ul>";
+
+static bool respond_with_context(divulge_request_t* request, void* context) {
+    test_handler_context_t* handler_context = (test_handler_context_t*)context;
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Content-Type", .value = handler_context->content_type},
+        {.key = "ETag", .value = handler_context->etag},
+    };
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.count = handler_context->etag ? 2 : 1, .entries = header_entries},
+        .payload = handler_context->payload,
+        .payload_size = strlen(handler_context->payload),
+    };
+    if (!handler_context->is_chunked) {
+        return divulge_respond(request, &response);
+    }
+    divulge_begin_chunked_response(request, &response);
+    for (size_t i = 0; i < response.payload_size; i += 10) {
+        size_t size = ((response.payload_size - i) < 10) ? (response.payload_size - i) : 10;
+        divulge_send_chunk(request, response.payload + i, size);
+    }
+    return divulge_end_chunked_response(request);
+}
+
+static divulge_t* create_router(divulge_compression_t* compression, test_handler_context_t* context) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_uri_t uri = {
+        .uri = "/{page}",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = respond_with_context, .context = context},
+    };
+    divulge_register_uri(divulge, &uri);
+    divulge_add_middleware_to_uri(divulge, &uri, divulge_compression_get_middleware(compression));
+    return divulge;
+}
+
+static void process(divulge_t* divulge, test_connection_t* connection, const char* accept_encoding) {
+    char request[TEST_BUFFER_SIZE];
+    if (accept_encoding) {
+        snprintf(request, sizeof(request), "GET /page HTTP/1.1\r\nAccept-Encoding: %s\r\n\r\n", accept_encoding);
+    } else {
+        strcpy(request, "GET /page HTTP/1.1\r\n\r\n");
+    }
+    test_connection_process(divulge, connection, request);
+}
+
+static const uint8_t* get_body(test_connection_t* connection) {
+    const char* body = strstr(connection->output, "\r\n\r\n");
+    assert_non_null(body);
+    return (const uint8_t*)body + 4;
+}
+
+static size_t get_content_length(test_connection_t* connection) {
+    const char* value = strstr(connection->output, "Content-Length: ");
+    assert_non_null(value);
+    return (size_t)strtoul(value + strlen("Content-Length: "), NULL, 10);
+}
+
+static bool accepts_gzip_handler(divulge_request_t* request, void* context) {
+    *(bool*)context = divulge_compression_is_accepted(request, "gzip");
+    divulge_response_t response = {.return_code = 204};
+    return divulge_respond(request, &response);
+}
+
+static void test_accept_encoding_negotiation(void** state) {
+    static const struct {
+        const char* accept_encoding;
+        bool is_accepted;
+    } cases[] = {
+        {"gzip", true},
+        {"deflate, GZIP", true},
+        {"br;q=1.0, gzip;q=0.5", true},
+        {"gzip;q=0", false},
+        {"gzip; q=0.000, *", false},
+        {"*", true},
+        {"*;q=0", false},
+        {"identity", false},
+        {"gzipped", false},
+        {"", false},
+    };
+    bool is_accepted = false;
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_uri_t uri = {
+        .uri = "/{page}",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = accepts_gzip_handler, .context = &is_accepted},
+    };
+    divulge_register_uri(divulge, &uri);
+    test_connection_t connection;
+    for (size_t i = 0; i < (sizeof(cases) / sizeof(cases[0])); i++) {
+        is_accepted = !cases[i].is_accepted;
+        process(divulge, &connection, cases[i].accept_encoding);
+        assert_int_equal(is_accepted, cases[i].is_accepted);
+    }
+    process(divulge, &connection, NULL);
+    assert_false(is_accepted);
+}
+
+static void test_compress_response(void** state) {
+    test_handler_context_t context = {.content_type = "text/html", .payload = text_payload};
+    divulge_compression_t* compression = divulge_compression_create(TEST_MIN_PAYLOAD_SIZE);
+    divulge_t* divulge = create_router(compression, &context);
+    test_connection_t connection;
+
+    process(divulge, &connection, "br, gzip");
+    assert_true(test_connection_contains(&connection, "Content-Encoding: gzip\r\n"));
+    assert_true(test_connection_contains(&connection, "Vary: Accept-Encoding\r\n"));
+    size_t content_length = get_content_length(&connection);
+    assert_true(content_length < strlen(text_payload));
+    const uint8_t* body = get_body(&connection);
+    assert_int_equal(body[0], 0x1f);
+    assert_int_equal(body[1], 0x8b);
+    assert_int_equal((size_t)((const char*)body - connection.output) + content_length, connection.output_size);
+
+    process(divulge, &connection, "deflate");
+    assert_true(test_connection_contains(&connection, "Content-Encoding: deflate\r\n"));
+    body = get_body(&connection);
+    assert_int_equal(((body[0] << 8) | body[1]) % 31, 0);
+    divulge_compression_destroy(compression);
+}
+
+static void test_uncompressed_responses(void** state) {
+    test_handler_context_t context = {.content_type = "text/html", .payload = text_payload};
+    divulge_compression_t* compression = divulge_compression_create(TEST_MIN_PAYLOAD_SIZE);
+    divulge_t* divulge = create_router(compression, &context);
+    test_connection_t connection;
+
+    process(divulge, &connection, NULL);
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+    assert_int_equal(get_content_length(&connection), strlen(text_payload));
+
+    process(divulge, &connection, "identity");
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+
+    context.content_type = "image/png";
+    process(divulge, &connection, "gzip");
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+
+    context.content_type = "text/plain";
+    context.payload = "short";
+    process(divulge, &connection, "gzip");
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nshort"));
+
+    context.payload = "a1b2c3d4e5f6g7h8i9j0k!l@m#n$o%p^q&r*s(t)u-v_w=x+y[z]A{B}C;D:E'F\"G<H>I,J.K/L?";
+    process(divulge, &connection, "gzip");
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+    divulge_compression_destroy(compression);
+}
+
+static void test_entity_tag_becomes_weak(void** state) {
+    test_handler_context_t context = {.content_type = "text/html", .etag = "\"1234\"", .payload = text_payload};
+    divulge_compression_t* compression = divulge_compression_create(TEST_MIN_PAYLOAD_SIZE);
+    divulge_t* divulge = create_router(compression, &context);
+    test_connection_t connection;
+
+    process(divulge, &connection, "gzip");
+    assert_true(test_connection_contains(&connection, "ETag: W/\"1234\"\r\n"));
+    process(divulge, &connection, NULL);
+    assert_true(test_connection_contains(&connection, "ETag: \"1234\"\r\n"));
+    divulge_compression_destroy(compression);
+}
+
+static void test_compress_chunked_response(void** state) {
+    test_handler_context_t context = {.content_type = "application/json", .payload = text_payload, .is_chunked = true};
+    divulge_compression_t* compression = divulge_compression_create(TEST_MIN_PAYLOAD_SIZE);
+    divulge_t* divulge = create_router(compression, &context);
+    test_connection_t connection;
+
+    process(divulge, &connection, "gzip");
+    assert_true(test_connection_contains(&connection, "Transfer-Encoding: chunked\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Encoding: gzip\r\n"));
+    assert_false(test_connection_contains(&connection, "Content-Length"));
+    const uint8_t* body = get_body(&connection);
+    char* chunk_end = NULL;
+    size_t chunk_size = (size_t)strtoul((const char*)body, &chunk_end, 16);
+    assert_true((chunk_size > 0) && (chunk_size < strlen(text_payload)));
+    assert_memory_equal(chunk_end, "\r\n\x1f\x8b", 4);
+    assert_memory_equal(connection.output + connection.output_size - 5, "0\r\n\r\n", 5);
+    assert_int_equal((size_t)(chunk_end + 2 + chunk_size + 2 + 5 - connection.output), connection.output_size);
+
+    process(divulge, &connection, NULL);
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+    assert_true(test_connection_contains(&connection, "a\r\n<ul><li>te\r\n"));
+
+    deflate_count = 0;
+    test_connection_process(divulge, &connection, "HEAD /page HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Encoding: gzip\r\n"));
+    assert_true(test_connection_contains(&connection, "Vary: Accept-Encoding\r\n"));
+    assert_int_equal(strlen((const char*)get_body(&connection)), 0);
+    assert_int_equal(deflate_count, 0);
+    divulge_compression_destroy(compression);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_accept_encoding_negotiation),
+        cmocka_unit_test(test_compress_response),
+        cmocka_unit_test(test_uncompressed_responses),
+        cmocka_unit_test(test_entity_tag_becomes_weak),
+        cmocka_unit_test(test_compress_chunked_response),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
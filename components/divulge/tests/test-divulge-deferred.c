@@ -0,0 +1,185 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "cmocka.h"
+
+#include "divulge.h"
+#include "stream-server.h"
+
+#define TEST_PORT (5712)
+#define TEST_BUFFER_SIZE (1024)
+#define TEST_THREAD_COUNT (1)
+#define TEST_MAX_WAITING_CONNECTIONS (1)
+#define TEST_OTHER_CLIENT_COUNT (4)
+
+static divulge_t* test_divulge;
+static _Atomic(divulge_deferred_response_t*) test_deferred;
+
+static void socket_send(void* connection_context, const char* data, size_t data_size) {
+    stream_server_write((stream_server_connection_t*)connection_context, data, data_size);
+}
+
+static void socket_send_vector(void* connection_context, const divulge_io_vector_t* vectors, size_t vector_count) {
+    stream_server_writev((stream_server_connection_t*)connection_context, (const stream_server_io_vector_t*)vectors,
+                         vector_count);
+}
+
+static void socket_close(void* connection_context) {
+    stream_server_close((stream_server_connection_t*)connection_context);
+}
+
+static size_t socket_receive(void* connection_context, char* data, size_t max_data_size) {
+    return stream_server_read((stream_server_connection_t*)connection_context, data, max_data_size);
+}
+
+static void socket_set_receive_timeout(void* connection_context, uint32_t timeout_ms) {
+    stream_server_set_read_timeout((stream_server_connection_t*)connection_context, timeout_ms);
+}
+
+static bool defer_request(divulge_request_t* request, void* context) {
+    divulge_deferred_response_t* deferred = divulge_defer_response(request);
+    atomic_store(&test_deferred, deferred);
+    return deferred != NULL;
+}
+
+static bool respond_with_context(divulge_request_t* request, void* context) {
+    const char* text = (const char*)context;
+    divulge_response_t response = {.return_code = 200, .payload = text, .payload_size = strlen(text)};
+    return divulge_respond(request, &response);
+}
+
+static void handle_connection(stream_server_t* server, stream_server_connection_t* connection, void* context) {
+    char request_buffer[TEST_BUFFER_SIZE];
+    char response_buffer[TEST_BUFFER_SIZE];
+    divulge_serve_connection(test_divulge, connection, request_buffer, sizeof(request_buffer), response_buffer,
+                             sizeof(response_buffer));
+}
+
+static void* run_loop(void* context) {
+    while (true) {
+        stream_server_loop((stream_server_t*)context);
+    }
+    return NULL;
+}
+
+static int request(const char* raw_request) {
+    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert_true(socket_fd >= 0);
+    struct timeval timeout = {.tv_sec = 5};
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    assert_int_equal(connect(socket_fd, (struct sockaddr*)&address, sizeof(address)), 0);
+    assert_int_equal(send(socket_fd, raw_request, strlen(raw_request), 0), (ssize_t)strlen(raw_request));
+    return socket_fd;
+}
+
+static void receive_until_closed(int socket_fd, char* data, size_t max_data_size) {
+    size_t size = 0;
+    while (size < (max_data_size - 1)) {
+        ssize_t received = recv(socket_fd, data + size, max_data_size - 1 - size, 0);
+        assert_true(received >= 0);
+        if (received == 0) {
+            break;
+        }
+        size += (size_t)received;
+    }
+    data[size] = '\0';
+    close(socket_fd);
+}
+
+/* The clients served while the response is deferred reuse every free slot of the pool */
+static void test_deferred_response_reaches_its_client(void** state) {
+    int deferred_fd = request("GET /defer HTTP/1.1\r\n\r\n");
+    for (size_t i = 0; (i < 1000) && !atomic_load(&test_deferred); i++) {
+        usleep(1000);
+    }
+    assert_non_null(atomic_load(&test_deferred));
+
+    char data[TEST_BUFFER_SIZE];
+    for (size_t i = 0; i < TEST_OTHER_CLIENT_COUNT; i++) {
+        receive_until_closed(request("GET /other HTTP/1.1\r\nConnection: close\r\n\r\n"), data, sizeof(data));
+        assert_non_null(strstr(data, "\r\n\r\nother"));
+        assert_null(strstr(data, "deferred"));
+    }
+
+    divulge_response_t response = {.return_code = 200, .payload = "deferred", .payload_size = 8};
+    assert_true(divulge_complete_deferred_response(atomic_load(&test_deferred), &response));
+    receive_until_closed(deferred_fd, data, sizeof(data));
+    assert_non_null(strstr(data, "HTTP/1.1 200 OK\r\n"));
+    assert_non_null(strstr(data, "\r\n\r\ndeferred"));
+}
+
+static int start_server(void** state) {
+    divulge_configuration_t configuration = {
+        .send = socket_send,
+        .sendv = socket_send_vector,
+        .close = socket_close,
+        .receive = socket_receive,
+        .set_receive_timeout = socket_set_receive_timeout,
+    };
+    test_divulge = divulge_initialize(&configuration);
+    static divulge_uri_t defer_uri = {
+        .uri = "/defer",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = defer_request},
+    };
+    static divulge_uri_t other_uri = {
+        .uri = "/other",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = respond_with_context, .context = "other"},
+    };
+    divulge_register_uri(test_divulge, &defer_uri);
+    divulge_register_uri(test_divulge, &other_uri);
+    stream_server_t* server =
+        stream_server_create(TEST_PORT, TEST_MAX_WAITING_CONNECTIONS, TEST_THREAD_COUNT, handle_connection, NULL);
+    pthread_t loop_thread;
+    if (!server || (pthread_create(&loop_thread, NULL, run_loop, server) != 0)) {
+        return -1;
+    }
+    pthread_detach(loop_thread);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_deferred_response_reaches_its_client),
+    };
+
+    return cmocka_run_group_tests(tests, start_server, NULL);
+}
@@ -0,0 +1,237 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-hpack.h"
+
+#define TEST_MAX_FIELD_COUNT (8)
+#define TEST_FIELD_MAX_SIZE (64)
+#define TEST_BLOCK_SIZE (256)
+
+typedef struct decoded_fields {
+    char fields[TEST_MAX_FIELD_COUNT][TEST_FIELD_MAX_SIZE];
+    size_t count;
+} decoded_fields_t;
+
+static void collect_field(void* context, const char* name, size_t name_length, const char* value, size_t value_length) {
+    decoded_fields_t* decoded = context;
+    assert_true(decoded->count < TEST_MAX_FIELD_COUNT);
+    snprintf(decoded->fields[decoded->count++], TEST_FIELD_MAX_SIZE, "%.*s: %.*s", (int)name_length, name,
+             (int)value_length, value);
+}
+
+static const uint8_t first_request[] = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2,
+                                        0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+static const uint8_t second_request[] = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x86, 0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf};
+static const uint8_t third_request[] = {0x82, 0x87, 0x85, 0xbf, 0x40, 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b,
+                                        0xa9, 0x7d, 0x7f, 0x89, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf};
+
+static void test_decode_requests(void** state) {
+    static divulge_hpack_decoder_t decoder;
+    divulge_hpack_decoder_initialize(&decoder);
+
+    decoded_fields_t decoded = {.count = 0};
+    assert_true(divulge_hpack_decode(&decoder, first_request, sizeof(first_request), collect_field, &decoded));
+    assert_int_equal(decoded.count, 4);
+    assert_string_equal(decoded.fields[0], ":method: GET");
+    assert_string_equal(decoded.fields[1], ":scheme: http");
+    assert_string_equal(decoded.fields[2], ":path: /");
+    assert_string_equal(decoded.fields[3], ":authority: www.example.com");
+    assert_int_equal(decoder.table.size, 57);
+
+    decoded.count = 0;
+    assert_true(divulge_hpack_decode(&decoder, second_request, sizeof(second_request), collect_field, &decoded));
+    assert_int_equal(decoded.count, 5);
+    assert_string_equal(decoded.fields[3], ":authority: www.example.com");
+    assert_string_equal(decoded.fields[4], "cache-control: no-cache");
+    assert_int_equal(decoder.table.size, 110);
+
+    decoded.count = 0;
+    assert_true(divulge_hpack_decode(&decoder, third_request, sizeof(third_request), collect_field, &decoded));
+    assert_int_equal(decoded.count, 5);
+    assert_string_equal(decoded.fields[1], ":scheme: https");
+    assert_string_equal(decoded.fields[2], ":path: /index.html");
+    assert_string_equal(decoded.fields[3], ":authority: www.example.com");
+    assert_string_equal(decoded.fields[4], "custom-key: custom-value");
+    assert_int_equal(decoder.table.size, 164);
+    assert_int_equal(decoder.table.entry_count, 3);
+}
+
+static size_t encode_fields(divulge_hpack_encoder_t* encoder, const char* const fields[][2], size_t count,
+                            uint8_t* block) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t field_size = divulge_hpack_encode(encoder, fields[i][0], strlen(fields[i][0]), fields[i][1],
+                                                 strlen(fields[i][1]), block + size, TEST_BLOCK_SIZE - size);
+        assert_int_not_equal(field_size, 0);
+        size += field_size;
+    }
+    return size;
+}
+
+static void test_encode_requests(void** state) {
+    static divulge_hpack_encoder_t encoder;
+    divulge_hpack_encoder_initialize(&encoder);
+    uint8_t block[TEST_BLOCK_SIZE];
+
+    const char* const first[][2] = {
+        {":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}};
+    assert_int_equal(encode_fields(&encoder, first, 4, block), sizeof(first_request));
+    assert_memory_equal(block, first_request, sizeof(first_request));
+
+    const char* const second[][2] = {{":method", "GET"},
+                                     {":scheme", "http"},
+                                     {":path", "/"},
+                                     {":authority", "www.example.com"},
+                                     {"cache-control", "no-cache"}};
+    assert_int_equal(encode_fields(&encoder, second, 5, block), sizeof(second_request));
+    assert_memory_equal(block, second_request, sizeof(second_request));
+
+    const char* const third[][2] = {{":method", "GET"},
+                                    {":scheme", "https"},
+                                    {":path", "/index.html"},
+                                    {":authority", "www.example.com"},
+                                    {"custom-key", "custom-value"}};
+    assert_int_equal(encode_fields(&encoder, third, 5, block), sizeof(third_request));
+    assert_memory_equal(block, third_request, sizeof(third_request));
+}
+
+static void test_encode_and_decode_response(void** state) {
+    static divulge_hpack_encoder_t encoder;
+    static divulge_hpack_decoder_t decoder;
+    divulge_hpack_encoder_initialize(&encoder);
+    divulge_hpack_decoder_initialize(&decoder);
+    uint8_t block[TEST_BLOCK_SIZE];
+    const char* const fields[][2] = {
+        {":status", "206"}, {"server", "Divulge"}, {"content-length", "1234"}, {"x-empty", ""}};
+
+    for (int round = 0; round < 2; round++) {
+        size_t size = encode_fields(&encoder, fields, 4, block);
+        decoded_fields_t decoded = {.count = 0};
+        assert_true(divulge_hpack_decode(&decoder, block, size, collect_field, &decoded));
+        assert_int_equal(decoded.count, 4);
+        assert_string_equal(decoded.fields[0], ":status: 206");
+        assert_string_equal(decoded.fields[1], "server: Divulge");
+        assert_string_equal(decoded.fields[2], "content-length: 1234");
+        assert_string_equal(decoded.fields[3], "x-empty: ");
+    }
+    assert_int_equal(encoder.table.entry_count, 2);
+    assert_int_equal(decoder.table.size, encoder.table.size);
+}
+
+static void test_table_size_update(void** state) {
+    static divulge_hpack_encoder_t encoder;
+    divulge_hpack_encoder_initialize(&encoder);
+    uint8_t block[TEST_BLOCK_SIZE];
+
+    divulge_hpack_encoder_set_max_table_size(&encoder, 0);
+    divulge_hpack_encoder_set_max_table_size(&encoder, 256);
+    size_t size = divulge_hpack_encode(&encoder, "custom-key", 10, "custom-value", 12, block, sizeof(block));
+    const uint8_t updates[] = {0x20, 0x3f, 0xe1, 0x01, 0x40};
+    assert_true(size > sizeof(updates));
+    assert_memory_equal(block, updates, sizeof(updates));
+    assert_int_equal(encoder.table.size, 54);
+
+    size = divulge_hpack_encode(&encoder, "custom-key", 10, "custom-value", 12, block, sizeof(block));
+    assert_int_equal(size, 1);
+    assert_int_equal(block[0], 0xbe);
+
+    divulge_hpack_encoder_set_max_table_size(&encoder, 64);
+    assert_int_equal(encoder.table.entry_count, 1);
+    size = divulge_hpack_encode(&encoder, "other-key", 9, "other-value", 11, block, sizeof(block));
+    assert_int_equal(block[0], 0x3f);
+    assert_int_equal(encoder.table.entry_count, 1);
+    assert_int_equal(encoder.table.size, 52);
+
+    divulge_hpack_encoder_set_max_table_size(&encoder, 0);
+    assert_int_equal(divulge_hpack_encode(&encoder, "other-key", 9, "other-value", 11, block, 1), 0);
+    assert_true(encoder.is_table_size_update_pending);
+}
+
+static void test_reject_malformed_blocks(void** state) {
+    static divulge_hpack_decoder_t decoder;
+    divulge_hpack_decoder_initialize(&decoder);
+    decoded_fields_t decoded = {.count = 0};
+
+    const uint8_t zero_index[] = {0x80};
+    assert_false(divulge_hpack_decode(&decoder, zero_index, sizeof(zero_index), collect_field, &decoded));
+    const uint8_t unknown_index[] = {0xbe};
+    assert_false(divulge_hpack_decode(&decoder, unknown_index, sizeof(unknown_index), collect_field, &decoded));
+    const uint8_t oversized_table[] = {0x3f, 0xe2, 0x1f};
+    assert_false(divulge_hpack_decode(&decoder, oversized_table, sizeof(oversized_table), collect_field, &decoded));
+    const uint8_t late_update[] = {0x82, 0x20};
+    assert_false(divulge_hpack_decode(&decoder, late_update, sizeof(late_update), collect_field, &decoded));
+    const uint8_t truncated_string[] = {0x04, 0x05, 'a', 'b'};
+    assert_false(divulge_hpack_decode(&decoder, truncated_string, sizeof(truncated_string), collect_field, &decoded));
+    const uint8_t endless_integer[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    assert_false(divulge_hpack_decode(&decoder, endless_integer, sizeof(endless_integer), collect_field, &decoded));
+}
+
+static void test_huffman_coding(void** state) {
+    uint8_t coded[32];
+    const uint8_t expected[] = {0xd0, 0x7a, 0xbe, 0x94, 0x10, 0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05,
+                                0x95, 0x04, 0x0b, 0x81, 0x66, 0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff};
+    const char* text = "Mon, 21 Oct 2013 20:13:21 GMT";
+    assert_int_equal(divulge_hpack_huffman_encoded_size(text, strlen(text)), sizeof(expected));
+    assert_int_equal(divulge_hpack_huffman_encode(text, strlen(text), coded, sizeof(coded)), sizeof(expected));
+    assert_memory_equal(coded, expected, sizeof(expected));
+    assert_int_equal(divulge_hpack_huffman_encode(text, strlen(text), coded, sizeof(expected) - 1), 0);
+
+    char decoded[32];
+    size_t decoded_size = 0;
+    assert_true(divulge_hpack_huffman_decode(expected, sizeof(expected), decoded, sizeof(decoded), &decoded_size));
+    assert_int_equal(decoded_size, strlen(text));
+    assert_memory_equal(decoded, text, decoded_size);
+    assert_false(divulge_hpack_huffman_decode(expected, sizeof(expected), decoded, 8, &decoded_size));
+
+    const uint8_t end_of_string[] = {0xff, 0xff, 0xff, 0xff};
+    assert_false(divulge_hpack_huffman_decode(end_of_string, 4, decoded, sizeof(decoded), &decoded_size));
+    const uint8_t long_padding[] = {0x1f, 0xff};
+    assert_false(divulge_hpack_huffman_decode(long_padding, 2, decoded, sizeof(decoded), &decoded_size));
+    const uint8_t zero_padding[] = {0x18};
+    assert_false(divulge_hpack_huffman_decode(zero_padding, 1, decoded, sizeof(decoded), &decoded_size));
+    const uint8_t one_padding[] = {0x1f};
+    assert_true(divulge_hpack_huffman_decode(one_padding, 1, decoded, sizeof(decoded), &decoded_size));
+    assert_int_equal(decoded_size, 1);
+    assert_int_equal(decoded[0], 'a');
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_decode_requests),
+        cmocka_unit_test(test_encode_requests),
+        cmocka_unit_test(test_encode_and_decode_response),
+        cmocka_unit_test(test_table_size_update),
+        cmocka_unit_test(test_reject_malformed_blocks),
+        cmocka_unit_test(test_huffman_coding),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-html-render.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+
+#define TEST_TEMPLATE "<p>[%name%]</p><i>[%count%]</i>"
+
+static size_t render_count;
+
+static size_t render_entry(void* ctx, const char* template_key, int index, char* buffer, size_t buffer_size) {
+    if (strcmp(template_key, "name") == 0) {
+        return (size_t)snprintf(buffer, buffer_size, "%s", (const char*)ctx);
+    }
+    return (size_t)snprintf(buffer, buffer_size, "%zu", (render_count++ == 0) ? (size_t)12345 : (size_t)7);
+}
+
+static bool respond_with_page(divulge_request_t* request, void* context) {
+    g2l_html_render_page_t* page = (g2l_html_render_page_t*)context;
+    divulge_header_entry_t header_entries[] = {{.key = "Cache-Control", .value = "no-store"}};
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.count = 1, .entries = header_entries},
+    };
+    divulge_html_render_mode_t mode =
+        request->url_query ? DIVULGE_HTML_RENDER_MODE_CONTENT_LENGTH : DIVULGE_HTML_RENDER_MODE_CHUNKED;
+    return divulge_html_render_respond(request, &response, page, mode);
+}
+
+static void process(divulge_t* divulge, test_connection_t* connection, const char* raw_request) {
+    render_count = 0;
+    test_connection_process(divulge, connection, raw_request);
+}
+
+static void test_render_page(void** state) {
+    char render_buffer[8];
+    g2l_html_render_page_configuration_t page_configuration = {
+        .html_template = TEST_TEMPLATE,
+        .render_buffer = render_buffer,
+        .render_buffer_size = sizeof(render_buffer),
+        .entry_callback = render_entry,
+        .ctx = "divulge",
+    };
+    g2l_html_render_page_t* page = g2l_html_render_create_page(&page_configuration);
+    assert_ptr_not_equal(page, NULL);
+    assert_int_equal(g2l_html_render_get_page_size(page), strlen("<p>divulge</p><i>12345</i>"));
+
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_uri_t uri = {
+        .uri = "/page",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = respond_with_page, .context = page},
+    };
+    divulge_register_uri(divulge, &uri);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /page HTTP/1.1\r\n\r\n");
+    assert_non_null(strstr(connection.output, "Cache-Control: no-store\r\n"));
+    assert_non_null(strstr(connection.output, "Content-Type: text/html\r\n"));
+    assert_non_null(strstr(connection.output, "Transfer-Encoding: chunked\r\n"));
+    assert_null(strstr(connection.output, "Content-Length"));
+    assert_non_null(strstr(connection.output,
+                           "\r\n\r\n3\r\n<p>\r\n7\r\ndivulge\r\n7\r\n</p><i>\r\n5\r\n12345\r\n4\r\n</i>\r\n0\r\n\r\n"));
+
+    process(divulge, &connection, "GET /page?length HTTP/1.1\r\n\r\n");
+    assert_null(strstr(connection.output, "Transfer-Encoding"));
+    assert_non_null(strstr(connection.output, "Content-Length: 26\r\n\r\n<p>divulge</p><i>7</i>    "));
+    assert_int_equal(strlen(strstr(connection.output, "\r\n\r\n")), 4 + 26);
+
+    process(divulge, &connection, "HEAD /page HTTP/1.1\r\n\r\n");
+    assert_non_null(strstr(connection.output, "Transfer-Encoding: chunked\r\n"));
+    assert_int_equal(strlen(strstr(connection.output, "\r\n\r\n")), 4);
+    assert_int_equal(render_count, 0);
+
+    g2l_html_render_destroy_page(page);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_render_page),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
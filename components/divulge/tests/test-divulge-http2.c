@@ -0,0 +1,370 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-hpack.h"
+#include "divulge-http2.h"
+
+#define TEST_MAX_FRAME_COUNT (16)
+#define TEST_OUTPUT_SIZE (4096)
+#define TEST_STREAM_BUFFER_SIZE (1024)
+
+#define FRAME_TYPE_DATA (0x0)
+#define FRAME_TYPE_HEADERS (0x1)
+#define FRAME_TYPE_RST_STREAM (0x3)
+#define FRAME_TYPE_SETTINGS (0x4)
+#define FRAME_TYPE_GOAWAY (0x7)
+#define FRAME_TYPE_WINDOW_UPDATE (0x8)
+#define FLAG_END_STREAM (0x1)
+#define FLAG_ACK (0x1)
+#define FLAG_END_HEADERS (0x4)
+
+typedef struct test_frame {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream_id;
+    const uint8_t* payload;
+    size_t length;
+} test_frame_t;
+
+typedef struct test_connection {
+    uint8_t output[TEST_OUTPUT_SIZE];
+    size_t output_size;
+    test_frame_t frames[TEST_MAX_FRAME_COUNT];
+    size_t frame_count;
+    char request[TEST_STREAM_BUFFER_SIZE + 1];
+    const char* response;
+    bool is_http1_required;
+} test_connection_t;
+
+static test_connection_t test_connection;
+
+static void mock_send(void* connection_context, const char* data, size_t data_size) {
+    test_connection_t* connection = connection_context;
+    assert_true((connection->output_size + data_size) <= TEST_OUTPUT_SIZE);
+    memcpy(connection->output + connection->output_size, data, data_size);
+    connection->output_size += data_size;
+}
+
+static size_t mock_receive(void* connection_context, char* data, size_t max_data_size) {
+    return 0;
+}
+
+static void mock_dispatch(void* context,
+                          divulge_http2_stream_t* stream,
+                          char* request,
+                          size_t request_size,
+                          size_t request_capacity) {
+    test_connection_t* connection = context;
+    assert_true(request_size <= request_capacity);
+    memcpy(connection->request, request, request_size + 1);
+    if (connection->is_http1_required) {
+        divulge_http2_stream_require_http1(stream);
+    } else {
+        assert_true(divulge_http2_stream_write(stream, connection->response, strlen(connection->response)));
+    }
+}
+
+static void split_frames(test_connection_t* connection) {
+    size_t position = 0;
+    while ((position + DIVULGE_HTTP2_FRAME_HEADER_SIZE) <= connection->output_size) {
+        assert_true(connection->frame_count < TEST_MAX_FRAME_COUNT);
+        const uint8_t* header = connection->output + position;
+        test_frame_t* frame = &connection->frames[connection->frame_count++];
+        frame->length = ((size_t)header[0] << 16) | ((size_t)header[1] << 8) | header[2];
+        frame->type = header[3];
+        frame->flags = header[4];
+        frame->stream_id = ((uint32_t)header[5] << 24) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 8) |
+                           (uint32_t)header[8];
+        frame->payload = header + DIVULGE_HTTP2_FRAME_HEADER_SIZE;
+        position += DIVULGE_HTTP2_FRAME_HEADER_SIZE + frame->length;
+    }
+    assert_int_equal(position, connection->output_size);
+}
+
+static const test_frame_t* find_frame(uint8_t type, uint32_t stream_id) {
+    for (size_t i = 0; i < test_connection.frame_count; i++) {
+        if ((test_connection.frames[i].type == type) && (test_connection.frames[i].stream_id == stream_id)) {
+            return &test_connection.frames[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t append_frame(uint8_t* data,
+                           uint8_t type,
+                           uint8_t flags,
+                           uint32_t stream_id,
+                           const void* payload,
+                           size_t length) {
+    uint8_t header[DIVULGE_HTTP2_FRAME_HEADER_SIZE] = {
+        (uint8_t)(length >> 16),     (uint8_t)(length >> 8),     (uint8_t)length,
+        type,                        flags,                      (uint8_t)(stream_id >> 24),
+        (uint8_t)(stream_id >> 16), (uint8_t)(stream_id >> 8), (uint8_t)stream_id,
+    };
+    memcpy(data, header, sizeof(header));
+    memcpy(data + sizeof(header), payload, length);
+    return sizeof(header) + length;
+}
+
+static void serve(const uint8_t* received, size_t received_size) {
+    divulge_http2_configuration_t configuration = {
+        .send = mock_send,
+        .receive = mock_receive,
+        .connection_context = &test_connection,
+        .max_concurrent_streams = 4,
+        .stream_buffer_size = TEST_STREAM_BUFFER_SIZE,
+        .dispatch = mock_dispatch,
+        .dispatch_context = &test_connection,
+    };
+    divulge_http2_connection_t* connection = divulge_http2_create(&configuration);
+    assert_non_null(connection);
+    divulge_http2_serve(connection, (const char*)received, received_size);
+    divulge_http2_destroy(connection);
+    split_frames(&test_connection);
+}
+
+static int setup(void** state) {
+    memset(&test_connection, 0, sizeof(test_connection));
+    test_connection.response =
+        "HTTP/1.1 200 OK\r\nServer: Divulge\r\nConnection: close\r\nContent-Length: 5\r\n\r\nHello";
+    return 0;
+}
+
+static size_t append_preface(uint8_t* data) {
+    memcpy(data, DIVULGE_HTTP2_PREFACE, strlen(DIVULGE_HTTP2_PREFACE));
+    size_t size = strlen(DIVULGE_HTTP2_PREFACE);
+    return size + append_frame(data + size, FRAME_TYPE_SETTINGS, 0, 0, NULL, 0);
+}
+
+/* :method GET, :scheme http, :path /, :authority www.example.com from RFC 7541 C.4.1 */
+static const uint8_t get_request_block[] = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                                            0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+
+typedef struct response_fields {
+    char status[8];
+    char content_length[8];
+    bool has_connection;
+} response_fields_t;
+
+static void collect_response_field(void* context,
+                                   const char* name,
+                                   size_t name_length,
+                                   const char* value,
+                                   size_t value_length) {
+    response_fields_t* fields = context;
+    if ((name_length == 7) && (memcmp(name, ":status", 7) == 0)) {
+        snprintf(fields->status, sizeof(fields->status), "%.*s", (int)value_length, value);
+    } else if ((name_length == 14) && (memcmp(name, "content-length", 14) == 0)) {
+        snprintf(fields->content_length, sizeof(fields->content_length), "%.*s", (int)value_length, value);
+    } else if ((name_length == 10) && (memcmp(name, "connection", 10) == 0)) {
+        fields->has_connection = true;
+    }
+}
+
+static void test_is_preface(void** state) {
+    assert_true(divulge_http2_is_preface(DIVULGE_HTTP2_PREFACE, strlen(DIVULGE_HTTP2_PREFACE)));
+    assert_true(divulge_http2_is_preface("PRI * HTTP/2.0\r\n", 16));
+    assert_false(divulge_http2_is_preface("GET / HTTP/1.1\r\n", 16));
+    assert_false(divulge_http2_is_preface("PRI", 3));
+    assert_false(divulge_http2_is_preface(NULL, 0));
+}
+
+static void test_create_with_invalid_configuration(void** state) {
+    divulge_http2_configuration_t configuration = {
+        .send = mock_send,
+        .receive = mock_receive,
+        .max_concurrent_streams = 0,
+        .stream_buffer_size = TEST_STREAM_BUFFER_SIZE,
+        .dispatch = mock_dispatch,
+    };
+    assert_null(divulge_http2_create(NULL));
+    assert_null(divulge_http2_create(&configuration));
+    configuration.max_concurrent_streams = 1;
+    configuration.dispatch = NULL;
+    assert_null(divulge_http2_create(&configuration));
+}
+
+static void test_get_request(void** state) {
+    uint8_t received[256];
+    size_t size = append_preface(received);
+    size += append_frame(received + size, FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM, 1,
+                         get_request_block, sizeof(get_request_block));
+    serve(received, size);
+
+    assert_string_equal(test_connection.request, "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n");
+    assert_int_equal(test_connection.frames[0].type, FRAME_TYPE_SETTINGS);
+    assert_int_equal(test_connection.frames[0].flags, 0);
+    bool is_acknowledged = false;
+    for (size_t i = 0; i < test_connection.frame_count; i++) {
+        is_acknowledged |= (test_connection.frames[i].type == FRAME_TYPE_SETTINGS) &&
+                           (test_connection.frames[i].flags == FLAG_ACK);
+    }
+    assert_true(is_acknowledged);
+
+    const test_frame_t* frame = find_frame(FRAME_TYPE_HEADERS, 1);
+    assert_non_null(frame);
+    assert_true(frame->flags & FLAG_END_HEADERS);
+    static divulge_hpack_decoder_t decoder;
+    divulge_hpack_decoder_initialize(&decoder);
+    response_fields_t fields = {0};
+    assert_true(divulge_hpack_decode(&decoder, frame->payload, frame->length, collect_response_field, &fields));
+    assert_string_equal(fields.status, "200");
+    assert_string_equal(fields.content_length, "5");
+    assert_false(fields.has_connection);
+
+    frame = find_frame(FRAME_TYPE_DATA, 1);
+    assert_non_null(frame);
+    assert_int_equal(frame->length, 5);
+    assert_memory_equal(frame->payload, "Hello", 5);
+    const test_frame_t* last = &test_connection.frames[test_connection.frame_count - 1];
+    assert_int_equal(last->type, FRAME_TYPE_GOAWAY);
+    bool is_stream_ended = false;
+    for (size_t i = 0; i < test_connection.frame_count; i++) {
+        is_stream_ended |= (test_connection.frames[i].stream_id == 1) &&
+                           (test_connection.frames[i].type == FRAME_TYPE_DATA) &&
+                           (test_connection.frames[i].flags & FLAG_END_STREAM);
+    }
+    assert_true(is_stream_ended);
+}
+
+static void test_post_request_with_body(void** state) {
+    /* :method POST, :scheme http, :path /, :authority www.example.com */
+    static const uint8_t block[] = {0x83, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                                    0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    uint8_t received[256];
+    size_t size = append_preface(received);
+    size += append_frame(received + size, FRAME_TYPE_HEADERS, FLAG_END_HEADERS, 1, block, sizeof(block));
+    size += append_frame(received + size, FRAME_TYPE_DATA, 0, 1, "a=1", 3);
+    size += append_frame(received + size, FRAME_TYPE_DATA, FLAG_END_STREAM, 1, "&b=2", 4);
+    serve(received, size);
+
+    assert_string_equal(test_connection.request,
+                        "POST / HTTP/1.1\r\nHost: www.example.com\r\nContent-Length: 7\r\n\r\na=1&b=2");
+    assert_non_null(find_frame(FRAME_TYPE_WINDOW_UPDATE, 0));
+    assert_non_null(find_frame(FRAME_TYPE_HEADERS, 1));
+}
+
+static void test_response_without_body(void** state) {
+    test_connection.response = "HTTP/1.1 204 No Content\r\nServer: Divulge\r\n\r\n";
+    uint8_t received[256];
+    size_t size = append_preface(received);
+    size += append_frame(received + size, FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM, 1,
+                         get_request_block, sizeof(get_request_block));
+    serve(received, size);
+
+    const test_frame_t* frame = find_frame(FRAME_TYPE_HEADERS, 1);
+    assert_non_null(frame);
+    assert_int_equal(frame->flags, FLAG_END_HEADERS | FLAG_END_STREAM);
+    assert_null(find_frame(FRAME_TYPE_DATA, 1));
+}
+
+static void test_http1_required(void** state) {
+    test_connection.is_http1_required = true;
+    uint8_t received[256];
+    size_t size = append_preface(received);
+    size += append_frame(received + size, FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM, 1,
+                         get_request_block, sizeof(get_request_block));
+    serve(received, size);
+
+    assert_null(find_frame(FRAME_TYPE_HEADERS, 1));
+    const test_frame_t* frame = find_frame(FRAME_TYPE_RST_STREAM, 1);
+    assert_non_null(frame);
+    assert_int_equal(frame->length, 4);
+    assert_int_equal(frame->payload[3], 0xd);
+}
+
+static void test_malformed_request_resets_stream(void** state) {
+    /* :method GET, :scheme http, :path /, literal "X-A: b" with an uppercase name */
+    static const uint8_t block[] = {0x82, 0x86, 0x84, 0x40, 0x03, 'X', '-', 'A', 0x01, 'b'};
+    uint8_t received[256];
+    size_t size = append_preface(received);
+    size += append_frame(received + size, FRAME_TYPE_HEADERS, FLAG_END_HEADERS | FLAG_END_STREAM, 1, block,
+                         sizeof(block));
+    serve(received, size);
+
+    assert_string_equal(test_connection.request, "");
+    const test_frame_t* frame = find_frame(FRAME_TYPE_RST_STREAM, 1);
+    assert_non_null(frame);
+    assert_int_equal(frame->payload[3], 0x1);
+}
+
+static void test_invalid_preface(void** state) {
+    static const char received[] = "PRI * HTTP/2.0\r\n\r\nXX\r\n\r\n";
+    serve((const uint8_t*)received, strlen(received));
+
+    assert_int_equal(test_connection.frame_count, 2);
+    const test_frame_t* frame = find_frame(FRAME_TYPE_GOAWAY, 0);
+    assert_non_null(frame);
+    assert_int_equal(frame->payload[7], 0x1);
+}
+
+static void test_upgrade(void** state) {
+    static const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    static const char settings[] = "AAMAAABkAAQAoAAAAAIAAAAA";
+    divulge_http2_configuration_t configuration = {
+        .send = mock_send,
+        .receive = mock_receive,
+        .connection_context = &test_connection,
+        .max_concurrent_streams = 4,
+        .stream_buffer_size = TEST_STREAM_BUFFER_SIZE,
+        .dispatch = mock_dispatch,
+        .dispatch_context = &test_connection,
+    };
+    divulge_http2_connection_t* connection = divulge_http2_create(&configuration);
+    assert_non_null(connection);
+    assert_false(divulge_http2_upgrade(connection, "A*B", 3, request, strlen(request)));
+    assert_true(divulge_http2_upgrade(connection, settings, strlen(settings), request, strlen(request)));
+    uint8_t received[64];
+    size_t size = append_preface(received);
+    divulge_http2_serve(connection, (const char*)received, size);
+    divulge_http2_destroy(connection);
+    split_frames(&test_connection);
+
+    assert_string_equal(test_connection.request, request);
+    assert_non_null(find_frame(FRAME_TYPE_HEADERS, 1));
+    assert_non_null(find_frame(FRAME_TYPE_DATA, 1));
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_is_preface),
+        cmocka_unit_test(test_create_with_invalid_configuration),
+        cmocka_unit_test_setup(test_get_request, setup),
+        cmocka_unit_test_setup(test_post_request_with_body, setup),
+        cmocka_unit_test_setup(test_response_without_body, setup),
+        cmocka_unit_test_setup(test_http1_required, setup),
+        cmocka_unit_test_setup(test_malformed_request_resets_stream, setup),
+        cmocka_unit_test_setup(test_invalid_preface, setup),
+        cmocka_unit_test_setup(test_upgrade, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-metrics.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+
+static uint64_t test_time_us;
+static uint64_t test_time_step_us;
+
+static uint64_t test_get_time_us(void) {
+    test_time_us += test_time_step_us;
+    return test_time_us;
+}
+
+static bool respond_with_text(divulge_request_t* request, void* context) {
+    const char* text = (const char*)context;
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = text,
+        .payload_size = strlen(text),
+    };
+    return divulge_respond(request, &response);
+}
+
+static void test_latency_buckets(void** state) {
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(0), 0);
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(23), 0);
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(24), 1);
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(31), 1);
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(32), 2);
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(48), 3);
+    assert_int_equal(divulge_metrics_get_latency_bucket_index(UINT64_MAX), DIVULGE_METRICS_LATENCY_BUCKET_COUNT - 1);
+    assert_int_equal(divulge_metrics_get_latency_bucket_bound_us(0), 24);
+    assert_int_equal(divulge_metrics_get_latency_bucket_bound_us(1), 32);
+    assert_int_equal(divulge_metrics_get_latency_bucket_bound_us(2), 48);
+    assert_int_equal(divulge_metrics_get_latency_bucket_bound_us(DIVULGE_METRICS_LATENCY_BUCKET_COUNT - 1), UINT64_MAX);
+    for (size_t i = 0; i < (DIVULGE_METRICS_LATENCY_BUCKET_COUNT - 1); i++) {
+        uint64_t bound_us = divulge_metrics_get_latency_bucket_bound_us(i);
+        assert_int_equal(divulge_metrics_get_latency_bucket_index(bound_us - 1), i);
+        assert_int_equal(divulge_metrics_get_latency_bucket_index(bound_us), i + 1);
+    }
+}
+
+static void test_metrics_endpoint(void** state) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.get_time_us = test_get_time_us;
+    configuration.metrics_uri = "/metrics";
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_uri_t uri = {
+        .uri = "/api/{id}",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = respond_with_text, .context = "hello"},
+    };
+    divulge_register_uri(divulge, &uri);
+    test_connection_t connection;
+    test_time_step_us = 20;
+    test_connection_process(divulge, &connection, "GET /api/1 HTTP/1.1\r\n\r\n");
+    size_t response_size = connection.output_size;
+    test_time_step_us = 1000;
+    test_connection_process(divulge, &connection, "GET /api/2 HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /missing HTTP/1.1\r\n\r\n");
+    test_time_step_us = 0;
+
+    test_connection_process(divulge, &connection, "GET /metrics HTTP/1.1\r\n\r\n");
+    assert_non_null(strstr(connection.output, "Content-Type: text/plain; version=0.0.4\r\n"));
+    assert_non_null(strstr(connection.output, "# TYPE divulge_requests_total counter\n"));
+    assert_non_null(strstr(connection.output, "# TYPE divulge_request_duration_seconds histogram\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_requests_total{method=\"GET\",route=\"/api/{id}\",code=\"2xx\"} 2\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_requests_total{method=\"GET\",route=\"/api/{id}\",code=\"4xx\"} 0\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_requests_total{method=\"ANY\",route=\"unmatched\",code=\"4xx\"} 1\n"));
+    char expected[128];
+    snprintf(expected, sizeof(expected), "divulge_response_bytes_total{method=\"GET\",route=\"/api/{id}\"} %zu\n",
+             response_size * 2);
+    assert_non_null(strstr(connection.output, expected));
+    assert_non_null(strstr(connection.output,
+                           "divulge_request_duration_seconds_bucket{method=\"GET\",route=\"/api/{id}\","
+                           "le=\"0.000024\"} 1\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_request_duration_seconds_bucket{method=\"GET\",route=\"/api/{id}\","
+                           "le=\"0.000768\"} 1\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_request_duration_seconds_bucket{method=\"GET\",route=\"/api/{id}\","
+                           "le=\"0.001024\"} 2\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_request_duration_seconds_bucket{method=\"GET\",route=\"/api/{id}\","
+                           "le=\"+Inf\"} 2\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_request_duration_seconds_sum{method=\"GET\",route=\"/api/{id}\"} 0.001020\n"));
+    assert_non_null(strstr(connection.output,
+                           "divulge_request_duration_seconds_count{method=\"GET\",route=\"/api/{id}\"} 2\n"));
+    assert_null(strstr(strstr(connection.output, "divulge_request_duration_seconds"), "divulge_requests_total{"));
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_latency_buckets),
+        cmocka_unit_test(test_metrics_endpoint),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
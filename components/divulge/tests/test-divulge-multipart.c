@@ -0,0 +1,262 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-multipart.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+
+#define TEST_BOUNDARY "XyZ-42"
+
+typedef struct test_log {
+    char text[TEST_BUFFER_SIZE];
+    size_t size;
+    size_t abort_after_size;
+} test_log_t;
+
+static const char test_body[] =
+    "preamble to be ignored\r\n"
+    "--" TEST_BOUNDARY "\r\n"
+    "Content-Disposition: form-data; name=\"note\"\r\n"
+    "\r\n"
+    "line\r\n-- not a boundary\r\n--XyZ-4 almost\r\r\n--" TEST_BOUNDARY "\r\n"
+    "content-disposition: form-data; name=\"firmware\"; filename=\"image.bin\"\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "\r\n"
+    "\x01\x02\r\n\x03"
+    "\r\n--" TEST_BOUNDARY "--\r\n"
+    "epilogue to be ignored";
+
+static const char test_log_text[] =
+    "[note||]line\r\n-- not a boundary\r\n--XyZ-4 almost\r[end]"
+    "[firmware|image.bin|application/octet-stream]\x01\x02\r\n\x03[end]";
+
+static void append_log(test_log_t* log, const char* text, size_t size) {
+    assert_true((log->size + size) < sizeof(log->text));
+    memcpy(log->text + log->size, text, size);
+    log->size += size;
+    log->text[log->size] = '\0';
+}
+
+static bool handle_part_begin(divulge_request_t* request, const divulge_multipart_part_t* part, void* context) {
+    test_log_t* log = (test_log_t*)context;
+    char text[200];
+    assert_int_equal(strlen(part->name.text), part->name.length);
+    assert_int_equal(strlen(part->file_name.text), part->file_name.length);
+    assert_int_equal(strlen(part->content_type.text), part->content_type.length);
+    snprintf(text, sizeof(text), "[%s|%s|%s]", part->name.text, part->file_name.text, part->content_type.text);
+    append_log(log, text, strlen(text));
+    return true;
+}
+
+static bool handle_part_data(divulge_request_t* request,
+                             const divulge_multipart_part_t* part,
+                             const char* data,
+                             size_t data_size,
+                             void* context) {
+    test_log_t* log = (test_log_t*)context;
+    assert_true(data_size > 0);
+    append_log(log, data, data_size);
+    return (log->abort_after_size == 0) || (log->size < log->abort_after_size);
+}
+
+static bool handle_part_end(divulge_request_t* request, const divulge_multipart_part_t* part, void* context) {
+    append_log((test_log_t*)context, "[end]", 5);
+    return true;
+}
+
+static divulge_multipart_handlers_t create_handlers(test_log_t* log) {
+    memset(log, 0, sizeof(*log));
+    return (divulge_multipart_handlers_t){
+        .part_begin = handle_part_begin,
+        .part_data = handle_part_data,
+        .part_end = handle_part_end,
+        .context = log,
+    };
+}
+
+static divulge_multipart_parser_status_t parse(const char* body, size_t body_size, size_t piece_size, test_log_t* log) {
+    divulge_multipart_handlers_t handlers = create_handlers(log);
+    divulge_multipart_parser_t parser;
+    assert_true(divulge_multipart_parser_reset(&parser, static_string_create(TEST_BOUNDARY), &handlers, NULL));
+    divulge_multipart_parser_status_t status = DIVULGE_MULTIPART_PARSER_STATUS_INCOMPLETE;
+    for (size_t i = 0; (i < body_size) && (status == DIVULGE_MULTIPART_PARSER_STATUS_INCOMPLETE); i += piece_size) {
+        size_t size = ((body_size - i) < piece_size) ? (body_size - i) : piece_size;
+        status = divulge_multipart_parser_execute(&parser, body + i, size);
+    }
+    return status;
+}
+
+static void test_get_boundary(void** state) {
+    static_string_t boundary;
+    assert_true(divulge_multipart_get_boundary(static_string_create("multipart/form-data; boundary=abc"), &boundary));
+    assert_int_equal(boundary.length, 3);
+    assert_memory_equal(boundary.text, "abc", 3);
+    assert_true(divulge_multipart_get_boundary(
+        static_string_create("Multipart/Form-Data; charset=utf-8; Boundary=\"a b:c\""), &boundary));
+    assert_int_equal(boundary.length, 5);
+    assert_memory_equal(boundary.text, "a b:c", 5);
+    assert_false(divulge_multipart_get_boundary(static_string_create("multipart/mixed; boundary=abc"), &boundary));
+    assert_false(divulge_multipart_get_boundary(static_string_create("multipart/form-data"), &boundary));
+    assert_false(divulge_multipart_get_boundary(static_string_create("multipart/form-data; boundary="), &boundary));
+    assert_false(divulge_multipart_get_boundary(static_string_create("multipart/form-data; boundary=a\rb"), &boundary));
+    assert_false(divulge_multipart_get_boundary(
+        static_string_create("multipart/form-data; boundary="
+                             "0123456789012345678901234567890123456789012345678901234567890123456789X"),
+        &boundary));
+}
+
+static void test_parse_in_pieces(void** state) {
+    test_log_t log;
+    for (size_t piece_size = 1; piece_size <= sizeof(test_body); piece_size++) {
+        assert_int_equal(parse(test_body, sizeof(test_body) - 1, piece_size, &log),
+                         DIVULGE_MULTIPART_PARSER_STATUS_COMPLETE);
+        assert_int_equal(log.size, sizeof(test_log_text) - 1);
+        assert_memory_equal(log.text, test_log_text, log.size);
+    }
+}
+
+static void test_parse_split_at_every_position(void** state) {
+    size_t body_size = sizeof(test_body) - 1;
+    for (size_t split = 0; split <= body_size; split++) {
+        test_log_t log;
+        divulge_multipart_handlers_t handlers = create_handlers(&log);
+        divulge_multipart_parser_t parser;
+        assert_true(divulge_multipart_parser_reset(&parser, static_string_create(TEST_BOUNDARY), &handlers, NULL));
+        divulge_multipart_parser_execute(&parser, test_body, split);
+        assert_int_equal(divulge_multipart_parser_execute(&parser, test_body + split, body_size - split),
+                         DIVULGE_MULTIPART_PARSER_STATUS_COMPLETE);
+        assert_memory_equal(log.text, test_log_text, sizeof(test_log_text) - 1);
+    }
+}
+
+static void test_parse_errors(void** state) {
+    test_log_t log;
+    const char* missing_disposition = "--" TEST_BOUNDARY "\r\nContent-Type: text/plain\r\n\r\ndata";
+    assert_int_equal(parse(missing_disposition, strlen(missing_disposition), 4, &log),
+                     DIVULGE_MULTIPART_PARSER_STATUS_ERROR);
+    const char* garbage = "--" TEST_BOUNDARY "x\r\n";
+    assert_int_equal(parse(garbage, strlen(garbage), 4, &log), DIVULGE_MULTIPART_PARSER_STATUS_ERROR);
+    const char* unterminated = "--" TEST_BOUNDARY "\r\nContent-Disposition: form-data; name=a\r\n\r\ndata";
+    assert_int_equal(parse(unterminated, strlen(unterminated), 4, &log), DIVULGE_MULTIPART_PARSER_STATUS_INCOMPLETE);
+    assert_string_equal(log.text, "[a||]data");
+
+    char oversized[DIVULGE_MULTIPART_HEADERS_MAX_SIZE + 100];
+    int size = snprintf(oversized, sizeof(oversized), "--%s\r\nContent-Disposition: form-data; name=\"", TEST_BOUNDARY);
+    memset(oversized + size, 'a', sizeof(oversized) - size);
+    assert_int_equal(parse(oversized, sizeof(oversized), 16, &log), DIVULGE_MULTIPART_PARSER_STATUS_ERROR);
+    assert_int_equal(log.size, 0);
+
+    divulge_multipart_parser_t parser;
+    divulge_multipart_handlers_t handlers = create_handlers(&log);
+    assert_false(divulge_multipart_parser_reset(&parser, static_string_create(""), &handlers, NULL));
+    assert_false(divulge_multipart_parser_reset(&parser, static_string_create("a\r\n"), &handlers, NULL));
+}
+
+static void test_parse_aborted(void** state) {
+    test_log_t log;
+    divulge_multipart_handlers_t handlers = create_handlers(&log);
+    log.abort_after_size = 10;
+    divulge_multipart_parser_t parser;
+    assert_true(divulge_multipart_parser_reset(&parser, static_string_create(TEST_BOUNDARY), &handlers, NULL));
+    assert_int_equal(divulge_multipart_parser_execute(&parser, test_body, sizeof(test_body) - 1),
+                     DIVULGE_MULTIPART_PARSER_STATUS_ABORTED);
+    assert_int_equal(divulge_multipart_parser_execute(&parser, test_body, sizeof(test_body) - 1),
+                     DIVULGE_MULTIPART_PARSER_STATUS_ABORTED);
+    assert_string_equal(log.text, "[note||]line");
+}
+
+static bool handle_upload(divulge_request_t* request, void* context) {
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = "stored",
+        .payload_size = 6,
+    };
+    return divulge_respond(request, &response);
+}
+
+static void serve(divulge_t* divulge, test_connection_t* connection, const char* request) {
+    test_connection_reset(connection, request);
+    connection->input_chunk_size = 7;
+    test_connection_serve(divulge, connection);
+}
+
+static void test_middleware(void** state) {
+    test_log_t log;
+    divulge_multipart_handlers_t handlers = create_handlers(&log);
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_uri_t uri = {
+        .uri = "/upload",
+        .method = DIVULGE_ROUTE_METHOD_POST,
+        .handler = {.handler = handle_upload},
+    };
+    divulge_handler_object_t* middleware = divulge_multipart_create(&handlers);
+    assert_ptr_not_equal(middleware, NULL);
+    divulge_register_uri(divulge, &uri);
+    divulge_add_middleware_to_uri(divulge, &uri, middleware);
+
+    char request[TEST_BUFFER_SIZE];
+    test_connection_t connection;
+    snprintf(request, sizeof(request),
+             "POST /upload HTTP/1.1\r\nContent-Type: multipart/form-data; boundary=" TEST_BOUNDARY
+             "\r\nContent-Length: %zu\r\n\r\n%s",
+             sizeof(test_body) - 1, test_body);
+    serve(divulge, &connection, request);
+    assert_ptr_not_equal(strstr(connection.output, "HTTP/1.1 200 OK\r\n"), NULL);
+    assert_ptr_not_equal(strstr(connection.output, "\r\n\r\nstored"), NULL);
+    assert_memory_equal(log.text, test_log_text, sizeof(test_log_text) - 1);
+
+    serve(divulge, &connection, "POST /upload HTTP/1.1\r\nContent-Type: text/plain\r\nContent-Length: 4\r\n\r\ntext");
+    assert_ptr_not_equal(strstr(connection.output, "HTTP/1.1 415 Unsupported Media Type\r\n"), NULL);
+
+    memset(&log, 0, sizeof(log));
+    snprintf(request, sizeof(request),
+             "POST /upload HTTP/1.1\r\nContent-Type: multipart/form-data; boundary=" TEST_BOUNDARY
+             "\r\nContent-Length: %d\r\n\r\n%.*s",
+             60, 60, test_body);
+    serve(divulge, &connection, request);
+    assert_ptr_not_equal(strstr(connection.output, "HTTP/1.1 400 Bad Request\r\n"), NULL);
+    assert_ptr_equal(strstr(connection.output, "stored"), NULL);
+    divulge_multipart_destroy(middleware);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_get_boundary),
+        cmocka_unit_test(test_parse_in_pieces),
+        cmocka_unit_test(test_parse_split_at_every_position),
+        cmocka_unit_test(test_parse_errors),
+        cmocka_unit_test(test_parse_aborted),
+        cmocka_unit_test(test_middleware),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-range.h"
+
+#define TEST_CONTENT_SIZE (1000)
+
+static divulge_range_status_t parse(const char* value, divulge_range_t* ranges, size_t* range_count) {
+    return divulge_range_parse(static_string_create(value), TEST_CONTENT_SIZE, ranges, DIVULGE_RANGE_MAX_COUNT,
+                               range_count);
+}
+
+static void test_single_ranges(void** state) {
+    divulge_range_t ranges[DIVULGE_RANGE_MAX_COUNT];
+    size_t range_count = 0;
+
+    assert_int_equal(parse("bytes=0-499", ranges, &range_count), DIVULGE_RANGE_STATUS_SATISFIABLE);
+    assert_int_equal(range_count, 1);
+    assert_int_equal(ranges[0].offset, 0);
+    assert_int_equal(ranges[0].size, 500);
+
+    assert_int_equal(parse("bytes=900-", ranges, &range_count), DIVULGE_RANGE_STATUS_SATISFIABLE);
+    assert_int_equal(ranges[0].offset, 900);
+    assert_int_equal(ranges[0].size, 100);
+
+    assert_int_equal(parse("bytes=-10", ranges, &range_count), DIVULGE_RANGE_STATUS_SATISFIABLE);
+    assert_int_equal(ranges[0].offset, 990);
+    assert_int_equal(ranges[0].size, 10);
+
+    assert_int_equal(parse("bytes=-5000", ranges, &range_count), DIVULGE_RANGE_STATUS_SATISFIABLE);
+    assert_int_equal(ranges[0].offset, 0);
+    assert_int_equal(ranges[0].size, TEST_CONTENT_SIZE);
+
+    assert_int_equal(parse("bytes=990-5000", ranges, &range_count), DIVULGE_RANGE_STATUS_SATISFIABLE);
+    assert_int_equal(ranges[0].offset, 990);
+    assert_int_equal(ranges[0].size, 10);
+}
+
+static void test_multiple_ranges(void** state) {
+    divulge_range_t ranges[DIVULGE_RANGE_MAX_COUNT];
+    size_t range_count = 0;
+
+    assert_int_equal(parse("bytes=0-0, 2000-3000,-1 ,10-19", ranges, &range_count), DIVULGE_RANGE_STATUS_SATISFIABLE);
+    assert_int_equal(range_count, 3);
+    assert_int_equal(ranges[0].offset, 0);
+    assert_int_equal(ranges[0].size, 1);
+    assert_int_equal(ranges[1].offset, 999);
+    assert_int_equal(ranges[1].size, 1);
+    assert_int_equal(ranges[2].offset, 10);
+    assert_int_equal(ranges[2].size, 10);
+
+    assert_int_equal(parse("bytes=0-0,1-1,2-2,3-3,4-4,5-5,6-6,7-7,8-8", ranges, &range_count),
+                     DIVULGE_RANGE_STATUS_IGNORED);
+}
+
+static void test_unsatisfiable_ranges(void** state) {
+    divulge_range_t ranges[DIVULGE_RANGE_MAX_COUNT];
+    size_t range_count = 0;
+
+    assert_int_equal(parse("bytes=1000-", ranges, &range_count), DIVULGE_RANGE_STATUS_UNSATISFIABLE);
+    assert_int_equal(parse("bytes=-0", ranges, &range_count), DIVULGE_RANGE_STATUS_UNSATISFIABLE);
+    assert_int_equal(parse("bytes=2000-2100,1000-1001", ranges, &range_count), DIVULGE_RANGE_STATUS_UNSATISFIABLE);
+    assert_int_equal(parse("bytes=99999999999999999999999-", ranges, &range_count),
+                     DIVULGE_RANGE_STATUS_UNSATISFIABLE);
+    assert_int_equal(divulge_range_parse(static_string_create("bytes=0-"), 0, ranges, DIVULGE_RANGE_MAX_COUNT,
+                                         &range_count),
+                     DIVULGE_RANGE_STATUS_UNSATISFIABLE);
+}
+
+static void test_ignored_ranges(void** state) {
+    divulge_range_t ranges[DIVULGE_RANGE_MAX_COUNT];
+    size_t range_count = 0;
+
+    assert_int_equal(parse("bytes=5-2", ranges, &range_count), DIVULGE_RANGE_STATUS_IGNORED);
+    assert_int_equal(parse("items=0-1", ranges, &range_count), DIVULGE_RANGE_STATUS_IGNORED);
+    assert_int_equal(parse("bytes=", ranges, &range_count), DIVULGE_RANGE_STATUS_IGNORED);
+    assert_int_equal(parse("bytes=-", ranges, &range_count), DIVULGE_RANGE_STATUS_IGNORED);
+    assert_int_equal(parse("bytes=a-1", ranges, &range_count), DIVULGE_RANGE_STATUS_IGNORED);
+    assert_int_equal(parse("bytes=0-1;2-3", ranges, &range_count), DIVULGE_RANGE_STATUS_IGNORED);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_single_ranges),
+        cmocka_unit_test(test_multiple_ranges),
+        cmocka_unit_test(test_unsatisfiable_ranges),
+        cmocka_unit_test(test_ignored_ranges),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,142 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-request-parser.h"
+
+static const char* test_request =
+    "POST /api/devices?limit=10&offset=5 HTTP/1.1\r\n"
+    "Host: localhost:5000\r\n"
+    "Content-Type:application/json\r\n"
+    "X-Padded:   value with spaces  \r\n"
+    "X-Empty:\r\n"
+    "\r\n"
+    "{\"name\":\"sensor\"}";
+
+static void assert_span_equal(const char* buffer, divulge_request_span_t span, const char* expected) {
+    assert_int_equal(span.length, strlen(expected));
+    assert_memory_equal(buffer + span.offset, expected, span.length);
+}
+
+static void assert_test_request_parsed(const divulge_request_parser_t* parser) {
+    assert_span_equal(test_request, parser->method, "POST");
+    assert_span_equal(test_request, parser->path, "/api/devices");
+    assert_true(parser->has_query);
+    assert_span_equal(test_request, parser->query, "limit=10&offset=5");
+    assert_span_equal(test_request, parser->version, "HTTP/1.1");
+    assert_int_equal(parser->header_count, 4);
+    assert_span_equal(test_request, parser->headers[0].name, "Host");
+    assert_span_equal(test_request, parser->headers[0].value, "localhost:5000");
+    assert_span_equal(test_request, parser->headers[1].name, "Content-Type");
+    assert_span_equal(test_request, parser->headers[1].value, "application/json");
+    assert_span_equal(test_request, parser->headers[2].name, "X-Padded");
+    assert_span_equal(test_request, parser->headers[2].value, "value with spaces");
+    assert_span_equal(test_request, parser->headers[3].name, "X-Empty");
+    assert_int_equal(parser->headers[3].value.length, 0);
+    assert_string_equal(test_request + parser->head_size, "{\"name\":\"sensor\"}");
+}
+
+static void test_parse_complete_request(void** state) {
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    assert_int_equal(divulge_request_parser_execute(&parser, test_request, strlen(test_request)),
+                     DIVULGE_REQUEST_PARSER_STATUS_COMPLETE);
+    assert_test_request_parsed(&parser);
+}
+
+static void test_parse_request_byte_by_byte(void** state) {
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    size_t head_size = (size_t)(strstr(test_request, "\r\n\r\n") - test_request) + 4;
+    for (size_t size = 1; size < head_size; size++) {
+        assert_int_equal(divulge_request_parser_execute(&parser, test_request, size),
+                         DIVULGE_REQUEST_PARSER_STATUS_INCOMPLETE);
+    }
+    assert_int_equal(divulge_request_parser_execute(&parser, test_request, head_size),
+                     DIVULGE_REQUEST_PARSER_STATUS_COMPLETE);
+    assert_test_request_parsed(&parser);
+}
+
+static void test_parse_request_without_query(void** state) {
+    const char* request = "GET / HTTP/1.0\n\n";
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    assert_int_equal(divulge_request_parser_execute(&parser, request, strlen(request)),
+                     DIVULGE_REQUEST_PARSER_STATUS_COMPLETE);
+    assert_span_equal(request, parser.method, "GET");
+    assert_span_equal(request, parser.path, "/");
+    assert_false(parser.has_query);
+    assert_int_equal(parser.header_count, 0);
+    assert_int_equal(parser.head_size, strlen(request));
+}
+
+static void assert_malformed(const char* request) {
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    assert_int_equal(divulge_request_parser_execute(&parser, request, strlen(request)),
+                     DIVULGE_REQUEST_PARSER_STATUS_ERROR);
+}
+
+static void test_parse_malformed_requests(void** state) {
+    assert_malformed(" / HTTP/1.1\r\n\r\n");
+    assert_malformed("GET index.html HTTP/1.1\r\n\r\n");
+    assert_malformed("GET / HTTP/2.0\r\n\r\n");
+    assert_malformed("GET / HTTP/1.1 extra\r\n\r\n");
+    assert_malformed("GET /\x01 HTTP/1.1\r\n\r\n");
+    assert_malformed("GET / HTTP/1.1\r\nNo-Colon\r\n\r\n");
+    assert_malformed("GET / HTTP/1.1\r\nBad Name: x\r\n\r\n");
+    assert_malformed("GET / HTTP/1.1\r\nFolded: x\r\n continued\r\n\r\n");
+    assert_malformed("GET / HTTP/1.1\r\rHost: x\r\n\r\n");
+    assert_malformed("VERYLONGMETHODNAME / HTTP/1.1\r\n\r\n");
+}
+
+static void test_parse_too_many_headers(void** state) {
+    char request[2048] = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= DIVULGE_REQUEST_PARSER_HEADERS_MAX_COUNT; i++) {
+        strcat(request, "X-Header: value\r\n");
+    }
+    strcat(request, "\r\n");
+    divulge_request_parser_t parser;
+    divulge_request_parser_reset(&parser);
+    assert_int_equal(divulge_request_parser_execute(&parser, request, strlen(request)),
+                     DIVULGE_REQUEST_PARSER_STATUS_TOO_MANY_HEADERS);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_parse_complete_request),
+        cmocka_unit_test(test_parse_request_byte_by_byte),
+        cmocka_unit_test(test_parse_request_without_query),
+        cmocka_unit_test(test_parse_malformed_requests),
+        cmocka_unit_test(test_parse_too_many_headers),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
\ No newline at end of file
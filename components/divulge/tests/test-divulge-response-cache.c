@@ -0,0 +1,322 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-response-cache.h"
+#include "divulge-test-connection.h"
+#include "divulge-url-query.h"
+#include "divulge.h"
+
+#define TEST_REQUEST_ARENA_SIZE (256)
+
+typedef struct test_handler_context {
+    const char* payload;
+    int return_code;
+    const char* header_key;
+    const char* header_value;
+    size_t call_count;
+} test_handler_context_t;
+
+typedef struct g2l_mutex g2l_mutex_t;
+
+static int test_mutex;
+
+g2l_mutex_t* __wrap_g2l_mutex_create(void) {
+    return (g2l_mutex_t*)&test_mutex;
+}
+
+void __wrap_g2l_mutex_destroy(g2l_mutex_t* mutex) {}
+
+void __wrap_g2l_mutex_lock(g2l_mutex_t* mutex) {
+    assert_int_equal(test_mutex, 0);
+    test_mutex = 1;
+}
+
+void __wrap_g2l_mutex_unlock(g2l_mutex_t* mutex) {
+    assert_int_equal(test_mutex, 1);
+    test_mutex = 0;
+}
+
+static bool respond_with_context(divulge_request_t* request, void* context) {
+    test_handler_context_t* handler_context = (test_handler_context_t*)context;
+    handler_context->call_count++;
+    divulge_url_query_t query = divulge_url_query_create_from_request(request);
+    for (size_t i = 0; i < query.parameter_count; i++) {
+        divulge_url_query_get_value(&query, i);
+    }
+    divulge_header_entry_t header_entries[] = {
+        {.key = "Content-Type", .value = "text/plain"},
+        {.key = handler_context->header_key, .value = handler_context->header_value},
+    };
+    divulge_response_t response = {
+        .return_code = handler_context->return_code,
+        .header = {.count = handler_context->header_key ? 2 : 1, .entries = header_entries},
+        .payload = handler_context->payload,
+        .payload_size = strlen(handler_context->payload),
+    };
+    return divulge_respond(request, &response);
+}
+
+static divulge_t* create_router(divulge_response_cache_t* cache, test_handler_context_t* context) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.request_arena_size = TEST_REQUEST_ARENA_SIZE;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    divulge_route_method_t methods[] = {DIVULGE_ROUTE_METHOD_GET, DIVULGE_ROUTE_METHOD_POST};
+    for (size_t i = 0; i < (sizeof(methods) / sizeof(methods[0])); i++) {
+        divulge_uri_t uri = {
+            .uri = "/{page}",
+            .method = methods[i],
+            .handler = {.handler = respond_with_context, .context = context},
+        };
+        divulge_register_uri(divulge, &uri);
+        divulge_add_middleware_to_uri(divulge, &uri, divulge_response_cache_get_middleware(cache));
+    }
+    return divulge;
+}
+
+static void get_etag(test_connection_t* connection, char* etag, size_t etag_size) {
+    const char* value = strstr(connection->output, "ETag: ");
+    assert_ptr_not_equal(value, NULL);
+    value += strlen("ETag: ");
+    size_t length = (size_t)(strstr(value, "\r\n") - value);
+    assert_true(length < etag_size);
+    memcpy(etag, value, length);
+    etag[length] = '\0';
+}
+
+static void test_cache_hit(void** state) {
+    test_handler_context_t context = {.payload = "dashboard", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(4, 64);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+    char etag[32];
+    char cached_etag[32];
+
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 1);
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "Content-Type: text/plain\r\n"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\ndashboard"));
+    get_etag(&connection, etag, sizeof(etag));
+    assert_int_equal(strlen(etag), 18);
+    assert_int_equal(etag[0], '"');
+
+    context.payload = "changed";
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 1);
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "Content-Type: text/plain\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 9\r\n"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\ndashboard"));
+    get_etag(&connection, cached_etag, sizeof(cached_etag));
+    assert_string_equal(etag, cached_etag);
+
+    test_connection_process(divulge, &connection, "GET /index?page=2 HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 2);
+    assert_true(test_connection_contains(&connection, "\r\n\r\nchanged"));
+
+    test_connection_process(divulge, &connection, "POST /index HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 3);
+    assert_false(test_connection_contains(&connection, "ETag"));
+    divulge_response_cache_destroy(cache);
+}
+
+static void test_decoded_query_keeps_key(void** state) {
+    test_handler_context_t context = {.payload = "both", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(4, 64);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /x?a=1&b=2 HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 1);
+
+    context.payload = "first";
+    test_connection_process(divulge, &connection, "GET /x?a HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 2);
+    assert_true(test_connection_contains(&connection, "\r\n\r\nfirst"));
+
+    test_connection_process(divulge, &connection, "GET /x?a=1&b=2 HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 2);
+    assert_true(test_connection_contains(&connection, "\r\n\r\nboth"));
+    divulge_response_cache_destroy(cache);
+}
+
+static void test_conditional_get(void** state) {
+    test_handler_context_t context = {.payload = "dashboard", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(4, 64);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+    char etag[32];
+    char request[TEST_BUFFER_SIZE];
+
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    get_etag(&connection, etag, sizeof(etag));
+
+    snprintf(request, sizeof(request), "GET /index HTTP/1.1\r\nIf-None-Match: %s\r\n\r\n", etag);
+    test_connection_process(divulge, &connection, request);
+    assert_int_equal(context.call_count, 1);
+    assert_true(test_connection_contains(&connection, "304 Not Modified"));
+    assert_true(test_connection_contains(&connection, etag));
+    assert_false(test_connection_contains(&connection, "Content-Length"));
+    assert_false(test_connection_contains(&connection, "dashboard"));
+
+    snprintf(request, sizeof(request), "GET /index HTTP/1.1\r\nIf-None-Match: \"other\", W/%s\r\n\r\n", etag);
+    test_connection_process(divulge, &connection, request);
+    assert_true(test_connection_contains(&connection, "304 Not Modified"));
+
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\nIf-None-Match: \"other\"\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\ndashboard"));
+
+    divulge_response_cache_invalidate_all(cache);
+    snprintf(request, sizeof(request), "GET /index HTTP/1.1\r\nIf-None-Match: %s\r\n\r\n", etag);
+    test_connection_process(divulge, &connection, request);
+    assert_int_equal(context.call_count, 2);
+    assert_true(test_connection_contains(&connection, "304 Not Modified"));
+    divulge_response_cache_destroy(cache);
+}
+
+static void test_invalidation(void** state) {
+    test_handler_context_t context = {.payload = "first", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(4, 64);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /index?verbose HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /indexes HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 3);
+
+    context.payload = "second";
+    divulge_response_cache_invalidate(cache, "/index");
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nsecond"));
+    test_connection_process(divulge, &connection, "GET /index?verbose HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nsecond"));
+    test_connection_process(divulge, &connection, "GET /indexes HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nfirst"));
+    assert_int_equal(context.call_count, 5);
+    divulge_response_cache_destroy(cache);
+}
+
+static void test_eviction_and_limits(void** state) {
+    test_handler_context_t context = {.payload = "page", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(2, 8);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /a HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /b HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /a HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /c HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 3);
+    test_connection_process(divulge, &connection, "GET /a HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 3);
+    test_connection_process(divulge, &connection, "GET /b HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 4);
+
+    context.payload = "too large page";
+    test_connection_process(divulge, &connection, "GET /d HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /d HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 6);
+    assert_false(test_connection_contains(&connection, "ETag"));
+
+    context.payload = "error";
+    context.return_code = 500;
+    test_connection_process(divulge, &connection, "GET /e HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /e HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 8);
+    assert_true(test_connection_contains(&connection, "500"));
+    divulge_response_cache_destroy(cache);
+}
+
+static void test_uncacheable_responses(void** state) {
+    static const divulge_header_entry_t uncacheable_headers[] = {
+        {.key = "Set-Cookie", .value = "session=1"},
+        {.key = "Vary", .value = "Accept-Language"},
+        {.key = "content-encoding", .value = "gzip"},
+        {.key = "Cache-Control", .value = "No-Store"},
+        {.key = "Cache-Control", .value = "max-age=60, private=\"Set-Cookie\""},
+    };
+    test_handler_context_t context = {.payload = "page", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(4, 64);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+
+    for (size_t i = 0; i < (sizeof(uncacheable_headers) / sizeof(uncacheable_headers[0])); i++) {
+        context.header_key = uncacheable_headers[i].key;
+        context.header_value = uncacheable_headers[i].value;
+        test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+        test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+        assert_int_equal(context.call_count, (i + 1) * 2);
+        assert_false(test_connection_contains(&connection, "ETag"));
+    }
+
+    context.header_key = "Cache-Control";
+    context.header_value = "max-age=60";
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 11);
+    assert_true(test_connection_contains(&connection, "ETag"));
+    divulge_response_cache_destroy(cache);
+}
+
+static void test_authorized_request_bypasses_cache(void** state) {
+    test_handler_context_t context = {.payload = "public", .return_code = 200};
+    divulge_response_cache_t* cache = divulge_response_cache_create(4, 64);
+    divulge_t* divulge = create_router(cache, &context);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    context.payload = "private";
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\nAuthorization: Basic dXNlcg==\r\n\r\n");
+    assert_int_equal(context.call_count, 2);
+    assert_true(test_connection_contains(&connection, "\r\n\r\nprivate"));
+    assert_false(test_connection_contains(&connection, "ETag"));
+
+    test_connection_process(divulge, &connection, "GET /index HTTP/1.1\r\n\r\n");
+    assert_int_equal(context.call_count, 2);
+    assert_true(test_connection_contains(&connection, "\r\n\r\npublic"));
+    divulge_response_cache_destroy(cache);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_cache_hit),
+        cmocka_unit_test(test_decoded_query_keeps_key),
+        cmocka_unit_test(test_conditional_get),
+        cmocka_unit_test(test_invalidation),
+        cmocka_unit_test(test_eviction_and_limits),
+        cmocka_unit_test(test_uncacheable_responses),
+        cmocka_unit_test(test_authorized_request_bypasses_cache),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
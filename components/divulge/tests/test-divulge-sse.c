@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-sse.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+
+#define TEST_MUTEXES_MAX_COUNT (8)
+
+typedef struct g2l_mutex g2l_mutex_t;
+
+static int test_mutexes[TEST_MUTEXES_MAX_COUNT];
+static size_t test_mutex_count;
+static int* test_sse_mutex;
+static divulge_sse_t* test_sse;
+static divulge_sse_stream_t* retained_stream;
+static size_t open_count;
+static size_t close_count;
+
+g2l_mutex_t* __wrap_g2l_mutex_create(void) {
+    assert_true(test_mutex_count < TEST_MUTEXES_MAX_COUNT);
+    return (g2l_mutex_t*)(test_mutexes + test_mutex_count++);
+}
+
+void __wrap_g2l_mutex_destroy(g2l_mutex_t* mutex) {
+    assert_int_equal(*(int*)mutex, 0);
+}
+
+void __wrap_g2l_mutex_lock(g2l_mutex_t* mutex) {
+    assert_int_equal(*(int*)mutex, 0);
+    *(int*)mutex = 1;
+}
+
+void __wrap_g2l_mutex_unlock(g2l_mutex_t* mutex) {
+    assert_int_equal(*(int*)mutex, 1);
+    *(int*)mutex = 0;
+}
+
+static void test_send_unlocked_vector(void* connection_context,
+                                      const divulge_io_vector_t* vectors,
+                                      size_t vector_count) {
+    assert_int_equal(*test_sse_mutex, 0);
+    test_send_vector(connection_context, vectors, vector_count);
+}
+
+static void handle_stream(divulge_sse_stream_t* stream, bool is_connected, void* context) {
+    if (!is_connected) {
+        close_count++;
+        assert_int_equal(divulge_sse_get_stream_count(test_sse), 0);
+        assert_false(divulge_sse_send(stream, NULL, "too late"));
+        return;
+    }
+    open_count++;
+    divulge_sse_retain(stream);
+    retained_stream = stream;
+    assert_int_equal(divulge_sse_get_stream_count(test_sse), 1);
+    static_string_t last_event_id = divulge_get_request_header(divulge_sse_get_request(stream), "Last-Event-ID");
+    assert_int_equal(last_event_id.length, 2);
+    assert_true(divulge_sse_send(stream, "reading", "21.5"));
+    assert_true(divulge_sse_send(stream, NULL, "first\nsecond\r\nthird"));
+    assert_int_equal(divulge_sse_broadcast(test_sse, "log", "started"), 1);
+}
+
+static divulge_t* create_router(void) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.sendv = test_send_unlocked_vector;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    memset(test_mutexes, 0, sizeof(test_mutexes));
+    test_mutex_count = 0;
+    divulge_sse_configuration_t sse_configuration = {
+        .max_stream_count = 1,
+        .stream_handler = handle_stream,
+    };
+    test_sse = divulge_sse_create(&sse_configuration);
+    test_sse_mutex = test_mutexes + test_mutex_count - 1;
+    assert_ptr_not_equal(divulge_sse_mount(divulge, test_sse, "/events"), NULL);
+    open_count = 0;
+    close_count = 0;
+    return divulge;
+}
+
+static void serve(divulge_t* divulge, test_connection_t* connection, const char* request) {
+    test_connection_reset(connection, request);
+    test_connection_serve(divulge, connection);
+}
+
+static void test_stream_events(void** state) {
+    divulge_t* divulge = create_router();
+    test_connection_t connection;
+
+    serve(divulge, &connection, "GET /events HTTP/1.1\r\nLast-Event-ID: 42\r\n\r\nignored client data");
+    const char* body = strstr(connection.output, "\r\n\r\n");
+    assert_ptr_not_equal(body, NULL);
+    assert_ptr_not_equal(strstr(connection.output, "HTTP/1.1 200 OK\r\n"), NULL);
+    assert_ptr_not_equal(strstr(connection.output, "Content-Type: text/event-stream\r\n"), NULL);
+    assert_ptr_not_equal(strstr(connection.output, "Cache-Control: no-cache\r\n"), NULL);
+    assert_ptr_not_equal(strstr(connection.output, "Connection: close\r\n"), NULL);
+    assert_ptr_equal(strstr(connection.output, "Content-Length"), NULL);
+    assert_string_equal(body + 4,
+                        "event: reading\ndata: 21.5\n\n"
+                        "data: first\ndata: second\ndata: third\n\n"
+                        "event: log\ndata: started\n\n");
+    assert_int_equal(connection.vector_send_count, 3);
+    assert_int_equal(open_count, 1);
+    assert_int_equal(close_count, 1);
+    assert_int_equal(divulge_sse_broadcast(test_sse, NULL, "nobody"), 0);
+    assert_false(divulge_sse_send(retained_stream, NULL, "after close"));
+    assert_ptr_equal(divulge_sse_get_request(retained_stream), NULL);
+    divulge_sse_release(retained_stream);
+    divulge_sse_destroy(test_sse);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_stream_events),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,371 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-static-files.h"
+#include "divulge-test-connection.h"
+#include "divulge.h"
+#include "g2l-fs.h"
+
+#define TEST_LARGE_FILE_SIZE (1000)
+#define TEST_MAX_FILE_NAME_LENGTH (24)
+#define TEST_MODIFICATION_TIME (1700000000)
+#define TEST_ETAG "\"f-6553f100\""
+#define TEST_BOUNDARY "divulge-byteranges-5f3a9c0e71d2b846"
+
+typedef struct g2l_fs_file {
+    const char* content;
+    size_t size;
+    size_t position;
+} g2l_fs_file_t;
+
+typedef struct test_file_entry {
+    const char* name;
+    const char* content;
+    bool is_directory;
+} test_file_entry_t;
+
+static char large_file[TEST_LARGE_FILE_SIZE + 1];
+static size_t send_file_count;
+static size_t open_count;
+
+static const test_file_entry_t test_files[] = {
+    {.name = "www/index.html", .content = "<h1>index</h1>"},
+    {.name = "www/app.js", .content = "console.log(1);"},
+    {.name = "www/docs", .content = "", .is_directory = true},
+    {.name = "www/docs/index.html", .content = "<h1>docs</h1>"},
+    {.name = "www/style.css", .content = "body{}"},
+    {.name = "www/style.css.gz", .content = "gzipped"},
+    {.name = "www/my file.TXT", .content = "spaced"},
+    {.name = "www/large.bin", .content = large_file},
+    {.name = "www/abcdefghijklmnop.txt", .content = "longest"},
+    {.name = "www/abcdefghijklmnopq.txt", .content = "too long"},
+    {.name = "secret.txt", .content = "secret"},
+};
+
+static const test_file_entry_t* find_test_file(const char* file_name) {
+    for (size_t i = 0; i < (sizeof(test_files) / sizeof(test_files[0])); i++) {
+        if (strcmp(test_files[i].name, file_name) == 0) {
+            return test_files + i;
+        }
+    }
+    return NULL;
+}
+
+size_t __wrap_g2l_fs_get_max_file_name_length(void) {
+    return TEST_MAX_FILE_NAME_LENGTH;
+}
+
+size_t __wrap_g2l_fs_file_size(const char* file_name) {
+    const test_file_entry_t* entry = find_test_file(file_name);
+    return entry ? strlen(entry->content) : 0;
+}
+
+uint64_t __wrap_g2l_fs_file_modification_time(const char* file_name) {
+    return find_test_file(file_name) ? TEST_MODIFICATION_TIME : 0;
+}
+
+bool __wrap_g2l_fs_file_is_regular(const char* file_name) {
+    const test_file_entry_t* entry = find_test_file(file_name);
+    return entry && !entry->is_directory;
+}
+
+g2l_fs_file_t* __wrap_g2l_fs_file_open(const char* file_name, g2l_fs_mode_t mode) {
+    static g2l_fs_file_t file;
+    const test_file_entry_t* entry = find_test_file(file_name);
+    if (!entry || (mode != G2L_FS_MODE_READ)) {
+        return NULL;
+    }
+    open_count++;
+    file.content = entry->content;
+    file.size = strlen(entry->content);
+    file.position = 0;
+    return &file;
+}
+
+void __wrap_g2l_fs_file_close(g2l_fs_file_t* file) {}
+
+size_t __wrap_g2l_fs_file_read(g2l_fs_file_t* file, void* data, size_t max_data_size) {
+    size_t size = file->size - file->position;
+    if (size > max_data_size) {
+        size = max_data_size;
+    }
+    memcpy(data, file->content + file->position, size);
+    file->position += size;
+    return size;
+}
+
+bool __wrap_g2l_fs_file_seek(g2l_fs_file_t* file, g2l_fs_seek_mode_t mode, size_t offset) {
+    if ((mode != G2L_FS_SEEK_SET) || (offset > file->size)) {
+        return false;
+    }
+    file->position = offset;
+    return true;
+}
+
+static size_t test_send_file(void* connection_context, g2l_fs_file_t* file, size_t offset, size_t size) {
+    send_file_count++;
+    test_send(connection_context, file->content + offset, size);
+    return size;
+}
+
+static size_t test_send_partial_file(void* connection_context, g2l_fs_file_t* file, size_t offset, size_t size) {
+    return test_send_file(connection_context, file, offset, (size > 3) ? 3 : size);
+}
+
+static divulge_t* create_router(divulge_socket_send_file_callback_t send_file) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.send_file = send_file;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    assert_ptr_not_equal(divulge_static_files_mount(divulge, "/static/", "www", "index.html"), NULL);
+    return divulge;
+}
+
+static void process(divulge_t* divulge, test_connection_t* connection, const char* raw_request) {
+    send_file_count = 0;
+    open_count = 0;
+    test_connection_process(divulge, connection, raw_request);
+}
+
+static void test_content_type(void** state) {
+    assert_string_equal(divulge_static_files_get_content_type("index.html"), "text/html");
+    assert_string_equal(divulge_static_files_get_content_type("js/app.min.JS"), "application/javascript");
+    assert_string_equal(divulge_static_files_get_content_type("image.svg"), "image/svg+xml");
+    assert_string_equal(divulge_static_files_get_content_type("archive.tar.gz"), "application/gzip");
+    assert_string_equal(divulge_static_files_get_content_type("README"), "application/octet-stream");
+    assert_string_equal(divulge_static_files_get_content_type("v1.0/README"), "application/octet-stream");
+    assert_string_equal(divulge_static_files_get_content_type("file.jsx"), "application/octet-stream");
+}
+
+static void test_serve_files(void** state) {
+    divulge_t* divulge = create_router(NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "Content-Type: application/javascript\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 15\r\n\r\nconsole.log(1);"));
+
+    process(divulge, &connection, "GET /static/ HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Type: text/html\r\n"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\n<h1>index</h1>"));
+
+    process(divulge, &connection, "GET /static/docs/ HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\n<h1>docs</h1>"));
+
+    process(divulge, &connection, "GET /static/my%20file.TXT HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Type: text/plain\r\n"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nspaced"));
+
+    process(divulge, &connection, "HEAD /static/app.js HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 15\r\n\r\n"));
+    assert_false(test_connection_contains(&connection, "console"));
+    assert_int_equal(open_count, 0);
+}
+
+static void test_reject_missing_and_escaping_files(void** state) {
+    divulge_t* divulge = create_router(NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/missing.js HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    process(divulge, &connection, "GET /static/../secret.txt HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+    assert_false(test_connection_contains(&connection, "secret"));
+
+    process(divulge, &connection, "GET /static/%2e%2e/secret.txt HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    process(divulge, &connection, "GET /static/docs/.. HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    process(divulge, &connection, "GET /static/docs HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+    assert_int_equal(open_count, 0);
+
+    process(divulge, &connection, "GET /static/app%2 HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    process(divulge, &connection, "GET /secret.txt HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+}
+
+static void test_serve_precompressed_file(void** state) {
+    divulge_t* divulge = create_router(NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/style.css HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Type: text/css\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Encoding: gzip\r\n"));
+    assert_true(test_connection_contains(&connection, "Vary: Accept-Encoding\r\n"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\ngzipped"));
+
+    process(divulge, &connection, "GET /static/style.css HTTP/1.1\r\n\r\n");
+    assert_false(test_connection_contains(&connection, "Content-Encoding"));
+    assert_true(test_connection_contains(&connection, "Vary: Accept-Encoding\r\n"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nbody{}"));
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    assert_false(test_connection_contains(&connection, "Vary"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nconsole.log(1);"));
+}
+
+static void test_reject_names_longer_than_file_system_limit(void** state) {
+    divulge_t* divulge = create_router(NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/abcdefghijklmnop.txt HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nlongest"));
+
+    process(divulge, &connection, "GET /static/abcdefghijklmnopq.txt HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+    assert_false(test_connection_contains(&connection, "too long"));
+}
+
+static void test_serve_large_file(void** state) {
+    memset(large_file, 'L', TEST_LARGE_FILE_SIZE);
+    large_file[TEST_LARGE_FILE_SIZE - 1] = 'E';
+    test_connection_t connection;
+
+    divulge_t* divulge = create_router(NULL);
+    process(divulge, &connection, "GET /static/large.bin HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Type: application/octet-stream\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 1000\r\n\r\nLLL"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, large_file);
+
+    divulge = create_router(test_send_file);
+    process(divulge, &connection, "GET /static/large.bin HTTP/1.1\r\n\r\n");
+    assert_int_equal(send_file_count, 1);
+    assert_true(test_connection_contains(&connection, "Content-Length: 1000\r\n\r\nLLL"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, large_file);
+}
+
+static size_t get_body_size(test_connection_t* connection) {
+    return strlen(strstr(connection->output, "\r\n\r\n") + 4);
+}
+
+static void test_serve_ranges(void** state) {
+    divulge_t* divulge = create_router(test_send_file);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "Accept-Ranges: bytes\r\n"));
+    assert_true(test_connection_contains(&connection, "ETag: " TEST_ETAG "\r\n"));
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=0-6\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "HTTP/1.1 206 Partial Content\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Type: application/javascript\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Range: bytes 0-6/15\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 7\r\n"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "console");
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=8-\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Range: bytes 8-14/15\r\n"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "log(1);");
+
+    process(divulge, &connection,
+            "GET /static/app.js HTTP/1.1\r\nRange: bytes=-3\r\nIf-Range: " TEST_ETAG "\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Range: bytes 12-14/15\r\n"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "1);");
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=-3\r\nIf-Range: \"old\"\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "console.log(1);");
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=5-2\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+
+    process(divulge, &connection, "HEAD /static/app.js HTTP/1.1\r\nRange: bytes=0-1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_int_equal(get_body_size(&connection), 0);
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=20-\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "HTTP/1.1 416 Range Not Satisfiable\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Range: bytes */15\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 0\r\n"));
+    assert_int_equal(get_body_size(&connection), 0);
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=0-0, 8-10\r\n\r\n");
+    const char* multipart_body =
+        "\r\n--" TEST_BOUNDARY "\r\nContent-Type: application/javascript\r\nContent-Range: bytes 0-0/15\r\n\r\nc"
+        "\r\n--" TEST_BOUNDARY "\r\nContent-Type: application/javascript\r\nContent-Range: bytes 8-10/15\r\n\r\nlog"
+        "\r\n--" TEST_BOUNDARY "--\r\n";
+    char content_length[32];
+    snprintf(content_length, sizeof(content_length), "Content-Length: %zu\r\n", strlen(multipart_body));
+    assert_true(test_connection_contains(&connection, "206 Partial Content"));
+    assert_true(
+        test_connection_contains(&connection, "Content-Type: multipart/byteranges; boundary=" TEST_BOUNDARY "\r\n"));
+    assert_false(test_connection_contains(&connection, "Content-Type: application/javascript\r\nContent-Length"));
+    assert_true(test_connection_contains(&connection, content_length));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, multipart_body);
+    assert_int_equal(send_file_count, 2);
+}
+
+static void test_serve_range_without_send_file(void** state) {
+    memset(large_file, 'L', TEST_LARGE_FILE_SIZE);
+    large_file[TEST_LARGE_FILE_SIZE - 1] = 'E';
+    divulge_t* divulge = create_router(NULL);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/large.bin HTTP/1.1\r\nRange: bytes=995-\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Range: bytes 995-999/1000\r\n"));
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "LLLLE");
+}
+
+static void test_continue_after_partial_send_file(void** state) {
+    divulge_t* divulge = create_router(test_send_partial_file);
+    test_connection_t connection;
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\n\r\n");
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "console.log(1);");
+
+    process(divulge, &connection, "GET /static/app.js HTTP/1.1\r\nRange: bytes=8-\r\n\r\n");
+    assert_string_equal(strstr(connection.output, "\r\n\r\n") + 4, "log(1);");
+    assert_int_equal(send_file_count, 1);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_content_type),
+        cmocka_unit_test(test_serve_files),
+        cmocka_unit_test(test_reject_missing_and_escaping_files),
+        cmocka_unit_test(test_serve_precompressed_file),
+        cmocka_unit_test(test_reject_names_longer_than_file_system_limit),
+        cmocka_unit_test(test_serve_large_file),
+        cmocka_unit_test(test_serve_ranges),
+        cmocka_unit_test(test_serve_range_without_send_file),
+        cmocka_unit_test(test_continue_after_partial_send_file),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,184 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-test-connection.h"
+#include "divulge.h"
+
+static char middleware_log[64];
+
+static bool respond_with_context(divulge_request_t* request, void* context) {
+    const char* text = (const char*)context;
+    divulge_response_t response = {.return_code = 200, .payload = text, .payload_size = strlen(text)};
+    return divulge_respond(request, &response);
+}
+
+static bool respond_with_parameter(divulge_request_t* request, void* context) {
+    static_string_t value = divulge_get_route_parameter(request, (const char*)context);
+    divulge_response_t response = {.return_code = 200, .payload = value.text, .payload_size = value.length};
+    return divulge_respond(request, &response);
+}
+
+static bool log_middleware(divulge_request_t* request, void* context) {
+    strcat(middleware_log, (const char*)context);
+    return true;
+}
+
+static bool reject_without_token(divulge_request_t* request, void* context) {
+    if (divulge_get_request_header(request, "X-Token").text) {
+        return true;
+    }
+    divulge_response_t response = {.return_code = 401, .payload = "", .payload_size = 0};
+    divulge_respond(request, &response);
+    return false;
+}
+
+DIVULGE_ROUTE(hello, DIVULGE_ROUTE_METHOD_GET, "/hello", respond_with_context, "static hello");
+DIVULGE_ROUTE(item, DIVULGE_ROUTE_METHOD_GET, "/items/{id}", respond_with_parameter, "id");
+DIVULGE_ROUTE(file, DIVULGE_ROUTE_METHOD_GET, "/files/readme", respond_with_context, "static readme");
+DIVULGE_ROUTE(any, DIVULGE_ROUTE_METHOD_ANY, "/both", respond_with_context, "static any");
+DIVULGE_ROUTE(secret,
+              DIVULGE_ROUTE_METHOD_POST,
+              "/secret/{path*}",
+              respond_with_parameter,
+              "path",
+              {.handler = log_middleware, .context = "a"},
+              {.handler = reject_without_token},
+              {.handler = log_middleware, .context = "b"});
+
+static divulge_t* create_router(const char* metrics_uri) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.metrics_uri = metrics_uri;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    assert_ptr_not_equal(divulge, NULL);
+    return divulge;
+}
+
+static void register_route(divulge_t* divulge, const char* uri, divulge_route_method_t method, const char* text) {
+    divulge_uri_t route = {
+        .uri = uri,
+        .method = method,
+        .handler = {.handler = respond_with_context, .context = (void*)text},
+    };
+    divulge_register_uri(divulge, &route);
+}
+
+static test_connection_t connection;
+
+static void test_static_routes(void** state) {
+    divulge_t* divulge = create_router(NULL);
+
+    test_connection_process(divulge, &connection, "GET /hello HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nstatic hello"));
+
+    test_connection_process(divulge, &connection, "HEAD /hello HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Length: 12\r\n\r\n"));
+    assert_false(test_connection_contains(&connection, "static hello"));
+
+    test_connection_process(divulge, &connection, "GET /items/42 HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\n42"));
+
+    test_connection_process(divulge, &connection, "POST /hello HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    test_connection_process(divulge, &connection, "GET /items/ HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+}
+
+static void test_static_route_middlewares(void** state) {
+    divulge_t* divulge = create_router(NULL);
+
+    middleware_log[0] = '\0';
+    test_connection_process(divulge, &connection, "POST /secret/a/b HTTP/1.1\r\nX-Token: 1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\na/b"));
+    assert_string_equal(middleware_log, "ab");
+
+    middleware_log[0] = '\0';
+    test_connection_process(divulge, &connection, "POST /secret/a/b HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "401"));
+    assert_string_equal(middleware_log, "a");
+}
+
+static void test_static_and_registered_routes(void** state) {
+    divulge_t* divulge = create_router(NULL);
+    register_route(divulge, "/items/special", DIVULGE_ROUTE_METHOD_GET, "registered special");
+    register_route(divulge, "/files/*", DIVULGE_ROUTE_METHOD_GET, "registered file");
+    register_route(divulge, "/both", DIVULGE_ROUTE_METHOD_GET, "registered get");
+
+    test_connection_process(divulge, &connection, "GET /items/special HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nregistered special"));
+
+    test_connection_process(divulge, &connection, "GET /items/7 HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\n7"));
+
+    test_connection_process(divulge, &connection, "GET /files/readme HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nstatic readme"));
+
+    test_connection_process(divulge, &connection, "GET /files/other HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nregistered file"));
+
+    test_connection_process(divulge, &connection, "GET /both HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nregistered get"));
+
+    test_connection_process(divulge, &connection, "DELETE /both HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nstatic any"));
+}
+
+static void test_static_route_wins_over_duplicate(void** state) {
+    divulge_t* divulge = create_router(NULL);
+    register_route(divulge, "/hello", DIVULGE_ROUTE_METHOD_GET, "registered hello");
+
+    test_connection_process(divulge, &connection, "GET /hello HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nstatic hello"));
+}
+
+static void test_static_route_metrics(void** state) {
+    divulge_t* divulge = create_router("/metrics");
+
+    test_connection_process(divulge, &connection, "GET /hello HTTP/1.1\r\n\r\n");
+    test_connection_process(divulge, &connection, "GET /metrics HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection,
+                                  "divulge_requests_total{method=\"GET\",route=\"/hello\",code=\"2xx\"} 1\n"));
+    assert_true(test_connection_contains(
+        &connection, "divulge_requests_total{method=\"POST\",route=\"/secret/{path*}\",code=\"2xx\"} 0\n"));
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_static_routes),
+        cmocka_unit_test(test_static_route_middlewares),
+        cmocka_unit_test(test_static_and_registered_routes),
+        cmocka_unit_test(test_static_route_wins_over_duplicate),
+        cmocka_unit_test(test_static_route_metrics),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,144 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-url-query.h"
+
+static void assert_static_string_equal(static_string_t text, const char* expected) {
+    assert_ptr_not_equal(text.text, NULL);
+    assert_int_equal(text.length, strlen(expected));
+    assert_memory_equal(text.text, expected, text.length);
+}
+
+static void test_split_parameters(void** state) {
+    char raw_query[] = "a=1&b=two&&flag&empty=&c=x=y";
+    divulge_url_query_t query = divulge_url_query_create_from_raw_query(raw_query);
+    assert_int_equal(query.parameter_count, 5);
+    assert_static_string_equal(divulge_url_query_get_key(&query, 0), "a");
+    assert_static_string_equal(divulge_url_query_get_value(&query, 0), "1");
+    assert_static_string_equal(divulge_url_query_get_key(&query, 1), "b");
+    assert_static_string_equal(divulge_url_query_get_value(&query, 1), "two");
+    assert_static_string_equal(divulge_url_query_get_key(&query, 2), "flag");
+    assert_int_equal(divulge_url_query_get_value(&query, 2).length, 0);
+    assert_static_string_equal(divulge_url_query_get_key(&query, 3), "empty");
+    assert_int_equal(divulge_url_query_get_value(&query, 3).length, 0);
+    assert_static_string_equal(divulge_url_query_find(&query, "c"), "x=y");
+    assert_ptr_equal(divulge_url_query_get_key(&query, 5).text, NULL);
+    assert_ptr_equal(divulge_url_query_find(&query, "missing").text, NULL);
+    assert_true(divulge_url_query_has(&query, "flag"));
+    assert_false(divulge_url_query_has(&query, "fla"));
+
+    query = divulge_url_query_create_from_raw_query(NULL);
+    assert_int_equal(query.parameter_count, 0);
+    char empty_query[] = "";
+    query = divulge_url_query_create_from_raw_query(empty_query);
+    assert_int_equal(query.parameter_count, 0);
+}
+
+static void test_lazy_percent_decoding(void** state) {
+    char raw_query[] = "na%6De=J%C3%B3zef+Nowak&path=%2Fvar%2flog&bad=%zz%4&plus=a%2Bb";
+    divulge_url_query_t query = divulge_url_query_create_from_raw_query(raw_query);
+    assert_int_equal(query.parameter_count, 4);
+    assert_int_equal(memcmp(raw_query, "na%6De=J%C3%B3zef+Nowak", strlen("na%6De=J%C3%B3zef+Nowak")), 0);
+
+    static_string_t value = divulge_url_query_find(&query, "name");
+    assert_static_string_equal(value, "J\xC3\xB3zef Nowak");
+    assert_int_equal(value.text[value.length], '\0');
+    assert_static_string_equal(divulge_url_query_find(&query, "name"), "J\xC3\xB3zef Nowak");
+    assert_static_string_equal(divulge_url_query_find(&query, "path"), "/var/log");
+    assert_static_string_equal(divulge_url_query_find(&query, "bad"), "%zz%4");
+    assert_static_string_equal(divulge_url_query_find(&query, "plus"), "a+b");
+    assert_string_equal(raw_query, "na%6De=J%C3%B3zef+Nowak&path=%2Fvar%2flog&bad=%zz%4&plus=a%2Bb");
+}
+
+static void test_decoded_storage_limit(void** state) {
+    char raw_query[DIVULGE_URL_QUERY_DECODED_BUFFER_SIZE + 16];
+    strcpy(raw_query, "short=1&long=");
+    size_t length = strlen(raw_query);
+    memset(raw_query + length, 'x', sizeof(raw_query) - length - 1);
+    raw_query[sizeof(raw_query) - 1] = '\0';
+    divulge_url_query_t query = divulge_url_query_create_from_raw_query(raw_query);
+    assert_ptr_equal(divulge_url_query_find(&query, "long").text, NULL);
+    assert_static_string_equal(divulge_url_query_find(&query, "short"), "1");
+}
+
+static void test_typed_getters(void** state) {
+    char raw_query[] = "limit=25&offset=-3&big=99999999999&bad=12a&space=%2012&ratio=0.25&nan=x"
+                       "&debug&verbose=On&quiet=0&maybe=perhaps";
+    divulge_url_query_t query = divulge_url_query_create_from_raw_query(raw_query);
+    int number = 0;
+    assert_true(divulge_url_query_get_int(&query, "limit", &number));
+    assert_int_equal(number, 25);
+    assert_true(divulge_url_query_get_int(&query, "offset", &number));
+    assert_int_equal(number, -3);
+    assert_false(divulge_url_query_get_int(&query, "big", &number));
+    assert_false(divulge_url_query_get_int(&query, "bad", &number));
+    assert_false(divulge_url_query_get_int(&query, "space", &number));
+    assert_false(divulge_url_query_get_int(&query, "debug", &number));
+    assert_false(divulge_url_query_get_int(&query, "missing", &number));
+    assert_int_equal(number, -3);
+
+    float ratio = 0.0f;
+    assert_true(divulge_url_query_get_float(&query, "ratio", &ratio));
+    assert_true((ratio > 0.249f) && (ratio < 0.251f));
+    assert_true(divulge_url_query_get_float(&query, "limit", &ratio));
+    assert_true((ratio > 24.99f) && (ratio < 25.01f));
+    assert_false(divulge_url_query_get_float(&query, "nan", &ratio));
+
+    bool flag = false;
+    assert_true(divulge_url_query_get_bool(&query, "debug", &flag));
+    assert_true(flag);
+    assert_true(divulge_url_query_get_bool(&query, "quiet", &flag));
+    assert_false(flag);
+    assert_true(divulge_url_query_get_bool(&query, "verbose", &flag));
+    assert_true(flag);
+    assert_false(divulge_url_query_get_bool(&query, "maybe", &flag));
+    assert_false(divulge_url_query_get_bool(&query, "missing", &flag));
+}
+
+static void test_parameter_limit(void** state) {
+    char raw_query[128] = "";
+    for (size_t i = 0; i < (DIVULGE_URL_QUERY_PARAMETERS_MAX_COUNT + 4); i++) {
+        strcat(raw_query, "k=v&");
+    }
+    divulge_url_query_t query = divulge_url_query_create_from_raw_query(raw_query);
+    assert_int_equal(query.parameter_count, DIVULGE_URL_QUERY_PARAMETERS_MAX_COUNT);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_split_parameters),
+        cmocka_unit_test(test_lazy_percent_decoding),
+        cmocka_unit_test(test_decoded_storage_limit),
+        cmocka_unit_test(test_typed_getters),
+        cmocka_unit_test(test_parameter_limit),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,332 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "divulge-test-connection.h"
+#include "divulge-websocket.h"
+#include "divulge.h"
+
+#define TEST_MUTEXES_MAX_COUNT (8)
+
+typedef struct g2l_mutex g2l_mutex_t;
+
+typedef struct test_events {
+    size_t open_count;
+    size_t close_count;
+    size_t message_count;
+    size_t broadcast_count;
+} test_events_t;
+
+static const char* upgrade_request =
+    "GET /events HTTP/1.1\r\n"
+    "Host: server.example.com\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: keep-alive, Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "\r\n";
+
+static char test_input[TEST_BUFFER_SIZE];
+static int test_mutexes[TEST_MUTEXES_MAX_COUNT];
+static size_t test_mutex_count;
+static int* test_websocket_mutex;
+static divulge_websocket_connection_t* retained_connection;
+static test_events_t events;
+
+g2l_mutex_t* __wrap_g2l_mutex_create(void) {
+    assert_true(test_mutex_count < TEST_MUTEXES_MAX_COUNT);
+    return (g2l_mutex_t*)(test_mutexes + test_mutex_count++);
+}
+
+void __wrap_g2l_mutex_destroy(g2l_mutex_t* mutex) {
+    assert_int_equal(*(int*)mutex, 0);
+}
+
+void __wrap_g2l_mutex_lock(g2l_mutex_t* mutex) {
+    assert_int_equal(*(int*)mutex, 0);
+    *(int*)mutex = 1;
+}
+
+void __wrap_g2l_mutex_unlock(g2l_mutex_t* mutex) {
+    assert_int_equal(*(int*)mutex, 1);
+    *(int*)mutex = 0;
+}
+
+static void test_send_unlocked(void* connection_context, const char* data, size_t data_size) {
+    assert_int_equal(*test_websocket_mutex, 0);
+    test_send(connection_context, data, data_size);
+}
+
+static void handle_connection(divulge_websocket_connection_t* connection, bool is_connected, void* context) {
+    divulge_websocket_t* websocket = *(divulge_websocket_t**)context;
+    if (is_connected) {
+        events.open_count++;
+        divulge_websocket_retain(connection);
+        retained_connection = connection;
+        assert_int_equal(divulge_websocket_get_connection_count(websocket), 1);
+        assert_ptr_not_equal(divulge_websocket_get_request(connection), NULL);
+        events.broadcast_count += divulge_websocket_broadcast(websocket, DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT, "hi", 2);
+    } else {
+        events.close_count++;
+        assert_int_equal(divulge_websocket_get_connection_count(websocket), 0);
+        assert_false(divulge_websocket_send(connection, DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT, "too late", 8));
+    }
+}
+
+static bool echo_message(divulge_websocket_connection_t* connection,
+                         divulge_websocket_message_type_t type,
+                         const char* data,
+                         size_t data_size,
+                         void* context) {
+    events.message_count++;
+    if ((data_size == 4) && (memcmp(data, "quit", 4) == 0)) {
+        return false;
+    }
+    return divulge_websocket_send(connection, type, data, data_size);
+}
+
+static void append_input(test_connection_t* connection, const void* data, size_t data_size) {
+    assert_true((connection->input_size + data_size) <= sizeof(test_input));
+    memcpy(test_input + connection->input_size, data, data_size);
+    connection->input = test_input;
+    connection->input_size += data_size;
+}
+
+static void append_frame(test_connection_t* connection,
+                         bool is_final,
+                         uint8_t opcode,
+                         const char* payload,
+                         size_t payload_size) {
+    static const uint8_t mask[] = {0x37, 0xfa, 0x21, 0x3d};
+    uint8_t header[8] = {(uint8_t)((is_final ? 0x80 : 0x00) | opcode)};
+    size_t header_size = 2;
+    if (payload_size < 126) {
+        header[1] = 0x80 | (uint8_t)payload_size;
+    } else {
+        header[1] = 0x80 | 126;
+        header[header_size++] = (uint8_t)(payload_size >> 8);
+        header[header_size++] = (uint8_t)payload_size;
+    }
+    append_input(connection, header, header_size);
+    append_input(connection, mask, sizeof(mask));
+    for (size_t i = 0; i < payload_size; i++) {
+        char masked = (char)(payload[i] ^ mask[i & 3]);
+        append_input(connection, &masked, 1);
+    }
+}
+
+static void serve(divulge_t* divulge, test_connection_t* connection) {
+    connection->input_chunk_size = 7;
+    test_connection_serve(divulge, connection);
+}
+
+static const char* find_output(test_connection_t* connection, const void* data, size_t data_size) {
+    for (size_t i = 0; (i + data_size) <= connection->output_size; i++) {
+        if (memcmp(connection->output + i, data, data_size) == 0) {
+            return connection->output + i;
+        }
+    }
+    return NULL;
+}
+
+static const char* find_output_text(test_connection_t* connection, const char* text) {
+    return find_output(connection, text, strlen(text));
+}
+
+static divulge_t* create_router(divulge_websocket_t** websocket, size_t max_message_size) {
+    divulge_websocket_release(retained_connection);
+    retained_connection = NULL;
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.send = test_send_unlocked;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    memset(test_mutexes, 0, sizeof(test_mutexes));
+    test_mutex_count = 0;
+    divulge_websocket_configuration_t websocket_configuration = {
+        .max_connection_count = 2,
+        .max_message_size = max_message_size,
+        .connection_handler = handle_connection,
+        .message_handler = echo_message,
+        .context = websocket,
+    };
+    *websocket = divulge_websocket_create(&websocket_configuration);
+    test_websocket_mutex = test_mutexes + test_mutex_count - 1;
+    assert_ptr_not_equal(divulge_websocket_mount(divulge, *websocket, "/events"), NULL);
+    memset(&events, 0, sizeof(events));
+    return divulge;
+}
+
+static void test_handshake_and_messages(void** state) {
+    divulge_websocket_t* websocket = NULL;
+    divulge_t* divulge = create_router(&websocket, 256);
+    test_connection_t connection = {.receive_timeout_ms = 100};
+    char long_message[200];
+    memset(long_message, 'x', sizeof(long_message));
+    append_input(&connection, upgrade_request, strlen(upgrade_request));
+    append_frame(&connection, true, 0x1, "hello", 5);
+    append_frame(&connection, false, 0x2, "ab", 2);
+    append_frame(&connection, true, 0x9, "ping", 4);
+    append_frame(&connection, true, 0x0, "cd", 2);
+    append_frame(&connection, true, 0x1, long_message, sizeof(long_message));
+    append_frame(&connection, true, 0x8, "\x03\xe8", 2);
+
+    serve(divulge, &connection);
+    assert_ptr_not_equal(find_output_text(&connection, "HTTP/1.1 101 Switching Protocols\r\n"), NULL);
+    assert_ptr_not_equal(find_output_text(&connection, "Connection: Upgrade\r\n"), NULL);
+    assert_ptr_not_equal(find_output_text(&connection, "Upgrade: websocket\r\n"), NULL);
+    assert_ptr_not_equal(find_output_text(&connection, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), NULL);
+    assert_ptr_equal(find_output_text(&connection, "Content-Length"), NULL);
+    assert_int_equal(connection.receive_timeout_ms, 0);
+
+    const char* frames = find_output_text(&connection, "\r\n\r\n") + 4;
+    static const char expected_frames[] =
+        "\x81\x02hi"
+        "\x81\x05hello"
+        "\x8a\x04ping"
+        "\x82\x04"
+        "abcd"
+        "\x81\x7e\x00\xc8";
+    assert_memory_equal(frames, expected_frames, sizeof(expected_frames) - 1);
+    frames += sizeof(expected_frames) - 1;
+    assert_memory_equal(frames, long_message, sizeof(long_message));
+    assert_memory_equal(frames + sizeof(long_message), "\x88\x02\x03\xe8", 4);
+    assert_int_equal((frames + sizeof(long_message) + 4) - connection.output, connection.output_size);
+
+    assert_int_equal(events.open_count, 1);
+    assert_int_equal(events.close_count, 1);
+    assert_int_equal(events.message_count, 3);
+    assert_int_equal(events.broadcast_count, 1);
+    assert_int_equal(divulge_websocket_get_connection_count(websocket), 0);
+    assert_ptr_equal(divulge_websocket_get_request(retained_connection), NULL);
+    assert_false(divulge_websocket_send(retained_connection, DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT, "hi", 2));
+}
+
+static void test_server_initiated_close(void** state) {
+    divulge_websocket_t* websocket = NULL;
+    divulge_t* divulge = create_router(&websocket, 256);
+    test_connection_t connection = {0};
+    append_input(&connection, upgrade_request, strlen(upgrade_request));
+    append_frame(&connection, true, 0x1, "quit", 4);
+    append_frame(&connection, true, 0x1, "late", 4);
+    append_frame(&connection, true, 0x8, "", 0);
+
+    serve(divulge, &connection);
+    assert_ptr_not_equal(find_output(&connection, "\x88\x02\x03\xe8", 4), NULL);
+    assert_ptr_equal(find_output_text(&connection, "late"), NULL);
+    assert_int_equal(events.close_count, 1);
+}
+
+static void assert_closed_with_status(const uint8_t* frame, size_t frame_size, const char* expected_close_frame) {
+    divulge_websocket_t* websocket = NULL;
+    divulge_t* divulge = create_router(&websocket, 16);
+    test_connection_t connection = {0};
+    append_input(&connection, upgrade_request, strlen(upgrade_request));
+    append_input(&connection, frame, frame_size);
+    append_frame(&connection, true, 0x1, "ignored", 7);
+
+    serve(divulge, &connection);
+    assert_ptr_not_equal(find_output(&connection, expected_close_frame, 4), NULL);
+    assert_int_equal(events.message_count, 0);
+    assert_int_equal(events.close_count, 1);
+}
+
+static void test_protocol_errors(void** state) {
+    static const uint8_t unmasked_frame[] = {0x81, 0x02, 'h', 'i'};
+    assert_closed_with_status(unmasked_frame, sizeof(unmasked_frame), "\x88\x02\x03\xea");
+    static const uint8_t reserved_bits_frame[] = {0xc1, 0x80, 0, 0, 0, 0};
+    assert_closed_with_status(reserved_bits_frame, sizeof(reserved_bits_frame), "\x88\x02\x03\xea");
+    static const uint8_t orphan_continuation_frame[] = {0x80, 0x80, 0, 0, 0, 0};
+    assert_closed_with_status(orphan_continuation_frame, sizeof(orphan_continuation_frame), "\x88\x02\x03\xea");
+    static const uint8_t fragmented_ping_frame[] = {0x09, 0x80, 0, 0, 0, 0};
+    assert_closed_with_status(fragmented_ping_frame, sizeof(fragmented_ping_frame), "\x88\x02\x03\xea");
+    static const uint8_t too_big_frame[] = {0x82, 0x91, 0, 0, 0, 0};
+    assert_closed_with_status(too_big_frame, sizeof(too_big_frame), "\x88\x02\x03\xf1");
+}
+
+static void test_invalid_utf8(void** state) {
+    static const uint8_t invalid_sequence_frame[] = {0x81, 0x82, 0, 0, 0, 0, 0xc3, 0x28};
+    assert_closed_with_status(invalid_sequence_frame, sizeof(invalid_sequence_frame), "\x88\x02\x03\xef");
+    static const uint8_t overlong_frame[] = {0x81, 0x82, 0, 0, 0, 0, 0xc0, 0xaf};
+    assert_closed_with_status(overlong_frame, sizeof(overlong_frame), "\x88\x02\x03\xef");
+    static const uint8_t surrogate_frame[] = {0x81, 0x83, 0, 0, 0, 0, 0xed, 0xa0, 0x80};
+    assert_closed_with_status(surrogate_frame, sizeof(surrogate_frame), "\x88\x02\x03\xef");
+    static const uint8_t truncated_frame[] = {0x81, 0x82, 0, 0, 0, 0, 0xe2, 0x82};
+    assert_closed_with_status(truncated_frame, sizeof(truncated_frame), "\x88\x02\x03\xef");
+    static const uint8_t invalid_close_reason_frame[] = {0x88, 0x83, 0, 0, 0, 0, 0x03, 0xe8, 0xff};
+    assert_closed_with_status(invalid_close_reason_frame, sizeof(invalid_close_reason_frame), "\x88\x02\x03\xef");
+}
+
+static void test_valid_utf8_split_across_fragments(void** state) {
+    divulge_websocket_t* websocket = NULL;
+    divulge_t* divulge = create_router(&websocket, 64);
+    test_connection_t connection = {0};
+    append_input(&connection, upgrade_request, strlen(upgrade_request));
+    append_frame(&connection, false, 0x1, "z\xc5", 2);
+    append_frame(&connection, false, 0x0, "\xbc\xf0\x9f", 3);
+    append_frame(&connection, true, 0x0, "\x98\x80", 2);
+    append_frame(&connection, true, 0x8, "", 0);
+
+    serve(divulge, &connection);
+    assert_ptr_not_equal(find_output(&connection, "\x81\x07z\xc5\xbc\xf0\x9f\x98\x80", 9), NULL);
+    assert_int_equal(events.message_count, 1);
+}
+
+static void test_invalid_handshake(void** state) {
+    divulge_websocket_t* websocket = NULL;
+    divulge_t* divulge = create_router(&websocket, 16);
+    test_connection_t connection = {0};
+    const char* plain_request = "GET /events HTTP/1.1\r\nConnection: close\r\n\r\n";
+    append_input(&connection, plain_request, strlen(plain_request));
+    serve(divulge, &connection);
+    assert_ptr_not_equal(find_output_text(&connection, "HTTP/1.1 426 Upgrade Required\r\n"), NULL);
+    assert_ptr_not_equal(find_output_text(&connection, "Sec-WebSocket-Version: 13\r\n"), NULL);
+
+    connection = (test_connection_t){0};
+    const char* invalid_key_request =
+        "GET /events HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: short\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    append_input(&connection, invalid_key_request, strlen(invalid_key_request));
+    serve(divulge, &connection);
+    assert_ptr_not_equal(find_output_text(&connection, "HTTP/1.1 400 Bad Request\r\n"), NULL);
+    assert_int_equal(events.open_count, 0);
+    assert_int_equal(divulge_websocket_broadcast(websocket, DIVULGE_WEBSOCKET_MESSAGE_TYPE_TEXT, "hi", 2), 0);
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_handshake_and_messages),
+        cmocka_unit_test(test_server_initiated_close),
+        cmocka_unit_test(test_protocol_errors),
+        cmocka_unit_test(test_invalid_utf8),
+        cmocka_unit_test(test_valid_utf8_split_across_fragments),
+        cmocka_unit_test(test_invalid_handshake),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
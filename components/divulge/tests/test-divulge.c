@@ -25,15 +25,749 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include "cmocka.h"
 
+#include "divulge-request-parser.h"
+#include "divulge-test-connection.h"
 #include "divulge.h"
 
-static void test_dummy(void** state) {}
+static bool respond_with_context(divulge_request_t* request, void* context) {
+    const char* text = (const char*)context;
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = text,
+        .payload_size = strlen(text),
+    };
+    return divulge_respond(request, &response);
+}
+
+static bool respond_with_parameters(divulge_request_t* request, void* context) {
+    char buffer[TEST_BUFFER_SIZE] = {0};
+    size_t size = 0;
+    for (size_t i = 0; i < request->parameter_count; i++) {
+        const divulge_route_parameter_t* parameter = request->parameters + i;
+        size += (size_t)snprintf(buffer + size, sizeof(buffer) - size, "%.*s=%.*s;", (int)parameter->name.length,
+                                 parameter->name.text, (int)parameter->value.length, parameter->value.text);
+    }
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = buffer,
+        .payload_size = size,
+    };
+    return divulge_respond(request, &response);
+}
+
+static divulge_t* create_router_with_limits(size_t keep_alive_max_requests, size_t request_arena_size) {
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.keep_alive_max_requests = keep_alive_max_requests;
+    configuration.keep_alive_timeout_ms = 1500;
+    configuration.request_arena_size = request_arena_size;
+    return divulge_initialize(&configuration);
+}
+
+static divulge_t* create_router(void) {
+    return create_router_with_limits(0, 0);
+}
+
+static void register_route(divulge_t* divulge,
+                           const char* uri,
+                           divulge_route_method_t method,
+                           divulge_uri_handler_t handler,
+                           void* context) {
+    divulge_uri_t route = {
+        .uri = uri,
+        .method = method,
+        .handler = {.handler = handler, .context = context},
+    };
+    divulge_register_uri(divulge, &route);
+}
+
+static void serve(divulge_t* divulge, test_connection_t* connection, const char* raw_request, size_t chunk_size) {
+    test_connection_reset(connection, raw_request);
+    connection->input_chunk_size = chunk_size;
+    test_connection_serve(divulge, connection);
+}
+
+static size_t count_occurrences(test_connection_t* connection, const char* text) {
+    size_t count = 0;
+    for (const char* position = strstr(connection->output, text); position;
+         position = strstr(position + 1, text)) {
+        count++;
+    }
+    return count;
+}
+
+static bool respond_with_payload(divulge_request_t* request, void* context) {
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = request->payload,
+        .payload_size = request->payload_size,
+    };
+    return divulge_respond(request, &response);
+}
+
+static void test_static_routes(void** state) {
+    divulge_t* divulge = create_router();
+    assert_ptr_not_equal(divulge, NULL);
+    register_route(divulge, "/", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "root");
+    register_route(divulge, "/api/users", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "users");
+    register_route(divulge, "/api/user", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "user");
+    register_route(divulge, "/api/u", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "u");
+    register_route(divulge, "/api/users", DIVULGE_ROUTE_METHOD_POST, respond_with_context, "new user");
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET / HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "root"));
+    assert_true(connection.was_closed);
+
+    test_connection_process(divulge, &connection, "GET /api/user HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nuser"));
+
+    test_connection_process(divulge, &connection, "GET /api/users HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nusers"));
+
+    test_connection_process(divulge, &connection, "GET /api/u HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nu"));
+
+    test_connection_process(divulge, &connection, "POST /api/users HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "new user"));
+
+    test_connection_process(divulge, &connection, "GET /api/use HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    test_connection_process(divulge, &connection, "GET /api/users/ HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    test_connection_process(divulge, &connection, "POST /api/user HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+}
+
+static void test_parameter_routes(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/devices/{id}", DIVULGE_ROUTE_METHOD_GET, respond_with_parameters, NULL);
+    register_route(divulge, "/devices/{id}/sensors/{sensor}", DIVULGE_ROUTE_METHOD_GET, respond_with_parameters,
+                   NULL);
+    register_route(divulge, "/devices/all", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "all devices");
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /devices/42 HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nid=42;"));
+
+    test_connection_process(divulge, &connection, "GET /devices/42/sensors/temperature?unit=C HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nid=42;sensor=temperature;"));
+
+    test_connection_process(divulge, &connection, "GET /devices/all HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "all devices"));
+
+    test_connection_process(divulge, &connection, "GET /devices/ HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+
+    test_connection_process(divulge, &connection, "GET /devices/42/sensors HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+}
+
+static bool check_route_parameter(divulge_request_t* request, void* context) {
+    static_string_t value = divulge_get_route_parameter(request, "name");
+    assert_int_equal(value.length, strlen("dashboard"));
+    assert_memory_equal(value.text, "dashboard", value.length);
+    value = divulge_get_route_parameter(request, "missing");
+    assert_ptr_equal(value.text, NULL);
+    return respond_with_context(request, "checked");
+}
+
+static void test_route_parameter_lookup(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/pages/{name}", DIVULGE_ROUTE_METHOD_GET, check_route_parameter, NULL);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /pages/dashboard HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "checked"));
+}
+
+static void test_wildcard_routes(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/static/{path*}", DIVULGE_ROUTE_METHOD_GET, respond_with_parameters, NULL);
+    register_route(divulge, "/static/index.html", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "index");
+    register_route(divulge, "/files/*", DIVULGE_ROUTE_METHOD_GET, respond_with_parameters, NULL);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /static/css/main.css HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\npath=css/main.css;"));
+
+    test_connection_process(divulge, &connection, "GET /static/index.html HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nindex"));
+
+    test_connection_process(divulge, &connection, "GET /files/logs/today.txt HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\n*=logs/today.txt;"));
+
+    test_connection_process(divulge, &connection, "GET /files HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+}
+
+static void test_any_method_route(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/echo", DIVULGE_ROUTE_METHOD_ANY, respond_with_context, "any");
+    register_route(divulge, "/echo", DIVULGE_ROUTE_METHOD_POST, respond_with_context, "post");
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /echo HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nany"));
+
+    test_connection_process(divulge, &connection, "POST /echo HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\npost"));
+}
+
+static void test_request_methods(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/item", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "get");
+    register_route(divulge, "/item", DIVULGE_ROUTE_METHOD_PUT, respond_with_context, "put");
+    register_route(divulge, "/item", DIVULGE_ROUTE_METHOD_DELETE, respond_with_context, "delete");
+    register_route(divulge, "/item", DIVULGE_ROUTE_METHOD_PATCH, respond_with_context, "patch");
+    register_route(divulge, "/item", DIVULGE_ROUTE_METHOD_OPTIONS, respond_with_context, "options");
+    register_route(divulge, "/item", DIVULGE_ROUTE_METHOD_ANY, respond_with_context, "any");
+    register_route(divulge, "/own", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "get");
+    register_route(divulge, "/own", DIVULGE_ROUTE_METHOD_HEAD, respond_with_context, "head");
+    test_connection_t connection;
+    const char* requests[][2] = {
+        {"GET /item HTTP/1.1\r\n\r\n", "\r\n\r\nget"},
+        {"PUT /item HTTP/1.1\r\n\r\n", "\r\n\r\nput"},
+        {"DELETE /item HTTP/1.1\r\n\r\n", "\r\n\r\ndelete"},
+        {"PATCH /item HTTP/1.1\r\n\r\n", "\r\n\r\npatch"},
+        {"OPTIONS /item HTTP/1.1\r\n\r\n", "\r\n\r\noptions"},
+        {"POST /item HTTP/1.1\r\n\r\n", "\r\n\r\nany"},
+        {"PUSH /item HTTP/1.1\r\n\r\n", "\r\n\r\nany"},
+        {"put /item HTTP/1.1\r\n\r\n", "\r\n\r\nany"},
+        {"PROPFIND /item HTTP/1.1\r\n\r\n", "\r\n\r\nany"},
+    };
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+        test_connection_process(divulge, &connection, requests[i][0]);
+        assert_true(test_connection_contains(&connection, requests[i][1]));
+    }
+
+    test_connection_process(divulge, &connection, "HEAD /item HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "HTTP/1.1 200 OK\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 3\r\n"));
+    assert_int_equal(strlen(strstr(connection.output, "\r\n\r\n")), 4);
+
+    test_connection_process(divulge, &connection, "HEAD /own HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "Content-Length: 4\r\n"));
+    assert_int_equal(strlen(strstr(connection.output, "\r\n\r\n")), 4);
+
+    assert_string_equal(divulge_method_name_from_method(DIVULGE_ROUTE_METHOD_OPTIONS), "OPTIONS");
+    assert_string_equal(divulge_method_name_from_method(DIVULGE_ROUTE_METHOD_ANY), "ANY");
+}
+
+static bool reject_middleware(divulge_request_t* request, void* context) {
+    respond_with_context(request, "rejected");
+    return false;
+}
+
+static void test_middleware_is_bound_to_route(void** state) {
+    divulge_t* divulge = create_router();
+    divulge_uri_t guarded = {
+        .uri = "/guarded/{id}",
+        .method = DIVULGE_ROUTE_METHOD_GET,
+        .handler = {.handler = respond_with_context, .context = "guarded"},
+    };
+    divulge_handler_object_t middleware = {.handler = reject_middleware};
+    divulge_register_uri(divulge, &guarded);
+    divulge_add_middleware_to_uri(divulge, &guarded, &middleware);
+    register_route(divulge, "/open/{id}", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "open");
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /guarded/1 HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "rejected"));
+    assert_false(test_connection_contains(&connection, "\r\n\r\nguarded"));
+
+    test_connection_process(divulge, &connection, "GET /open/1 HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nopen"));
+}
+
+static bool check_request_headers(divulge_request_t* request, void* context) {
+    assert_int_equal(request->header_count, 3);
+    static_string_t value = divulge_get_request_header(request, "content-type");
+    assert_int_equal(value.length, strlen("text/plain"));
+    assert_memory_equal(value.text, "text/plain", value.length);
+    value = divulge_get_request_header(request, "CONTENT-TYPE");
+    assert_memory_equal(value.text, "text/plain", value.length);
+    value = divulge_get_request_header(request, "Authorization");
+    assert_int_equal(value.length, 0);
+    assert_ptr_equal(value.text, NULL);
+    value = divulge_get_request_header(request, "X-Empty");
+    assert_int_equal(value.length, 0);
+    assert_ptr_not_equal(value.text, NULL);
+
+    const char* entry = divulge_find_request_header_key(request, "x-note");
+    assert_ptr_not_equal(entry, NULL);
+    assert_string_equal(divulge_get_request_header_entry_value(entry), "Authorization: none");
+    assert_string_equal(divulge_get_request_header_entry_value(entry), "Authorization: none");
+    assert_ptr_equal(divulge_find_request_header_key(request, "Authorization"), NULL);
+    assert_ptr_equal(divulge_find_request_header_key(request, "Content"), NULL);
+    return respond_with_context(request, "headers");
+}
+
+static void test_request_headers(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/headers", DIVULGE_ROUTE_METHOD_GET, check_request_headers, NULL);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection,
+            "GET /headers HTTP/1.1\r\nX-Note: Authorization: none\r\nContent-Type:  text/plain \r\n"
+            "X-Empty:\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\nheaders"));
+}
+
+static void test_incomplete_or_malformed_request(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "root");
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET / HTTP/1.1\r\nHost: local");
+    assert_true(test_connection_contains(&connection, "400 Bad Request"));
+    assert_true(connection.was_closed);
+
+    test_connection_process(divulge, &connection, "GET /\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "400 Bad Request"));
+}
+
+static void test_serve_fragmented_request(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/devices/{id}", DIVULGE_ROUTE_METHOD_GET, respond_with_parameters, NULL);
+    test_connection_t connection;
+
+    for (size_t chunk_size = 1; chunk_size < 8; chunk_size++) {
+        serve(divulge, &connection, "GET /devices/7?verbose=1 HTTP/1.1\r\nHost: localhost\r\n\r\n", chunk_size);
+        assert_true(test_connection_contains(&connection, "\r\n\r\nid=7;"));
+        assert_true(connection.was_closed);
+    }
+
+    serve(divulge, &connection, "GET /devices/7 HTTP/1.1\r\nHost: loc", 5);
+    assert_int_equal(connection.output_size, 0);
+    assert_true(connection.was_closed);
+}
+
+static void test_serve_too_large_request(void** state) {
+    divulge_t* divulge = create_router();
+    char request[TEST_BUFFER_SIZE * 2] = "GET / HTTP/1.1\r\nX-Long: ";
+    while (strlen(request) < TEST_BUFFER_SIZE) {
+        strcat(request, "value ");
+    }
+    test_connection_t connection;
+
+    serve(divulge, &connection, request, 100);
+    assert_true(test_connection_contains(&connection, "431"));
+    assert_true(connection.was_closed);
+}
+
+static void test_serve_too_many_headers(void** state) {
+    divulge_t* divulge = create_router();
+    char request[TEST_BUFFER_SIZE] = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= DIVULGE_REQUEST_PARSER_HEADERS_MAX_COUNT; i++) {
+        strcat(request, "X-Tag: 1\r\n");
+    }
+    strcat(request, "\r\n");
+    test_connection_t connection;
+
+    serve(divulge, &connection, request, 100);
+    assert_true(test_connection_contains(&connection, "HTTP/1.1 431 "));
+    assert_true(connection.was_closed);
+}
+
+static void test_keep_alive_pipelined_requests(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    register_route(divulge, "/b", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "second");
+    register_route(divulge, "/echo", DIVULGE_ROUTE_METHOD_POST, respond_with_payload, NULL);
+    test_connection_t connection;
+    const char* requests =
+        "GET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+        "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+        "GET /b HTTP/1.1\r\nHost: x\r\n\r\n";
+
+    serve(divulge, &connection, requests, strlen(requests));
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 3);
+    assert_true(test_connection_contains(&connection, "Content-Length: 5\r\n\r\nfirst"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 5\r\n\r\nhello"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 6\r\n\r\nsecond"));
+    assert_false(test_connection_contains(&connection, "Connection: close"));
+    assert_int_equal(connection.receive_timeout_ms, 1500);
+    assert_true(connection.was_closed);
+
+    serve(divulge, &connection, requests, 3);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 3);
+    assert_true(test_connection_contains(&connection, "\r\n\r\nhello"));
+}
+
+static void test_keep_alive_connection_close(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    test_connection_t connection;
+
+    serve(divulge, &connection, "GET /a HTTP/1.1\r\nConnection: Close\r\n\r\nGET /a HTTP/1.1\r\n\r\n", 100);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 1);
+    assert_true(test_connection_contains(&connection, "Connection: close"));
+
+    serve(divulge, &connection, "GET /a HTTP/1.0\r\n\r\nGET /a HTTP/1.0\r\n\r\n", 100);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 1);
+
+    serve(divulge, &connection, "GET /a HTTP/1.0\r\nConnection: keep-alive\r\n\r\nGET /a HTTP/1.1\r\n\r\n", 100);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 2);
+    assert_true(test_connection_contains(&connection, "Connection: keep-alive"));
+}
+
+static void test_response_is_sent_in_single_write(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /a HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nfirst"));
+    assert_int_equal(connection.send_count, 1);
+
+    test_connection_process(divulge, &connection, "GET /missing HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "404"));
+    assert_int_equal(connection.send_count, 1);
+}
+
+static void test_large_response_is_sent_as_vector(void** state) {
+    char payload[TEST_BUFFER_SIZE * 2];
+    memset(payload, 'x', sizeof(payload) - 1);
+    payload[sizeof(payload) - 1] = '\0';
+    divulge_configuration_t configuration = test_connection_create_configuration();
+    configuration.sendv = test_send_vector;
+    divulge_t* divulge = divulge_initialize(&configuration);
+    register_route(divulge, "/large", DIVULGE_ROUTE_METHOD_GET, respond_with_context, payload);
+    test_connection_t connection;
+
+    test_connection_process(divulge, &connection, "GET /large HTTP/1.1\r\n\r\n");
+    assert_int_equal(connection.vector_send_count, 1);
+    assert_int_equal(connection.send_count, 0);
+    assert_true(test_connection_contains(&connection, "Content-Length: 2047\r\n\r\nxxx"));
+    assert_int_equal(strlen(strstr(connection.output, "\r\n\r\n")), sizeof(payload) - 1 + 4);
+
+    divulge = create_router();
+    register_route(divulge, "/large", DIVULGE_ROUTE_METHOD_GET, respond_with_context, payload);
+
+    test_connection_process(divulge, &connection, "GET /large HTTP/1.1\r\n\r\n");
+    assert_int_equal(connection.send_count, 2);
+    assert_true(test_connection_contains(&connection, "Content-Length: 2047\r\n\r\nxxx"));
+}
+
+static bool respond_with_chunks(divulge_request_t* request, void* context) {
+    divulge_header_entry_t header_entries[] = {{.key = "Content-Type", .value = "text/plain"}};
+    divulge_response_t response = {
+        .return_code = 200,
+        .header = {.count = 1, .entries = header_entries},
+    };
+    divulge_begin_chunked_response(request, &response);
+    divulge_send_chunk(request, "hello", 5);
+    divulge_send_chunk(request, "", 0);
+    divulge_send_chunk(request, (const char*)context, strlen((const char*)context));
+    if (strcmp(request->route, "/unfinished") != 0) {
+        divulge_end_chunked_response(request);
+    }
+    return true;
+}
+
+static void test_chunked_response(void** state) {
+    char payload[TEST_BUFFER_SIZE + 3];
+    memset(payload, 'x', sizeof(payload) - 1);
+    payload[sizeof(payload) - 1] = '\0';
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/stream", DIVULGE_ROUTE_METHOD_GET, respond_with_chunks, ", world");
+    register_route(divulge, "/unfinished", DIVULGE_ROUTE_METHOD_GET, respond_with_chunks, "!");
+    register_route(divulge, "/large", DIVULGE_ROUTE_METHOD_GET, respond_with_chunks, payload);
+    test_connection_t connection;
+
+    serve(divulge, &connection, "GET /stream HTTP/1.1\r\n\r\nGET /unfinished HTTP/1.1\r\n\r\n", 100);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 2);
+    assert_int_equal(count_occurrences(&connection, "Transfer-Encoding: chunked\r\n"), 2);
+    assert_false(test_connection_contains(&connection, "Content-Length"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\n5\r\nhello\r\n7\r\n, world\r\n0\r\n\r\nHTTP/1.1"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\n5\r\nhello\r\n1\r\n!\r\n0\r\n\r\n"));
+    assert_false(test_connection_contains(&connection, "Connection: close"));
+
+    serve(divulge, &connection, "GET /large HTTP/1.1\r\n\r\n", 100);
+    assert_true(test_connection_contains(&connection, "\r\n\r\n5\r\nhello\r\n402\r\nxxx"));
+    assert_true(test_connection_contains(&connection, "xxx\r\n0\r\n\r\n"));
+
+    serve(divulge, &connection, "GET /stream HTTP/1.0\r\nConnection: keep-alive\r\n\r\nGET /stream HTTP/1.0\r\n\r\n",
+          100);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 1);
+    assert_true(test_connection_contains(&connection, "Connection: close\r\n"));
+    assert_false(test_connection_contains(&connection, "Transfer-Encoding"));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nhello, world"));
+    assert_true(connection.was_closed);
+
+    serve(divulge, &connection, "HEAD /stream HTTP/1.1\r\n\r\nGET /stream HTTP/1.1\r\n\r\n", 100);
+    assert_int_equal(count_occurrences(&connection, "Transfer-Encoding: chunked\r\n"), 2);
+    assert_true(test_connection_contains(&connection, "\r\n\r\nHTTP/1.1 200 OK"));
+    assert_int_equal(count_occurrences(&connection, "hello"), 1);
+}
+
+static void test_keep_alive_max_requests(void** state) {
+    divulge_t* divulge = create_router_with_limits(2, 0);
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    test_connection_t connection;
+
+    serve(divulge, &connection, "GET /a HTTP/1.1\r\n\r\nGET /a HTTP/1.1\r\n\r\nGET /a HTTP/1.1\r\n\r\n", 100);
+    assert_int_equal(count_occurrences(&connection, "200 OK"), 2);
+    assert_int_equal(count_occurrences(&connection, "Connection: close"), 1);
+    assert_true(connection.was_closed);
+}
+
+typedef struct test_upload {
+    size_t size;
+    size_t call_count;
+    bool is_valid;
+} test_upload_t;
+
+static bool receive_upload(divulge_request_t* request, const char* data, size_t data_size, void* context) {
+    test_upload_t* upload = (test_upload_t*)context;
+    for (size_t i = 0; i < data_size; i++) {
+        upload->is_valid = upload->is_valid && (data[i] == (char)('a' + ((upload->size + i) % 26)));
+    }
+    upload->size += data_size;
+    upload->call_count++;
+    return upload->size <= (TEST_BUFFER_SIZE * 4);
+}
+
+static bool respond_with_upload_size(divulge_request_t* request, void* context) {
+    test_upload_t* upload = (test_upload_t*)context;
+    char text[32];
+    snprintf(text, sizeof(text), "%zu", upload->size);
+    return respond_with_context(request, text);
+}
+
+static void register_upload_route(divulge_t* divulge, test_upload_t* upload) {
+    divulge_uri_t route = {
+        .uri = "/upload",
+        .method = DIVULGE_ROUTE_METHOD_POST,
+        .handler = {.handler = respond_with_upload_size, .context = upload},
+        .body_handler = receive_upload,
+    };
+    divulge_register_uri(divulge, &route);
+}
+
+static size_t write_upload_request(char* buffer, size_t body_size, const char* trailing_request) {
+    size_t size = (size_t)sprintf(buffer, "POST /upload HTTP/1.1\r\nContent-Length: %zu\r\n\r\n", body_size);
+    for (size_t i = 0; i < body_size; i++) {
+        buffer[size++] = (char)('a' + (i % 26));
+    }
+    strcpy(buffer + size, trailing_request);
+    return size + strlen(trailing_request);
+}
+
+static void test_streamed_request_body(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    test_upload_t upload = {.is_valid = true};
+    register_upload_route(divulge, &upload);
+    test_connection_t connection;
+    static char requests[TEST_BUFFER_SIZE * 8];
+
+    write_upload_request(requests, TEST_BUFFER_SIZE * 3, "GET /a HTTP/1.1\r\n\r\n");
+    serve(divulge, &connection, requests, 100);
+    assert_true(upload.is_valid);
+    assert_int_equal(upload.size, TEST_BUFFER_SIZE * 3);
+    assert_true(upload.call_count > 1);
+    assert_true(test_connection_contains(&connection, "Content-Length: 4\r\n\r\n3072"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 5\r\n\r\nfirst"));
+
+    upload = (test_upload_t){.is_valid = true};
+    serve(divulge, &connection,
+          "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+          "3\r\nabc\r\n5;ext=1\r\ndefgh\r\n0\r\n\r\n"
+          "GET /a HTTP/1.1\r\n\r\n",
+          7);
+    assert_true(upload.is_valid);
+    assert_int_equal(upload.size, 8);
+    assert_true(test_connection_contains(&connection, "Content-Length: 1\r\n\r\n8"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 5\r\n\r\nfirst"));
+
+    upload = (test_upload_t){.is_valid = true};
+    write_upload_request(requests, TEST_BUFFER_SIZE * 6, "GET /a HTTP/1.1\r\n\r\n");
+    serve(divulge, &connection, requests, 100);
+    assert_true(test_connection_contains(&connection, "400 Bad Request"));
+    assert_false(test_connection_contains(&connection, "first"));
+    assert_true(connection.was_closed);
+}
+
+static void test_buffered_request_body(void** state) {
+    divulge_t* divulge = create_router();
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    register_route(divulge, "/echo", DIVULGE_ROUTE_METHOD_POST, respond_with_payload, NULL);
+    test_connection_t connection;
+    static char requests[TEST_BUFFER_SIZE * 2];
+
+    serve(divulge, &connection,
+          "POST /echo HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+          "5\r\nhello\r\n7\r\n, world\r\n0\r\nX-Trailer: 1\r\n\r\n"
+          "GET /a HTTP/1.1\r\n\r\n",
+          3);
+    assert_true(test_connection_contains(&connection, "Content-Length: 12\r\n\r\nhello, world"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 5\r\n\r\nfirst"));
+
+    serve(divulge, &connection, "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nx\r\n", 100);
+    assert_true(test_connection_contains(&connection, "400 Bad Request"));
+    assert_true(connection.was_closed);
+
+    serve(divulge, &connection, "POST /echo HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\nhello", 100);
+    assert_true(test_connection_contains(&connection, "400 Bad Request"));
+
+    serve(divulge, &connection, "POST /echo HTTP/1.1\r\nContent-Length: 5x\r\n\r\nhello", 100);
+    assert_true(test_connection_contains(&connection, "400 Bad Request"));
+
+    serve(divulge, &connection, "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nhel", 100);
+    assert_false(test_connection_contains(&connection, "200 OK"));
+    assert_true(connection.was_closed);
+
+    size_t size = (size_t)sprintf(requests, "POST /echo HTTP/1.1\r\nContent-Length: %d\r\n\r\n", TEST_BUFFER_SIZE);
+    memset(requests + size, 'x', TEST_BUFFER_SIZE);
+    requests[size + TEST_BUFFER_SIZE] = '\0';
+    serve(divulge, &connection, requests, 100);
+    assert_true(test_connection_contains(&connection, "413 Payload Too Large"));
+    assert_true(test_connection_contains(&connection, "Connection: close"));
+    assert_true(connection.was_closed);
+}
+
+static bool defer_response(divulge_request_t* request, void* context) {
+    divulge_deferred_response_t** deferred = (divulge_deferred_response_t**)context;
+    *deferred = divulge_defer_response(request);
+    assert_ptr_not_equal(*deferred, NULL);
+    assert_ptr_equal(divulge_defer_response(request), NULL);
+    return true;
+}
+
+static void test_deferred_response(void** state) {
+    divulge_t* divulge = create_router();
+    divulge_deferred_response_t* deferred = NULL;
+    register_route(divulge, "/slow", DIVULGE_ROUTE_METHOD_GET, defer_response, &deferred);
+    register_route(divulge, "/a", DIVULGE_ROUTE_METHOD_GET, respond_with_context, "first");
+    test_connection_t connection;
+
+    serve(divulge, &connection, "GET /slow HTTP/1.1\r\n\r\nGET /a HTTP/1.1\r\n\r\n", 100);
+    assert_int_equal(connection.output_size, 0);
+    assert_false(connection.was_closed);
+    divulge_response_t response = {
+        .return_code = 200,
+        .payload = "late",
+        .payload_size = 4,
+    };
+    assert_true(divulge_complete_deferred_response(deferred, &response));
+    assert_true(test_connection_contains(&connection, "HTTP/1.1 200 OK\r\n"));
+    assert_true(test_connection_contains(&connection, "Connection: close\r\n"));
+    assert_true(test_connection_contains(&connection, "Content-Length: 4\r\n\r\nlate"));
+    assert_false(test_connection_contains(&connection, "first"));
+    assert_int_equal(connection.send_count, 1);
+    assert_true(connection.was_closed);
+
+    test_connection_process(divulge, &connection, "GET /slow HTTP/1.1\r\n\r\n");
+    assert_false(connection.was_closed);
+    divulge_request_t* request = divulge_get_deferred_request(deferred);
+    assert_true(divulge_begin_chunked_response(request, &response));
+    assert_true(divulge_send_chunk(request, "abc", 3));
+    assert_true(divulge_complete_deferred_response(deferred, NULL));
+    assert_true(test_connection_contains(&connection, "Transfer-Encoding: chunked\r\n"));
+    assert_true(test_connection_contains(&connection, "3\r\nabc\r\n0\r\n\r\n"));
+    assert_true(connection.was_closed);
+
+    serve(divulge, &connection, "GET /slow HTTP/1.1\r\n\r\n", 100);
+    assert_true(divulge_complete_deferred_response(deferred, NULL));
+    assert_true(test_connection_contains(&connection, "500 Internal server error"));
+    assert_false(divulge_complete_deferred_response(NULL, NULL));
+}
+
+static bool respond_from_arena(divulge_request_t* request, void* context) {
+    char* first = divulge_allocate(request, 200);
+    char* second = divulge_allocate(request, 1);
+    char* third = divulge_allocate(request, 200);
+    assert_ptr_not_equal(first, NULL);
+    assert_ptr_not_equal(second, NULL);
+    assert_ptr_not_equal(third, NULL);
+    assert_int_equal((uintptr_t)third % _Alignof(max_align_t), 0);
+    assert_ptr_equal(divulge_allocate(request, 200), NULL);
+    snprintf(third, 200, "arena %s", request->route);
+    divulge_response_t response = {.return_code = 200, .payload = third, .payload_size = strlen(third)};
+    return divulge_respond(request, &response);
+}
+
+static bool defer_with_arena(divulge_request_t* request, void* context) {
+    char** text = (char**)context;
+    *text = divulge_allocate(request, 8);
+    assert_ptr_not_equal(*text, NULL);
+    strcpy(*text, "kept");
+    divulge_deferred_response_t* deferred = divulge_defer_response(request);
+    assert_ptr_not_equal(deferred, NULL);
+    assert_ptr_equal(divulge_allocate(request, 8), NULL);
+    text[1] = (char*)deferred;
+    return true;
+}
+
+static bool check_no_arena(divulge_request_t* request, void* context) {
+    assert_ptr_equal(divulge_allocate(request, 1), NULL);
+    return respond_with_context(request, "none");
+}
+
+static void test_request_arena(void** state) {
+    divulge_t* divulge = create_router_with_limits(0, 512);
+    register_route(divulge, "/arena", DIVULGE_ROUTE_METHOD_GET, respond_from_arena, NULL);
+    char* deferred_context[2] = {NULL, NULL};
+    register_route(divulge, "/defer", DIVULGE_ROUTE_METHOD_GET, defer_with_arena, deferred_context);
+    test_connection_t connection;
+    const char* requests =
+        "GET /arena HTTP/1.1\r\n\r\n"
+        "GET /arena HTTP/1.1\r\n\r\n"
+        "GET /arena HTTP/1.1\r\n\r\n";
+
+    serve(divulge, &connection, requests, strlen(requests));
+    assert_int_equal(count_occurrences(&connection, "Content-Length: 12\r\n\r\narena /arena"), 3);
+
+    test_connection_process(divulge, &connection, "GET /arena HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "\r\n\r\narena /arena"));
+
+    serve(divulge, &connection, "GET /defer HTTP/1.1\r\n\r\n", 100);
+    divulge_deferred_response_t* deferred = (divulge_deferred_response_t*)deferred_context[1];
+    divulge_request_t* request = divulge_get_deferred_request(deferred);
+    assert_ptr_not_equal(divulge_allocate(request, 8), NULL);
+    divulge_response_t response = {.return_code = 200, .payload = deferred_context[0], .payload_size = 4};
+    assert_true(divulge_complete_deferred_response(deferred, &response));
+    assert_true(test_connection_contains(&connection, "\r\n\r\nkept"));
+
+    divulge_t* no_arena = create_router();
+    register_route(no_arena, "/none", DIVULGE_ROUTE_METHOD_GET, check_no_arena, NULL);
+    test_connection_process(no_arena, &connection, "GET /none HTTP/1.1\r\n\r\n");
+    assert_true(test_connection_contains(&connection, "200 OK"));
+}
 
 int main(int argc, char** argv) {
     const struct CMUnitTest tests[] = {
-        cmocka_unit_test(test_dummy),
+        cmocka_unit_test(test_static_routes),
+        cmocka_unit_test(test_parameter_routes),
+        cmocka_unit_test(test_route_parameter_lookup),
+        cmocka_unit_test(test_wildcard_routes),
+        cmocka_unit_test(test_any_method_route),
+        cmocka_unit_test(test_request_methods),
+        cmocka_unit_test(test_middleware_is_bound_to_route),
+        cmocka_unit_test(test_request_headers),
+        cmocka_unit_test(test_incomplete_or_malformed_request),
+        cmocka_unit_test(test_serve_fragmented_request),
+        cmocka_unit_test(test_serve_too_large_request),
+        cmocka_unit_test(test_serve_too_many_headers),
+        cmocka_unit_test(test_keep_alive_pipelined_requests),
+        cmocka_unit_test(test_keep_alive_connection_close),
+        cmocka_unit_test(test_keep_alive_max_requests),
+        cmocka_unit_test(test_response_is_sent_in_single_write),
+        cmocka_unit_test(test_large_response_is_sent_as_vector),
+        cmocka_unit_test(test_chunked_response),
+        cmocka_unit_test(test_streamed_request_body),
+        cmocka_unit_test(test_buffered_request_body),
+        cmocka_unit_test(test_deferred_response),
+        cmocka_unit_test(test_request_arena),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -23,6 +23,7 @@
  */
 #include "encodings-base64.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 static bool is_padding_character(char letter) {
@@ -96,3 +97,36 @@ void encodings_base64_decode(const char* base64, char* decoded) {
         decoded += 3;
     }
 }
+
+size_t encodings_base64_get_encode_buffer_size(size_t data_size) {
+    return (((data_size + 2) / 3) * 4) + 1;
+}
+
+void encodings_base64_encode(const void* data, size_t data_size, char* base64) {
+    if ((!data && (data_size > 0)) || !base64) {
+        return;
+    }
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const unsigned char* input = (const unsigned char*)data;
+    size_t position = 0;
+    for (; (position + 3) <= data_size; position += 3) {
+        uint32_t triplet = ((uint32_t)input[position] << 16) | ((uint32_t)input[position + 1] << 8) |
+                           (uint32_t)input[position + 2];
+        *base64++ = alphabet[(triplet >> 18) & 0x3F];
+        *base64++ = alphabet[(triplet >> 12) & 0x3F];
+        *base64++ = alphabet[(triplet >> 6) & 0x3F];
+        *base64++ = alphabet[triplet & 0x3F];
+    }
+    size_t remaining_size = data_size - position;
+    if (remaining_size > 0) {
+        uint32_t triplet = (uint32_t)input[position] << 16;
+        if (remaining_size > 1) {
+            triplet |= (uint32_t)input[position + 1] << 8;
+        }
+        *base64++ = alphabet[(triplet >> 18) & 0x3F];
+        *base64++ = alphabet[(triplet >> 12) & 0x3F];
+        *base64++ = (remaining_size > 1) ? alphabet[(triplet >> 6) & 0x3F] : '=';
+        *base64++ = '=';
+    }
+    *base64 = '\0';
+}
@@ -48,6 +48,24 @@ size_t encodings_base64_get_decode_buffer_size(const char* base64);
  */
 void encodings_base64_decode(const char* base64, char* decoded);
 
+/**
+ * @brief Get the required size of destination buffer for Base64 encoded content
+ * @param[in] data_size size of the data to encode
+ * @return size of the buffer needed to hold the encoded C-string (including
+ * the terminating null character)
+ */
+size_t encodings_base64_get_encode_buffer_size(size_t data_size);
+
+/**
+ * @brief Encode data to Base64 C-string
+ * @param[in] data pointer to input data
+ * @param[in] data_size size of the input data
+ * @param[out] base64 pointer to destination buffer for the encoded C-string
+ * @note The destination buffer needs to be able to hold
+ * encodings_base64_get_encode_buffer_size() characters!
+ */
+void encodings_base64_encode(const void* data, size_t data_size, char* base64);
+
 /**
  * @}
  */
@@ -0,0 +1,663 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "encodings-deflate.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_MATCH_LENGTH (3)
+#define MAX_MATCH_LENGTH (258)
+#define MAX_CHAIN_LENGTH (64)
+#define END_OF_BLOCK (256)
+#define FIRST_LENGTH_CODE (257)
+#define LENGTH_CODE_COUNT (29)
+#define CODE_LENGTH_CODE_COUNT (19)
+#define MAX_CODE_LENGTH (15)
+#define MAX_CODE_LENGTH_CODE_LENGTH (7)
+#define MIN_LITERAL_CODE_COUNT (257)
+#define MIN_CODE_LENGTH_CODE_COUNT (4)
+#define STORED_BLOCK_MAX_SIZE (65535)
+#define STORED_BLOCK_HEADER_BITS (40)
+#define BLOCK_HEADER_BITS (3)
+#define DYNAMIC_TREES_HEADER_BITS (14)
+#define TREE_MAX_SYMBOL_COUNT (ENCODINGS_DEFLATE_LITERAL_CODE_COUNT)
+#define LENGTHS_MAX_COUNT (ENCODINGS_DEFLATE_LITERAL_CODE_COUNT + ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT)
+#define REPEAT_PREVIOUS (16)
+#define REPEAT_ZERO (17)
+#define REPEAT_ZERO_LONG (18)
+#define ZLIB_METHOD_DEFLATE (8)
+#define ZLIB_CHECK_MODULO (31)
+#define GZIP_OS_UNKNOWN (255)
+#define ADLER_MODULO (65521)
+#define ADLER_MAX_RUN (5552)
+
+typedef enum block_type {
+    BLOCK_TYPE_STORED = 0,
+    BLOCK_TYPE_FIXED = 1,
+    BLOCK_TYPE_DYNAMIC = 2,
+} block_type_t;
+
+typedef struct huffman_tree {
+    uint8_t lengths[TREE_MAX_SYMBOL_COUNT];
+    uint16_t codes[TREE_MAX_SYMBOL_COUNT];
+} huffman_tree_t;
+
+typedef struct dynamic_trees {
+    huffman_tree_t literals;
+    huffman_tree_t distances;
+    huffman_tree_t code_lengths;
+    size_t literal_count;
+    size_t distance_count;
+    size_t code_length_count;
+    uint8_t symbols[LENGTHS_MAX_COUNT];
+    uint8_t extras[LENGTHS_MAX_COUNT];
+    size_t symbol_count;
+} dynamic_trees_t;
+
+static const uint16_t length_bases[LENGTH_CODE_COUNT] = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,
+                                                         15, 17, 19, 23, 27, 31, 35, 43,  51,  59,
+                                                         67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t length_extra_bits[LENGTH_CODE_COUNT] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                             2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distance_bases[ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT] = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distance_extra_bits[ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8_t code_length_order[CODE_LENGTH_CODE_COUNT] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                                  11, 4,  12, 3, 13, 2, 14, 1, 15};
+static const uint32_t crc32_table[16] = {0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+                                         0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+                                         0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+
+static void flush_output(encodings_deflate_t* deflate) {
+    if (deflate->output_size > 0) {
+        deflate->output(deflate->output_context, deflate->output_buffer, deflate->output_size);
+        deflate->output_size = 0;
+    }
+}
+
+static void write_byte(encodings_deflate_t* deflate, uint8_t byte) {
+    if (deflate->output_size == ENCODINGS_DEFLATE_OUTPUT_BUFFER_SIZE) {
+        flush_output(deflate);
+    }
+    deflate->output_buffer[deflate->output_size++] = byte;
+}
+
+static void write_bits(encodings_deflate_t* deflate, uint32_t value, uint32_t count) {
+    deflate->bit_buffer |= value << deflate->bit_count;
+    deflate->bit_count += count;
+    while (deflate->bit_count >= 8) {
+        write_byte(deflate, (uint8_t)deflate->bit_buffer);
+        deflate->bit_buffer >>= 8;
+        deflate->bit_count -= 8;
+    }
+}
+
+static void align_to_byte(encodings_deflate_t* deflate) {
+    if (deflate->bit_count > 0) {
+        write_bits(deflate, 0, 8 - deflate->bit_count);
+    }
+}
+
+static void write_uint32_big_endian(encodings_deflate_t* deflate, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        write_byte(deflate, (uint8_t)(value >> shift));
+    }
+}
+
+static void write_uint32_little_endian(encodings_deflate_t* deflate, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        write_byte(deflate, (uint8_t)(value >> shift));
+    }
+}
+
+static size_t find_length_code(size_t length) {
+    size_t code = LENGTH_CODE_COUNT - 1;
+    while (length_bases[code] > length) {
+        code--;
+    }
+    return code;
+}
+
+static size_t find_distance_code(size_t distance) {
+    size_t code = ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT - 1;
+    while (distance_bases[code] > distance) {
+        code--;
+    }
+    return code;
+}
+
+static int compare_keys(const void* first, const void* second) {
+    uint32_t first_key = *(const uint32_t*)first;
+    uint32_t second_key = *(const uint32_t*)second;
+    return (first_key > second_key) - (first_key < second_key);
+}
+
+/* Leaves are sorted by weight, then merged with two queues; the node weights grow monotonically. */
+static uint8_t build_huffman_lengths(const uint32_t* weights, size_t count, uint8_t* lengths) {
+    uint32_t keys[TREE_MAX_SYMBOL_COUNT];
+    uint32_t node_weights[2 * TREE_MAX_SYMBOL_COUNT];
+    uint16_t parents[2 * TREE_MAX_SYMBOL_COUNT];
+    uint8_t depths[2 * TREE_MAX_SYMBOL_COUNT];
+    size_t leaf_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        lengths[i] = 0;
+        if (weights[i] > 0) {
+            keys[leaf_count++] = (weights[i] << 9) | (uint32_t)i;
+        }
+    }
+    qsort(keys, leaf_count, sizeof(uint32_t), compare_keys);
+    for (size_t i = 0; i < leaf_count; i++) {
+        node_weights[i] = keys[i] >> 9;
+    }
+    size_t next_leaf = 0;
+    size_t next_internal = leaf_count;
+    size_t node_count = leaf_count;
+    while (node_count < ((2 * leaf_count) - 1)) {
+        size_t children[2];
+        for (size_t i = 0; i < 2; i++) {
+            if ((next_leaf < leaf_count) &&
+                ((next_internal == node_count) || (node_weights[next_leaf] <= node_weights[next_internal]))) {
+                children[i] = next_leaf++;
+            } else {
+                children[i] = next_internal++;
+            }
+        }
+        node_weights[node_count] = node_weights[children[0]] + node_weights[children[1]];
+        parents[children[0]] = (uint16_t)node_count;
+        parents[children[1]] = (uint16_t)node_count;
+        node_count++;
+    }
+    uint8_t max_length = 0;
+    depths[node_count - 1] = 0;
+    for (size_t node = node_count - 1; node-- > 0;) {
+        depths[node] = depths[parents[node]] + 1;
+        if (node < leaf_count) {
+            lengths[keys[node] & 0x1FF] = depths[node];
+            max_length = (depths[node] > max_length) ? depths[node] : max_length;
+        }
+    }
+    return max_length;
+}
+
+/* At least two codes are always defined, so every tree is complete. Overlong codes are shortened by flattening the
+ * weights until the tree fits. */
+static void build_tree(const uint16_t* frequencies, size_t count, uint8_t max_length, huffman_tree_t* tree) {
+    uint32_t weights[TREE_MAX_SYMBOL_COUNT];
+    size_t used_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        weights[i] = frequencies[i];
+        used_count += (weights[i] > 0) ? 1 : 0;
+    }
+    for (size_t i = 0; used_count < 2; i++) {
+        if (weights[i] == 0) {
+            weights[i] = 1;
+            used_count++;
+        }
+    }
+    while (build_huffman_lengths(weights, count, tree->lengths) > max_length) {
+        for (size_t i = 0; i < count; i++) {
+            weights[i] = (weights[i] + 1) >> 1;
+        }
+    }
+}
+
+static uint16_t reverse_bits(uint16_t code, uint8_t length) {
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        reversed = (uint16_t)((reversed << 1) | (code & 1));
+        code >>= 1;
+    }
+    return reversed;
+}
+
+static void assign_codes(huffman_tree_t* tree, size_t count) {
+    uint16_t length_counts[MAX_CODE_LENGTH + 1] = {0};
+    for (size_t i = 0; i < count; i++) {
+        length_counts[tree->lengths[i]]++;
+    }
+    length_counts[0] = 0;
+    uint16_t next_codes[MAX_CODE_LENGTH + 1] = {0};
+    uint16_t code = 0;
+    for (size_t length = 1; length <= MAX_CODE_LENGTH; length++) {
+        code = (uint16_t)((code + length_counts[length - 1]) << 1);
+        next_codes[length] = code;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint8_t length = tree->lengths[i];
+        tree->codes[i] = (length > 0) ? reverse_bits(next_codes[length]++, length) : 0;
+    }
+}
+
+static void build_fixed_trees(huffman_tree_t* literals, huffman_tree_t* distances) {
+    for (size_t i = 0; i < ENCODINGS_DEFLATE_LITERAL_CODE_COUNT; i++) {
+        literals->lengths[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+    }
+    assign_codes(literals, ENCODINGS_DEFLATE_LITERAL_CODE_COUNT);
+    for (size_t i = 0; i < ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT; i++) {
+        distances->lengths[i] = 5;
+    }
+    assign_codes(distances, ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT);
+}
+
+static void append_code_length_symbol(dynamic_trees_t* trees, uint16_t* frequencies, uint8_t symbol, uint8_t extra) {
+    trees->symbols[trees->symbol_count] = symbol;
+    trees->extras[trees->symbol_count++] = extra;
+    frequencies[symbol]++;
+}
+
+/* Literal and distance code lengths form one sequence, so runs may cross from one tree into the other. */
+static void encode_code_lengths(dynamic_trees_t* trees, uint16_t* frequencies) {
+    uint8_t lengths[LENGTHS_MAX_COUNT];
+    size_t count = trees->literal_count + trees->distance_count;
+    memcpy(lengths, trees->literals.lengths, trees->literal_count);
+    memcpy(lengths + trees->literal_count, trees->distances.lengths, trees->distance_count);
+    trees->symbol_count = 0;
+    for (size_t i = 0; i < count;) {
+        uint8_t length = lengths[i];
+        size_t run = 1;
+        while (((i + run) < count) && (lengths[i + run] == length)) {
+            run++;
+        }
+        i += run;
+        if (length == 0) {
+            while (run >= 11) {
+                size_t repeat = (run < 138) ? run : 138;
+                append_code_length_symbol(trees, frequencies, REPEAT_ZERO_LONG, (uint8_t)(repeat - 11));
+                run -= repeat;
+            }
+            if (run >= 3) {
+                append_code_length_symbol(trees, frequencies, REPEAT_ZERO, (uint8_t)(run - 3));
+                run = 0;
+            }
+        } else {
+            append_code_length_symbol(trees, frequencies, length, 0);
+            run--;
+            while (run >= 3) {
+                size_t repeat = (run < 6) ? run : 6;
+                append_code_length_symbol(trees, frequencies, REPEAT_PREVIOUS, (uint8_t)(repeat - 3));
+                run -= repeat;
+            }
+        }
+        for (; run > 0; run--) {
+            append_code_length_symbol(trees, frequencies, length, 0);
+        }
+    }
+}
+
+static uint8_t get_code_length_extra_bits(uint8_t symbol) {
+    return (symbol == REPEAT_PREVIOUS) ? 2 : (symbol == REPEAT_ZERO) ? 3 : (symbol == REPEAT_ZERO_LONG) ? 7 : 0;
+}
+
+static size_t build_dynamic_trees(const encodings_deflate_t* deflate, dynamic_trees_t* trees) {
+    build_tree(deflate->literal_frequencies, ENCODINGS_DEFLATE_LITERAL_CODE_COUNT, MAX_CODE_LENGTH, &trees->literals);
+    build_tree(deflate->distance_frequencies, ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT, MAX_CODE_LENGTH,
+               &trees->distances);
+    trees->literal_count = ENCODINGS_DEFLATE_LITERAL_CODE_COUNT;
+    while ((trees->literal_count > MIN_LITERAL_CODE_COUNT) &&
+           (trees->literals.lengths[trees->literal_count - 1] == 0)) {
+        trees->literal_count--;
+    }
+    trees->distance_count = ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT;
+    while ((trees->distance_count > 1) && (trees->distances.lengths[trees->distance_count - 1] == 0)) {
+        trees->distance_count--;
+    }
+    uint16_t frequencies[CODE_LENGTH_CODE_COUNT] = {0};
+    encode_code_lengths(trees, frequencies);
+    build_tree(frequencies, CODE_LENGTH_CODE_COUNT, MAX_CODE_LENGTH_CODE_LENGTH, &trees->code_lengths);
+    trees->code_length_count = CODE_LENGTH_CODE_COUNT;
+    while ((trees->code_length_count > MIN_CODE_LENGTH_CODE_COUNT) &&
+           (trees->code_lengths.lengths[code_length_order[trees->code_length_count - 1]] == 0)) {
+        trees->code_length_count--;
+    }
+    assign_codes(&trees->literals, ENCODINGS_DEFLATE_LITERAL_CODE_COUNT);
+    assign_codes(&trees->distances, ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT);
+    assign_codes(&trees->code_lengths, CODE_LENGTH_CODE_COUNT);
+    size_t bits = DYNAMIC_TREES_HEADER_BITS + (3 * trees->code_length_count);
+    for (size_t i = 0; i < trees->symbol_count; i++) {
+        bits += trees->code_lengths.lengths[trees->symbols[i]] + get_code_length_extra_bits(trees->symbols[i]);
+    }
+    return bits;
+}
+
+static size_t compute_symbol_bits(const encodings_deflate_t* deflate,
+                                  const huffman_tree_t* literals,
+                                  const huffman_tree_t* distances) {
+    size_t bits = 0;
+    for (size_t i = 0; i < ENCODINGS_DEFLATE_LITERAL_CODE_COUNT; i++) {
+        size_t extra_bits = (i >= FIRST_LENGTH_CODE) ? length_extra_bits[i - FIRST_LENGTH_CODE] : 0;
+        bits += deflate->literal_frequencies[i] * (literals->lengths[i] + extra_bits);
+    }
+    for (size_t i = 0; i < ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT; i++) {
+        bits += deflate->distance_frequencies[i] * (distances->lengths[i] + distance_extra_bits[i]);
+    }
+    return bits;
+}
+
+static void write_code(encodings_deflate_t* deflate, const huffman_tree_t* tree, size_t symbol) {
+    write_bits(deflate, tree->codes[symbol], tree->lengths[symbol]);
+}
+
+static void write_symbols(encodings_deflate_t* deflate,
+                          const huffman_tree_t* literals,
+                          const huffman_tree_t* distances) {
+    for (size_t i = 0; i < deflate->symbol_count; i++) {
+        size_t distance = deflate->symbol_distances[i];
+        if (distance == 0) {
+            write_code(deflate, literals, deflate->symbol_values[i]);
+            continue;
+        }
+        size_t length = (size_t)deflate->symbol_values[i] + MIN_MATCH_LENGTH;
+        size_t length_code = find_length_code(length);
+        write_code(deflate, literals, FIRST_LENGTH_CODE + length_code);
+        write_bits(deflate, (uint32_t)(length - length_bases[length_code]), length_extra_bits[length_code]);
+        size_t distance_code = find_distance_code(distance);
+        write_code(deflate, distances, distance_code);
+        write_bits(deflate, (uint32_t)(distance - distance_bases[distance_code]), distance_extra_bits[distance_code]);
+    }
+    write_code(deflate, literals, END_OF_BLOCK);
+}
+
+static void write_dynamic_trees(encodings_deflate_t* deflate, const dynamic_trees_t* trees) {
+    write_bits(deflate, (uint32_t)(trees->literal_count - MIN_LITERAL_CODE_COUNT), 5);
+    write_bits(deflate, (uint32_t)(trees->distance_count - 1), 5);
+    write_bits(deflate, (uint32_t)(trees->code_length_count - MIN_CODE_LENGTH_CODE_COUNT), 4);
+    for (size_t i = 0; i < trees->code_length_count; i++) {
+        write_bits(deflate, trees->code_lengths.lengths[code_length_order[i]], 3);
+    }
+    for (size_t i = 0; i < trees->symbol_count; i++) {
+        write_code(deflate, &trees->code_lengths, trees->symbols[i]);
+        write_bits(deflate, trees->extras[i], get_code_length_extra_bits(trees->symbols[i]));
+    }
+}
+
+static void write_stored_blocks(encodings_deflate_t* deflate, bool is_last) {
+    const uint8_t* data = deflate->window + deflate->block_start;
+    size_t size = deflate->position - deflate->block_start;
+    do {
+        size_t block_size = (size < STORED_BLOCK_MAX_SIZE) ? size : STORED_BLOCK_MAX_SIZE;
+        size -= block_size;
+        write_bits(deflate, (is_last && (size == 0)) ? 1 : 0, 1);
+        write_bits(deflate, BLOCK_TYPE_STORED, 2);
+        align_to_byte(deflate);
+        write_bits(deflate, (uint32_t)block_size, 16);
+        write_bits(deflate, (uint32_t)(~block_size & 0xFFFF), 16);
+        for (size_t i = 0; i < block_size; i++) {
+            write_byte(deflate, data[i]);
+        }
+        data += block_size;
+    } while (size > 0);
+}
+
+static size_t compute_stored_bits(const encodings_deflate_t* deflate) {
+    size_t size = deflate->position - deflate->block_start;
+    size_t block_count = (size + STORED_BLOCK_MAX_SIZE - 1) / STORED_BLOCK_MAX_SIZE;
+    return (8 * size) + (((block_count > 0) ? block_count : 1) * STORED_BLOCK_HEADER_BITS);
+}
+
+static void write_block(encodings_deflate_t* deflate, bool is_last) {
+    deflate->literal_frequencies[END_OF_BLOCK]++;
+    huffman_tree_t fixed_literals;
+    huffman_tree_t fixed_distances;
+    build_fixed_trees(&fixed_literals, &fixed_distances);
+    dynamic_trees_t dynamic_trees;
+    size_t dynamic_bits = build_dynamic_trees(deflate, &dynamic_trees) +
+                          compute_symbol_bits(deflate, &dynamic_trees.literals, &dynamic_trees.distances);
+    size_t fixed_bits = compute_symbol_bits(deflate, &fixed_literals, &fixed_distances);
+    size_t stored_bits = compute_stored_bits(deflate);
+    if ((stored_bits < fixed_bits) && (stored_bits < dynamic_bits)) {
+        write_stored_blocks(deflate, is_last);
+    } else if (fixed_bits <= dynamic_bits) {
+        write_bits(deflate, is_last ? 1 : 0, 1);
+        write_bits(deflate, BLOCK_TYPE_FIXED, 2);
+        write_symbols(deflate, &fixed_literals, &fixed_distances);
+    } else {
+        write_bits(deflate, is_last ? 1 : 0, 1);
+        write_bits(deflate, BLOCK_TYPE_DYNAMIC, 2);
+        write_dynamic_trees(deflate, &dynamic_trees);
+        write_symbols(deflate, &dynamic_trees.literals, &dynamic_trees.distances);
+    }
+    memset(deflate->literal_frequencies, 0, sizeof(deflate->literal_frequencies));
+    memset(deflate->distance_frequencies, 0, sizeof(deflate->distance_frequencies));
+    deflate->symbol_count = 0;
+    deflate->block_start = deflate->position;
+}
+
+static void record_literal(encodings_deflate_t* deflate, uint8_t literal) {
+    deflate->symbol_values[deflate->symbol_count] = literal;
+    deflate->symbol_distances[deflate->symbol_count++] = 0;
+    deflate->literal_frequencies[literal]++;
+}
+
+static void record_match(encodings_deflate_t* deflate, size_t distance, size_t length) {
+    deflate->symbol_values[deflate->symbol_count] = (uint8_t)(length - MIN_MATCH_LENGTH);
+    deflate->symbol_distances[deflate->symbol_count++] = (uint16_t)distance;
+    deflate->literal_frequencies[FIRST_LENGTH_CODE + find_length_code(length)]++;
+    deflate->distance_frequencies[find_distance_code(distance)]++;
+}
+
+static size_t insert_string(encodings_deflate_t* deflate, size_t position) {
+    const uint8_t* data = deflate->window + position;
+    uint32_t hash = ((uint32_t)data[0] << 10) ^ ((uint32_t)data[1] << 5) ^ data[2];
+    hash &= ENCODINGS_DEFLATE_HASH_SIZE - 1;
+    size_t head = deflate->hash_heads[hash];
+    deflate->hash_chains[position % ENCODINGS_DEFLATE_WINDOW_SIZE] = (uint16_t)head;
+    deflate->hash_heads[hash] = (uint16_t)position;
+    return head;
+}
+
+/* Position 0 doubles as the empty chain marker, so the very first byte of the window is never matched. */
+static size_t find_longest_match(const encodings_deflate_t* deflate,
+                                 size_t candidate,
+                                 size_t max_length,
+                                 size_t* distance) {
+    const uint8_t* current = deflate->window + deflate->position;
+    size_t best_length = 0;
+    for (size_t chain = 0; (candidate > 0) && (chain < MAX_CHAIN_LENGTH); chain++) {
+        if ((deflate->position - candidate) >= ENCODINGS_DEFLATE_WINDOW_SIZE) {
+            break;
+        }
+        const uint8_t* match = deflate->window + candidate;
+        if (match[best_length] == current[best_length]) {
+            size_t length = 0;
+            while ((length < max_length) && (match[length] == current[length])) {
+                length++;
+            }
+            if (length > best_length) {
+                best_length = length;
+                *distance = deflate->position - candidate;
+                if (length == max_length) {
+                    break;
+                }
+            }
+        }
+        size_t next = deflate->hash_chains[candidate % ENCODINGS_DEFLATE_WINDOW_SIZE];
+        if (next >= candidate) {
+            break;
+        }
+        candidate = next;
+    }
+    return best_length;
+}
+
+/* Unless finishing, a full match length of lookahead is kept so matches are not cut at the end of the input. */
+static void compress_window(encodings_deflate_t* deflate, bool is_finishing) {
+    size_t min_lookahead = is_finishing ? 0 : MAX_MATCH_LENGTH;
+    while ((deflate->window_end - deflate->position) > min_lookahead) {
+        size_t available = deflate->window_end - deflate->position;
+        size_t max_length = (available < MAX_MATCH_LENGTH) ? available : MAX_MATCH_LENGTH;
+        size_t length = 0;
+        size_t distance = 0;
+        if (available >= MIN_MATCH_LENGTH) {
+            size_t candidate = insert_string(deflate, deflate->position);
+            length = find_longest_match(deflate, candidate, max_length, &distance);
+        }
+        if (length >= MIN_MATCH_LENGTH) {
+            record_match(deflate, distance, length);
+            for (size_t i = 1; i < length; i++) {
+                if ((deflate->position + i + MIN_MATCH_LENGTH) <= deflate->window_end) {
+                    insert_string(deflate, deflate->position + i);
+                }
+            }
+            deflate->position += length;
+        } else {
+            record_literal(deflate, deflate->window[deflate->position]);
+            deflate->position++;
+        }
+        if (deflate->symbol_count == ENCODINGS_DEFLATE_BLOCK_SYMBOL_COUNT) {
+            write_block(deflate, false);
+        }
+    }
+}
+
+static uint16_t slide_position(uint16_t position) {
+    return (position >= ENCODINGS_DEFLATE_WINDOW_SIZE) ? (uint16_t)(position - ENCODINGS_DEFLATE_WINDOW_SIZE) : 0;
+}
+
+/* The current block is written first if its data would be dropped, keeping it available for a stored block. */
+static void slide_window(encodings_deflate_t* deflate) {
+    if (deflate->block_start < ENCODINGS_DEFLATE_WINDOW_SIZE) {
+        write_block(deflate, false);
+    }
+    memmove(deflate->window, deflate->window + ENCODINGS_DEFLATE_WINDOW_SIZE,
+            deflate->window_end - ENCODINGS_DEFLATE_WINDOW_SIZE);
+    deflate->window_end -= ENCODINGS_DEFLATE_WINDOW_SIZE;
+    deflate->position -= ENCODINGS_DEFLATE_WINDOW_SIZE;
+    deflate->block_start -= ENCODINGS_DEFLATE_WINDOW_SIZE;
+    for (size_t i = 0; i < ENCODINGS_DEFLATE_HASH_SIZE; i++) {
+        deflate->hash_heads[i] = slide_position(deflate->hash_heads[i]);
+    }
+    for (size_t i = 0; i < ENCODINGS_DEFLATE_WINDOW_SIZE; i++) {
+        deflate->hash_chains[i] = slide_position(deflate->hash_chains[i]);
+    }
+}
+
+static void write_stream_header(encodings_deflate_t* deflate) {
+    if (deflate->format == ENCODINGS_DEFLATE_FORMAT_GZIP) {
+        static const uint8_t header[] = {0x1f, 0x8b, ZLIB_METHOD_DEFLATE, 0, 0, 0, 0, 0, 0, GZIP_OS_UNKNOWN};
+        for (size_t i = 0; i < sizeof(header); i++) {
+            write_byte(deflate, header[i]);
+        }
+    } else if (deflate->format == ENCODINGS_DEFLATE_FORMAT_ZLIB) {
+        uint32_t window_bits = 0;
+        while ((1U << (window_bits + 1)) <= ENCODINGS_DEFLATE_WINDOW_SIZE) {
+            window_bits++;
+        }
+        uint32_t method = ((window_bits - 8) << 4) | ZLIB_METHOD_DEFLATE;
+        write_byte(deflate, (uint8_t)method);
+        write_byte(deflate, (uint8_t)((ZLIB_CHECK_MODULO - ((method << 8) % ZLIB_CHECK_MODULO)) % ZLIB_CHECK_MODULO));
+    }
+}
+
+void encodings_deflate_initialize(encodings_deflate_t* deflate,
+                                  encodings_deflate_format_t format,
+                                  encodings_deflate_output_callback_t output,
+                                  void* output_context) {
+    if (!deflate || !output) {
+        return;
+    }
+    memset(deflate, 0, sizeof(encodings_deflate_t));
+    deflate->format = format;
+    deflate->output = output;
+    deflate->output_context = output_context;
+    deflate->checksum = (format == ENCODINGS_DEFLATE_FORMAT_ZLIB) ? 1 : 0;
+    write_stream_header(deflate);
+}
+
+void encodings_deflate_update(encodings_deflate_t* deflate, const void* data, size_t data_size) {
+    if (!deflate || (!data && (data_size > 0))) {
+        return;
+    }
+    if (deflate->format == ENCODINGS_DEFLATE_FORMAT_GZIP) {
+        deflate->checksum = encodings_deflate_crc32(deflate->checksum, data, data_size);
+    } else if (deflate->format == ENCODINGS_DEFLATE_FORMAT_ZLIB) {
+        deflate->checksum = encodings_deflate_adler32(deflate->checksum, data, data_size);
+    }
+    deflate->input_size += (uint32_t)data_size;
+    const uint8_t* input = (const uint8_t*)data;
+    while (data_size > 0) {
+        if (deflate->window_end == sizeof(deflate->window)) {
+            slide_window(deflate);
+        }
+        size_t copy_size = sizeof(deflate->window) - deflate->window_end;
+        if (copy_size > data_size) {
+            copy_size = data_size;
+        }
+        memcpy(deflate->window + deflate->window_end, input, copy_size);
+        deflate->window_end += copy_size;
+        input += copy_size;
+        data_size -= copy_size;
+        compress_window(deflate, false);
+    }
+}
+
+void encodings_deflate_finalize(encodings_deflate_t* deflate) {
+    if (!deflate) {
+        return;
+    }
+    compress_window(deflate, true);
+    write_block(deflate, true);
+    align_to_byte(deflate);
+    if (deflate->format == ENCODINGS_DEFLATE_FORMAT_GZIP) {
+        write_uint32_little_endian(deflate, deflate->checksum);
+        write_uint32_little_endian(deflate, deflate->input_size);
+    } else if (deflate->format == ENCODINGS_DEFLATE_FORMAT_ZLIB) {
+        write_uint32_big_endian(deflate, deflate->checksum);
+    }
+    flush_output(deflate);
+}
+
+uint32_t encodings_deflate_crc32(uint32_t crc, const void* data, size_t data_size) {
+    if (!data) {
+        return crc;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < data_size; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ crc32_table[crc & 0xF];
+        crc = (crc >> 4) ^ crc32_table[crc & 0xF];
+    }
+    return ~crc;
+}
+
+uint32_t encodings_deflate_adler32(uint32_t adler, const void* data, size_t data_size) {
+    if (!data) {
+        return adler;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t low = adler & 0xFFFF;
+    uint32_t high = adler >> 16;
+    while (data_size > 0) {
+        size_t run = (data_size < ADLER_MAX_RUN) ? data_size : ADLER_MAX_RUN;
+        data_size -= run;
+        for (; run > 0; run--) {
+            low += *bytes++;
+            high += low;
+        }
+        low %= ADLER_MODULO;
+        high %= ADLER_MODULO;
+    }
+    return (high << 16) | low;
+}
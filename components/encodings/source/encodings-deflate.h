@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef ENCODINGS_DEFLATE_H
+#define ENCODINGS_DEFLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup encodings-deflate Encodings DEFLATE
+ * @brief Streaming DEFLATE compression (RFC 1951) with zlib (RFC 1950) and gzip (RFC 1952) framing
+ *
+ * Input is matched against a small sliding window and every block is written with fixed or dynamic Huffman codes, or
+ * stored, whichever is shorter. The whole state lives in encodings_deflate_t, about 33 KiB, and no memory is
+ * allocated.
+ * @{
+ */
+
+/**
+ * @brief Distance over which repeated strings are found
+ */
+#define ENCODINGS_DEFLATE_WINDOW_SIZE (4096)
+
+/**
+ * @brief Number of hash chain heads, a power of two
+ */
+#define ENCODINGS_DEFLATE_HASH_SIZE (2048)
+
+/**
+ * @brief Maximal number of literals and matches in a single block
+ */
+#define ENCODINGS_DEFLATE_BLOCK_SYMBOL_COUNT (4096)
+
+/**
+ * @brief Size of the compressed data passed to the output callback at once
+ */
+#define ENCODINGS_DEFLATE_OUTPUT_BUFFER_SIZE (1024)
+
+#define ENCODINGS_DEFLATE_LITERAL_CODE_COUNT (286)
+#define ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT (30)
+
+typedef enum encodings_deflate_format {
+    ENCODINGS_DEFLATE_FORMAT_RAW,  /**< @brief bare DEFLATE stream */
+    ENCODINGS_DEFLATE_FORMAT_ZLIB, /**< @brief zlib stream, the `deflate` HTTP content coding */
+    ENCODINGS_DEFLATE_FORMAT_GZIP, /**< @brief gzip member, the `gzip` HTTP content coding */
+} encodings_deflate_format_t;
+
+/**
+ * @brief Receives compressed data
+ * @param[in] context output context given on initialization
+ * @param[in] data pointer to compressed data
+ * @param[in] data_size size of the compressed data
+ */
+typedef void (*encodings_deflate_output_callback_t)(void* context, const uint8_t* data, size_t data_size);
+
+/**
+ * @brief DEFLATE compression state
+ */
+typedef struct encodings_deflate {
+    encodings_deflate_format_t format;
+    encodings_deflate_output_callback_t output;
+    void* output_context;
+    uint8_t window[2 * ENCODINGS_DEFLATE_WINDOW_SIZE]; /**< @brief history followed by the lookahead */
+    size_t window_end;                                 /**< @brief number of bytes in the window */
+    size_t position;                                   /**< @brief next byte to be matched */
+    size_t block_start;                                /**< @brief first byte of the current block */
+    uint16_t hash_heads[ENCODINGS_DEFLATE_HASH_SIZE];
+    uint16_t hash_chains[ENCODINGS_DEFLATE_WINDOW_SIZE];
+    uint16_t symbol_distances[ENCODINGS_DEFLATE_BLOCK_SYMBOL_COUNT]; /**< @brief 0 for literals */
+    uint8_t symbol_values[ENCODINGS_DEFLATE_BLOCK_SYMBOL_COUNT];     /**< @brief literal or match length - 3 */
+    size_t symbol_count;
+    uint16_t literal_frequencies[ENCODINGS_DEFLATE_LITERAL_CODE_COUNT];
+    uint16_t distance_frequencies[ENCODINGS_DEFLATE_DISTANCE_CODE_COUNT];
+    uint32_t bit_buffer;
+    uint32_t bit_count;
+    uint8_t output_buffer[ENCODINGS_DEFLATE_OUTPUT_BUFFER_SIZE];
+    size_t output_size;
+    uint32_t checksum;   /**< @brief CRC-32 for gzip, Adler-32 for zlib */
+    uint32_t input_size; /**< @brief size of the input modulo 2^32 */
+} encodings_deflate_t;
+
+/**
+ * @brief Initialize DEFLATE compression
+ * @param[out] deflate pointer to compression state
+ * @param[in] format framing of the compressed stream
+ * @param[in] output callback receiving compressed data
+ * @param[in] output_context context passed to the callback
+ */
+void encodings_deflate_initialize(encodings_deflate_t* deflate,
+                                  encodings_deflate_format_t format,
+                                  encodings_deflate_output_callback_t output,
+                                  void* output_context);
+
+/**
+ * @brief Feed data into compression
+ *
+ * Compressed data is passed to the output callback whenever a block is complete, so the input may be buffered
+ * until the next call or until encodings_deflate_finalize().
+ * @param[in,out] deflate pointer to compression state
+ * @param[in] data pointer to input data
+ * @param[in] data_size size of the input data
+ */
+void encodings_deflate_update(encodings_deflate_t* deflate, const void* data, size_t data_size);
+
+/**
+ * @brief Compress the buffered input and terminate the stream
+ * @param[in,out] deflate pointer to compression state
+ */
+void encodings_deflate_finalize(encodings_deflate_t* deflate);
+
+/**
+ * @brief Update a CRC-32 (ISO-HDLC, as used by gzip) with data
+ * @param[in] crc CRC of the preceding data, 0 for none
+ * @param[in] data pointer to input data
+ * @param[in] data_size size of the input data
+ * @return updated CRC
+ */
+uint32_t encodings_deflate_crc32(uint32_t crc, const void* data, size_t data_size);
+
+/**
+ * @brief Update an Adler-32 checksum (as used by zlib) with data
+ * @param[in] adler checksum of the preceding data, 1 for none
+ * @param[in] data pointer to input data
+ * @param[in] data_size size of the input data
+ * @return updated checksum
+ */
+uint32_t encodings_deflate_adler32(uint32_t adler, const void* data, size_t data_size);
+
+/**
+ * @}
+ */
+
+#endif  // ENCODINGS_DEFLATE_H
@@ -0,0 +1,152 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "encodings-sha1.h"
+#include <string.h>
+
+#define BLOCK_SIZE (64)
+
+static uint32_t rotate_left(uint32_t value, unsigned count) {
+    return (value << count) | (value >> (32 - count));
+}
+
+static uint32_t load_big_endian(const uint8_t* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static void store_big_endian(uint8_t* data, uint32_t value) {
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+}
+
+static void process_block(uint32_t* state, const uint8_t* block) {
+    uint32_t words[16];
+    for (size_t i = 0; i < 16; i++) {
+        words[i] = load_big_endian(block + (i * 4));
+    }
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    for (size_t i = 0; i < 80; i++) {
+        if (i >= 16) {
+            uint32_t word = words[(i + 13) & 15] ^ words[(i + 8) & 15] ^ words[(i + 2) & 15] ^ words[i & 15];
+            words[i & 15] = rotate_left(word, 1);
+        }
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temporary = rotate_left(a, 5) + f + e + k + words[i & 15];
+        e = d;
+        d = c;
+        c = rotate_left(b, 30);
+        b = a;
+        a = temporary;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+void encodings_sha1_initialize(encodings_sha1_t* sha1) {
+    if (!sha1) {
+        return;
+    }
+    sha1->state[0] = 0x67452301;
+    sha1->state[1] = 0xEFCDAB89;
+    sha1->state[2] = 0x98BADCFE;
+    sha1->state[3] = 0x10325476;
+    sha1->state[4] = 0xC3D2E1F0;
+    sha1->size = 0;
+}
+
+void encodings_sha1_update(encodings_sha1_t* sha1, const void* data, size_t data_size) {
+    if (!sha1 || (!data && (data_size > 0))) {
+        return;
+    }
+    const uint8_t* input = (const uint8_t*)data;
+    size_t block_position = (size_t)(sha1->size % BLOCK_SIZE);
+    sha1->size += data_size;
+    if (block_position > 0) {
+        size_t size = BLOCK_SIZE - block_position;
+        if (size > data_size) {
+            size = data_size;
+        }
+        memcpy(sha1->block + block_position, input, size);
+        input += size;
+        data_size -= size;
+        if ((block_position + size) < BLOCK_SIZE) {
+            return;
+        }
+        process_block(sha1->state, sha1->block);
+    }
+    for (; data_size >= BLOCK_SIZE; data_size -= BLOCK_SIZE, input += BLOCK_SIZE) {
+        process_block(sha1->state, input);
+    }
+    memcpy(sha1->block, input, data_size);
+}
+
+void encodings_sha1_finalize(encodings_sha1_t* sha1, uint8_t* digest) {
+    if (!sha1 || !digest) {
+        return;
+    }
+    uint64_t bit_size = sha1->size * 8;
+    size_t block_position = (size_t)(sha1->size % BLOCK_SIZE);
+    sha1->block[block_position++] = 0x80;
+    if (block_position > (BLOCK_SIZE - 8)) {
+        memset(sha1->block + block_position, 0, BLOCK_SIZE - block_position);
+        process_block(sha1->state, sha1->block);
+        block_position = 0;
+    }
+    memset(sha1->block + block_position, 0, (BLOCK_SIZE - 8) - block_position);
+    store_big_endian(sha1->block + BLOCK_SIZE - 8, (uint32_t)(bit_size >> 32));
+    store_big_endian(sha1->block + BLOCK_SIZE - 4, (uint32_t)bit_size);
+    process_block(sha1->state, sha1->block);
+    for (size_t i = 0; i < 5; i++) {
+        store_big_endian(digest + (i * 4), sha1->state[i]);
+    }
+}
+
+void encodings_sha1(const void* data, size_t data_size, uint8_t* digest) {
+    encodings_sha1_t sha1;
+    encodings_sha1_initialize(&sha1);
+    encodings_sha1_update(&sha1, data, data_size);
+    encodings_sha1_finalize(&sha1, digest);
+}
@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef ENCODINGS_SHA1_H
+#define ENCODINGS_SHA1_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup encodings-sha1 Encodings SHA-1
+ * @brief SHA-1 message digest procedures
+ * @note SHA-1 is not collision resistant; use it only where a protocol
+ * mandates it (e.g. WebSocket handshake)
+ * @{
+ */
+
+/**
+ * @brief Size of the SHA-1 digest in bytes
+ */
+#define ENCODINGS_SHA1_DIGEST_SIZE (20)
+
+/**
+ * @brief SHA-1 incremental computation state
+ */
+typedef struct encodings_sha1 {
+    uint32_t state[5];  /**< @brief intermediate hash value */
+    uint64_t size;      /**< @brief number of bytes processed so far */
+    uint8_t block[64];  /**< @brief partially filled input block */
+} encodings_sha1_t;
+
+/**
+ * @brief Initialize SHA-1 computation
+ * @param[out] sha1 pointer to computation state
+ */
+void encodings_sha1_initialize(encodings_sha1_t* sha1);
+
+/**
+ * @brief Feed data into SHA-1 computation
+ * @param[in,out] sha1 pointer to computation state
+ * @param[in] data pointer to input data
+ * @param[in] data_size size of the input data
+ */
+void encodings_sha1_update(encodings_sha1_t* sha1, const void* data, size_t data_size);
+
+/**
+ * @brief Finish SHA-1 computation
+ * @param[in,out] sha1 pointer to computation state
+ * @param[out] digest destination for ENCODINGS_SHA1_DIGEST_SIZE bytes of the digest
+ */
+void encodings_sha1_finalize(encodings_sha1_t* sha1, uint8_t* digest);
+
+/**
+ * @brief Compute SHA-1 digest of a single buffer
+ * @param[in] data pointer to input data
+ * @param[in] data_size size of the input data
+ * @param[out] digest destination for ENCODINGS_SHA1_DIGEST_SIZE bytes of the digest
+ */
+void encodings_sha1(const void* data, size_t data_size, uint8_t* digest);
+
+/**
+ * @}
+ */
+
+#endif  // ENCODINGS_SHA1_H
@@ -69,10 +69,27 @@ static void test_decode_text(void** state) {
     free(decoded);
 }
 
+static void test_encode_data(void** state) {
+    char encoded[64];
+    assert_int_equal(encodings_base64_get_encode_buffer_size(0), 1);
+    assert_int_equal(encodings_base64_get_encode_buffer_size(5), 9);
+    encodings_base64_encode("", 0, encoded);
+    assert_string_equal(encoded, "");
+    encodings_base64_encode("A", 1, encoded);
+    assert_string_equal(encoded, "QQ==");
+    encodings_base64_encode("hello", 5, encoded);
+    assert_string_equal(encoded, "aGVsbG8=");
+    encodings_base64_encode("Lorem ipsum dolor sit amet", 26, encoded);
+    assert_string_equal(encoded, "TG9yZW0gaXBzdW0gZG9sb3Igc2l0IGFtZXQ=");
+    encodings_base64_encode("\xFF\xFE\xFD", 3, encoded);
+    assert_string_equal(encoded, "//79");
+}
+
 int main(int argc, char** argv) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_calculate_decode_buffer_length),
         cmocka_unit_test(test_decode_text),
+        cmocka_unit_test(test_encode_data),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
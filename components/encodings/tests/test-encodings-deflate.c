@@ -0,0 +1,404 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "encodings-deflate.h"
+
+#define TEST_OUTPUT_CAPACITY (1 << 18)
+
+typedef struct test_output {
+    uint8_t data[TEST_OUTPUT_CAPACITY];
+    size_t size;
+    size_t call_count;
+} test_output_t;
+
+typedef struct inflate_table {
+    uint16_t counts[16];
+    uint16_t symbols[ENCODINGS_DEFLATE_LITERAL_CODE_COUNT + 2];
+} inflate_table_t;
+
+typedef struct inflate_state {
+    const uint8_t* input;
+    size_t input_size;
+    size_t position;
+    uint32_t bit_buffer;
+    uint32_t bit_count;
+    uint8_t* output;
+    size_t output_size;
+    size_t output_capacity;
+    bool is_failed;
+    uint32_t block_types;
+} inflate_state_t;
+
+static const uint16_t length_bases[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t length_extra_bits[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                            2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distance_bases[] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                          33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                          1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distance_extra_bits[] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                              6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static test_output_t compressed;
+static uint8_t decompressed[TEST_OUTPUT_CAPACITY];
+static encodings_deflate_t deflate;
+
+static void collect_output(void* context, const uint8_t* data, size_t data_size) {
+    test_output_t* output = context;
+    assert_true((output->size + data_size) <= TEST_OUTPUT_CAPACITY);
+    memcpy(output->data + output->size, data, data_size);
+    output->size += data_size;
+    output->call_count++;
+}
+
+static uint32_t get_bits(inflate_state_t* state, uint32_t count) {
+    while (state->bit_count < count) {
+        if (state->position >= state->input_size) {
+            state->is_failed = true;
+            return 0;
+        }
+        state->bit_buffer |= (uint32_t)state->input[state->position++] << state->bit_count;
+        state->bit_count += 8;
+    }
+    uint32_t value = state->bit_buffer & ((1U << count) - 1);
+    state->bit_buffer >>= count;
+    state->bit_count -= count;
+    return value;
+}
+
+static void build_table(inflate_table_t* table, const uint8_t* lengths, size_t count) {
+    uint16_t offsets[16];
+    memset(table->counts, 0, sizeof(table->counts));
+    for (size_t i = 0; i < count; i++) {
+        table->counts[lengths[i]]++;
+    }
+    offsets[1] = 0;
+    for (size_t length = 1; length < 15; length++) {
+        offsets[length + 1] = offsets[length] + table->counts[length];
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] != 0) {
+            table->symbols[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+    }
+}
+
+static int decode_symbol(inflate_state_t* state, const inflate_table_t* table) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (size_t length = 1; length < 16; length++) {
+        code |= (int)get_bits(state, 1);
+        int count = table->counts[length];
+        if ((code - first) < count) {
+            return table->symbols[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    state->is_failed = true;
+    return 0;
+}
+
+static void inflate_codes(inflate_state_t* state, const inflate_table_t* literals, const inflate_table_t* distances) {
+    while (!state->is_failed) {
+        int symbol = decode_symbol(state, literals);
+        if (symbol < 256) {
+            assert_true(state->output_size < state->output_capacity);
+            state->output[state->output_size++] = (uint8_t)symbol;
+        } else if (symbol == 256) {
+            return;
+        } else {
+            symbol -= 257;
+            assert_true(symbol < 29);
+            size_t length = length_bases[symbol] + get_bits(state, length_extra_bits[symbol]);
+            int distance_code = decode_symbol(state, distances);
+            assert_true(distance_code < 30);
+            size_t distance = distance_bases[distance_code] + get_bits(state, distance_extra_bits[distance_code]);
+            assert_true(distance <= state->output_size);
+            assert_true(distance <= ENCODINGS_DEFLATE_WINDOW_SIZE);
+            assert_true((state->output_size + length) <= state->output_capacity);
+            for (size_t i = 0; i < length; i++, state->output_size++) {
+                state->output[state->output_size] = state->output[state->output_size - distance];
+            }
+        }
+    }
+}
+
+static void inflate_fixed(inflate_state_t* state) {
+    uint8_t lengths[288];
+    for (size_t i = 0; i < 288; i++) {
+        lengths[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+    }
+    inflate_table_t literals;
+    build_table(&literals, lengths, 288);
+    memset(lengths, 5, 30);
+    inflate_table_t distances;
+    build_table(&distances, lengths, 30);
+    inflate_codes(state, &literals, &distances);
+}
+
+static void inflate_dynamic(inflate_state_t* state) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    size_t literal_count = get_bits(state, 5) + 257;
+    size_t distance_count = get_bits(state, 5) + 1;
+    size_t code_length_count = get_bits(state, 4) + 4;
+    uint8_t lengths[320] = {0};
+    for (size_t i = 0; i < code_length_count; i++) {
+        lengths[order[i]] = (uint8_t)get_bits(state, 3);
+    }
+    inflate_table_t code_lengths;
+    build_table(&code_lengths, lengths, 19);
+    memset(lengths, 0, sizeof(lengths));
+    for (size_t i = 0; (i < (literal_count + distance_count)) && !state->is_failed;) {
+        int symbol = decode_symbol(state, &code_lengths);
+        if (symbol < 16) {
+            lengths[i++] = (uint8_t)symbol;
+            continue;
+        }
+        uint8_t length = 0;
+        size_t repeat = 0;
+        if (symbol == 16) {
+            assert_true(i > 0);
+            length = lengths[i - 1];
+            repeat = 3 + get_bits(state, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + get_bits(state, 3);
+        } else {
+            repeat = 11 + get_bits(state, 7);
+        }
+        assert_true((i + repeat) <= (literal_count + distance_count));
+        for (; repeat > 0; repeat--) {
+            lengths[i++] = length;
+        }
+    }
+    inflate_table_t literals;
+    build_table(&literals, lengths, literal_count);
+    inflate_table_t distances;
+    build_table(&distances, lengths + literal_count, distance_count);
+    inflate_codes(state, &literals, &distances);
+}
+
+static void inflate_stored(inflate_state_t* state) {
+    state->bit_buffer = 0;
+    state->bit_count = 0;
+    assert_true((state->position + 4) <= state->input_size);
+    size_t size = state->input[state->position] | ((size_t)state->input[state->position + 1] << 8);
+    size_t complement = state->input[state->position + 2] | ((size_t)state->input[state->position + 3] << 8);
+    assert_int_equal(size, ~complement & 0xFFFF);
+    state->position += 4;
+    assert_true((state->position + size) <= state->input_size);
+    assert_true((state->output_size + size) <= state->output_capacity);
+    memcpy(state->output + state->output_size, state->input + state->position, size);
+    state->position += size;
+    state->output_size += size;
+}
+
+/* Returns the size of the inflated data and the position after the last block. */
+static size_t inflate_raw(const uint8_t* input, size_t input_size, size_t* end, uint32_t* block_types) {
+    inflate_state_t state = {
+        .input = input,
+        .input_size = input_size,
+        .output = decompressed,
+        .output_capacity = sizeof(decompressed),
+    };
+    bool is_last = false;
+    while (!is_last && !state.is_failed) {
+        is_last = get_bits(&state, 1);
+        uint32_t type = get_bits(&state, 2);
+        state.block_types |= 1U << type;
+        if (type == 0) {
+            inflate_stored(&state);
+        } else if (type == 1) {
+            inflate_fixed(&state);
+        } else if (type == 2) {
+            inflate_dynamic(&state);
+        } else {
+            state.is_failed = true;
+        }
+    }
+    assert_false(state.is_failed);
+    *end = state.position;
+    if (block_types) {
+        *block_types = state.block_types;
+    }
+    return state.output_size;
+}
+
+static void compress(encodings_deflate_format_t format, const void* data, size_t data_size, size_t step) {
+    compressed.size = 0;
+    compressed.call_count = 0;
+    encodings_deflate_initialize(&deflate, format, collect_output, &compressed);
+    const uint8_t* input = data;
+    for (size_t position = 0; position < data_size; position += step) {
+        size_t size = ((data_size - position) < step) ? (data_size - position) : step;
+        encodings_deflate_update(&deflate, input + position, size);
+    }
+    encodings_deflate_finalize(&deflate);
+}
+
+static uint32_t assert_raw_roundtrip(const void* data, size_t data_size, size_t step) {
+    compress(ENCODINGS_DEFLATE_FORMAT_RAW, data, data_size, step);
+    size_t end = 0;
+    uint32_t block_types = 0;
+    assert_int_equal(inflate_raw(compressed.data, compressed.size, &end, &block_types), data_size);
+    assert_int_equal(end, compressed.size);
+    assert_memory_equal(decompressed, data, data_size);
+    return block_types;
+}
+
+static size_t create_text(char* text, size_t size) {
+    static const char* const words[] = {"temperature", "humidity", "sensor", "value", "\"id\":", "{", "}", ",",
+                                        "pressure",    "battery",  "online", "true",  "false", "0.5", "17"};
+    size_t length = 0;
+    uint32_t seed = 12345;
+    while (length < size) {
+        seed = (seed * 1103515245) + 12345;
+        const char* word = words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))];
+        for (; *word && (length < size); word++) {
+            text[length++] = *word;
+        }
+    }
+    return length;
+}
+
+static void test_checksums(void** state) {
+    assert_int_equal(encodings_deflate_crc32(0, "123456789", 9), 0xCBF43926);
+    assert_int_equal(encodings_deflate_crc32(encodings_deflate_crc32(0, "1234", 4), "56789", 5), 0xCBF43926);
+    assert_int_equal(encodings_deflate_crc32(0, "", 0), 0);
+    assert_int_equal(encodings_deflate_adler32(1, "Wikipedia", 9), 0x11E60398);
+    assert_int_equal(encodings_deflate_adler32(1, "", 0), 1);
+}
+
+static void test_empty_input(void** state) {
+    assert_raw_roundtrip("", 0, 1);
+    assert_int_equal(compressed.size, 2);
+}
+
+static void test_short_text_uses_fixed_codes(void** state) {
+    const char* text = "Hello, Hello, Hello, divulge!";
+    assert_int_equal(assert_raw_roundtrip(text, strlen(text), 1), 1U << 1);
+    assert_true(compressed.size < strlen(text));
+}
+
+static void test_long_text_uses_dynamic_codes(void** state) {
+    static char text[100000];
+    size_t size = create_text(text, sizeof(text));
+    assert_true(assert_raw_roundtrip(text, size, size) & (1U << 2));
+    assert_true(compressed.size < (size / 4));
+    assert_true(compressed.call_count > 1);
+}
+
+static void test_incremental_input(void** state) {
+    static char text[20000];
+    size_t size = create_text(text, sizeof(text));
+    assert_raw_roundtrip(text, size, 1);
+    assert_raw_roundtrip(text, size, 333);
+    assert_raw_roundtrip(text, size, 8192);
+}
+
+static void test_repetitions(void** state) {
+    static uint8_t data[70000];
+    memset(data, 'a', sizeof(data));
+    assert_raw_roundtrip(data, sizeof(data), sizeof(data));
+    assert_true(compressed.size < 1000);
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i % 251);
+    }
+    assert_raw_roundtrip(data, sizeof(data), 1000);
+    assert_true(compressed.size < 2000);
+}
+
+static void test_random_data_is_stored(void** state) {
+    static uint8_t data[50000];
+    uint32_t seed = 1;
+    for (size_t i = 0; i < sizeof(data); i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        data[i] = (uint8_t)seed;
+    }
+    assert_int_equal(assert_raw_roundtrip(data, sizeof(data), 4000), 1U << 0);
+    assert_true(compressed.size < (sizeof(data) + 100));
+}
+
+static void test_gzip_format(void** state) {
+    static char text[5000];
+    size_t size = create_text(text, sizeof(text));
+    compress(ENCODINGS_DEFLATE_FORMAT_GZIP, text, size, 100);
+    static const uint8_t header[] = {0x1f, 0x8b, 0x08, 0x00};
+    assert_memory_equal(compressed.data, header, sizeof(header));
+    size_t end = 0;
+    assert_int_equal(inflate_raw(compressed.data + 10, compressed.size - 10, &end, NULL), size);
+    assert_memory_equal(decompressed, text, size);
+    assert_int_equal(compressed.size, 10 + end + 8);
+    const uint8_t* trailer = compressed.data + 10 + end;
+    uint32_t crc = trailer[0] | ((uint32_t)trailer[1] << 8) | ((uint32_t)trailer[2] << 16) |
+                   ((uint32_t)trailer[3] << 24);
+    uint32_t input_size = trailer[4] | ((uint32_t)trailer[5] << 8) | ((uint32_t)trailer[6] << 16) |
+                          ((uint32_t)trailer[7] << 24);
+    assert_int_equal(crc, encodings_deflate_crc32(0, text, size));
+    assert_int_equal(input_size, size);
+}
+
+static void test_zlib_format(void** state) {
+    static char text[5000];
+    size_t size = create_text(text, sizeof(text));
+    compress(ENCODINGS_DEFLATE_FORMAT_ZLIB, text, size, size);
+    assert_int_equal(compressed.data[0] & 0x0F, 8);
+    assert_true(((compressed.data[0] >> 4) + 8) <= 15);
+    assert_int_equal(((compressed.data[0] << 8) | compressed.data[1]) % 31, 0);
+    size_t end = 0;
+    assert_int_equal(inflate_raw(compressed.data + 2, compressed.size - 2, &end, NULL), size);
+    assert_int_equal(compressed.size, 2 + end + 4);
+    const uint8_t* trailer = compressed.data + 2 + end;
+    uint32_t adler = ((uint32_t)trailer[0] << 24) | ((uint32_t)trailer[1] << 16) | ((uint32_t)trailer[2] << 8) |
+                     trailer[3];
+    assert_int_equal(adler, encodings_deflate_adler32(1, text, size));
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_checksums),
+        cmocka_unit_test(test_empty_input),
+        cmocka_unit_test(test_short_text_uses_fixed_codes),
+        cmocka_unit_test(test_long_text_uses_dynamic_codes),
+        cmocka_unit_test(test_incremental_input),
+        cmocka_unit_test(test_repetitions),
+        cmocka_unit_test(test_random_data_is_stored),
+        cmocka_unit_test(test_gzip_format),
+        cmocka_unit_test(test_zlib_format),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
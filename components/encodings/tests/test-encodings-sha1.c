@@ -0,0 +1,93 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmocka.h"
+
+#include "encodings-base64.h"
+#include "encodings-sha1.h"
+
+static void assert_digest_equal(const uint8_t* digest, const char* expected) {
+    char text[(ENCODINGS_SHA1_DIGEST_SIZE * 2) + 1];
+    for (size_t i = 0; i < ENCODINGS_SHA1_DIGEST_SIZE; i++) {
+        snprintf(text + (i * 2), 3, "%02x", digest[i]);
+    }
+    assert_string_equal(text, expected);
+}
+
+static void test_digest_of_known_messages(void** state) {
+    uint8_t digest[ENCODINGS_SHA1_DIGEST_SIZE];
+    encodings_sha1("", 0, digest);
+    assert_digest_equal(digest, "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    encodings_sha1("abc", 3, digest);
+    assert_digest_equal(digest, "a9993e364706816aba3e25717850c26c9cd0d89d");
+    const char* message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    encodings_sha1(message, strlen(message), digest);
+    assert_digest_equal(digest, "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+}
+
+static void test_incremental_digest(void** state) {
+    uint8_t digest[ENCODINGS_SHA1_DIGEST_SIZE];
+    encodings_sha1_t sha1;
+    encodings_sha1_initialize(&sha1);
+    char block[1000];
+    memset(block, 'a', sizeof(block));
+    for (size_t i = 0; i < 1000; i++) {
+        encodings_sha1_update(&sha1, block, sizeof(block));
+    }
+    encodings_sha1_finalize(&sha1, digest);
+    assert_digest_equal(digest, "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+
+    const char* message = "The quick brown fox jumps over the lazy dog";
+    encodings_sha1_initialize(&sha1);
+    for (size_t i = 0; message[i]; i++) {
+        encodings_sha1_update(&sha1, message + i, 1);
+    }
+    encodings_sha1_finalize(&sha1, digest);
+    assert_digest_equal(digest, "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12");
+}
+
+static void test_websocket_accept_key(void** state) {
+    const char* key = "dGhlIHNhbXBsZSBub25jZQ==258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[ENCODINGS_SHA1_DIGEST_SIZE];
+    encodings_sha1(key, strlen(key), digest);
+    char accept[32];
+    assert_int_equal(encodings_base64_get_encode_buffer_size(sizeof(digest)), 29);
+    encodings_base64_encode(digest, sizeof(digest), accept);
+    assert_string_equal(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_digest_of_known_messages),
+        cmocka_unit_test(test_incremental_digest),
+        cmocka_unit_test(test_websocket_accept_key),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -32,11 +32,28 @@ void g2l_fs_initialize(const char* base_path) {
     E(TAG, "g2l_fs_initialize - Not implemented!");
 }
 
+size_t g2l_fs_get_max_file_name_length(void) {
+    E(TAG, "g2l_fs_get_max_file_name_length - Not implemented!");
+    return 0;
+}
+
 size_t g2l_fs_file_size(const char* file_name) {
     E(TAG, "g2l_fs_file_size - Not implemented!");
     return 0;
 }
 
+uint64_t g2l_fs_file_modification_time(const char* file_name) {
+    (void)file_name;
+    E(TAG, "g2l_fs_file_modification_time - Not implemented!");
+    return 0;
+}
+
+bool g2l_fs_file_is_regular(const char* file_name) {
+    (void)file_name;
+    E(TAG, "g2l_fs_file_is_regular - Not implemented!");
+    return false;
+}
+
 g2l_fs_file_t* g2l_fs_file_open(const char* file_name, g2l_fs_mode_t mode) {
     (void)file_name;
     (void)mode;
@@ -76,3 +93,9 @@ bool g2l_fs_file_seek(g2l_fs_file_t* file,
     E(TAG, "g2l_fs_file_seek - Not implemented!");
     return false;
 }
+
+int g2l_fs_file_get_descriptor(g2l_fs_file_t* file) {
+    (void)file;
+    E(TAG, "g2l_fs_file_get_descriptor - Not implemented!");
+    return -1;
+}
@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "esp_err.h"
 #include "esp_spiffs.h"
 #include "esp_vfs.h"
@@ -49,7 +50,7 @@ void g2l_fs_initialize(const char* base_path) {
     if (is_fs_initialized) {
         return;
     }
-    if (base_path) {
+    if (base_path && (strlen(base_path) < sizeof(fs_base_path))) {
         strcpy(fs_base_path, base_path);
     }
     esp_vfs_spiffs_conf_t conf = {.base_path = fs_base_path,
@@ -72,15 +73,32 @@ void g2l_fs_initialize(const char* base_path) {
     is_fs_initialized = true;
 }
 
-static void create_full_path_name(full_path_name full_path, const char* name) {
-    strcpy(full_path, fs_base_path);
-    strcat(full_path, "/");
-    strcat(full_path, name);
+size_t g2l_fs_get_max_file_name_length(void) {
+    size_t max_length = sizeof(full_path_name) - strlen(fs_base_path) - 2;
+#ifdef CONFIG_SPIFFS_OBJ_NAME_LEN
+    // SPIFFS stores the name with its leading separator and terminator
+    if (max_length > (CONFIG_SPIFFS_OBJ_NAME_LEN - 2)) {
+        max_length = CONFIG_SPIFFS_OBJ_NAME_LEN - 2;
+    }
+#endif
+    return max_length;
+}
+
+static bool create_full_path_name(full_path_name full_path, const char* name) {
+    int length = snprintf(full_path, sizeof(full_path_name), "%s/%s",
+                          fs_base_path, name);
+    if ((length < 0) || ((size_t)length >= sizeof(full_path_name))) {
+        E(TAG, "File name '%.32s...' is too long", name);
+        return false;
+    }
+    return true;
 }
 
 size_t g2l_fs_file_size(const char* file_name) {
     full_path_name path;
-    create_full_path_name(path, file_name);
+    if (!create_full_path_name(path, file_name)) {
+        return 0;
+    }
     struct stat info;
     int result = stat(path, &info);
     if (result == 0) {
@@ -92,9 +110,32 @@ size_t g2l_fs_file_size(const char* file_name) {
     return 0;
 }
 
+uint64_t g2l_fs_file_modification_time(const char* file_name) {
+    full_path_name path;
+    if (!create_full_path_name(path, file_name)) {
+        return 0;
+    }
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return 0;
+    }
+    return (info.st_mtime > 0) ? (uint64_t)info.st_mtime : 0;
+}
+
+bool g2l_fs_file_is_regular(const char* file_name) {
+    full_path_name path;
+    if (!create_full_path_name(path, file_name)) {
+        return false;
+    }
+    struct stat info;
+    return (stat(path, &info) == 0) && S_ISREG(info.st_mode);
+}
+
 g2l_fs_file_t* g2l_fs_file_open(const char* file_name, g2l_fs_mode_t mode) {
     full_path_name path;
-    create_full_path_name(path, file_name);
+    if (!create_full_path_name(path, file_name)) {
+        return NULL;
+    }
     char* mode_str = NULL;
     if (mode == G2L_FS_MODE_READ) {
         mode_str = "r";
@@ -155,3 +196,10 @@ bool g2l_fs_file_seek(g2l_fs_file_t* file,
     }
     return (fseek(file->file, (long)offset, whence) == 0);
 }
+
+int g2l_fs_file_get_descriptor(g2l_fs_file_t* file) {
+    if (!file) {
+        return -1;
+    }
+    return fileno(file->file);
+}
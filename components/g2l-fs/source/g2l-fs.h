@@ -25,6 +25,7 @@
 #define G2L_FS_H
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum g2l_fs_mode {
     G2L_FS_MODE_READ,
@@ -44,8 +45,14 @@ typedef struct g2l_fs_file g2l_fs_file_t;
 
 void g2l_fs_initialize(const char* base_path);
 
+size_t g2l_fs_get_max_file_name_length(void);
+
 size_t g2l_fs_file_size(const char* file_name);
 
+uint64_t g2l_fs_file_modification_time(const char* file_name);
+
+bool g2l_fs_file_is_regular(const char* file_name);
+
 g2l_fs_file_t* g2l_fs_file_open(const char* file_name, g2l_fs_mode_t mode);
 
 void g2l_fs_file_close(g2l_fs_file_t* file);
@@ -60,4 +67,6 @@ bool g2l_fs_file_seek(g2l_fs_file_t* file,
                       g2l_fs_seek_mode_t mode,
                       size_t offset);
 
+int g2l_fs_file_get_descriptor(g2l_fs_file_t* file);
+
 #endif  // G2L_FS_H
\ No newline at end of file
@@ -22,6 +22,7 @@
  * SOFTWARE.
  */
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,7 +33,7 @@
 
 #define TAG "g2l-fs"
 
-#define FULL_FILE_NAME_PATH (100)
+#define FULL_FILE_NAME_PATH (PATH_MAX)
 #define DEFAULT_BASE_PATH "/var/tmp/g2labs-idf"
 
 typedef struct g2l_fs_file {
@@ -43,21 +44,35 @@ typedef char file_name_path[FULL_FILE_NAME_PATH];
 static char fs_base_path[FULL_FILE_NAME_PATH] = DEFAULT_BASE_PATH;
 
 void g2l_fs_initialize(const char* base_path) {
-    if (base_path) {
-        memset(fs_base_path, 0, sizeof(fs_base_path));
-        strcpy(fs_base_path, base_path);
+    if (!base_path) {
+        return;
     }
+    if ((strlen(base_path) + 2) >= sizeof(fs_base_path)) {
+        E(TAG, "Base path '%s' is too long", base_path);
+        return;
+    }
+    strcpy(fs_base_path, base_path);
+}
+
+size_t g2l_fs_get_max_file_name_length(void) {
+    return sizeof(file_name_path) - strlen(fs_base_path) - 2;
 }
 
-static void create_full_path_name(file_name_path full_path, const char* name) {
-    strcpy(full_path, fs_base_path);
-    strcat(full_path, "/");
-    strcat(full_path, name);
+static bool create_full_path_name(file_name_path full_path, const char* name) {
+    int length = snprintf(full_path, sizeof(file_name_path), "%s/%s",
+                          fs_base_path, name);
+    if ((length < 0) || ((size_t)length >= sizeof(file_name_path))) {
+        E(TAG, "File name '%.32s...' is too long", name);
+        return false;
+    }
+    return true;
 }
 
 size_t g2l_fs_file_size(const char* file_name) {
     file_name_path path;
-    create_full_path_name(path, file_name);
+    if (!create_full_path_name(path, file_name)) {
+        return 0;
+    }
     struct stat info;
     int result = stat(path, &info);
     if (result == 0) {
@@ -69,9 +84,32 @@ size_t g2l_fs_file_size(const char* file_name) {
     return 0;
 }
 
+uint64_t g2l_fs_file_modification_time(const char* file_name) {
+    file_name_path path;
+    if (!create_full_path_name(path, file_name)) {
+        return 0;
+    }
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return 0;
+    }
+    return (info.st_mtime > 0) ? (uint64_t)info.st_mtime : 0;
+}
+
+bool g2l_fs_file_is_regular(const char* file_name) {
+    file_name_path path;
+    if (!create_full_path_name(path, file_name)) {
+        return false;
+    }
+    struct stat info;
+    return (stat(path, &info) == 0) && S_ISREG(info.st_mode);
+}
+
 g2l_fs_file_t* g2l_fs_file_open(const char* file_name, g2l_fs_mode_t mode) {
     file_name_path path;
-    create_full_path_name(path, file_name);
+    if (!create_full_path_name(path, file_name)) {
+        return NULL;
+    }
     char* mode_str = NULL;
     if (mode == G2L_FS_MODE_READ) {
         mode_str = "r";
@@ -132,3 +170,10 @@ bool g2l_fs_file_seek(g2l_fs_file_t* file,
     }
     return (fseek(file->file, (long)offset, whence) == 0);
 }
+
+int g2l_fs_file_get_descriptor(g2l_fs_file_t* file) {
+    if (!file) {
+        return -1;
+    }
+    return fileno(file->file);
+}
@@ -53,36 +53,109 @@ void g2l_html_render_destroy_page(g2l_html_render_page_t* page) {
     free(page);
 }
 
+static bool find_token(const char* text,
+                       char* key,
+                       size_t* literal_size,
+                       size_t* token_size) {
+    const char* open = strstr(text, G2L_HTML_RENDER_PAGE_TOKEN_OPEN);
+    if (!open) {
+        *literal_size = strlen(text);
+        *token_size = 0;
+        return false;
+    }
+    const char* key_start = open + strlen(G2L_HTML_RENDER_PAGE_TOKEN_OPEN);
+    const char* close = strstr(key_start, G2L_HTML_RENDER_PAGE_TOKEN_CLOSE);
+    *literal_size = (size_t)(open - text);
+    if (!close) {
+        *token_size = 0;
+        return false;
+    }
+    size_t key_size = (size_t)(close - key_start);
+    if (key_size > G2L_HTML_RENDER_PAGE_KEY_MAX_SIZE) {
+        key_size = G2L_HTML_RENDER_PAGE_KEY_MAX_SIZE;
+    }
+    memcpy(key, key_start, key_size);
+    key[key_size] = '\0';
+    *token_size = (size_t)(close - open) + strlen(G2L_HTML_RENDER_PAGE_TOKEN_CLOSE);
+    return true;
+}
+
+static size_t render_entry(g2l_html_render_page_t* page,
+                           const char* key,
+                           char* buffer,
+                           size_t buffer_size) {
+    D(TAG, "Rendering for Key: %s", key);
+    size_t size = page->config.entry_callback(page->config.ctx, key, 0, buffer,
+                                              buffer_size);
+    return (size < buffer_size) ? size : buffer_size;
+}
+
 size_t g2l_html_render_page(g2l_html_render_page_t* page) {
     if (!page) {
         return 0;
     }
-    char key[G2L_HTML_RENDER_PAGE_KEY_MAX_SIZE + 1] = {0};
-
+    char key[G2L_HTML_RENDER_PAGE_KEY_MAX_SIZE + 1];
     const char* read_ptr = page->config.html_template;
     char* write_ptr = page->config.render_buffer;
     size_t available_size = page->config.render_buffer_size;
-    while (*read_ptr) {
-        if (strncmp(read_ptr, G2L_HTML_RENDER_PAGE_TOKEN_OPEN,
-                    sizeof(G2L_HTML_RENDER_PAGE_TOKEN_OPEN) - 1) == 0) {
-            read_ptr += strlen(G2L_HTML_RENDER_PAGE_TOKEN_OPEN);
-            char* end = strstr(read_ptr, G2L_HTML_RENDER_PAGE_TOKEN_CLOSE);
-            if (end) {
-                memset(key, 0, sizeof(key));
-                memcpy(key, read_ptr, end - read_ptr);
-                I(TAG, "Rendering for Key: %s", key);
-                size_t write_size = page->config.entry_callback(
-                    page->config.ctx, key, 0, write_ptr, available_size);
-                read_ptr = end + strlen(G2L_HTML_RENDER_PAGE_TOKEN_CLOSE);
-                write_ptr += write_size;
-            } else {
-                break;
-            }
-        } else {
-            *write_ptr = *read_ptr;
-            write_ptr++;
-            read_ptr++;
+    while (*read_ptr && (available_size > 0)) {
+        size_t literal_size = 0;
+        size_t token_size = 0;
+        bool has_token = find_token(read_ptr, key, &literal_size, &token_size);
+        if (literal_size > available_size) {
+            literal_size = available_size;
         }
+        memcpy(write_ptr, read_ptr, literal_size);
+        write_ptr += literal_size;
+        available_size -= literal_size;
+        if (!has_token) {
+            break;
+        }
+        size_t write_size = render_entry(page, key, write_ptr, available_size);
+        write_ptr += write_size;
+        available_size -= write_size;
+        read_ptr += literal_size + token_size;
     }
     return (size_t)(write_ptr - page->config.render_buffer);
-}
\ No newline at end of file
+}
+
+bool g2l_html_render_page_stream(g2l_html_render_page_t* page,
+                                 g2l_html_render_output_callback_t output,
+                                 void* output_ctx) {
+    if (!page || !output) {
+        return false;
+    }
+    char key[G2L_HTML_RENDER_PAGE_KEY_MAX_SIZE + 1];
+    const char* read_ptr = page->config.html_template;
+    while (*read_ptr) {
+        size_t literal_size = 0;
+        size_t token_size = 0;
+        bool has_token = find_token(read_ptr, key, &literal_size, &token_size);
+        if ((literal_size > 0) && !output(output_ctx, read_ptr, literal_size)) {
+            return false;
+        }
+        if (!has_token) {
+            break;
+        }
+        size_t write_size = render_entry(page, key, page->config.render_buffer,
+                                         page->config.render_buffer_size);
+        if ((write_size > 0) &&
+            !output(output_ctx, page->config.render_buffer, write_size)) {
+            return false;
+        }
+        read_ptr += literal_size + token_size;
+    }
+    return true;
+}
+
+static bool count_output(void* ctx, const char* data, size_t data_size) {
+    (void)data;
+    *(size_t*)ctx += data_size;
+    return true;
+}
+
+size_t g2l_html_render_get_page_size(g2l_html_render_page_t* page) {
+    size_t size = 0;
+    g2l_html_render_page_stream(page, count_output, &size);
+    return size;
+}
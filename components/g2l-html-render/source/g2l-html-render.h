@@ -24,6 +24,7 @@
 #ifndef G2L_HTML_RENDER_H
 #define G2L_HTML_RENDER_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #define G2L_HTML_RENDER_PAGE_TOKEN_OPEN "[%"
@@ -37,6 +38,10 @@ typedef size_t (*g2l_html_render_entry_page_callback_t)(
     char* buffer,
     size_t buffer_size);
 
+typedef bool (*g2l_html_render_output_callback_t)(void* ctx,
+                                                  const char* data,
+                                                  size_t data_size);
+
 typedef struct g2l_html_render_page_configuration {
     const char* html_template;
     char* render_buffer;
@@ -54,4 +59,10 @@ void g2l_html_render_destroy_page(g2l_html_render_page_t* page);
 
 size_t g2l_html_render_page(g2l_html_render_page_t* page);
 
+bool g2l_html_render_page_stream(g2l_html_render_page_t* page,
+                                 g2l_html_render_output_callback_t output,
+                                 void* output_ctx);
+
+size_t g2l_html_render_get_page_size(g2l_html_render_page_t* page);
+
 #endif  // G2L_HTML_RENDER_H
\ No newline at end of file
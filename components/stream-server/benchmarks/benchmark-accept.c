@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "dynamic-queue.h"
+#include "stream-server.h"
+
+#define BENCHMARK_PORT (5700)
+#define BENCHMARK_MAX_WAITING_CONNECTIONS (1024)
+#define BENCHMARK_THREAD_POOL_SIZE (8)
+#define BENCHMARK_CLIENT_COUNT (4)
+#define BENCHMARK_CONNECTIONS_PER_CLIENT (25000)
+#define BENCHMARK_DRAIN_TIMEOUT_S (5.0)
+
+static atomic_size_t connected_count;
+static atomic_size_t handled_count;
+
+static double get_time_s(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+static void connection_handler(stream_server_t* server, stream_server_connection_t* connection, void* context) {
+    (void)server;
+    (void)context;
+    stream_server_close(connection);
+    atomic_fetch_add_explicit(&handled_count, 1, memory_order_relaxed);
+}
+
+static void* serve(void* context) {
+    stream_server_t* server = (stream_server_t*)context;
+    while (true) {
+        stream_server_loop(server);
+    }
+    return NULL;
+}
+
+/*
+ * Baseline: the handoff stream-server used before the lock-free ring, one
+ * allocation and a dynamic queue node per connection behind a single mutex and
+ * condition variable. Run with the "baseline" argument to compare on the same
+ * machine.
+ */
+typedef struct baseline_server {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition_var;
+    dynamic_queue_t* pool_queue;
+    int socket_fd;
+} baseline_server_t;
+
+typedef struct baseline_connection {
+    int id;
+} baseline_connection_t;
+
+static void* baseline_thread_pool_handler(void* context) {
+    baseline_server_t* server = (baseline_server_t*)context;
+    while (true) {
+        pthread_mutex_lock(&server->mutex);
+        baseline_connection_t* connection = dynamic_queue_dequeue(server->pool_queue);
+        if (!connection) {
+            pthread_cond_wait(&server->condition_var, &server->mutex);
+            connection = dynamic_queue_dequeue(server->pool_queue);
+        }
+        pthread_mutex_unlock(&server->mutex);
+        if (connection) {
+            close(connection->id);
+            atomic_fetch_add_explicit(&handled_count, 1, memory_order_relaxed);
+            free(connection);
+        }
+    }
+    return NULL;
+}
+
+static void* baseline_serve(void* context) {
+    baseline_server_t* server = (baseline_server_t*)context;
+    while (true) {
+        int connection_fd = accept(server->socket_fd, (struct sockaddr*)NULL, NULL);
+        baseline_connection_t* connection = calloc(1, sizeof(baseline_connection_t));
+        connection->id = connection_fd;
+        pthread_mutex_lock(&server->mutex);
+        dynamic_queue_enqueue(server->pool_queue, connection);
+        pthread_cond_signal(&server->condition_var);
+        pthread_mutex_unlock(&server->mutex);
+    }
+    return NULL;
+}
+
+static bool start_baseline_server(void) {
+    static baseline_server_t server;
+    server.socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server.socket_fd < 0) {
+        return false;
+    }
+    int true_value = 1;
+    setsockopt(server.socket_fd, SOL_SOCKET, SO_REUSEADDR, &true_value, sizeof(int));
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(BENCHMARK_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if ((bind(server.socket_fd, (struct sockaddr*)&address, sizeof(address)) < 0) ||
+        (listen(server.socket_fd, BENCHMARK_MAX_WAITING_CONNECTIONS) < 0)) {
+        close(server.socket_fd);
+        return false;
+    }
+    pthread_mutex_init(&server.mutex, NULL);
+    pthread_cond_init(&server.condition_var, NULL);
+    server.pool_queue = dynamic_queue_create();
+    pthread_t thread;
+    for (size_t i = 0; i < BENCHMARK_THREAD_POOL_SIZE; i++) {
+        pthread_create(&thread, NULL, baseline_thread_pool_handler, &server);
+    }
+    pthread_create(&thread, NULL, baseline_serve, &server);
+    return true;
+}
+
+static bool start_server(void) {
+    stream_server_t* server = stream_server_create(BENCHMARK_PORT, BENCHMARK_MAX_WAITING_CONNECTIONS,
+                                                   BENCHMARK_THREAD_POOL_SIZE, connection_handler, NULL);
+    if (!server) {
+        return false;
+    }
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, serve, server);
+    return true;
+}
+
+static void* connect_client(void* context) {
+    (void)context;
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(BENCHMARK_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct linger linger = {.l_onoff = 1, .l_linger = 0};
+    for (size_t i = 0; i < BENCHMARK_CONNECTIONS_PER_CLIENT; i++) {
+        int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (socket_fd < 0) {
+            continue;
+        }
+        if (connect(socket_fd, (struct sockaddr*)&address, sizeof(address)) == 0) {
+            atomic_fetch_add_explicit(&connected_count, 1, memory_order_relaxed);
+        }
+        setsockopt(socket_fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+        close(socket_fd);
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    bool is_baseline = (argc > 1) && (strcmp(argv[1], "baseline") == 0);
+    if (!(is_baseline ? start_baseline_server() : start_server())) {
+        fprintf(stderr, "Failed to create the stream server\n");
+        return EXIT_FAILURE;
+    }
+    printf("Accepting %d connections from %d clients on %d worker threads (%s)\n",
+           BENCHMARK_CLIENT_COUNT * BENCHMARK_CONNECTIONS_PER_CLIENT, BENCHMARK_CLIENT_COUNT,
+           BENCHMARK_THREAD_POOL_SIZE, is_baseline ? "mutex and condition variable baseline" : "lock-free ring");
+
+    pthread_t client_threads[BENCHMARK_CLIENT_COUNT];
+    double start = get_time_s();
+    for (size_t i = 0; i < BENCHMARK_CLIENT_COUNT; i++) {
+        pthread_create(client_threads + i, NULL, connect_client, NULL);
+    }
+    for (size_t i = 0; i < BENCHMARK_CLIENT_COUNT; i++) {
+        pthread_join(client_threads[i], NULL);
+    }
+    double deadline = get_time_s() + BENCHMARK_DRAIN_TIMEOUT_S;
+    while ((atomic_load(&handled_count) < atomic_load(&connected_count)) && (get_time_s() < deadline)) {
+        usleep(100);
+    }
+    double elapsed = get_time_s() - start;
+    size_t handled = atomic_load(&handled_count);
+    printf("%zu of %zu connections handled in %.3f s, %.0f accepts/s\n", handled, atomic_load(&connected_count),
+           elapsed, (double)handled / elapsed);
+    return (handled == atomic_load(&connected_count)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
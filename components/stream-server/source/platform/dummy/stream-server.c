@@ -37,12 +37,33 @@ stream_server_t* stream_server_create(uint16_t port,
     return NULL;
 }
 
+stream_server_t* stream_server_create_reactor(uint16_t port,
+                                              int max_waiting_connections,
+                                              size_t thread_count,
+                                              const stream_server_reactor_handlers_t* handlers,
+                                              void* context) {
+    return NULL;
+}
+
 size_t stream_server_read(stream_server_connection_t* connection, char* data, size_t max_data_size) {
     return 0;
 }
 
 void stream_server_write(stream_server_connection_t* connection, const char* data, size_t data_size) {}
 
+void stream_server_writev(stream_server_connection_t* connection,
+                          const stream_server_io_vector_t* vectors,
+                          size_t vector_count) {}
+
+size_t stream_server_send_file(stream_server_connection_t* connection,
+                               int file_descriptor,
+                               size_t offset,
+                               size_t size) {
+    return 0;
+}
+
+void stream_server_set_read_timeout(stream_server_connection_t* connection, uint32_t timeout_ms) {}
+
 void stream_server_close(stream_server_connection_t* connection) {}
 
 void stream_server_loop(stream_server_t* server) {}
\ No newline at end of file
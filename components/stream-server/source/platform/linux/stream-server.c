@@ -21,54 +21,159 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#define _GNU_SOURCE
 #include "stream-server.h"
 #include <arpa/inet.h>
 #include <errno.h>
+#include <linux/futex.h>
 #include <netinet/in.h>
 #include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
-#include "dynamic-queue.h"
+#include "atomic-queue.h"
 #include "g2l-log.h"
 #define TAG "stream-server"
+#define STREAM_SERVER_IO_VECTORS_MAX_COUNT (16)
+#define STREAM_SERVER_REACTOR_EVENTS_MAX_COUNT (64)
+#define STREAM_SERVER_REACTOR_READ_BUFFER_SIZE (4096)
+#define STREAM_SERVER_REACTOR_READS_PER_EVENT (16)
+#define STREAM_SERVER_REACTOR_OUTPUT_MIN_CAPACITY (1024)
+
+typedef struct connection_channel {
+    atomic_queue_t* queue;
+    atomic_uint signal;
+    atomic_uint waiter_count;
+} connection_channel_t;
 
 typedef struct stream_server {
     pthread_t* thread_pool;
-    pthread_mutex_t mutex;
-    pthread_cond_t condition_var;
-    dynamic_queue_t* pool_queue;
+    stream_server_connection_t* connections;
+    connection_channel_t free_connections;
+    connection_channel_t pending_connections;
     stream_server_connection_handler_t connection_handler;
     void* connection_handler_context;
     int socket_fd;
+    int epoll_fd;
+    stream_server_reactor_handlers_t reactor_handlers;
+    void* reactor_context;
 } stream_server_t;
 
 typedef struct stream_server_connection {
     int id;
+    stream_server_t* server;
+    void* state;
+    char* output;
+    size_t output_offset;
+    size_t output_size;
+    size_t output_capacity;
+    bool is_closing;
+    bool is_broken;
+    atomic_bool is_open;
 } stream_server_connection_t;
 
+static bool initialize_channel(connection_channel_t* channel,
+                               size_t capacity) {
+    channel->queue = atomic_queue_create(capacity);
+    atomic_init(&channel->signal, 0);
+    atomic_init(&channel->waiter_count, 0);
+    return channel->queue != NULL;
+}
+
+static bool push_connection(connection_channel_t* channel,
+                            stream_server_connection_t* connection) {
+    if (!atomic_queue_enqueue(channel->queue, connection)) {
+        E(TAG, "Failed to queue connection slot %p", (void*)connection);
+        return false;
+    }
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&channel->waiter_count, memory_order_relaxed) > 0) {
+        atomic_fetch_add_explicit(&channel->signal, 1, memory_order_relaxed);
+        syscall(SYS_futex, &channel->signal, FUTEX_WAKE_PRIVATE, 1, NULL, NULL,
+                0);
+    }
+    return true;
+}
+
+static stream_server_connection_t* pop_connection(
+    connection_channel_t* channel) {
+    stream_server_connection_t* connection =
+        atomic_queue_dequeue(channel->queue);
+    while (!connection) {
+        unsigned int signal =
+            atomic_load_explicit(&channel->signal, memory_order_relaxed);
+        atomic_fetch_add_explicit(&channel->waiter_count, 1,
+                                  memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        connection = atomic_queue_dequeue(channel->queue);
+        if (!connection) {
+            syscall(SYS_futex, &channel->signal, FUTEX_WAIT_PRIVATE, signal,
+                    NULL, NULL, 0);
+            connection = atomic_queue_dequeue(channel->queue);
+        }
+        atomic_fetch_sub_explicit(&channel->waiter_count, 1,
+                                  memory_order_relaxed);
+    }
+    return connection;
+}
+
+static void block_broken_pipe_signal(void) {
+    // sendfile() has no MSG_NOSIGNAL, a closed peer must not kill the process
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+}
+
 static void* thread_pool_handler(void* context) {
     stream_server_t* server = (stream_server_t*)context;
+    block_broken_pipe_signal();
     while (true) {
-        pthread_mutex_lock(&server->mutex);
         stream_server_connection_t* connection =
-            dynamic_queue_dequeue(server->pool_queue);
-        if (!connection) {
-            pthread_cond_wait(&server->condition_var, &server->mutex);
-            connection = dynamic_queue_dequeue(server->pool_queue);
-        }
-        pthread_mutex_unlock(&server->mutex);
-        if (connection) {
-            server->connection_handler(server, connection,
-                                       server->connection_handler_context);
-            free(connection);
-        }
+            pop_connection(&server->pending_connections);
+        // The handler owns the connection, the slot is recycled by
+        // stream_server_close() which may run after the handler returned
+        server->connection_handler(server, connection,
+                                   server->connection_handler_context);
+    }
+    return NULL;
+}
+
+static int open_listening_socket(uint16_t port,
+                                 int max_waiting_connections,
+                                 int type) {
+    int socket_fd = socket(AF_INET, type, 0);
+    if (socket_fd < 0) {
+        return -1;
+    }
+    int true_value = 1;
+    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &true_value, sizeof(int));
+
+    struct sockaddr_in serv_addr;
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(port);
+
+    if ((bind(socket_fd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) ||
+        (listen(socket_fd, max_waiting_connections) < 0)) {
+        E(TAG, "Failed to listen on port %u: %s", port, strerror(errno));
+        close(socket_fd);
+        return -1;
     }
+    return socket_fd;
 }
 
 stream_server_t* stream_server_create(
@@ -83,30 +188,382 @@ stream_server_t* stream_server_create(
     }
     server->connection_handler = connection_handler;
     server->connection_handler_context = connection_handler_context;
-    server->pool_queue = dynamic_queue_create();
-    pthread_mutex_init(&server->mutex, NULL);
-    pthread_cond_init(&server->condition_var, NULL);
+    server->epoll_fd = -1;
+    size_t connection_count =
+        thread_pool_size + (size_t)(max_waiting_connections > 0
+                                        ? max_waiting_connections
+                                        : 1);
+    server->connections =
+        calloc(connection_count, sizeof(stream_server_connection_t));
+    if (!server->connections ||
+        !initialize_channel(&server->free_connections, connection_count) ||
+        !initialize_channel(&server->pending_connections, connection_count)) {
+        E(TAG, "Failed to allocate %zu connection slots", connection_count);
+        atomic_queue_destroy(server->free_connections.queue);
+        atomic_queue_destroy(server->pending_connections.queue);
+        free(server->connections);
+        free(server);
+        return NULL;
+    }
+    for (size_t i = 0; i < connection_count; i++) {
+        server->connections[i].server = server;
+        atomic_init(&server->connections[i].is_open, false);
+        if (!atomic_queue_enqueue(server->free_connections.queue,
+                                  server->connections + i)) {
+            E(TAG, "Failed to queue connection slot %zu", i);
+        }
+    }
     server->thread_pool = calloc(thread_pool_size, sizeof(pthread_t));
     for (size_t i = 0; i < thread_pool_size; i++) {
         pthread_create(server->thread_pool + i, NULL, thread_pool_handler,
                        server);
     }
 
-    server->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    int true_value = 1;
-    int status = setsockopt(server->socket_fd, SOL_SOCKET, SO_REUSEADDR,
-                            &true_value, sizeof(int));
+    server->socket_fd =
+        open_listening_socket(port, max_waiting_connections, SOCK_STREAM);
+    return server;
+}
 
-    struct sockaddr_in serv_addr;
-    memset(&serv_addr, '0', sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    serv_addr.sin_port = htons(port);
+static bool is_reactor_connection(stream_server_connection_t* connection) {
+    return connection->server->epoll_fd >= 0;
+}
+
+static bool has_pending_output(stream_server_connection_t* connection) {
+    return connection->output_offset < connection->output_size;
+}
+
+static bool queue_output(stream_server_connection_t* connection,
+                         const char* data,
+                         size_t data_size) {
+    size_t pending_size = connection->output_size - connection->output_offset;
+    if (connection->output_offset > 0) {
+        memmove(connection->output,
+                connection->output + connection->output_offset, pending_size);
+        connection->output_offset = 0;
+        connection->output_size = pending_size;
+    }
+    if ((pending_size + data_size) > connection->output_capacity) {
+        size_t capacity = connection->output_capacity
+                              ? connection->output_capacity
+                              : STREAM_SERVER_REACTOR_OUTPUT_MIN_CAPACITY;
+        while (capacity < (pending_size + data_size)) {
+            capacity *= 2;
+        }
+        char* output = realloc(connection->output, capacity);
+        if (!output) {
+            E(TAG, "Failed to queue %zu bytes of output", data_size);
+            connection->is_broken = true;
+            return false;
+        }
+        connection->output = output;
+        connection->output_capacity = capacity;
+    }
+    memcpy(connection->output + connection->output_size, data, data_size);
+    connection->output_size += data_size;
+    return true;
+}
+
+static bool is_would_block(void) {
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+}
+
+static size_t send_available(stream_server_connection_t* connection,
+                             const char* data,
+                             size_t data_size) {
+    size_t sent_size = 0;
+    while (sent_size < data_size) {
+        ssize_t sent = send(connection->id, data + sent_size,
+                            data_size - sent_size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            connection->is_broken = !is_would_block();
+            break;
+        }
+        sent_size += (size_t)sent;
+    }
+    return sent_size;
+}
+
+static void flush_output(stream_server_connection_t* connection) {
+    connection->output_offset += send_available(
+        connection, connection->output + connection->output_offset,
+        connection->output_size - connection->output_offset);
+    if (!has_pending_output(connection)) {
+        connection->output_offset = 0;
+        connection->output_size = 0;
+    }
+}
+
+static void write_to_reactor(stream_server_connection_t* connection,
+                             const char* data,
+                             size_t data_size) {
+    if (connection->is_broken) {
+        return;
+    }
+    size_t sent_size = has_pending_output(connection)
+                           ? 0
+                           : send_available(connection, data, data_size);
+    if ((sent_size < data_size) && !connection->is_broken) {
+        queue_output(connection, data + sent_size, data_size - sent_size);
+    }
+}
+
+static void writev_to_reactor(stream_server_connection_t* connection,
+                              const stream_server_io_vector_t* vectors,
+                              size_t vector_count) {
+    if (connection->is_broken) {
+        return;
+    }
+    size_t sent_size = 0;
+    if (!has_pending_output(connection)) {
+        struct iovec iov[STREAM_SERVER_IO_VECTORS_MAX_COUNT];
+        struct msghdr message = {.msg_iov = iov};
+        for (; (message.msg_iovlen < vector_count) &&
+               (message.msg_iovlen < STREAM_SERVER_IO_VECTORS_MAX_COUNT);
+             message.msg_iovlen++) {
+            iov[message.msg_iovlen].iov_base =
+                (void*)vectors[message.msg_iovlen].data;
+            iov[message.msg_iovlen].iov_len = vectors[message.msg_iovlen].size;
+        }
+        ssize_t sent;
+        do {
+            sent = sendmsg(connection->id, &message, MSG_NOSIGNAL);
+        } while ((sent < 0) && (errno == EINTR));
+        if ((sent < 0) && !is_would_block()) {
+            connection->is_broken = true;
+            return;
+        }
+        sent_size = (sent > 0) ? (size_t)sent : 0;
+    }
+    for (size_t i = 0; i < vector_count; i++) {
+        if (sent_size >= vectors[i].size) {
+            sent_size -= vectors[i].size;
+            continue;
+        }
+        write_to_reactor(connection, vectors[i].data + sent_size,
+                         vectors[i].size - sent_size);
+        sent_size = 0;
+    }
+}
+
+static size_t send_file_to_reactor(stream_server_connection_t* connection,
+                                   int file_descriptor,
+                                   size_t offset,
+                                   size_t size) {
+    off_t file_offset = (off_t)offset;
+    size_t sent_size = 0;
+    while (!has_pending_output(connection) && !connection->is_broken &&
+           (sent_size < size)) {
+        ssize_t sent = sendfile(connection->id, file_descriptor, &file_offset,
+                                size - sent_size);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            connection->is_broken = !is_would_block();
+            break;
+        } else if (sent == 0) {
+            return sent_size;
+        }
+        sent_size += (size_t)sent;
+    }
+    char buffer[STREAM_SERVER_REACTOR_READ_BUFFER_SIZE];
+    while (!connection->is_broken && (sent_size < size)) {
+        size_t chunk_size = size - sent_size;
+        if (chunk_size > sizeof(buffer)) {
+            chunk_size = sizeof(buffer);
+        }
+        ssize_t read_size =
+            pread(file_descriptor, buffer, chunk_size, (off_t)(offset + sent_size));
+        if (read_size <= 0) {
+            break;
+        }
+        if (!queue_output(connection, buffer, (size_t)read_size)) {
+            break;
+        }
+        sent_size += (size_t)read_size;
+    }
+    return sent_size;
+}
+
+static void receive_available(stream_server_connection_t* connection) {
+    stream_server_t* server = connection->server;
+    char buffer[STREAM_SERVER_REACTOR_READ_BUFFER_SIZE];
+    for (size_t i = 0;
+         (i < STREAM_SERVER_REACTOR_READS_PER_EVENT) && !connection->is_closing;
+         i++) {
+        ssize_t read_size = read(connection->id, buffer, sizeof(buffer));
+        if (read_size > 0) {
+            server->reactor_handlers.receive(connection, buffer,
+                                             (size_t)read_size,
+                                             connection->state);
+            if ((size_t)read_size < sizeof(buffer)) {
+                return;
+            }
+        } else if (read_size == 0) {
+            connection->is_closing = true;
+        } else if (errno != EINTR) {
+            connection->is_broken = !is_would_block();
+            connection->is_closing |= connection->is_broken;
+            return;
+        }
+    }
+}
+
+static void destroy_connection(stream_server_connection_t* connection) {
+    stream_server_t* server = connection->server;
+    if (server->reactor_handlers.close) {
+        server->reactor_handlers.close(connection, connection->state);
+    }
+    close(connection->id);
+    free(connection->output);
+    free(connection);
+}
+
+static void settle_connection(stream_server_connection_t* connection,
+                              int operation) {
+    if (connection->is_broken ||
+        (connection->is_closing && !has_pending_output(connection))) {
+        destroy_connection(connection);
+        return;
+    }
+    struct epoll_event event = {
+        .events = EPOLLET | EPOLLONESHOT | EPOLLRDHUP,
+        .data.ptr = connection,
+    };
+    if (!connection->is_closing) {
+        event.events |= EPOLLIN;
+    }
+    if (has_pending_output(connection)) {
+        event.events |= EPOLLOUT;
+    }
+    if (epoll_ctl(connection->server->epoll_fd, operation, connection->id,
+                  &event) < 0) {
+        E(TAG, "Failed to watch connection %d: %s", connection->id,
+          strerror(errno));
+        destroy_connection(connection);
+    }
+}
+
+static void open_connection(stream_server_t* server, int connection_fd) {
+    stream_server_connection_t* connection =
+        calloc(1, sizeof(stream_server_connection_t));
+    if (!connection) {
+        close(connection_fd);
+        return;
+    }
+    connection->id = connection_fd;
+    connection->server = server;
+    connection->state =
+        server->reactor_handlers.open
+            ? server->reactor_handlers.open(connection, server->reactor_context)
+            : server->reactor_context;
+    settle_connection(connection, EPOLL_CTL_ADD);
+}
+
+static void accept_connections(stream_server_t* server) {
+    while (true) {
+        int connection_fd = accept4(server->socket_fd, NULL, NULL,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connection_fd >= 0) {
+            open_connection(server, connection_fd);
+        } else if ((errno != EINTR) && (errno != ECONNABORTED)) {
+            if (!is_would_block()) {
+                E(TAG, "Failed to accept connection: %s", strerror(errno));
+            }
+            break;
+        }
+    }
+    struct epoll_event event = {
+        .events = EPOLLIN | EPOLLET | EPOLLONESHOT,
+        .data.ptr = NULL,
+    };
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, server->socket_fd, &event);
+}
+
+static void dispatch_connection(stream_server_connection_t* connection,
+                                uint32_t events) {
+    stream_server_t* server = connection->server;
+    bool was_output_pending = has_pending_output(connection);
+    if (was_output_pending) {
+        flush_output(connection);
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        receive_available(connection);
+    }
+    if (was_output_pending && !has_pending_output(connection) &&
+        !connection->is_closing && !connection->is_broken &&
+        server->reactor_handlers.writable) {
+        server->reactor_handlers.writable(connection, connection->state);
+    }
+    settle_connection(connection, EPOLL_CTL_MOD);
+}
 
-    status = bind(server->socket_fd, (struct sockaddr*)&serv_addr,
-                  sizeof(serv_addr));
+static void run_reactor(stream_server_t* server) {
+    struct epoll_event events[STREAM_SERVER_REACTOR_EVENTS_MAX_COUNT];
+    int event_count = epoll_wait(server->epoll_fd, events,
+                                 STREAM_SERVER_REACTOR_EVENTS_MAX_COUNT, -1);
+    for (int i = 0; i < event_count; i++) {
+        if (!events[i].data.ptr) {
+            accept_connections(server);
+        } else {
+            dispatch_connection(events[i].data.ptr, events[i].events);
+        }
+    }
+}
+
+static void* reactor_thread_handler(void* context) {
+    stream_server_t* server = (stream_server_t*)context;
+    block_broken_pipe_signal();
+    while (true) {
+        run_reactor(server);
+    }
+    return NULL;
+}
 
-    status = listen(server->socket_fd, max_waiting_connections);
+stream_server_t* stream_server_create_reactor(
+    uint16_t port,
+    int max_waiting_connections,
+    size_t thread_count,
+    const stream_server_reactor_handlers_t* handlers,
+    void* context) {
+    if (!handlers || !handlers->receive) {
+        return NULL;
+    }
+    stream_server_t* server = calloc(1, sizeof(stream_server_t));
+    if (!server) {
+        return NULL;
+    }
+    server->reactor_handlers = *handlers;
+    server->reactor_context = context;
+    server->socket_fd = open_listening_socket(
+        port, max_waiting_connections,
+        SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {
+        .events = EPOLLIN | EPOLLET | EPOLLONESHOT,
+        .data.ptr = NULL,
+    };
+    if ((server->socket_fd < 0) || (server->epoll_fd < 0) ||
+        (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->socket_fd,
+                   &event) < 0)) {
+        E(TAG, "Failed to create reactor: %s", strerror(errno));
+        if (server->socket_fd >= 0) {
+            close(server->socket_fd);
+        }
+        if (server->epoll_fd >= 0) {
+            close(server->epoll_fd);
+        }
+        free(server);
+        return NULL;
+    }
+    server->thread_pool = calloc(thread_count, sizeof(pthread_t));
+    for (size_t i = 0; server->thread_pool && (i < thread_count); i++) {
+        pthread_create(server->thread_pool + i, NULL, reactor_thread_handler,
+                       server);
+    }
     return server;
 }
 
@@ -116,12 +573,21 @@ size_t stream_server_read(stream_server_connection_t* connection,
     if (!connection || !data || (max_data_size < 1)) {
         return 0;
     }
-    ssize_t read_bytes = read(connection->id, data, max_data_size);
+    ssize_t read_bytes;
+    do {
+        read_bytes = read(connection->id, data, max_data_size);
+    } while ((read_bytes < 0) && (errno == EINTR));
     if (read_bytes > 0) {
         return (size_t)read_bytes;
-    } else {
-        return 0;
     }
+    if (read_bytes == 0) {
+        errno = 0;
+        connection->is_closing |= is_reactor_connection(connection);
+    } else if (is_reactor_connection(connection) && !is_would_block()) {
+        connection->is_broken = true;
+        connection->is_closing = true;
+    }
+    return 0;
 }
 
 void stream_server_write(stream_server_connection_t* connection,
@@ -130,26 +596,144 @@ void stream_server_write(stream_server_connection_t* connection,
     if (!connection || !data || (data_size < 1)) {
         return;
     }
-    write(connection->id, data, data_size);
+    if (is_reactor_connection(connection)) {
+        write_to_reactor(connection, data, data_size);
+        return;
+    }
+    size_t sent_size = 0;
+    while (sent_size < data_size) {
+        ssize_t sent = send(connection->id, data + sent_size,
+                            data_size - sent_size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        sent_size += (size_t)sent;
+    }
+}
+
+void stream_server_writev(stream_server_connection_t* connection,
+                          const stream_server_io_vector_t* vectors,
+                          size_t vector_count) {
+    if (!connection || !vectors) {
+        return;
+    }
+    if (is_reactor_connection(connection)) {
+        writev_to_reactor(connection, vectors, vector_count);
+        return;
+    }
+    while (vector_count > 0) {
+        struct iovec iov[STREAM_SERVER_IO_VECTORS_MAX_COUNT];
+        size_t batch_count = 0;
+        for (; (batch_count < vector_count) &&
+               (batch_count < STREAM_SERVER_IO_VECTORS_MAX_COUNT);
+             batch_count++) {
+            iov[batch_count].iov_base = (void*)vectors[batch_count].data;
+            iov[batch_count].iov_len = vectors[batch_count].size;
+        }
+        struct iovec* pending = iov;
+        size_t pending_count = batch_count;
+        while (pending_count > 0) {
+            struct msghdr message = {.msg_iov = pending,
+                                     .msg_iovlen = pending_count};
+            ssize_t written = sendmsg(connection->id, &message, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            while ((pending_count > 0) && ((size_t)written >= pending->iov_len)) {
+                written -= (ssize_t)pending->iov_len;
+                pending++;
+                pending_count--;
+            }
+            if (pending_count > 0) {
+                pending->iov_base = (char*)pending->iov_base + written;
+                pending->iov_len -= (size_t)written;
+            }
+        }
+        vectors += batch_count;
+        vector_count -= batch_count;
+    }
+}
+
+size_t stream_server_send_file(stream_server_connection_t* connection,
+                               int file_descriptor,
+                               size_t offset,
+                               size_t size) {
+    if (!connection || (file_descriptor < 0)) {
+        return 0;
+    }
+    if (is_reactor_connection(connection)) {
+        return send_file_to_reactor(connection, file_descriptor, offset, size);
+    }
+    off_t file_offset = (off_t)offset;
+    size_t sent_size = 0;
+    while (sent_size < size) {
+        ssize_t sent = sendfile(connection->id, file_descriptor, &file_offset,
+                                size - sent_size);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        } else if (sent == 0) {
+            break;
+        }
+        sent_size += (size_t)sent;
+    }
+    return sent_size;
+}
+
+void stream_server_set_read_timeout(stream_server_connection_t* connection,
+                                    uint32_t timeout_ms) {
+    if (!connection || is_reactor_connection(connection)) {
+        return;
+    }
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    setsockopt(connection->id, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+               sizeof(timeout));
 }
 
 void stream_server_close(stream_server_connection_t* connection) {
     if (!connection) {
         return;
     }
+    if (is_reactor_connection(connection)) {
+        connection->is_closing = true;
+        return;
+    }
+    if (!atomic_exchange(&connection->is_open, false)) {
+        return;
+    }
     close(connection->id);
+    connection->id = -1;
+    push_connection(&connection->server->free_connections, connection);
 }
 
 void stream_server_loop(stream_server_t* server) {
     if (!server) {
         return;
     }
-    int connection_fd = accept(server->socket_fd, (struct sockaddr*)NULL, NULL);
+    if (server->epoll_fd >= 0) {
+        run_reactor(server);
+        return;
+    }
     stream_server_connection_t* connection =
-        calloc(1, sizeof(stream_server_connection_t));
-    connection->id = connection_fd;
-    pthread_mutex_lock(&server->mutex);
-    dynamic_queue_enqueue(server->pool_queue, connection);
-    pthread_cond_signal(&server->condition_var);
-    pthread_mutex_unlock(&server->mutex);
+        pop_connection(&server->free_connections);
+    connection->id = accept(server->socket_fd, (struct sockaddr*)NULL, NULL);
+    if (connection->id < 0) {
+        push_connection(&server->free_connections, connection);
+        return;
+    }
+    atomic_store(&connection->is_open, true);
+    if (!push_connection(&server->pending_connections, connection)) {
+        stream_server_close(connection);
+    }
 }
\ No newline at end of file
@@ -30,20 +30,73 @@ typedef struct stream_server stream_server_t;
 
 typedef struct stream_server_connection stream_server_connection_t;
 
+typedef struct stream_server_io_vector {
+    const char* data;
+    size_t size;
+} stream_server_io_vector_t;
+
+/**
+ * @brief Called on a pool thread for every accepted connection
+ *
+ * The handler owns the connection. It stays open, and keeps its slot, until stream_server_close() is called; that may
+ * happen on another thread after the handler has returned.
+ */
 typedef void (*stream_server_connection_handler_t)(stream_server_t* stream_server,
                                                    stream_server_connection_t* connection,
                                                    void* context);
 
+/**
+ * @brief Callbacks of a reactor mode server, all but receive are optional
+ *
+ * open returns the per-connection state handed to the other callbacks (the context when open is NULL). receive gets
+ * everything read since the socket became readable, writable is called once queued output has been flushed and close
+ * releases the state. The connection functions may only be called from these callbacks; writes that would block are
+ * queued and the connection is closed after they have been sent.
+ */
+typedef struct stream_server_reactor_handlers {
+    void* (*open)(stream_server_connection_t* connection, void* context);
+    void (*receive)(stream_server_connection_t* connection, const char* data, size_t data_size, void* state);
+    void (*writable)(stream_server_connection_t* connection, void* state);
+    void (*close)(stream_server_connection_t* connection, void* state);
+} stream_server_reactor_handlers_t;
+
 stream_server_t* stream_server_create(uint16_t port,
                                       int max_waiting_connections,
                                       size_t thread_pool_size,
                                       stream_server_connection_handler_t connection_handler,
                                       void* connection_handler_context);
 
+stream_server_t* stream_server_create_reactor(uint16_t port,
+                                              int max_waiting_connections,
+                                              size_t thread_count,
+                                              const stream_server_reactor_handlers_t* handlers,
+                                              void* context);
+
+/**
+ * @brief Read available data from a connection
+ *
+ * Returns 0 when nothing was read. errno then tells the cases apart: 0 means the peer closed the connection, EAGAIN
+ * (or EWOULDBLOCK) means no data is available yet on a reactor connection or the read timeout expired, anything else is
+ * a socket error. On a reactor connection end of stream and errors also close the connection.
+ */
 size_t stream_server_read(stream_server_connection_t* connection, char* data, size_t max_data_size);
 
 void stream_server_write(stream_server_connection_t* connection, const char* data, size_t data_size);
 
+void stream_server_writev(stream_server_connection_t* connection,
+                          const stream_server_io_vector_t* vectors,
+                          size_t vector_count);
+
+size_t stream_server_send_file(stream_server_connection_t* connection,
+                               int file_descriptor,
+                               size_t offset,
+                               size_t size);
+
+void stream_server_set_read_timeout(stream_server_connection_t* connection, uint32_t timeout_ms);
+
+/**
+ * @brief Close a connection and return its slot to the server; the connection must not be used afterwards
+ */
 void stream_server_close(stream_server_connection_t* connection);
 
 void stream_server_loop(stream_server_t* server);
@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "cmocka.h"
+
+#include "stream-server.h"
+
+#define TEST_PORT (5711)
+#define TEST_THREAD_COUNT (1)
+#define TEST_MAX_WAITING_CONNECTIONS (1)
+#define TEST_OTHER_CLIENT_COUNT (4)
+
+static _Atomic(stream_server_connection_t*) deferred_connection;
+
+/* "DEFER" keeps the connection open after the handler returns, anything else is answered and closed at once */
+static void handle_connection(stream_server_t* server, stream_server_connection_t* connection, void* context) {
+    char data[16];
+    size_t size = stream_server_read(connection, data, sizeof(data));
+    if ((size == 5) && (memcmp(data, "DEFER", 5) == 0)) {
+        atomic_store(&deferred_connection, connection);
+        return;
+    }
+    stream_server_write(connection, "other", 5);
+    stream_server_close(connection);
+}
+
+static void* run_loop(void* context) {
+    while (true) {
+        stream_server_loop((stream_server_t*)context);
+    }
+    return NULL;
+}
+
+static int connect_client(void) {
+    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert_true(socket_fd >= 0);
+    struct timeval timeout = {.tv_sec = 5};
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    assert_int_equal(connect(socket_fd, (struct sockaddr*)&address, sizeof(address)), 0);
+    return socket_fd;
+}
+
+static void send_text(int socket_fd, const char* text) {
+    assert_int_equal(send(socket_fd, text, strlen(text), 0), (ssize_t)strlen(text));
+}
+
+static void assert_received_until_closed(int socket_fd, const char* text) {
+    char data[64] = {0};
+    size_t size = 0;
+    while (true) {
+        ssize_t received = recv(socket_fd, data + size, sizeof(data) - 1 - size, 0);
+        assert_true(received >= 0);
+        if (received == 0) {
+            break;
+        }
+        size += (size_t)received;
+    }
+    assert_string_equal(data, text);
+}
+
+/* Every slot freed in between is handed to a new client; none of them may be the deferred one */
+static void test_connection_outlives_handler(void** state) {
+    int deferred_fd = connect_client();
+    send_text(deferred_fd, "DEFER");
+    for (size_t i = 0; (i < 1000) && !atomic_load(&deferred_connection); i++) {
+        usleep(1000);
+    }
+    assert_non_null(atomic_load(&deferred_connection));
+
+    for (size_t i = 0; i < TEST_OTHER_CLIENT_COUNT; i++) {
+        int socket_fd = connect_client();
+        send_text(socket_fd, "hello");
+        assert_received_until_closed(socket_fd, "other");
+        close(socket_fd);
+    }
+
+    stream_server_connection_t* connection = atomic_load(&deferred_connection);
+    stream_server_write(connection, "deferred", 8);
+    stream_server_close(connection);
+    assert_received_until_closed(deferred_fd, "deferred");
+    close(deferred_fd);
+}
+
+static int start_server(void** state) {
+    stream_server_t* server =
+        stream_server_create(TEST_PORT, TEST_MAX_WAITING_CONNECTIONS, TEST_THREAD_COUNT, handle_connection, NULL);
+    pthread_t loop_thread;
+    if (!server || (pthread_create(&loop_thread, NULL, run_loop, server) != 0)) {
+        return -1;
+    }
+    pthread_detach(loop_thread);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_connection_outlives_handler),
+    };
+
+    return cmocka_run_group_tests(tests, start_server, NULL);
+}
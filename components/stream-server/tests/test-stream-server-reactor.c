@@ -0,0 +1,229 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Grzegorz Grzęda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "cmocka.h"
+
+#include "stream-server.h"
+
+#define TEST_PORT (5710)
+#define TEST_THREAD_COUNT (2)
+#define TEST_LARGE_PAYLOAD_SIZE (8 * 1024 * 1024)
+#define TEST_LARGE_HEADER "LARGE:"
+#define TEST_EOF_POLL_COUNT (2000)
+
+static char large_payload[TEST_LARGE_PAYLOAD_SIZE];
+static atomic_int open_count;
+static atomic_int close_count;
+
+static void* open_connection(stream_server_connection_t* connection, void* context) {
+    atomic_fetch_add(&open_count, 1);
+    return context;
+}
+
+static void reply_with_read_result(stream_server_connection_t* connection, bool wait_for_end) {
+    char data[16];
+    for (size_t i = 0; i < TEST_EOF_POLL_COUNT; i++) {
+        size_t read_size = stream_server_read(connection, data, sizeof(data));
+        if (read_size > 0) {
+            stream_server_write(connection, "DATA", 4);
+            return;
+        } else if (errno == 0) {
+            stream_server_write(connection, "EOF", 3);
+            return;
+        } else if (((errno != EAGAIN) && (errno != EWOULDBLOCK)) || !wait_for_end) {
+            stream_server_write(connection, "EAGAIN", 6);
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+static void receive(stream_server_connection_t* connection, const char* data, size_t data_size, void* state) {
+    if ((data_size == 5) && (memcmp(data, "LARGE", 5) == 0)) {
+        stream_server_io_vector_t vectors[] = {
+            {TEST_LARGE_HEADER, strlen(TEST_LARGE_HEADER)},
+            {large_payload, sizeof(large_payload)},
+        };
+        stream_server_writev(connection, vectors, 2);
+    } else if ((data_size == 4) && (memcmp(data, "PEEK", 4) == 0)) {
+        reply_with_read_result(connection, false);
+    } else if ((data_size == 4) && (memcmp(data, "WAIT", 4) == 0)) {
+        reply_with_read_result(connection, true);
+    } else if ((data_size == 4) && (memcmp(data, "QUIT", 4) == 0)) {
+        stream_server_close(connection);
+    } else {
+        stream_server_write(connection, data, data_size);
+    }
+}
+
+static void close_when_flushed(stream_server_connection_t* connection, void* state) {
+    stream_server_close(connection);
+}
+
+static void close_connection(stream_server_connection_t* connection, void* state) {
+    atomic_fetch_add(&close_count, 1);
+}
+
+static int connect_client(void) {
+    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert_true(socket_fd >= 0);
+    struct timeval timeout = {.tv_sec = 5};
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    assert_int_equal(connect(socket_fd, (struct sockaddr*)&address, sizeof(address)), 0);
+    return socket_fd;
+}
+
+static void send_text(int socket_fd, const char* text) {
+    assert_int_equal(send(socket_fd, text, strlen(text), 0), (ssize_t)strlen(text));
+}
+
+static size_t receive_until_closed(int socket_fd, char* data, size_t max_data_size) {
+    size_t size = 0;
+    while (true) {
+        char chunk[4096];
+        ssize_t received = recv(socket_fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            assert_int_equal(received, 0);
+            return size;
+        }
+        if ((size + (size_t)received) <= max_data_size) {
+            memcpy(data + size, chunk, (size_t)received);
+        }
+        size += (size_t)received;
+    }
+}
+
+static void receive_text(int socket_fd, const char* text) {
+    char data[64] = {0};
+    size_t size = 0;
+    while (size < strlen(text)) {
+        ssize_t received = recv(socket_fd, data + size, strlen(text) - size, 0);
+        assert_true(received > 0);
+        size += (size_t)received;
+    }
+    assert_string_equal(data, text);
+}
+
+static void wait_for_close_count(int expected_count) {
+    for (size_t i = 0; (i < 1000) && (atomic_load(&close_count) < expected_count); i++) {
+        usleep(1000);
+    }
+    assert_int_equal(atomic_load(&close_count), expected_count);
+}
+
+static void test_echo_and_close(void** state) {
+    int opened = atomic_load(&open_count);
+    int closed = atomic_load(&close_count);
+    int socket_fd = connect_client();
+    send_text(socket_fd, "hello");
+    receive_text(socket_fd, "hello");
+    send_text(socket_fd, "again");
+    receive_text(socket_fd, "again");
+    send_text(socket_fd, "QUIT");
+    char data[8];
+    assert_int_equal(receive_until_closed(socket_fd, data, sizeof(data)), 0);
+    close(socket_fd);
+    assert_int_equal(atomic_load(&open_count), opened + 1);
+    wait_for_close_count(closed + 1);
+}
+
+/* The reply does not fit the socket buffers, so only the writable callback can close the connection */
+static void test_queue_output_of_partial_writes(void** state) {
+    int closed = atomic_load(&close_count);
+    int socket_fd = connect_client();
+    int receive_buffer_size = 64 * 1024;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer_size, sizeof(receive_buffer_size));
+    send_text(socket_fd, "LARGE");
+    static char data[sizeof(TEST_LARGE_HEADER) - 1 + TEST_LARGE_PAYLOAD_SIZE];
+    assert_int_equal(receive_until_closed(socket_fd, data, sizeof(data)), sizeof(data));
+    assert_memory_equal(data, TEST_LARGE_HEADER, strlen(TEST_LARGE_HEADER));
+    assert_memory_equal(data + strlen(TEST_LARGE_HEADER), large_payload, sizeof(large_payload));
+    close(socket_fd);
+    wait_for_close_count(closed + 1);
+}
+
+static void test_read_reports_would_block(void** state) {
+    int closed = atomic_load(&close_count);
+    int socket_fd = connect_client();
+    send_text(socket_fd, "PEEK");
+    receive_text(socket_fd, "EAGAIN");
+    send_text(socket_fd, "ping");
+    receive_text(socket_fd, "ping");
+    close(socket_fd);
+    wait_for_close_count(closed + 1);
+}
+
+static void test_read_reports_end_of_stream(void** state) {
+    int closed = atomic_load(&close_count);
+    int socket_fd = connect_client();
+    send_text(socket_fd, "WAIT");
+    shutdown(socket_fd, SHUT_WR);
+    char data[8] = {0};
+    assert_int_equal(receive_until_closed(socket_fd, data, sizeof(data) - 1), 3);
+    assert_string_equal(data, "EOF");
+    close(socket_fd);
+    wait_for_close_count(closed + 1);
+}
+
+static int start_reactor(void** state) {
+    memset(large_payload, 'x', sizeof(large_payload));
+    for (size_t i = 0; i < sizeof(large_payload); i += 997) {
+        large_payload[i] = (char)('a' + (i % 26));
+    }
+    stream_server_reactor_handlers_t handlers = {
+        .open = open_connection,
+        .receive = receive,
+        .writable = close_when_flushed,
+        .close = close_connection,
+    };
+    return stream_server_create_reactor(TEST_PORT, 16, TEST_THREAD_COUNT, &handlers, NULL) ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_echo_and_close),
+        cmocka_unit_test(test_queue_output_of_partial_writes),
+        cmocka_unit_test(test_read_reports_would_block),
+        cmocka_unit_test(test_read_reports_end_of_stream),
+    };
+
+    return cmocka_run_group_tests(tests, start_reactor, NULL);
+}